@@ -30,6 +30,12 @@ class RadExporter;
 #include "../src/readers/SKPreader.h"
 class SKPreader;
 
+#include "../src/readers/snapshotreader.h"
+class SnapshotReader;
+
+#include "../src/writers/snapshot/snapshotwriter.h"
+class SnapshotWriter;
+
 // Calculation Tasks
 #include "../src/calculations/tasks/AddSkyToOctree.h"
 class AddSkyToOctree;
@@ -100,6 +106,11 @@ class OconvTask;
 #include "../src/calculations/tasks/CalculateStaticIlluminance.h"
 class CalculateStaticIlluminance;
 
+#include "../src/calculations/tasks/CalculateStaticSkyBatch.h"
+class CalculateStaticSkyBatch;
+
+#include "../src/calculations/tasks/RContribBatch.h"
+
 #include "../src/calculations/tasks/TriangulateWorkplane.h"
 class TriangulateWorkplane;
 
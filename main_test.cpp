@@ -12,6 +12,13 @@
 #include "./tests/triangulation_test.h"
 #include "./tests/polygon_test.h"
 #include "./tests/triangle_test.h" 
+#include "./tests/trianglemesh_test.h"
+#include "./tests/geometryoptimization_test.h"
+#include "./tests/trianglesoup_test.h"
+#include "./tests/snapshot_test.h"
+#include "./tests/sensorset_test.h"
+#include "./tests/octreecache_test.h"
+#include "./tests/ambientcache_test.h"
 #include "./tests/taskManager_test.h"
 #include "./tests/optionset_test.h"
 #include "./tests/matrix_test.h"
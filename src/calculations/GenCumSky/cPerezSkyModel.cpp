@@ -200,6 +200,36 @@ double cPerezSkyModel::GetRelativeLuminance(double Alt, double Az)
 	return lv;
 }
 
+bool cPerezSkyModel::GetRelativeLuminances(int NumPatches, const double *SinAlt, const double *CosAlt,
+										   const double *SinAz, const double *CosAz, double *ptLv)
+{
+	if (!m_coefficientsset)
+	{
+		// trying to use model without setting it up
+		printf("Attempt to use model before coefficients are set!\n");
+		return false;
+	}
+
+	// everything that depends on the sun only is calculated once
+	const double SinSolarAlt=sin(m_SolarAlt);
+	const double CosSolarAlt=cos(m_SolarAlt);
+	const double SinSolarAz=sin(m_SolarAz);
+	const double CosSolarAz=cos(m_SolarAz);
+
+	// plain loop over contiguous arrays, so that it can be vectorised
+	for (int i=0; i<NumPatches; i++)
+	{
+		// cos(|Az-SolarAz|) expanded, to avoid calculating it for every patch
+		double cosSkySunAngle = SinAlt[i]*SinSolarAlt + CosSolarAlt*CosAlt[i]*(CosAz[i]*CosSolarAz + SinAz[i]*SinSolarAz);
+		cosSkySunAngle = cosSkySunAngle > 1 ? 1 : (cosSkySunAngle < -1 ? -1 : cosSkySunAngle);
+
+		const double lv=(1 + m_a*exp(m_b/SinAlt[i])) * (1 + m_c*exp(m_d*acos(cosSkySunAngle)) + m_e*cosSkySunAngle*cosSkySunAngle);
+		ptLv[i] = lv < 0 ? 0 : lv;
+	}
+
+	return true;
+}
+
 // TODO: Work out W properly!
 // Td - three hourly surface dew point temp (degC)
 double cPerezSkyModel::GetDiffuseLumEffy(double SolarAlt, double Td)
@@ -10,6 +10,10 @@ public:
 	// cSun object should be set up in the correct position before calling
 	virtual bool SetSkyConditions(double Idh, double Ibh, cSun *Sun);
 	virtual double GetRelativeLuminance(double Alt, double Az);
+	// same as GetRelativeLuminance(), but for many patches at once. The sines and cosines of
+	// the altitude and azimuth of each patch are given, as they do not change from hour to hour
+	bool GetRelativeLuminances(int NumPatches, const double *SinAlt, const double *CosAlt,
+							   const double *SinAz, const double *CosAz, double *ptLv);
 	virtual double GetDiffuseLumEffy(double SolarAlt, double Td);
 	virtual double GetGlobalLumEffy(double SolarAlt, double Td);
 	virtual double GetBeamLumEffy(double SolarAlt, double Td);
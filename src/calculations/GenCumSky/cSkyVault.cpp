@@ -205,6 +205,9 @@ void cSkyVault::CalculateSky(cSkyVault::eSunType Suns, bool DoDiffuse, bool DoIl
 	}
 
 
+	// relative luminances of the patches (reused every hour)
+	ptLv=new double[m_NumPatches];
+
 	for (day=1; day<=365; day++)
 	{
 
@@ -220,7 +223,6 @@ void cSkyVault::CalculateSky(cSkyVault::eSunType Suns, bool DoDiffuse, bool DoIl
 			CosMinSunDist=-999;
 
 			index=(day-1)*24+(int)hour;
-			ptLv=new double[m_NumPatches];
 
 			// !!!!!!!!!!!!!!!!!!!!!!
 			hourangle=(hour+hourshift+m_Sun.TimeDiff(m_longitude))*M_PI/12;
@@ -325,11 +327,11 @@ void cSkyVault::CalculateSky(cSkyVault::eSunType Suns, bool DoDiffuse, bool DoIl
 				AzxIbh[AltIndex][AzIndex]+=SunAz*NormFac;
 				NxIbh[AltIndex][AzIndex]+=NormFac;
 			}
-			delete ptLv;
 NextHour:
 			continue;
 		}
 	}
+	delete[] ptLv;
 	//fprintf(stderr,"There were %d sun up hours in this climate file\n",SunUpHourCount);
 
 	// work out cumulative sky
@@ -0,0 +1,132 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdio>
+
+#include "./ambient_cache.h"
+#include "./octree_cache.h"
+#include "../config_constants.h"
+#include "../os_definitions.h"
+#include "../common/utilities/file.h"
+
+#ifdef WIN
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+//! The RTRACE options that change the values stored in an ambient file
+static const char * ambientOptions[] = {"ab", "aa", "ar", "ad", "as", "av", "aw"};
+
+AmbientCache::AmbientCache()
+{
+#ifdef WIN
+    // RTRACE does not lock ambient files on Windows
+    dir = "";
+#else
+    const char * d = std::getenv(EMP_CACHE);
+    dir = (d == nullptr) ? "" : d;
+#endif
+    
+    const char * size = std::getenv(EMP_AMBIENT_CACHE_SIZE);
+    const uint64_t megabytes = (size == nullptr) ? EMP_DEFAULT_AMBIENT_CACHE_SIZE : std::strtoull(size, nullptr, 10);
+    maxSize = megabytes * 1024 * 1024;
+    
+    const char * stride = std::getenv(EMP_AMBIENT_PREWARM);
+    prewarm = (stride == nullptr) ? 0 : (size_t)std::strtoull(stride, nullptr, 10);
+}
+
+AmbientCache::AmbientCache(std::string theDir, uint64_t theMaxSize, size_t thePrewarm)
+{
+    dir = theDir;
+    maxSize = theMaxSize;
+    prewarm = thePrewarm;
+}
+
+bool AmbientCache::isEnabled() const
+{
+    return !dir.empty();
+}
+
+size_t AmbientCache::getPrewarm() const
+{
+    return prewarm;
+}
+
+uint64_t AmbientCache::getKey(uint64_t octreeKey, const RTraceOptions * options)
+{
+    std::stringstream key;
+    key << "v" << EMP_AMBIENT_CACHE_VERSION << " " << std::hex << octreeKey << std::dec;
+    for(const char * option : ambientOptions){
+        if(options->hasOption(option))
+            key << " -" << option << " " << options->getOption<json>(option).dump();
+    }
+    
+    const std::string text = key.str();
+    uint64_t hash = 14695981039346656037ULL;
+    OctreeCache::hashBytes(&text[0], text.size(), &hash);
+    return hash;
+}
+
+std::string AmbientCache::getFileName(uint64_t key) const
+{
+    std::stringstream name;
+    name << dir << "/ambient_" << std::hex << std::setw(16) << std::setfill('0') << key << ".amb";
+    return name.str();
+}
+
+bool AmbientCache::getAmbientFile(const std::string & octreeName, const RTraceOptions * options, std::string * ambientFile, const std::vector<std::string> * dependencies) const
+{
+    if(!isEnabled() || !createdir(dir))
+        return false;
+    
+    uint64_t octreeKey;
+    if(!OctreeCache::getOctreeKey(octreeName, &octreeKey))
+        return false;
+    
+    uint64_t key = getKey(octreeKey, options);
+    
+    // The octree only has the names of these files
+    if(dependencies != nullptr){
+        for(const std::string & dependency : *dependencies){
+            if(!OctreeCache::hashFile(dependency, &key))
+                return false;
+        }
+    }
+    
+    *ambientFile = getFileName(key);
+    
+    // Mark as recently used
+    if(fexists(*ambientFile))
+        utime(&(*ambientFile)[0], nullptr);
+    
+    return true;
+}
+
+size_t AmbientCache::evict() const
+{
+    if(!isEnabled())
+        return 0;
+    
+    return evictCacheFiles(dir, "ambient_", ".amb", maxSize);
+}
@@ -0,0 +1,135 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../emp_model/src/rtraceoptions.h"
+
+//! The version of the ambient cache keys... change it to invalidate old entries
+#define EMP_AMBIENT_CACHE_VERSION 2
+
+//! A persistent store of Radiance ambient (i.e. irradiance cache) files
+/*!
+ Ambient files are stored in the cache directory (see EMP_CACHE) as
+ 'ambient_<key>.amb', where the key is a hash of the contents of the
+ octree (see OctreeCache::getOctreeKey()) and of the options that 
+ change the ambient values: -ab, -aa, -ar, -ad, -as, -av and -aw. 
+ Octrees only hold the names of the files they reference (e.g. the 
+ .cal files of the cumulative skies), so the contents of those files 
+ have to be added to the key by the caller. So, running the same 
+ calculation again starts with the irradiance cache left by the 
+ previous run instead of an empty one.
+ 
+ The files are handed to RTRACE directly (not copied), so several
+ processes append to the same file at once; RTRACE locks the ambient
+ file while writing it. As Radiance only does this on POSIX systems,
+ the cache is disabled on Windows.
+ 
+ The modification time of an entry is updated every time it is used, 
+ and the least recently used entries are evicted when the cache grows
+ beyond its maximum size.
+ */
+
+class AmbientCache {
+    
+private:
+    std::string dir; //!< The directory of the cache (empty means no cache)
+    uint64_t maxSize; //!< The maximum size of the cache, in bytes (0 means unbounded)
+    size_t prewarm; //!< Trace one of every these sensors before the rest on new files (0 means never)
+    
+public:
+    
+    //! Default constructor
+    /*!
+     The directory is read from EMP_CACHE (the cache is disabled
+     if it is not set), the maximum size (in megabytes) from
+     EMP_AMBIENT_CACHE_SIZE and the pre-warm stride from 
+     EMP_AMBIENT_PREWARM
+     
+     @author German Molina
+     */
+    AmbientCache();
+    
+    //! Constructor
+    /*!
+     @author German Molina
+     @param[in] theDir The directory of the cache (empty means no cache)
+     @param[in] theMaxSize The maximum size of the cache, in bytes (0 means unbounded)
+     @param[in] thePrewarm Trace one of every these sensors before the rest on new files (0 means never)
+     */
+    AmbientCache(std::string theDir, uint64_t theMaxSize, size_t thePrewarm);
+    
+    //! Checks whether the cache is enabled
+    /*!
+     @author German Molina
+     @return is enabled?
+     */
+    bool isEnabled() const;
+    
+    //! Retrieves the pre-warm stride
+    /*!
+     @author German Molina
+     @return One of every how many sensors are traced before the rest (0 means no pre-warm)
+     */
+    size_t getPrewarm() const;
+    
+    //! Calculates the key of an ambient file
+    /*!
+     @author German Molina
+     @param[in] octreeKey The key of the octree (see OctreeCache::getOctreeKey())
+     @param[in] options The RTRACE options
+     @return The key
+     */
+    static uint64_t getKey(uint64_t octreeKey, const RTraceOptions * options);
+    
+    //! Retrieves the name of the cache entry for a key
+    /*!
+     @author German Molina
+     @param[in] key The key
+     @return The file name
+     */
+    std::string getFileName(uint64_t key) const;
+    
+    //! Retrieves the ambient file to use for an octree and some options
+    /*!
+     The file is marked as recently used, but it might not exist yet
+     (RTRACE will create it)
+     
+     @author German Molina
+     @param[in] octreeName The name of the octree
+     @param[in] options The RTRACE options
+     @param[out] ambientFile The name of the ambient file
+     @param[in] dependencies The files referenced by the octree (e.g. .cal files), whose contents are added to the key
+     @return false if the cache is disabled or the octree (or one of its dependencies) could not be read
+     */
+    bool getAmbientFile(const std::string & octreeName, const RTraceOptions * options, std::string * ambientFile, const std::vector<std::string> * dependencies = nullptr) const;
+    
+    //! Removes the least recently used entries until the cache fits its maximum size
+    /*!
+     @author German Molina
+     @return The number of entries removed
+     */
+    size_t evict() const;
+};
@@ -26,116 +26,296 @@
 // by referring to the following article: "Robinson, D., Stone, A., Irradiation modeling
 //made simple � the cumulative sky approach and its applications, Proc. PLEA 2004, Eindhoven 2004."
 
-// THIS IS BASICALLY A COPY/PASTE/MODIFY OF THE ORIGINAL gencumulativesku.cpp FILE.
+// THE SKY MODEL IS THE ONE OF THE ORIGINAL gencumulativesky.cpp FILE (see GenCumSky/cSkyVault.cpp)
 
 #include "./gencumulativesky.h"
 
-#include "./GenCumSky/cSkyVault.h"
+#include <cmath>
+#include "tbb/tbb.h"
+#include "./reinhart.h"
+#include "./solar.h"
+#include "../common/utilities/io.h"
+#include "./GenCumSky/cPerezSkyModel.h"
 
-void genCumulativeSky(EmpModel * model, bool DoIlluminance, bool DoDiffuse, std::string filename)
+//! The geometry of the patches of a cumulative sky, stored as arrays
+/*!
+Only the sky patches are stored (i.e. the ground of the Reinhart sky is not included)
+*/
+class CumulativeSkyPatches {
+public:
+    int nPatches = 0; //!< The number of patches
+    std::vector<double> altitude = std::vector<double>(); //!< The altitude of the center, in radians
+    std::vector<double> azimuth = std::vector<double>(); //!< The azimuth of the center, in radians (from North, towards East)
+    std::vector<double> sinAlt = std::vector<double>(); //!< The sine of the altitude
+    std::vector<double> cosAlt = std::vector<double>(); //!< The cosine of the altitude
+    std::vector<double> sinAz = std::vector<double>(); //!< The sine of the azimuth
+    std::vector<double> cosAz = std::vector<double>(); //!< The cosine of the azimuth
+    std::vector<double> solidAngle = std::vector<double>(); //!< The solid angle
+};
+
+//! The radiance accumulated by a thread over a set of hours
+class CumulativeSkyAccumulator {
+public:
+    std::vector<double> radiance = std::vector<double>(); //!< The accumulated radiance of each patch
+    int sunUpHours = 0; //!< The number of hours with daylight
+};
+
+//! Builds the patches of a Reinhart sky
+/*!
+@author German Molina
+@param[in] mf The Reinhart subdivition scheme
+@param[out] patches The patches
+*/
+static void buildCumulativeSkyPatches(int mf, CumulativeSkyPatches * patches)
 {
-    double hourshift = 0;
+    const ReinhartTable * table = getReinhartTable(mf);
+    if (table == nullptr)
+        throw "Unsupported sky subdivition when calculating a cumulative sky";
     
-    cSkyVault sky;
-    double (*patchData)[5] = new double[145][5];
-    int i,j, counter;
+    const int n = (int)table->nBins - 1;
+    const double rowHeight = (M_PI / 2.0) / (7.0 * mf + 0.5);
     
-    double *CumSky;
+    patches->nPatches = n;
+    patches->altitude.resize(n);
+    patches->azimuth.resize(n);
+    patches->sinAlt.resize(n);
+    patches->cosAlt.resize(n);
+    patches->sinAz.resize(n);
+    patches->cosAz.resize(n);
+    patches->solidAngle.resize(n);
     
-    double rowdeltaaz[7]={12,12,15,15,20,30,60};
-    int rowdeltaalt=12;
-    
-    /* TRANSFORMED INTO ARGUMENTS TO FUNCTION */
-    //char * filename=argv[argc-1];
-    //double hourshift=0;
-    //bool DoIlluminance=false;
-    //bool DoDiffuse;
+    // skip the ground
+    for (int i = 0; i < n; i++) {
+        const size_t row = table->row[i + 1];
+        const double alt = (row + 0.5) * rowHeight;
+        const double az = 2.0 * M_PI * table->col[i + 1] / (double)reinhartRowPatches(row, mf);
+        
+        patches->altitude[i] = alt;
+        patches->azimuth[i] = az;
+        patches->sinAlt[i] = sin(alt);
+        patches->cosAlt[i] = cos(alt);
+        patches->sinAz[i] = sin(az);
+        patches->cosAz[i] = cos(az);
+        patches->solidAngle[i] = table->solidAngle[i + 1];
+    }
+}
+
+//! Adds the sky of one hour to an accumulator
+/*!
+Follows cSkyVault::CalculateSky(), except for the direct irradiance, which
+is taken straight from the direct normal irradiance of the weather.
+
+@author German Molina
+@param[in] data The weather of the hour
+@param[in] patches The patches of the sky
+@param[in] longitude The longitude, in radians (positive towards East)
+@param[in] DoIlluminance Calculate luminance instead of radiance
+@param[in] DoDiffuse Include the diffuse component
+@param[in] DoSun Add the direct component to the patch that contains the sun
+@param[in] sun The sun of the thread (with latitude and meridian already set)
+@param[in] skyModel The sky model of the thread
+@param[in] lv An auxiliar array, of nPatches elements
+@param[out] acc The accumulator
+*/
+static void accumulateCumulativeSkyHour(const HourlyData * data, const CumulativeSkyPatches * patches, double longitude, bool DoIlluminance, bool DoDiffuse, bool DoSun, cSun * sun, cPerezSkyModel * skyModel, double * lv, CumulativeSkyAccumulator * acc)
+{
+    if (!sun->SetDay(jdate(data->month, data->day)))
+        return;
     
-    cSkyVault::eSunType SunType;
-    cClimateFile::eClimateFileFormat ClimateFileFormat;
+    const double sunrise = sun->GetSunrise();
+    const double sunset = 2 * M_PI - sunrise;
     
-
-    /*
-    if (!(argc>1))
-    {
-        // User didn't give any command line arguments
-        fprintf(stderr,"gencumulativesky: Error - invalid input parameters\n");
-        goto USAGEERROR;
+    // if this is the first/last sun-up hour of the day, use the average position for while it is up
+    double hourangle = (data->hour + sun->TimeDiff(longitude)) * M_PI / 12;
+    if (fabs(hourangle - sunrise) < M_PI / 24) {
+        hourangle = (hourangle + M_PI / 24 + sunrise) / 2;
+    }else if (fabs(hourangle - sunset) < M_PI / 24) {
+        hourangle = (hourangle - M_PI / 24 + sunset) / 2;
     }
-     */
+    sun->SetHourAngle(hourangle);
     
-    std::cerr << "EMP_CORE WARNING: gencumulativesky is not yet working... Line: " << __LINE__ <<  " File:" << __FILE__ << std::endl;
+    double sunAlt, sunAz;
+    sun->GetPosition(sunAlt, sunAz);
     
-    // Get model location
-    Location * location = model->getLocation();
+    double Idh = data->diffuse_horizontal > 0 ? data->diffuse_horizontal : 0;
+    double Ibn = (sunAlt > 0 && data->direct_normal > 0) ? data->direct_normal : 0;
+    const double Ibh = Ibn * sin(sunAlt);
     
-    if(!location->hasWeather())
-        throw "Your model requires weather data to calculate a cumulative sky";
+    if (!skyModel->SetSkyConditions(Idh, Ibh, sun))
+        return;
+    
+    skyModel->GetRelativeLuminances(patches->nPatches, &patches->sinAlt[0], &patches->cosAlt[0], &patches->sinAz[0], &patches->cosAz[0], lv);
     
-    SunType=cSkyVault::NO_SUN;
+    double EIllum = 0;
+    for (int i = 0; i < patches->nPatches; i++)
+        EIllum += lv[i] * patches->solidAngle[i] * patches->sinAlt[i];
     
-    double latitude = location->getLatitude()*M_PI/180;
-    sky.SetLatitude(latitude);
+    if (Ibn > 1367) {
+        // Very large value for direct radiation - probably low solar altitude
+        Idh = Idh + Ibh;
+        Ibn = 0;
+    }
     
-    // EMP convention is latitude West (Santiago, Chile is about 73)... gencumulativesky is the other way around
-    double longitude = -location->getLongitude()*M_PI/180;
-    sky.SetLongitude(longitude);
+    if (EIllum > 0) {
+        acc->sunUpHours++;
+        
+        if (DoDiffuse) {
+            const double normFac = (DoIlluminance ? Idh * skyModel->GetDiffuseLumEffy(sunAlt, 0.0) : Idh) / EIllum;
+            for (int i = 0; i < patches->nPatches; i++)
+                acc->radiance[i] += lv[i] * normFac;
+        }
+    }
     
-    double meridian = 15.0 * location->getTimeZone()*M_PI/180;
-    sky.SetMeridian(meridian);
+    // add on direct radiation to patch with sun in
+    if (DoSun && Ibn > 0) {
+        const double cosSunAlt = cos(sunAlt);
+        const double sinSunAlt = sin(sunAlt);
+        double cosMinSunDist = -999;
+        int sunPatch = 0;
+        for (int i = 0; i < patches->nPatches; i++) {
+            const double cosSunDist = cosSunAlt * cos(fabs(sunAz - patches->azimuth[i])) * patches->cosAlt[i] + sinSunAlt * patches->sinAlt[i];
+            if (cosSunDist > cosMinSunDist) {
+                cosMinSunDist = cosSunDist;
+                sunPatch = i;
+            }
+        }
+        const double normFac = DoIlluminance ? Ibn * skyModel->GetBeamLumEffy(sunAlt, 0.0) : Ibn;
+        acc->radiance[sunPatch] += normFac / patches->solidAngle[sunPatch];
+    }
+}
+
+void calcCumulativeSky(Location * location, bool DoIlluminance, bool DoDiffuse, bool DoSun, int mf, std::vector<double> * cumulativeSky)
+{
+    if (!location->hasWeather())
+        throw "Your model requires weather data to calculate a cumulative sky";
     
-    ClimateFileFormat=cClimateFile::GLOBAL_DIFFUSE;
-    //ClimateFileFormat=cClimateFile::DIRECTHORIZONTAL_DIFFUSE; // We will use this.
+    CumulativeSkyPatches patches = CumulativeSkyPatches();
+    buildCumulativeSkyPatches(mf, &patches);
     
+    // EMP convention is longitude West (Santiago, Chile is about 73)... gencumulativesky is the other way around
+    const double latitude = location->getLatitude() * M_PI / 180;
+    const double longitude = -location->getLongitude() * M_PI / 180;
+    const double meridian = 15.0 * location->getTimeZone() * M_PI / 180;
+    const size_t nHours = location->getWeatherSize();
     
-    sky.loadModelWeather(model, ClimateFileFormat);
+    CumulativeSkyAccumulator identity = CumulativeSkyAccumulator();
+    identity.radiance.resize(patches.nPatches, 0.0);
     
+    // Deterministic, so that results do not depend on how the hours were split among threads
+    CumulativeSkyAccumulator total = tbb::parallel_deterministic_reduce(
+        tbb::blocked_range<size_t>(0, nHours, 24), identity,
+        [&](const tbb::blocked_range<size_t> &r, CumulativeSkyAccumulator acc) -> CumulativeSkyAccumulator {
+            cSun sun = cSun(latitude);
+            sun.SetMeridian(meridian);
+            cPerezSkyModel skyModel = cPerezSkyModel();
+            std::vector<double> lv = std::vector<double>(patches.nPatches);
+            
+            for (size_t i = r.begin(); i != r.end(); i++)
+                accumulateCumulativeSkyHour(location->getHourlyData(i), &patches, longitude, DoIlluminance, DoDiffuse, DoSun, &sun, &skyModel, &lv[0], &acc);
+            
+            return acc;
+        },
+        [](CumulativeSkyAccumulator a, const CumulativeSkyAccumulator &b) -> CumulativeSkyAccumulator {
+            for (size_t i = 0; i < a.radiance.size(); i++)
+                a.radiance[i] += b.radiance[i];
+            a.sunUpHours += b.sunUpHours;
+            return a;
+        }
+    );
     
+    // if we are doing the annual irradiance output the total, for illuminance output the mean
+    const double norm = (DoIlluminance && total.sunUpHours > 0) ? (double)total.sunUpHours : 1.0;
     
+    cumulativeSky->assign(patches.nPatches + 1, 0.0);
+    for (int i = 0; i < patches.nPatches; i++)
+        (*cumulativeSky)[i + 1] = total.radiance[i] / norm;
+}
+
+bool writeCumulativeSkyCal(const std::vector<double> * cumulativeSky, std::string filename)
+{
+    const double rowdeltaaz[7] = { 12,12,15,15,20,30,60 };
+    const int rowdeltaalt = 12;
     
-    sky.CalculateSky(SunType, DoDiffuse, DoIlluminance, hourshift);
+    if (cumulativeSky->size() != nReinhartBins(1)) {
+        WARN(msg, "Only cumulative skies with MF=1 can be written as a .cal file");
+        return false;
+    }
     
-    CumSky=sky.GetCumulativeSky();
-    sky.GetPatchDetails(patchData);
+    // skip the ground
+    const double * CumSky = &(*cumulativeSky)[1];
     
-    // Open file
     // We use this method to keep consistency with the original C-like code
+    FILE * calFile = fopen(&filename[0], "w");
+    if (calFile == NULL) {
+        WARN(msg, "Could not open file " + filename + " for writing the cumulative sky");
+        return false;
+    }
     
-    FILE * calFile;
-    calFile = fopen (&filename[0],"w");
-    
-    fprintf(calFile,"{ This .cal file was generated automatically by gencumulativesky within Emp_core }\n");
-    fprintf(calFile,"{ ");
-    //for (j=0; j<argc; j++)
-    //    printf("%s ",argv[j]);
-    fprintf(calFile," }\n\n");
-    fprintf(calFile,"skybright=");
-    for (j=0; j<7; j++)
+    fprintf(calFile, "{ This .cal file was generated automatically by gencumulativesky within Emp_core }\n");
+    fprintf(calFile, "{  }\n\n");
+    fprintf(calFile, "skybright=");
+    for (int j = 0; j < 7; j++)
     {
-        fprintf(calFile,"row%d+",j);
+        fprintf(calFile, "row%d+", j);
     }
-    fprintf(calFile,"row7;\n\n");
+    fprintf(calFile, "row7;\n\n");
     
-    counter=0;
-    for (j=0; j<7; j++)
+    int counter = 0;
+    for (int j = 0; j < 7; j++)
     {
         // note first patch split into two parts - first part (> 0 deg) and last patch (<360)
-        fprintf(calFile,"row%d=if(and(alt-%d, %d-alt),select(floor(0.5+az/%5.2f)+1,\n",j,j*rowdeltaalt,(j+1)*rowdeltaalt,rowdeltaaz[j]);
-        for (i=0+counter; i<counter+360/int(rowdeltaaz[j]); i++)
+        fprintf(calFile, "row%d=if(and(alt-%d, %d-alt),select(floor(0.5+az/%5.2f)+1,\n", j, j*rowdeltaalt, (j + 1)*rowdeltaalt, rowdeltaaz[j]);
+        for (int i = 0 + counter; i < counter + 360 / int(rowdeltaaz[j]); i++)
         {
-            fprintf(calFile,"\t%f,\n",CumSky[i]);
+            fprintf(calFile, "\t%f,\n", CumSky[i]);
         }
-        fprintf(calFile,"\t%f),0);\n\n",CumSky[counter]);
-        counter+=(int)(360/rowdeltaaz[j]);
+        fprintf(calFile, "\t%f),0);\n\n", CumSky[counter]);
+        counter += (int)(360 / rowdeltaaz[j]);
     }
     
-    fprintf(calFile,"row7=if(alt-84,%f,0);\n\n",CumSky[144]);
+    fprintf(calFile, "row7=if(alt-84,%f,0);\n\n", CumSky[144]);
     
-    fprintf(calFile,"alt=asin(Dz)*180/PI;\n\n");
+    fprintf(calFile, "alt=asin(Dz)*180/PI;\n\n");
     
-    fprintf(calFile,"az=if(azi,azi,azi+360);\n");
-    fprintf(calFile,"azi=atan2(Dx,Dy)*180/PI;\n\n");
+    fprintf(calFile, "az=if(azi,azi,azi+360);\n");
+    fprintf(calFile, "azi=atan2(Dx,Dy)*180/PI;\n\n");
     
     fclose(calFile);
+    return true;
 }
 
+bool cumulativeSkyExposure(const ColorMatrix * DC, const std::vector<double> * cumulativeSky, Matrix * result)
+{
+    const size_t nbins = cumulativeSky->size();
+    if (DC->ncols() != nbins) {
+        WARN(msg, "Size mismatch between Daylight Coefficients and cumulative sky");
+        return false;
+    }
+    
+    // The sky is white
+    ColorMatrix skyVector = ColorMatrix(nbins, 1);
+    for (size_t bin = 0; bin < nbins; bin++) {
+        const float v = (float)(*cumulativeSky)[bin];
+        skyVector.r()->setElement(bin, 0, v);
+        skyVector.g()->setElement(bin, 0, v);
+        skyVector.b()->setElement(bin, 0, v);
+    }
+    
+    const size_t nsensors = DC->nrows();
+    ColorMatrix aux = ColorMatrix(nsensors, 1);
+    DC->multiplyToColumn(&skyVector, 0, &aux);
+    
+    result->resize(nsensors, 1);
+    aux.calcIrradiance(result);
+    
+    return true;
+}
+
+void genCumulativeSky(EmpModel * model, bool DoIlluminance, bool DoDiffuse, std::string filename)
+{
+    std::vector<double> cumulativeSky = std::vector<double>();
+    calcCumulativeSky(model->getLocation(), DoIlluminance, DoDiffuse, false, 1, &cumulativeSky);
+    
+    if (!writeCumulativeSkyCal(&cumulativeSky, filename))
+        throw "Impossible to write cumulative sky file";
+}
@@ -27,8 +27,59 @@
 
 #pragma once
 
+#include <vector>
 #include "../emp_model/emp_model.h"
+#include "./color_matrix.h"
 
+//! Calculates a cumulative sky from the weather of a Location
+/*!
+The hours of the weather are processed in parallel, each thread accumulating
+the radiance of its hours into its own set of patches, which are added together
+at the end. The weather is read directly from the Location.
 
+The result has one element per Reinhart patch, following the same ordering
+used by rcontrib (i.e. element 0 is the ground, which is always zero). With
+mf = 1, elements 1 to 145 are the patches of the original GenCumulativeSky.
+
+@author German Molina
+@param[in] location The location, with its weather
+@param[in] DoIlluminance Calculate the mean sky luminance (instead of the total radiance)
+@param[in] DoDiffuse Include the diffuse component
+@param[in] DoSun Add the direct component to the patch that contains the sun
+@param[in] mf The Reinhart subdivition scheme
+@param[out] cumulativeSky The resulting cumulative sky
+*/
+void calcCumulativeSky(Location * location, bool DoIlluminance, bool DoDiffuse, bool DoSun, int mf, std::vector<double> * cumulativeSky);
+
+//! Writes a cumulative sky as a .cal file to be used with a brightfunc
+/*!
+@author German Molina
+@param[in] cumulativeSky The cumulative sky, calculated with mf = 1 (see calcCumulativeSky())
+@param[in] filename The name of the file to write
+@return success
+*/
+bool writeCumulativeSkyCal(const std::vector<double> * cumulativeSky, std::string filename);
+
+//! Exposes a set of sensors to a cumulative sky, using their Daylight Coefficients
+/*!
+Replaces a ray-tracing pass over an octree containing the cumulative sky by
+a single matrix-vector product.
+
+@author German Molina
+@param[in] DC The Daylight Coefficients (one row per sensor, one column per Reinhart patch)
+@param[in] cumulativeSky The cumulative sky (see calcCumulativeSky())
+@param[out] result The resulting vector (one row per sensor)
+@return success
+*/
+bool cumulativeSkyExposure(const ColorMatrix * DC, const std::vector<double> * cumulativeSky, Matrix * result);
+
+//! Calculates the cumulative sky (without sun) of a model and writes it as a .cal file
+/*!
+@author German Molina
+@param[in] model The model
+@param[in] DoIlluminance Calculate the mean sky luminance (instead of the total radiance)
+@param[in] DoDiffuse Include the diffuse component
+@param[in] filename The name of the .cal file to write
+*/
 void genCumulativeSky(EmpModel * model, bool DoIlluminance, bool DoDiffuse, std::string filename);
 
@@ -80,9 +80,12 @@ public:
     COLOR        grefl = {.2f, .2f, .2f};        /* ground reflectance */
     
     int        nskypatch;        /* number of Reinhart patches */
-    float        *rh_palt;        /* sky patch altitudes (radians) */
-    float        *rh_pazi;        /* sky patch azimuths (radians) */
-    float        *rh_dom;        /* sky patch solid angle (sr) */
+    float        *rh_palt = NULL;        /* sky patch altitudes (radians) */
+    float        *rh_pazi = NULL;        /* sky patch azimuths (radians) */
+    float        *rh_dom = NULL;        /* sky patch solid angle (sr) */
+    double       *rh_coszen = NULL;     /* cosine of the sky patch zenith angles */
+    double       *rh_sinzen = NULL;     /* sine of the sky patch zenith angles */
+    bool         owns_patches = true;   /* were the patch arrays allocated by this object? */
     
     
     
@@ -120,10 +123,30 @@ public:
 
     ~GenDayMtx()
     {
+        // Patches borrowed from another GenDayMtx are freed by their owner
+        if(!owns_patches)
+            return;
+        
         // Free
         free(rh_palt);// = (float *)malloc(sizeof(float)*nskypatch);
         free(rh_pazi);// = (float *)malloc(sizeof(float)*nskypatch);
         free(rh_dom);// = (float *)malloc(sizeof(float)*nskypatch);
+        free(rh_coszen);
+        free(rh_sinzen);
+    }
+    
+    /* Use the sky patches of another (initialized) GenDayMtx instead of calling rh_init() */
+    void
+    share_patches(const GenDayMtx * base)
+    {
+        rhsubdiv = base->rhsubdiv;
+        nskypatch = base->nskypatch;
+        rh_palt = base->rh_palt;
+        rh_pazi = base->rh_pazi;
+        rh_dom = base->rh_dom;
+        rh_coszen = base->rh_coszen;
+        rh_sinzen = base->rh_sinzen;
+        owns_patches = false;
     }
     
   
@@ -262,10 +285,27 @@ public:
     /* Compute sky patch radiance values (modified by GW) */
     void
     ComputeSky(float *parr)
+    {
+        if (!ComputeSkyParam()) {			/* 0 sky component? */
+            memset(parr, 0, sizeof(float)*3*nskypatch);
+            return;
+        }
+        /* Compute ground radiance (include solar contribution if any) */
+        ComputeGround(parr);
+
+        /* Calculate sky patch luminance values */
+        CalcSkyPatchLumin(parr);
+
+        /* Calculate relative horizontal illuminance, and normalize */
+        NormalizeSky(parr, (float)CalcRelHorzIllum(parr));
+    }
+
+    /* Compute the illuminances and Perez parameters of the current sun and */
+    /* weather (first part of ComputeSky). Returns 0 if there is no sky component */
+    int
+    ComputeSkyParam()
     {
         int index;			/* Category index */
-        float norm_diff_illum;		/* Normalized diffuse illuimnance */
-        int i;
         
         /* Calculate atmospheric precipitable water content */
         apwc = CalcPrecipWater(dew_point);
@@ -297,25 +337,30 @@ public:
         diff_illum = diff_irrad * CalcDiffuseIllumRatio(index);
         dir_illum = dir_irrad * CalcDirectIllumRatio(index);
    
-        if (bright(skycolor) <= 1e-4) {			/* 0 sky component? */
-            memset(parr, 0, sizeof(float)*3*nskypatch);
-            return;
-        }
-        /* Compute ground radiance (include solar contribution if any) */
+        if (bright(skycolor) <= 1e-4)			/* 0 sky component? */
+            return 0;
+
+        /* Calculate Perez sky model parameters */
+        CalcPerezParam(sun_zenith, sky_clearness, sky_brightness, index);
+        return 1;
+    }
+
+    /* Compute ground radiance (include solar contribution if any) */
+    void
+    ComputeGround(float *parr)
+    {
         parr[0] = diff_illum;
         if (altitude > 0)
             parr[0] += dir_illum * (float)sin(altitude);
         parr[2] = parr[1] = parr[0] *= (1.0f/ (float)PI/ (float)WHTEFFICACY);
         multcolor(parr, grefl);
+    }
 
-        /* Calculate Perez sky model parameters */
-        CalcPerezParam(sun_zenith, sky_clearness, sky_brightness, index);
-
-        /* Calculate sky patch luminance values */
-        CalcSkyPatchLumin(parr);
-
-        /* Calculate relative horizontal illuminance */
-        norm_diff_illum = (float)CalcRelHorzIllum(parr);
+    /* Turn relative sky patch luminances into absolute radiances (last part of ComputeSky) */
+    void
+    NormalizeSky(float *parr, float norm_diff_illum)
+    {
+        int i;
 
         /* Check for zero sky -- make uniform in that case */
         if (norm_diff_illum <= FTINY) {
@@ -411,8 +456,11 @@ public:
         rh_palt = (float *)malloc(sizeof(float)*nskypatch);
         rh_pazi = (float *)malloc(sizeof(float)*nskypatch);
         rh_dom = (float *)malloc(sizeof(float)*nskypatch);
+        rh_coszen = (double *)malloc(sizeof(double)*nskypatch);
+        rh_sinzen = (double *)malloc(sizeof(double)*nskypatch);
         
-        if ((rh_palt == NULL) | (rh_pazi == NULL) | (rh_dom == NULL)) {
+        if ((rh_palt == NULL) | (rh_pazi == NULL) | (rh_dom == NULL) |
+            (rh_coszen == NULL) | (rh_sinzen == NULL)) {
             fprintf(stderr, "%s: out of memory in rh_init()\n", gendaymtxname);
             exit(1);
         }
@@ -435,6 +483,12 @@ public:
                 rh_dom[p++] = dom;
             }
         }
+        /* zenith angles do not change with the sun; cache their trigonometry */
+        for (p = 0; p < nskypatch; p++) {
+            const double zsa = PI * 0.5 - rh_palt[p];
+            rh_coszen[p] = cos(zsa);
+            rh_sinzen[p] = sin(zsa);
+        }
         return nskypatch;
     #undef NROW
     }
@@ -800,5 +854,48 @@ public:
         }
     }
 
+    /* Same as CalcSkyPatchLumin() and CalcRelHorzIllum(), but for several */
+    /* timesteps at once. Each timestep has its own sun (cos_sz, sin_sz, azi) */
+    /* and Perez parameters (par[0..4], one array per parameter). The */
+    /* relative luminance of patch i in timestep t goes to lum[i*nsteps + t], */
+    /* and the relative horizontal illuminance of timestep t to rh_illum[t] */
+    void CalcSkyPatchLuminBatch( int nsteps, const double *cos_sz,
+            const double *sin_sz, const double *azi,
+            const double * const par[5], float *lum, double *rh_illum )
+    {
+        int i, t;
+
+        for (t = 0; t < nsteps; t++)
+            rh_illum[t] = 0.0;
+
+        /* One patch at a time, so the inner loop runs over contiguous */
+        /* arrays of timesteps and can be vectorised */
+        for (i = 1; i < nskypatch; i++)
+        {
+            const double coszen = rh_coszen[i];
+            const double sinzen = rh_sinzen[i];
+            const double pazi = rh_pazi[i];
+            const double patch_cos = rh_cos(i);
+            const double patch_dom = rh_dom[i];
+            float *row = lum + (size_t)i*nsteps;
+
+            for (t = 0; t < nsteps; t++)
+            {
+                /* Sun-sky point angle (Equation 8-20) */
+                const double sspa = acos(cos_sz[t] * coszen + sin_sz[t] *
+                        sinzen * cos(pazi - azi[t]));
+                const double cos_sspa = cos(sspa);
+
+                /* Patch luminance (see CalcRelLuminance) */
+                float lv = (float)((1.0 + par[0][t] * exp(par[1][t] / coszen)) *
+                        (1.0 + par[2][t] * exp(par[3][t] * sspa) +
+                        par[4][t] * cos_sspa * cos_sspa));
+                if (lv < 0) lv = 0;
+                row[t] = lv;
+                rh_illum[t] += lv * patch_cos * patch_dom;
+            }
+        }
+    }
+
 };
 
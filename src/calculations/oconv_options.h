@@ -27,6 +27,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define OCONV_INCLUDE_WINDOWS "include_windows"
 #define OCONV_USE_BLACK_GEOMETRY "black_geometry"
 #define OCONV_LIGHTS_ON "lights_on"
+#define OCONV_INSTANCE_COMPONENTS "instance_components"
+#define OCONV_FREEZE "freeze"
+#define OCONV_MESH_TRIANGLES "mesh_triangles"
+#define OCONV_USE_CACHE "use_cache"
+#define OCONV_OPTIMIZE_GEOMETRY "optimize_geometry"
 
 
 class OconvOptions : public OptionSet {
@@ -43,6 +48,11 @@ public:
     addOption(OCONV_INCLUDE_WINDOWS, true);
     addOption(OCONV_USE_BLACK_GEOMETRY, false);
     addOption(OCONV_LIGHTS_ON, false);
+    addOption(OCONV_INSTANCE_COMPONENTS, false);
+    addOption(OCONV_FREEZE, false);
+    addOption(OCONV_MESH_TRIANGLES, false);
+    addOption(OCONV_USE_CACHE, true);
+    addOption(OCONV_OPTIMIZE_GEOMETRY, false);
   };
 };
 
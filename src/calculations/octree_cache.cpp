@@ -0,0 +1,288 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+#include "./octree_cache.h"
+#include "../config_constants.h"
+#include "../os_definitions.h"
+#include "../common/utilities/file.h"
+#include "../taskmanager/mutexes.h"
+
+#ifdef WIN
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <utime.h>
+#endif
+
+//! The size of the chunks read when hashing files
+#define EMP_HASH_BUFFER_SIZE 65536
+
+/* Keys of the octrees built during this run */
+static std::map<std::string, uint64_t> octreeKeys = std::map<std::string, uint64_t>();
+
+//! An entry of a cache, used for eviction
+struct CacheEntry {
+    std::string name; //!< The name of the file
+    uint64_t size; //!< The size of the file
+    time_t lastUse; //!< The last time the file was used
+};
+
+//! Lists the files in a directory whose names have a certain prefix and extension
+/*!
+ @author German Molina
+ @param[in] dir The directory
+ @param[in] prefix The prefix of the names (e.g. "octree_")
+ @param[in] extension The extension of the names (e.g. ".oct")
+ @param[out] entries The entries found
+ */
+static void listCacheFiles(const std::string & dir, const std::string & prefix, const std::string & extension, std::vector<CacheEntry> * entries)
+{
+    std::vector<std::string> names = std::vector<std::string>();
+#ifdef WIN
+    struct _finddata_t data;
+    std::string pattern = dir + "/" + prefix + "*" + extension;
+    intptr_t handle = _findfirst(&pattern[0], &data);
+    if(handle == -1)
+        return;
+    do {
+        names.push_back(dir + "/" + data.name);
+    } while(_findnext(handle, &data) == 0);
+    _findclose(handle);
+#else
+    DIR * d = opendir(&dir[0]);
+    if(d == nullptr)
+        return;
+    struct dirent * ent;
+    while((ent = readdir(d)) != nullptr){
+        std::string name = std::string(ent->d_name);
+        if(name.size() > prefix.size() + extension.size() && name.compare(0, prefix.size(), prefix) == 0 && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+            names.push_back(dir + "/" + name);
+    }
+    closedir(d);
+#endif
+    
+    for(auto & name : names){
+        struct stat status;
+        if(stat(&name[0], &status) != 0)
+            continue;
+        entries->push_back({name, (uint64_t)status.st_size, status.st_mtime});
+    }
+}
+
+//! Copies a file
+/*!
+ @author German Molina
+ @param[in] from The source
+ @param[in] to The destination
+ @return success
+ */
+static bool copyFile(const std::string & from, const std::string & to)
+{
+    std::ifstream in(from, std::ios::binary);
+    if(!in)
+        return false;
+    std::ofstream out(to, std::ios::binary);
+    if(!out)
+        return false;
+    out << in.rdbuf();
+    return (bool)out;
+}
+
+//! Creates a hard link to a file, or a copy if that is not possible
+/*!
+ @author German Molina
+ @param[in] from The source
+ @param[in] to The destination
+ @return success
+ */
+static bool linkFile(const std::string & from, const std::string & to)
+{
+#ifndef WIN
+    if(link(&from[0], &to[0]) == 0)
+        return true;
+#endif
+    return copyFile(from, to);
+}
+
+OctreeCache::OctreeCache()
+{
+    const char * d = std::getenv(EMP_CACHE);
+    dir = (d == nullptr) ? "" : d;
+    
+    const char * size = std::getenv(EMP_OCTREE_CACHE_SIZE);
+    const uint64_t megabytes = (size == nullptr) ? EMP_DEFAULT_OCTREE_CACHE_SIZE : std::strtoull(size, nullptr, 10);
+    maxSize = megabytes * 1024 * 1024;
+}
+
+OctreeCache::OctreeCache(std::string theDir, uint64_t theMaxSize)
+{
+    dir = theDir;
+    maxSize = theMaxSize;
+}
+
+bool OctreeCache::isEnabled() const
+{
+    return !dir.empty();
+}
+
+std::string OctreeCache::getFileName(uint64_t key) const
+{
+    std::stringstream name;
+    name << dir << "/octree_" << std::hex << std::setw(16) << std::setfill('0') << key << ".oct";
+    return name.str();
+}
+
+bool OctreeCache::fetch(uint64_t key, const std::string & octreeName) const
+{
+    if(!isEnabled())
+        return false;
+    
+    std::string cacheFile = getFileName(key);
+    if(!fexists(cacheFile))
+        return false;
+    
+    remove(&octreeName[0]);
+    if(!linkFile(cacheFile, octreeName))
+        return false;
+    
+    // Mark as recently used
+    utime(&cacheFile[0], nullptr);
+    return true;
+}
+
+bool OctreeCache::store(uint64_t key, const std::string & octreeName) const
+{
+    if(!isEnabled() || !createdir(dir))
+        return false;
+    
+    // Through a temporary file, so other processes 
+    // never read a half written octree
+    std::string cacheFile = getFileName(key);
+    std::string tmpFile = cacheFile + "." + std::to_string(GETPID()) + "_" + std::to_string((size_t)&octreeName) + ".tmp";
+    if(!linkFile(octreeName, tmpFile) || std::rename(&tmpFile[0], &cacheFile[0]) != 0){
+        remove(&tmpFile[0]);
+        return false;
+    }
+    
+    evict();
+    return true;
+}
+
+size_t OctreeCache::evict() const
+{
+    if(!isEnabled())
+        return 0;
+    
+    return evictCacheFiles(dir, "octree_", ".oct", maxSize);
+}
+
+size_t evictCacheFiles(const std::string & dir, const std::string & prefix, const std::string & extension, uint64_t maxSize)
+{
+    if(maxSize == 0)
+        return 0;
+    
+    std::vector<CacheEntry> entries = std::vector<CacheEntry>();
+    listCacheFiles(dir, prefix, extension, &entries);
+    
+    uint64_t total = 0;
+    for(auto & entry : entries)
+        total += entry.size;
+    
+    if(total <= maxSize)
+        return 0;
+    
+    // Oldest first
+    std::sort(entries.begin(), entries.end(), [](const CacheEntry & a, const CacheEntry & b){
+        return a.lastUse < b.lastUse;
+    });
+    
+    size_t nRemoved = 0;
+    for(auto & entry : entries){
+        if(total <= maxSize)
+            break;
+        if(remove(&entry.name[0]) == 0){
+            total -= entry.size;
+            nRemoved++;
+        }
+    }
+    return nRemoved;
+}
+
+void OctreeCache::hashBytes(const void * data, size_t size, uint64_t * hash)
+{
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    for(size_t i = 0; i < size; i++){
+        *hash ^= bytes[i];
+        *hash *= 1099511628211ULL;
+    }
+}
+
+bool OctreeCache::hashFile(const std::string & filename, uint64_t * hash)
+{
+    FOPEN(file, &filename[0], "rb");
+    if(file == nullptr)
+        return false;
+    
+    std::vector<char> buffer = std::vector<char>(EMP_HASH_BUFFER_SIZE);
+    size_t n;
+    while((n = fread(&buffer[0], 1, buffer.size(), file)) > 0)
+        hashBytes(&buffer[0], n, hash);
+    
+    fclose(file);
+    return true;
+}
+
+void OctreeCache::setOctreeKey(const std::string & octreeName, uint64_t key)
+{
+    tbb::mutex::scoped_lock lock(octreeKeysMutex);
+    octreeKeys[octreeName] = key;
+}
+
+void OctreeCache::clearOctreeKey(const std::string & octreeName)
+{
+    tbb::mutex::scoped_lock lock(octreeKeysMutex);
+    octreeKeys.erase(octreeName);
+}
+
+bool OctreeCache::getOctreeKey(const std::string & octreeName, uint64_t * key)
+{
+    {
+        tbb::mutex::scoped_lock lock(octreeKeysMutex);
+        auto found = octreeKeys.find(octreeName);
+        if(found != octreeKeys.end()){
+            *key = found->second;
+            return true;
+        }
+    }
+    
+    *key = 14695981039346656037ULL;
+    return hashFile(octreeName, key);
+}
@@ -0,0 +1,174 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+//! The version of the octree cache keys... change it to invalidate old entries
+#define EMP_OCTREE_CACHE_VERSION 1
+
+//! A content-addressed, size-bounded store of octrees
+/*!
+ Octrees are stored in the cache directory (see EMP_CACHE) as
+ 'octree_<key>.oct', where the key is a hash of everything that was
+ fed to OCONV: the scene, the options and the octrees it depends on
+ (see cachedOconv()).
+ 
+ Entries are handed out as hard links (or copies, when links are not
+ possible), so a Task can remove() its octree without touching the 
+ cache. The modification time of an entry is updated every time it 
+ is used, and the least recently used entries are evicted when the
+ cache grows beyond its maximum size.
+ */
+
+class OctreeCache {
+    
+private:
+    std::string dir; //!< The directory of the cache (empty means no cache)
+    uint64_t maxSize; //!< The maximum size of the cache, in bytes (0 means unbounded)
+    
+public:
+    
+    //! Default constructor
+    /*!
+     The directory is read from EMP_CACHE (the cache is disabled
+     if it is not set) and the maximum size (in megabytes) from 
+     EMP_OCTREE_CACHE_SIZE
+     
+     @author German Molina
+     */
+    OctreeCache();
+    
+    //! Constructor
+    /*!
+     @author German Molina
+     @param[in] theDir The directory of the cache (empty means no cache)
+     @param[in] theMaxSize The maximum size of the cache, in bytes (0 means unbounded)
+     */
+    OctreeCache(std::string theDir, uint64_t theMaxSize);
+    
+    //! Checks whether the cache is enabled
+    /*!
+     @author German Molina
+     @return is enabled?
+     */
+    bool isEnabled() const;
+    
+    //! Retrieves the name of the cache entry for a key
+    /*!
+     @author German Molina
+     @param[in] key The key
+     @return The file name
+     */
+    std::string getFileName(uint64_t key) const;
+    
+    //! Retrieves an octree from the cache
+    /*!
+     @author German Molina
+     @param[in] key The key of the octree
+     @param[in] octreeName The name of the octree to create
+     @return true if the octree was in the cache
+     */
+    bool fetch(uint64_t key, const std::string & octreeName) const;
+    
+    //! Stores an octree in the cache, evicting old entries if needed
+    /*!
+     @author German Molina
+     @param[in] key The key of the octree
+     @param[in] octreeName The octree to store
+     @return success
+     */
+    bool store(uint64_t key, const std::string & octreeName) const;
+    
+    //! Removes the least recently used entries until the cache fits its maximum size
+    /*!
+     @author German Molina
+     @return The number of entries removed
+     */
+    size_t evict() const;
+    
+    //! Adds the contents of a file to a 64-bit FNV-1a hash
+    /*!
+     @author German Molina
+     @param[in] filename The name of the file
+     @param[in,out] hash The hash
+     @return false if the file could not be read
+     */
+    static bool hashFile(const std::string & filename, uint64_t * hash);
+    
+    //! Adds some bytes to a 64-bit FNV-1a hash
+    /*!
+     @author German Molina
+     @param[in] data The bytes
+     @param[in] size The number of bytes
+     @param[in,out] hash The hash
+     */
+    static void hashBytes(const void * data, size_t size, uint64_t * hash);
+    
+    //! Registers the key of an octree built during this run
+    /*!
+     This allows octrees built on top of it to be keyed
+     without reading it again
+     
+     @author German Molina
+     @param[in] octreeName The name of the octree
+     @param[in] key The key
+     */
+    static void setOctreeKey(const std::string & octreeName, uint64_t key);
+    
+    //! Forgets the key of an octree registered through setOctreeKey()
+    /*!
+     This is needed when the octree is rebuilt without a key, so 
+     the old one is not used for the new contents
+     
+     @author German Molina
+     @param[in] octreeName The name of the octree
+     */
+    static void clearOctreeKey(const std::string & octreeName);
+    
+    //! Retrieves the key of an octree
+    /*!
+     If the octree was not registered through setOctreeKey(), 
+     its contents are hashed
+     
+     @author German Molina
+     @param[in] octreeName The name of the octree
+     @param[out] key The key
+     @return false if the octree could not be read
+     */
+    static bool getOctreeKey(const std::string & octreeName, uint64_t * key);
+};
+
+//! Removes the least recently used files of a cache directory until they fit a maximum size
+/*!
+ Only the files whose names have the given prefix and extension are
+ considered, so several caches can share a directory. 
+ 
+ @author German Molina
+ @param[in] dir The directory
+ @param[in] prefix The prefix of the names of the files (e.g. "octree_")
+ @param[in] extension The extension of the names of the files (e.g. ".oct")
+ @param[in] maxSize The maximum size, in bytes (0 means unbounded)
+ @return The number of files removed
+ */
+size_t evictCacheFiles(const std::string & dir, const std::string & prefix, const std::string & extension, uint64_t maxSize);
@@ -26,9 +26,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "./radiance.h"
 #include "../config_constants.h"
 #include "../common/utilities/stringutils.h"
+#include "../common/utilities/file.h"
 #include "tbb/tbb.h"
 #include "../os_definitions.h"
 #include "./gendaymtx.h"
+#include "../taskmanager/mutexes.h"
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
 
 
 /*
@@ -59,10 +67,44 @@ extern "C" {
 
 #include "reinhart.h"
 
-bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, std::vector<RAY> * rays, int mf,const char * modifier, bool vMode, ColorMatrix * result)
+//! Builds the name of a temporary file next to an octree
+/*!
+The process ID and a counter make it unique, even when several 
+threads or processes trace the same octree at once
+
+@author German Molina
+@param[in] octname The name of the octree
+@param[in] extension The extension of the file (including the dot)
+@return The name of the file
+*/
+static std::string getTemporaryFileName(const char * octname, const char * extension)
+{
+    static std::atomic<size_t> counter(0);
+    return std::string(octname) + "." + std::to_string(GETPID()) + "." + std::to_string(counter++) + extension;
+}
+
+//! The number of RCONTRIB processes running at the moment
+static std::atomic<unsigned int> runningRContribs(0);
+
+unsigned int rcontribProcesses(unsigned int running)
+{
+    const char * n = std::getenv(EMP_RCONTRIB_PROCESSES);
+    if (n != nullptr) {
+        const unsigned long processes = std::strtoul(n, nullptr, 10);
+        return processes > 0 ? (unsigned int)processes : 1;
+    }
+    
+    // hardware_concurrency() is 0 when it is not known
+    const unsigned int nCores = std::thread::hardware_concurrency();
+    if (nCores == 0 || running == 0)
+        return 1;
+    return std::max(1u, nCores / running);
+}
+
+bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, SensorSet * rays, int mf,const char * modifier, bool vMode, ColorMatrix * result)
 {
     // Build the command
-    std::string rgbfile = octname + std::to_string(rand()) + std::string(".mtx");
+    std::string rgbfile = getTemporaryFileName(octname, ".mtx");
     
     std::string mode = "";
     if (imm_irrad) {
@@ -75,17 +117,26 @@ bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool
     std::string v = vMode ? " -V " : "";
     std::string ropts = options->getInlineVersion();
     
-    std::string command = "rcontrib -h " + v + mode + ropts + " -e MF:"+ std::to_string(mf) + " -f reinhart.cal -b rbin -bn Nrbins -m " + std::string(modifier) + " " + octname + " > " + rgbfile ;
+    // Share the cores with the other RCONTRIB calls running at 
+    // once (Radiance does not support -n on Windows)
+    std::string cores = "";
+#ifndef WIN
+    const unsigned int nProcesses = rcontribProcesses(++runningRContribs);
+    if (nProcesses > 1)
+        cores = " -n " + std::to_string(nProcesses);
+#endif
+    
+    std::string command = "rcontrib -h " + cores + v + mode + ropts + " -e MF:"+ std::to_string(mf) + " -f reinhart.cal -b rbin -bn Nrbins -m " + std::string(modifier) + " " + octname + " > " + rgbfile ;
     
     // Create the file
     FILE *rt = POPEN(&command[0], "w");
     
-    
-    for(auto ray : *rays){
-        fprintf(rt, "%f %f %f %f %f %f\n", ray.rorg[0], ray.rorg[1], ray.rorg[2], ray.rdir[0], ray.rdir[1], ray.rdir[2]);
-    }
+    rays->write(rt);
     
     PCLOSE(rt);
+#ifndef WIN
+    runningRContribs--;
+#endif
     
     std::ifstream in;
 #ifdef WIN
@@ -149,10 +200,10 @@ bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool
     return true;
 }
 
-bool rtrace(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, std::string amb, std::vector<RAY> * rays, ColorMatrix * result)
+bool rtrace(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, std::string amb, SensorSet * rays, ColorMatrix * result)
 {
     // Build the command
-    std::string rgbfile = std::string(octname) +".rgb";
+    std::string rgbfile = getTemporaryFileName(octname, ".rgb");
     
     std::string mode;
     if (imm_irrad) {
@@ -169,10 +220,7 @@ bool rtrace(RTraceOptions * options, char * octname, bool do_irradiance, bool im
     // Create the file
     FILE *rt = POPEN(&command[0], "w");
     
-    
-    for(auto ray : *rays){
-        fprintf(rt, "%f %f %f %f %f %f\n", ray.rorg[0], ray.rorg[1], ray.rorg[2], ray.rdir[0], ray.rdir[1], ray.rdir[2]);
-    }
+    rays->write(rt);
         
     PCLOSE(rt);
     
@@ -284,122 +332,661 @@ bool rtrace(RTraceOptions * options, char * octname, bool do_irradiance, bool im
 }
 
 
-bool rtrace_i( RTraceOptions * options, char * octname, std::string amb, std::vector<RAY> * rays, ColorMatrix * result)
+bool rtrace_i( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result)
 {
     return rtrace( options, octname, true, false, amb, rays, result);
 }
 
 
-bool rtrace_I( RTraceOptions * options, char * octname, std::string amb, std::vector<RAY> * rays, ColorMatrix * result)
+bool rtrace_I( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result)
 {
     return rtrace(options, octname, false, true, amb, rays, result);
 }
 
 
-bool oconv(std::string octname, OconvOptions * options, RadExporter exporter)
-{    
-    std::string command = "oconv - > " + std::string(octname);
-  	
-    FILE *octree = POPEN(&command[0], "w");
-            
+bool cachedRTrace_I( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result, const std::vector<std::string> * dependencies)
+{
+    AmbientCache cache = AmbientCache();
+    std::string cachedAmb;
+    if(!cache.getAmbientFile(std::string(octname), options, &cachedAmb, dependencies))
+        return rtrace_I(options, octname, amb, rays, result);
+    
+    // Spread the irradiance cache over all the sensors
+    const size_t stride = cache.getPrewarm();
+    if(stride > 1 && rays->size() > stride && !fexists(cachedAmb)){
+        SensorSet sparse = SensorSet();
+        sparse.reserve(rays->size()/stride + 1);
+        for(size_t i = 0; i < rays->size(); i += stride){
+            const float * o = rays->getOrigin(i);
+            const float * d = rays->getDirection(i);
+            sparse.addSensor(o[0], o[1], o[2], d[0], d[1], d[2]);
+        }
+        ColorMatrix aux = ColorMatrix(sparse.size(),1);
+        rtrace_I(options, octname, cachedAmb, &sparse, &aux);
+    }
+    
+    bool success = rtrace_I(options, octname, cachedAmb, rays, result);
+    cache.evict();
+    return success;
+}
 
-    // Add all the materials
-    bool blackGeometry = options->getOption<bool>(OCONV_USE_BLACK_GEOMETRY);
-    if (blackGeometry) {      
-      fprintf(octree, "void plastic black 0 0 5 0 0 0 0 0 \n\n");      
+
+//! Calculates the nesting depth of a ComponentDefinition
+/*!
+ @author German Molina
+ @param definition The ComponentDefinition
+ @param depths The depths already calculated
+ @return 0 if the definition does not instance other definitions; 1 + the deepest nested depth otherwise
+ */
+static size_t componentDepth(const ComponentDefinition * definition, std::map<const ComponentDefinition *, size_t> * depths)
+{
+    auto found = depths->find(definition);
+    if(found != depths->end())
+        return found->second;
+    
+    size_t depth = 0;
+    const std::vector < ComponentInstance * > * const instances = definition->getComponentInstancesRef();
+    for (auto instance : *instances) {
+        const ComponentDefinition * nested = instance->getDefinitionRef();
+        if(nested == nullptr || nested == definition)
+            continue;
+        depth = std::max(depth, 1 + componentDepth(nested, depths));
+    }
+    
+    (*depths)[definition] = depth;
+    return depth;
+}
+
+bool oconvComponents(std::string octreePrefix, OconvOptions * options, RadExporter exporter, std::vector<std::string> * componentOctrees)
+{
+    EmpModel * model = exporter.getModel();
+    size_t numDefinitions = model->getNumComponentDefinitions();
+    
+    // Group the (non empty) definitions by nesting depth
+    std::map<const ComponentDefinition *, size_t> depths = std::map<const ComponentDefinition *, size_t>();
+    std::vector< std::vector<const ComponentDefinition *> > levels = std::vector< std::vector<const ComponentDefinition *> >();
+    for (size_t i = 0; i < numDefinitions; i++) {
+        const ComponentDefinition * definition = model->getComponentDefinitionRef(i);
+        if (definition->getObjectsRef()->size() < 1 && definition->getComponentInstancesRef()->size() < 1)
+            continue;
+        
+        size_t depth = componentDepth(definition, &depths);
+        if (levels.size() <= depth)
+            levels.resize(depth + 1);
+        levels[depth].push_back(definition);
     }
-    exporter.writeMaterials(octree);
     
-    // Check windows
-    if (options->getOption<bool>(OCONV_INCLUDE_WINDOWS)) {
-      exporter.writeWindows(octree);
+    bool blackGeometry = options->getOption<bool>(OCONV_USE_BLACK_GEOMETRY);
+    std::string black = std::string("black");
+    std::string * newMaterial = blackGeometry ? &black : nullptr;
+    bool useCache = options->getOption<bool>(OCONV_USE_CACHE);
+    
+    // Whatever was already built (e.g. meshes) may be referenced by any definition
+    const std::vector<std::string> previous = *componentOctrees;
+    
+    bool success = true;
+    for (const auto & level : levels) {
+        const size_t nDefinitions = level.size();
+        std::vector<char> built = std::vector<char>(nDefinitions, 0);
+        
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, nDefinitions),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i != r.end(); ++i) {
+                    std::string octname = exporter.getComponentOctreeName(&octreePrefix, level[i]);
+                    
+                    // The nested definitions
+                    std::vector<std::string> nested = previous;
+                    for (auto instance : *(level[i]->getComponentInstancesRef())) {
+                        if (instance->getDefinitionRef() != nullptr)
+                            nested.push_back(exporter.getComponentOctreeName(&octreePrefix, instance->getDefinitionRef()));
+                    }
+                    
+                    built[i] = cachedOconv(octname, true, "", &nested, [&](FILE * octree) {
+                        // Frozen octrees need their own materials
+                        if (blackGeometry) {
+                            fprintf(octree, "void plastic black 0 0 5 0 0 0 0 0 \n\n");
+                        }
+                        else {
+                            exporter.writeMaterials(octree);
+                        }
+                        exporter.writeComponentDefinition(octree, level[i], newMaterial, &octreePrefix);
+                    }, useCache) ? 1 : 0;
+                }
+            }
+        );
+        
+        // Register them all, so the caller can clean up
+        for (size_t i = 0; i < nDefinitions; i++) {
+            componentOctrees->push_back(exporter.getComponentOctreeName(&octreePrefix, level[i]));
+            if (!built[i]) {
+                WARN(wMsg, "Impossible to oconv ComponentDefinition '" + level[i]->getName() + "'");
+                success = false;
+            }
+        }
+        
+        // Outer definitions cannot be built without the nested ones
+        if (!success)
+            return false;
     }
+    
+    return true;
+}
 
-    // check lights
-    if (options->getOption<bool>(OCONV_LIGHTS_ON)) {
-      std::cerr << "OCONVing lights is still not supported\n";
+bool cachedOconv(std::string octreeName, bool freeze, std::string baseOctree, const std::vector<std::string> * dependencies, std::function<void(FILE *)> writeScene, bool useCache)
+{
+    std::string flags = freeze ? "-f " : "";
+    if (!baseOctree.empty())
+        flags += "-i " + baseOctree + " ";
+    
+    // The octree may be a hard link to an entry of the cache,
+    // which must not be overwritten through it
+    remove(&octreeName[0]);
+    
+    // Bypassing the cache still goes through the scene file, so
+    // OCONV alone is measured; only a disabled cache pipes the scene
+    OctreeCache cache = OctreeCache();
+    if (useCache && !cache.isEnabled()) {
+        OctreeCache::clearOctreeKey(octreeName);
+        std::string command = "oconv " + flags + "- > " + octreeName;
+        FILE *octree = POPEN(&command[0], "w");
+        writeScene(octree);
+        return PCLOSE(octree) == 0;
     }
+    
+    // Write the scene, so it can be hashed
+    std::string sceneName = octreeName + ".rad";
+    FOPEN(scene, &sceneName[0], "w");
+    if (scene == nullptr) {
+        WARN(wMsg, "Impossible to write scene file '" + sceneName + "'");
+        return false;
+    }
+    writeScene(scene);
+    fclose(scene);
+    
+    // Build the key
+    uint64_t key = 14695981039346656037ULL;
+    const uint32_t header[2] = {EMP_OCTREE_CACHE_VERSION, freeze ? 1u : 0u};
+    OctreeCache::hashBytes(header, sizeof(header), &key);
+    
+    std::vector<std::string> inputs = std::vector<std::string>();
+    if (!baseOctree.empty())
+        inputs.push_back(baseOctree);
+    if (dependencies != nullptr)
+        inputs.insert(inputs.end(), dependencies->begin(), dependencies->end());
+    
+    bool keyed = useCache;
+    for (size_t i = 0; keyed && i < inputs.size(); i++) {
+        uint64_t inputKey;
+        if (!OctreeCache::getOctreeKey(inputs.at(i), &inputKey)) {
+            keyed = false;
+            break;
+        }
+        OctreeCache::hashBytes(&inputKey, sizeof(inputKey), &key);
+    }
+    keyed = keyed && OctreeCache::hashFile(sceneName, &key);
+    
+    // Reuse or build
+    bool success = keyed && cache.fetch(key, octreeName);
+    if (!success) {
+        std::string command = "oconv " + flags + sceneName + " > " + octreeName;
+        FILE *octree = POPEN(&command[0], "r");
+        success = PCLOSE(octree) == 0;
+        
+        if (success && keyed)
+            cache.store(key, octreeName);
+    }
+    remove(&sceneName[0]);
+    
+    // Octrees that could not be keyed are hashed when needed
+    if (success && keyed)
+        OctreeCache::setOctreeKey(octreeName, key);
+    else
+        OctreeCache::clearOctreeKey(octreeName);
+    
+    return success;
+}
 
+bool addToOctree(std::string baseOctree, std::string octreeName, std::function<void(FILE *)> writeScene)
+{
+    return cachedOconv(octreeName, false, baseOctree, nullptr, writeScene);
+}
 
-    // Add the geometry
-    if (blackGeometry) {
-        std::string black = std::string("black");
-        exporter.writeLayersInOneFile(octree, &black);
+bool compileTriangleSoups(std::string meshPrefix, bool includeDefinitions, RadExporter exporter, std::vector<TriangleSoup> * soups, std::vector<std::string> * meshes)
+{
+    EmpModel * model = exporter.getModel();
+    
+    // Find the triangles
+    size_t numLayers = model->getNumLayers();
+    for (size_t i = 0; i < numLayers; i++)
+        exporter.findTriangleSoups(model->getLayerRef(i), EMP_MESH_MIN_TRIANGLES, soups);
+    
+    if (includeDefinitions) {
+        size_t numDefinitions = model->getNumComponentDefinitions();
+        for (size_t i = 0; i < numDefinitions; i++)
+            exporter.findTriangleSoups(model->getComponentDefinitionRef(i), EMP_MESH_MIN_TRIANGLES, soups);
     }
-    else {
-      exporter.writeLayersInOneFile(octree, nullptr);
+    
+    const size_t nSoups = soups->size();
+    for (size_t i = 0; i < nSoups; i++)
+        (*soups)[i].meshName = meshPrefix + "_mesh" + std::to_string(i) + ".rtm";
+    
+    // Compile them
+    std::vector<char> built = std::vector<char>(nSoups, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, nSoups),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                const TriangleSoup * soup = &(*soups)[i];
+                std::string objName = soup->meshName.substr(0, soup->meshName.size() - 4) + ".obj";
+                
+                FOPEN(obj, &objName[0], "w");
+                if (obj == nullptr)
+                    continue;
+                bool written = exporter.writeOBJ(obj, soup);
+                fclose(obj);
+                
+                if (written) {
+                    std::string command = "obj2mesh " + objName + " " + soup->meshName;
+                    FILE * mesh = POPEN(&command[0], "r");
+                    built[i] = PCLOSE(mesh) == 0 ? 1 : 0;
+                }
+                remove(&objName[0]);
+            }
+        }
+    );
+    
+    // Register them all, so the caller can clean up
+    bool success = true;
+    for (size_t i = 0; i < nSoups; i++) {
+        meshes->push_back((*soups)[i].meshName);
+        if (!built[i]) {
+            WARN(wMsg, "Impossible to obj2mesh the triangles of '" + (*soups)[i].layer->getName() + "'");
+            success = false;
+        }
     }
     
-	PCLOSE(octree);
+    return success;
+}
 
-    return true;
+bool oconv(std::string octname, OconvOptions * options, RadExporter exporter, std::vector<std::string> * componentOctrees)
+{
+    bool instanceComponents = options->getOption<bool>(OCONV_INSTANCE_COMPONENTS);
+    std::string octreePrefix = octname;
+    size_t extension = octreePrefix.rfind(".oct");
+    if (extension != std::string::npos)
+        octreePrefix = octreePrefix.substr(0, extension);
+    
+    std::vector<std::string> created = std::vector<std::string>();
+    std::vector<std::string> * octrees = componentOctrees == nullptr ? &created : componentOctrees;
+    
+    // Compile the large triangle soups, if required. The meshes are
+    // dependencies of the octree, just like the component octrees
+    std::vector<TriangleSoup> soups = std::vector<TriangleSoup>();
+    if (options->getOption<bool>(OCONV_MESH_TRIANGLES)) {
+        if (!compileTriangleSoups(octreePrefix, instanceComponents, exporter, &soups, octrees))
+            return false;
+        exporter.setTriangleSoups(&soups);
+    }
+    
+    // Build the ComponentDefinitions first, if required
+    if (instanceComponents) {
+        if (!oconvComponents(octreePrefix, options, exporter, octrees))
+            return false;
+    }
+    
+    bool freeze = options->getOption<bool>(OCONV_FREEZE);
+    bool useCache = options->getOption<bool>(OCONV_USE_CACHE);
+    return cachedOconv(octname, freeze, "", octrees, [&](FILE * octree) {
+        // Add all the materials
+        bool blackGeometry = options->getOption<bool>(OCONV_USE_BLACK_GEOMETRY);
+        if (blackGeometry) {
+          fprintf(octree, "void plastic black 0 0 5 0 0 0 0 0 \n\n");
+        }
+        exporter.writeMaterials(octree);
+        
+        // Check windows
+        if (options->getOption<bool>(OCONV_INCLUDE_WINDOWS)) {
+          exporter.writeWindows(octree);
+        }
+
+        // check lights
+        if (options->getOption<bool>(OCONV_LIGHTS_ON)) {
+          std::cerr << "OCONVing lights is still not supported\n";
+        }
+
+        // Add the geometry
+        const std::string * prefix = instanceComponents ? &octreePrefix : nullptr;
+        if (blackGeometry) {
+            std::string black = std::string("black");
+            exporter.writeLayersInOneFile(octree, &black, prefix);
+        }
+        else {
+          exporter.writeLayersInOneFile(octree, nullptr, prefix);
+        }
+    }, useCache);
 }
 
-int genPerezSkyVector(int mo, int da, float hr, float dir, float dif, float albedo, float latitude, float longitude, float standardMeridian, int skyMF, bool sunOnly, bool sharpSun, float rotation, ColorMatrix * skyVec)
+bool measureOconv(EmpModel * model, GeometryReport * report)
 {
-    GenDayMtx g = GenDayMtx();
+    std::string octname = "Geometry_report_" + std::to_string(GETPID()) + ".oct";
+    OconvOptions options = OconvOptions();
+    options.setOption(OCONV_USE_CACHE, false);
+    RadExporter exporter = RadExporter(model);
+    std::vector<std::string> componentOctrees = std::vector<std::string>();
     
-    float	*mtx_data = NULL;	/* our matrix data */
-   
-    /* convert quantities to radians */
-    g.s_latitude = DegToRad(latitude);
-    g.s_longitude = DegToRad(longitude);
-    g.s_meridian = DegToRad(standardMeridian);
+    tbb::tick_count t0 = tbb::tick_count::now();
+    bool success = oconv(octname, &options, exporter, &componentOctrees);
+    tbb::tick_count t1 = tbb::tick_count::now();
     
+    struct stat status;
+    if (success && stat(&octname[0], &status) == 0) {
+        report->oconvSeconds = (t1 - t0).seconds();
+        report->octreeSize = (uint64_t)status.st_size;
+    } else {
+        success = false;
+    }
     
-    g.dir_irrad = dir;
-    g.diff_irrad = dif;
+    remove(&octname[0]);
+    for (auto & componentOctree : componentOctrees)
+        remove(&componentOctree[0]);
     
-    // Get options
-    g.grefl[0] = g.grefl[1] = g.grefl[2] = albedo;
-    g.rhsubdiv = skyMF;
+    return success;
+}
+
+bool optimizeModelGeometry(EmpModel * model, GeometryReport * report, bool measure)
+{
+    if (model->isGeometryOptimized())
+        return false;
+    
+    // Two extra octrees... only when asked for
+    if (measure) {
+        GeometryReport before = GeometryReport();
+        measureOconv(model, &before);
+        report->oconvSecondsBefore = before.oconvSeconds;
+        report->octreeSizeBefore = before.octreeSize;
+    }
+    
+    model->optimizeGeometry(EMP_GEOMETRY_TOLERANCE, report);
+    
+    INFORM(objectsMsg, "Geometry optimization: " + std::to_string(report->objectsBefore) + " -> " + std::to_string(report->objectsAfter) + " objects, " + std::to_string(report->verticesBefore) + " -> " + std::to_string(report->verticesAfter) + " vertices", true);
+    
+    if (measure) {
+        measureOconv(model, report);
+        INFORM(octreeMsg, "Geometry optimization: oconv took " + std::to_string(report->oconvSecondsBefore) + " -> " + std::to_string(report->oconvSeconds) + " seconds, octree size " + std::to_string(report->octreeSizeBefore) + " -> " + std::to_string(report->octreeSize) + " bytes", true);
+    }
+    
+    return true;
+}
+
+/* Sky patches, initialized once per sky subdivision and shared by all GenDayMtx */
+static std::map<int, GenDayMtx *> skyPatches = std::map<int, GenDayMtx *>();
+
+//! Retrieves the (shared) Reinhart sky patches for a certain subdivision
+/*!
+ @author German Molina
+ @param skyMF The sky subdivition scheme
+ @return A GenDayMtx whose sky patches have been initialized
+ */
+static const GenDayMtx * getSkyPatches(int skyMF)
+{
+    tbb::mutex::scoped_lock lock(skyPatchesMutex);
+    
+    auto found = skyPatches.find(skyMF);
+    if(found != skyPatches.end())
+        return found->second;
+    
+    GenDayMtx * base = new GenDayMtx();
+    base->rhsubdiv = skyMF;
+    base->rh_init();
+    skyPatches[skyMF] = base;
+    return base;
+}
+
+//! Prepares a GenDayMtx that borrows the shared sky patches
+/*!
+ @author German Molina
+ @param[out] g The GenDayMtx to prepare
+ @param albedo The albedo in the location
+ @param skyMF The sky subdivition scheme
+ @param sunOnly Option for avoiding the sky, calculating only the sun
+ @param sharpSun An option to use the -5 option in gendaymtx
+ */
+static void initPerezSky(GenDayMtx * g, float albedo, int skyMF, bool sunOnly, bool sharpSun)
+{
+    g->grefl[0] = g->grefl[1] = g->grefl[2] = albedo;
     if(sunOnly){
-        g.skycolor[0] = g.skycolor[1] = g.skycolor[2] = 0;
+        g->skycolor[0] = g->skycolor[1] = g->skycolor[2] = 0;
     }
     
     if(sharpSun){
-        g.nsuns = 1;
-        g.fixed_sun_sa = PI/360.0*0.533;
-        g.fixed_sun_sa *= g.fixed_sun_sa*PI;
+        g->nsuns = 1;
+        g->fixed_sun_sa = PI/360.0*0.533;
+        g->fixed_sun_sa *= g->fixed_sun_sa*PI;
     }
     
+    g->share_patches(getSkyPatches(skyMF));
+}
 
-    g.rh_init();			/* initialize sky patches */
+//! Calculates the sky for a single timestep, with the position of the sun already known
+/*!
+ @author German Molina
+ @param g The GenDayMtx, prepared with initPerezSky()
+ @param julianDate The day of the year
+ @param altitude The solar altitude (radians)
+ @param azimuth The solar azimuth (radians), already rotated
+ @param direct The direct normal irradiance
+ @param diffuse The diffuse horizontal irradiance
+ @param[out] mtxData The RGB values of each patch (3 x nskypatch)
+ @return the patch that uses the sun
+ */
+static int computePerezSky(GenDayMtx * g, int julianDate, double altitude, double azimuth, float direct, float diffuse, float * mtxData)
+{
+    g->sharp_patch = -1;
     
+    if (diffuse <= EMP_NIGHT_THRESHOLD) { // it is night
+        memset(mtxData, 0, sizeof(float)*3*g->nskypatch);
+        return g->sharp_patch;
+    }
     
+    g->dir_irrad = direct;
+    g->diff_irrad = diffuse;
+    g->julian_date = julianDate;
+    g->altitude = altitude;
+    g->azimuth = azimuth;
     
-    double		sda, sta;
+    /* compute sky patch values */
+    g->ComputeSky(mtxData);
+    g->AddDirect(mtxData);
     
-    /* make space for time step */
-    mtx_data = g.resize_dmatrix(mtx_data, 8, g.nskypatch);
+    return g->sharp_patch;
+}
+
+int genPerezSkyVector(int mo, int da, float hr, float dir, float dif, float albedo, float latitude, float longitude, float standardMeridian, int skyMF, bool sunOnly, bool sharpSun, float rotation, ColorMatrix * skyVec)
+{
+    GenDayMtx g = GenDayMtx();
+    initPerezSky(&g, albedo, skyMF, sunOnly, sharpSun);
     
+    /* compute solar position */
+    const double lat = DegToRad(latitude);
+    const double lon = DegToRad(longitude);
+    const double mer = DegToRad(standardMeridian);
+    const int jd = jdate(mo, da);
+    const double sda = sdec(jd);
+    const double sta = stadj(jd, lon, mer);
+    const double altitude = salt(sda, hr+sta, lat);
+    const double azimuth = sazi(sda, hr+sta, lat) + PI - DegToRad(rotation);
     
-    if (dif <= 1e-4) { // it is night
-        memset(mtx_data, 0, sizeof(float)*3*g.nskypatch);
-    }else { // it is daytime
-        /* compute solar position */
-        g.julian_date = jdate(mo, da);
-        sda = sdec(g.julian_date);
-        sta = stadj(g.julian_date,g.s_longitude,g.s_meridian);
-        g.altitude = salt(sda, hr+sta,g.s_latitude);
-        g.azimuth = sazi(sda, hr+sta,g.s_latitude) + PI - DegToRad(rotation);
-        
-        /* compute sky patch values */
-        g.ComputeSky(mtx_data);
-        g.AddDirect(mtx_data);
-    }
+    std::vector<float> mtxData = std::vector<float>(3*g.nskypatch);
+    int sharpPatch = computePerezSky(&g, jd, altitude, azimuth, dir, dif, &mtxData[0]);
     
     /* Translate values from mtx_data into ColorMatrix */
     size_t nBins = g.nskypatch;
     size_t aux = 0;
     for(size_t bin=0; bin < nBins; bin++){
-        skyVec->r()->setElement(bin,0,mtx_data[aux++]);
-        skyVec->g()->setElement(bin,0,mtx_data[aux++]);
-        skyVec->b()->setElement(bin,0,mtx_data[aux++]);
+        skyVec->r()->setElement(bin,0,mtxData[aux++]);
+        skyVec->g()->setElement(bin,0,mtxData[aux++]);
+        skyVec->b()->setElement(bin,0,mtxData[aux++]);
+    }
+    
+    return sharpPatch;
+}
+
+bool genSkyVector(std::string sky, int skyMF, ColorMatrix * skyVec)
+{
+    std::string command = sky + " | genskyvec -m " + std::to_string(skyMF);
+    FILE * pipe = POPEN(&command[0], "r");
+    if (pipe == nullptr)
+        return false;
+    
+    const size_t nBins = nReinhartBins(skyMF);
+    skyVec->resize(nBins, 1);
+    
+    // Read the patches... skipping the header, if any
+    char line[512];
+    size_t bin = 0;
+    bool inHeader = false;
+    while (fgets(line, sizeof(line), pipe) != nullptr) {
+        if (bin == 0 && strncmp(line, "#?", 2) == 0) {
+            inHeader = true;
+            continue;
+        }
+        if (inHeader) {
+            inHeader = (line[0] != '\n' && line[0] != '\r');
+            continue;
+        }
+        
+        float red, green, blue;
+        if (sscanf(line, "%f %f %f", &red, &green, &blue) != 3)
+            continue;
+        
+        if (bin < nBins) {
+            skyVec->r()->setElement(bin, 0, red);
+            skyVec->g()->setElement(bin, 0, green);
+            skyVec->b()->setElement(bin, 0, blue);
+        }
+        bin++;
     }
     
+    if (PCLOSE(pipe) != 0 || bin != nBins) {
+        WARN(wMsg, "Impossible to calculate the sky vector of '" + sky + "'");
+        return false;
+    }
     
-    return g.sharp_patch;
+    return true;
+}
+
+void genPerezSkyMatrix(const InterpolatedWeather * weather, size_t firstStep, size_t nSteps, float albedo, int skyMF, bool sunOnly, bool sharpSun, float rotation, ColorMatrix * skyMatrix, std::vector<int> * sharpPatches)
+{
+    if(firstStep + nSteps > weather->size())
+        throw "Trying to generate skies beyond the end of the interpolated weather";
+    
+    const size_t nBins = nReinhartBins(skyMF);
+    if(skyMatrix->nrows() != nBins || skyMatrix->ncols() != nSteps)
+        skyMatrix->resize(nBins,nSteps);
+    
+    if(sharpPatches != nullptr)
+        sharpPatches->resize(nSteps);
+    
+    const float northCorrection = (float)DegToRad(rotation);
+    
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, nSteps),
+                      [=](const tbb::blocked_range<size_t>& r) {
+                          
+                          // One generator per chunk of timesteps
+                          GenDayMtx g = GenDayMtx();
+                          initPerezSky(&g, albedo, skyMF, sunOnly, sharpSun);
+                          
+                          // The scalar parameters of each daytime timestep...
+                          // the sky ones in separate arrays, for the batch
+                          const size_t chunkSize = r.end() - r.begin();
+                          std::vector<size_t> daySteps = std::vector<size_t>();
+                          std::vector<float> diffIllum = std::vector<float>();
+                          std::vector<float> dirIllum = std::vector<float>();
+                          std::vector<int> batchIndex = std::vector<int>();
+                          std::vector<double> cosSz = std::vector<double>();
+                          std::vector<double> sinSz = std::vector<double>();
+                          std::vector<double> azimuth = std::vector<double>();
+                          std::vector<double> par[5];
+                          daySteps.reserve(chunkSize);
+                          
+                          for (size_t col = r.begin(); col != r.end(); ++col) {
+                              const size_t nstep = firstStep + col;
+                              if (weather->diffuse_horizontal[nstep] <= EMP_NIGHT_THRESHOLD) { // it is night
+                                  for(size_t bin=0; bin < nBins; bin++){
+                                      skyMatrix->r()->setElement(bin,col,0);
+                                      skyMatrix->g()->setElement(bin,col,0);
+                                      skyMatrix->b()->setElement(bin,col,0);
+                                  }
+                                  if(sharpPatches != nullptr)
+                                      (*sharpPatches)[col] = -1;
+                                  continue;
+                              }
+                              
+                              g.dir_irrad = weather->direct_normal[nstep];
+                              g.diff_irrad = weather->diffuse_horizontal[nstep];
+                              g.julian_date = jdate(weather->month[nstep], weather->day[nstep]);
+                              g.altitude = weather->altitude[nstep];
+                              g.azimuth = weather->azimuth[nstep] - northCorrection;
+                              
+                              daySteps.push_back(col);
+                              if (g.ComputeSkyParam()) {
+                                  batchIndex.push_back((int)cosSz.size());
+                                  cosSz.push_back(cos(g.sun_zenith));
+                                  sinSz.push_back(sin(g.sun_zenith));
+                                  azimuth.push_back(g.azimuth);
+                                  for (int k = 0; k < 5; k++)
+                                      par[k].push_back(g.perez_param[k]);
+                              } else {
+                                  batchIndex.push_back(-1);
+                              }
+                              diffIllum.push_back(g.diff_illum);
+                              dirIllum.push_back(g.dir_illum);
+                          }
+                          
+                          // Relative luminances of all the patches, for all
+                          // the timesteps with sky at once
+                          const int nBatch = (int)cosSz.size();
+                          std::vector<float> luminances = std::vector<float>(nBins*nBatch);
+                          std::vector<double> horizontalIllum = std::vector<double>(nBatch);
+                          if (nBatch > 0) {
+                              const double * const parameters[5] = {&par[0][0], &par[1][0], &par[2][0], &par[3][0], &par[4][0]};
+                              g.CalcSkyPatchLuminBatch(nBatch, &cosSz[0], &sinSz[0], &azimuth[0], parameters, &luminances[0], &horizontalIllum[0]);
+                          }
+                          
+                          // Normalize, add the sun and write every daytime timestep
+                          std::vector<float> mtxData = std::vector<float>(3*nBins);
+                          for (size_t i = 0; i < daySteps.size(); i++) {
+                              const size_t col = daySteps[i];
+                              const size_t nstep = firstStep + col;
+                              g.altitude = weather->altitude[nstep];
+                              g.azimuth = weather->azimuth[nstep] - northCorrection;
+                              g.diff_illum = diffIllum[i];
+                              g.dir_illum = dirIllum[i];
+                              
+                              const int k = batchIndex[i];
+                              if (k < 0) {
+                                  memset(&mtxData[0], 0, sizeof(float)*3*nBins);
+                              } else {
+                                  g.ComputeGround(&mtxData[0]);
+                                  for (size_t bin = 1; bin < nBins; bin++)
+                                      mtxData[3*bin] = mtxData[3*bin+1] = mtxData[3*bin+2] = luminances[bin*nBatch + k];
+                                  g.NormalizeSky(&mtxData[0], (float)horizontalIllum[k]);
+                              }
+                              
+                              g.sharp_patch = -1;
+                              g.AddDirect(&mtxData[0]);
+                              if(sharpPatches != nullptr)
+                                  (*sharpPatches)[col] = g.sharp_patch;
+                              
+                              size_t aux = 0;
+                              for(size_t bin=0; bin < nBins; bin++){
+                                  skyMatrix->r()->setElement(bin,col,mtxData[aux++]);
+                                  skyMatrix->g()->setElement(bin,col,mtxData[aux++]);
+                                  skyMatrix->b()->setElement(bin,col,mtxData[aux++]);
+                              }
+                          }
+                      },
+                      tbb::auto_partitioner()
+                      );// end of parallel_for
 }
 
 
@@ -409,9 +996,6 @@ void interpolatedDCTimestep(int interp, EmpModel * model, const ColorMatrix * DC
     // Get location info
     const Location * location = model -> getLocation();
     const float albedo = location->getAlbedo();
-    const float latitude = location->getLatitude();
-    const float longitude = location-> getLongitude();
-    const float meridian = location->getTimeZone()*(-15.0f);
     const float rotation = model -> getNorthCorrection();
     
     // Get sizes and resize
@@ -428,48 +1012,55 @@ void interpolatedDCTimestep(int interp, EmpModel * model, const ColorMatrix * DC
     
     
     
-    // Interpolate and multiply
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, nSamples),
+    // Get the (shared) interpolated weather
+    std::shared_ptr<const InterpolatedWeather> sharedWeather = location->getInterpolatedWeather(interp);
+    const InterpolatedWeather * weather = sharedWeather.get();
+    
+    // Generate skies in batches and multiply
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, interp*nSamples, EMP_SKY_BATCH_SIZE),
                       [=](const tbb::blocked_range<size_t>& r) {
-                          for (size_t timestep = r.begin(); timestep != r.end(); ++timestep) {
-                                                                                          
-                              HourlyData now = HourlyData();
-                              float floatInter = (float)interp;
-                              float q;
+                          
+                          // Generate all the skies in this batch
+                          const size_t nSkies = r.end() - r.begin();
+                          ColorMatrix skies = ColorMatrix(nBins,nSkies);
+                          std::vector<int> sharpPatches = std::vector<int>();
+                          genPerezSkyMatrix(weather, r.begin(), nSkies, albedo, mf, sunOnly, sharpSun, rotation, &skies, &sharpPatches);
+                          
+                          // Initialize Sky vector
+                          ColorMatrix skyVector = ColorMatrix(nBins,1);
+                          
+                          for (size_t nstep = r.begin(); nstep != r.end(); ++nstep) {
                               
-                              for(int i = 0; i < interp; i++){
-                                  size_t nstep = timestep * interp + i;
-                                  
-                                  q = (float)i / floatInter;
-                                  
-                                  location->getInterpolatedData(static_cast<int>(timestep),q,&now);
-                                  
-                                  // If it is day
-                                  if(now.diffuse_horizontal > 1e-4){
-                                      
-                                      // Initialize Sky vector
-                                      ColorMatrix skyVector = ColorMatrix(nBins,1);
-                                      
-                                      // Is day... calculate
-                                      int sharpPatch = genPerezSkyVector(now.month, now.day, now.hour, (float)now.direct_normal, (float)now.diffuse_horizontal, albedo, latitude, longitude, meridian, mf, sunOnly, sharpSun, rotation, &skyVector);
-                                      
-                                      if(sharpSun && sunOnly){
-                                          // In this case, we know that only one of the elements in the
-                                          // sky vector is not zero; so we multiply only that one.
-                                          if(sharpPatch >= 0)
-                                              DC->multiplyRowToColumn(&skyVector, sharpPatch, nstep, result);
-                                      }else{
-                                          // Multiply the whole matrices
-                                          DC->multiplyToColumn(&skyVector, nstep, result);
-                                      }
-                                      
-                                  } // No else... answer is Zero and matrices come with zeroes
+                              // Night... answer is Zero and matrices come with zeroes
+                              if(!weather->isDaytime[nstep])
+                                  continue;
+                              
+                              const size_t col = nstep - r.begin();
+                              
+                              if(sharpSun && sunOnly){
+                                  // In this case, we know that only one of the elements in the
+                                  // sky vector is not zero; so we multiply only that one.
+                                  const int sharpPatch = sharpPatches[col];
+                                  if(sharpPatch >= 0){
+                                      skyVector.r()->setElement(sharpPatch,0,skies.redChannel()->getElement(sharpPatch,col));
+                                      skyVector.g()->setElement(sharpPatch,0,skies.greenChannel()->getElement(sharpPatch,col));
+                                      skyVector.b()->setElement(sharpPatch,0,skies.blueChannel()->getElement(sharpPatch,col));
+                                      DC->multiplyRowToColumn(&skyVector, sharpPatch, nstep, result);
+                                  }
+                              }else{
+                                  for(size_t bin = 0; bin < nBins; bin++){
+                                      skyVector.r()->setElement(bin,0,skies.redChannel()->getElement(bin,col));
+                                      skyVector.g()->setElement(bin,0,skies.greenChannel()->getElement(bin,col));
+                                      skyVector.b()->setElement(bin,0,skies.blueChannel()->getElement(bin,col));
+                                  }
                                   
-                              }// enf loop in i
+                                  // Multiply the whole matrices
+                                  DC->multiplyToColumn(&skyVector, nstep, result);
+                              }
                               
                           }
           },
-          tbb::auto_partitioner()
+          tbb::simple_partitioner()
     );// end of parallel_for
     
 }
@@ -490,45 +1081,36 @@ void calcCBDMScore(int interp, EmpModel * model, int firstMonth, int lastMonth,
     Location * location = model->getLocation();
     size_t nSamples = location->getWeatherSize();
     
+    // Get the (shared) interpolated weather
+    std::shared_ptr<const InterpolatedWeather> sharedWeather = location->getInterpolatedWeather(interp);
+    const InterpolatedWeather * weather = sharedWeather.get();
+    const size_t nSteps = interp*nSamples;
+    
     // Initialize variables
     float lux;
     size_t nWorkingTsteps = 0;
-    size_t nstep=-1;
-    HourlyData now = HourlyData();
-    float floatInter = (float)interp;
-    float q;
+    
+    for(size_t nstep = 0 ; nstep < nSteps; nstep++ ){
         
-    for(int timestep = 0 ; timestep < nSamples; timestep++ ){
+        // Check if this moment counts
+        const int month = weather->month[nstep];
+        if(month < firstMonth || month > lastMonth)
+            continue;
         
-        // Interpolate between timesteps
-        for(int i = 0; i < interp; i++){
-            // Fraction between timesteps
-            q = (float)i / floatInter;
-            
-            // Fill the HourlyData with interpolated information
-            location->getInterpolatedData(timestep,q,&now);
-            
-            // Advance in time
-            nstep++;
-            
-            // Check if this moment counts
-            if(now.month < firstMonth || now.month > lastMonth)
-                continue;
-            
-            if(now.hour < early || now.hour > late)
-                continue;
+        const float hour = weather->hour[nstep];
+        if(hour < early || hour > late)
+            continue;
+        
+        // Increase working timesteps, if it counts
+        nWorkingTsteps++;
+        
+        // Iterate all sensors, increasing the score if needed
+        for(size_t sensor = 0; sensor < nsensors; sensor++){
+            lux = input->getElement(sensor,nstep);
             
-            // Increase working timesteps, if it counts
-            nWorkingTsteps++;
+            auto score = scoreCalculator(lux, minLux, maxLux);
             
-            // Iterate all sensors, increasing the score if needed
-            for(int sensor = 0; sensor < nsensors; sensor++){
-                lux = input->getElement(sensor,nstep);
-                
-                auto score = scoreCalculator(lux, minLux, maxLux);
-                
-                result->setElement(sensor,0,result->getElement(sensor,0)+score);                
-            }
+            result->setElement(sensor,0,result->getElement(sensor,0)+score);
         }
     }
     
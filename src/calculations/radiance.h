@@ -24,7 +24,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "./reinhart.h"
 #include "./color_matrix.h"
+#include "./sensor_set.h"
 #include "./oconv_options.h"
+#include "./octree_cache.h"
+#include "./ambient_cache.h"
 #include "../writers/rad/radexporter.h"
 
 
@@ -64,6 +67,19 @@ extern "C" {
 
 
 
+//! Chooses the number of processes (i.e. -n) of an RCONTRIB call
+/*!
+ The EMP_RCONTRIB_PROCESSES environmental variable is used, if set.
+ Otherwise, the cores are divided among the RCONTRIB calls running 
+ at the moment, so several Tasks tracing at once do not start one
+ process per core each.
+ 
+ @author German Molina
+ @param[in] running The number of RCONTRIB calls running (including this one)
+ @return The number of processes (at least 1)
+ */
+unsigned int rcontribProcesses(unsigned int running);
+
 //! This function emulates the use of Radiance's RCONTRIB program
 /*!
  
@@ -78,8 +94,9 @@ extern "C" {
  @param[in] vMode The -V option
  @param[out] result The result ColorMatrix
  @note Always enables the -V option
+ @note The rays are traced in parallel (-n, see rcontribProcesses()), except on Windows
  */
-bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, std::vector<RAY> * rays, int mf,const char * modifier, bool vMode, ColorMatrix * result);
+bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool imm_irrad, SensorSet * rays, int mf,const char * modifier, bool vMode, ColorMatrix * result);
 
 //! This function emulates the use of Radiance's RTRACE program
 /*!
@@ -91,7 +108,7 @@ bool rcontrib(RTraceOptions * options, char * octname, bool do_irradiance, bool
  @param[in] amb The name of the ambient file to use
  @param rays The place where the resulting rays will be stored
  */
-bool rtrace(RTraceOptions * options, char * octname, bool do_irrad, bool imm_irrad, std::string amb, std::vector<RAY> * rays, ColorMatrix * result);
+bool rtrace(RTraceOptions * options, char * octname, bool do_irrad, bool imm_irrad, std::string amb, SensorSet * rays, ColorMatrix * result);
 
 
 //! This function emulates the use of Radiance's RTRACE program with the -I option enabled
@@ -102,7 +119,26 @@ bool rtrace(RTraceOptions * options, char * octname, bool do_irrad, bool imm_irr
  @param[in] amb The name of the ambient file to use
  @param[out] rays The place where the resulting rays will be stored
  */
-bool rtrace_I( RTraceOptions * options, char * octname, std::string amb, std::vector<RAY> * rays, ColorMatrix * result);
+bool rtrace_I( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result);
+
+//! Calls RTRACE with the -I option enabled, reusing the persistent ambient cache
+/*!
+ The ambient file is taken from the AmbientCache, so the irradiance cache
+ built by previous runs (or by other Tasks, at the same time) is reused. 
+ If the ambient file is new and pre-warming is enabled, a subset of the 
+ sensors is traced first so the irradiance cache is spread over the
+ whole set. When the cache is disabled, this is the same as rtrace_I().
+ 
+ @author German Molina
+ @param[in] options The RTRACE options
+ @param[in] octname The name of the octree to read
+ @param[in] amb The name of the ambient file to use when the cache is disabled
+ @param[in] rays The sensors
+ @param[out] result The place where the results will be stored
+ @param[in] dependencies The files referenced by the octree (e.g. .cal files), which also identify the ambient file
+ @return success
+ */
+bool cachedRTrace_I( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result, const std::vector<std::string> * dependencies = nullptr);
 
 
 //! This function emulates the use of Radiance's RTRACE program with the -i option enabled
@@ -113,19 +149,127 @@ bool rtrace_I( RTraceOptions * options, char * octname, std::string amb, std::ve
  @param[in] amb The name of the ambient file to use
  @param[out] rays The place where the resulting rays will be stored
  */
-bool rtrace_i( RTraceOptions * options, char * octname, std::string amb, std::vector<RAY> * rays, ColorMatrix * result);
+bool rtrace_i( RTraceOptions * options, char * octname, std::string amb, SensorSet * rays, ColorMatrix * result);
 
 
+//! Runs OCONV through the octree cache
+/*!
+The scene is written to a temporary file, and the octree is keyed by its
+contents, the OCONV flags and the keys of the octrees it depends on (see
+OctreeCache). If the key is in the cache, the cached octree is reused;
+otherwise, OCONV is called and the result is stored in the cache. When the
+cache is disabled, the scene is piped directly into OCONV.
+
+@author German Molina
+@param[in] octreeName The name of the octree to create
+@param[in] freeze Freeze the octree (i.e. oconv -f)
+@param[in] baseOctree The octree to add the scene to (i.e. oconv -i); empty for none
+@param[in] dependencies Other octrees referenced by the scene, such as instances (can be NULL)
+@param[in] writeScene The function that writes the scene
+@param[in] useCache Use the octree cache (if enabled)
+@return success
+*/
+bool cachedOconv(std::string octreeName, bool freeze, std::string baseOctree, const std::vector<std::string> * dependencies, std::function<void(FILE *)> writeScene, bool useCache = true);
+
+//! Adds some Radiance primitives (e.g. a sky) to an existing octree
+/*!
+@author German Molina
+@param[in] baseOctree The octree to add the primitives to
+@param[in] octreeName The name of the octree to create
+@param[in] writeScene The function that writes the primitives
+@return success
+*/
+bool addToOctree(std::string baseOctree, std::string octreeName, std::function<void(FILE *)> writeScene);
+
 //! Creates an octree according to certain option
 /*
+If the OCONV_INSTANCE_COMPONENTS option is set, each ComponentDefinition
+is frozen into its own octree (see oconvComponents()) and the instances
+are referenced from the main octree. These octrees are read by Radiance
+whenever the main octree is used, so they are appended to componentOctrees
+for the caller to remove them when no longer needed.
+
+If the OCONV_MESH_TRIANGLES option is set, the large groups of triangles
+are compiled into Radiance meshes (see compileTriangleSoups()), which are
+appended to componentOctrees as well.
+
 @author German Molina
 @param[in] octreeName The name of the octree to create
 @param[in] options The OconvOptions set
 @param[in] exporter The RadianceExporter that will write all the necessary geometry
+@param[out] componentOctrees The names of the ComponentDefinition octrees created (can be NULL)
 @todo Lights on
 @return success
 */
-bool oconv(std::string octreeName, OconvOptions * options, RadExporter exporter);
+bool oconv(std::string octreeName, OconvOptions * options, RadExporter exporter, std::vector<std::string> * componentOctrees = nullptr);
+
+//! Builds an octree of a model, to measure how long it takes and how big it is
+/*!
+ Meant to be called after EmpModel::optimizeGeometry(), so the report
+ shows the resulting octree. The octree is built with the default
+ OconvOptions, bypassing the octree cache (see OctreeCache), and 
+ removed afterwards.
+ 
+ @author German Molina
+ @param[in] model The model
+ @param[out] report The report where the time and size are stored
+ @return success
+ */
+bool measureOconv(EmpModel * model, GeometryReport * report);
+
+//! Optimizes the geometry of a model (once), and reports the effect
+/*!
+ Calls EmpModel::optimizeGeometry() with EMP_GEOMETRY_TOLERANCE and 
+ informs the report. If requested, the octree is also measured (see 
+ measureOconv()) before and after optimizing, which means building it 
+ twice. Models that have already been optimized are left as they are,
+ so every OconvTask with OCONV_OPTIMIZE_GEOMETRY can request it.
+ 
+ This replaces the Face objects of the model, so it must not run while
+ other threads read it (see OconvTask::prepare()).
+ 
+ @author German Molina
+ @param[in] model The model
+ @param[out] report The report
+ @param[in] measure Measure the octree before and after optimizing
+ @return false if the model was already optimized
+ */
+bool optimizeModelGeometry(EmpModel * model, GeometryReport * report, bool measure);
+
+//! Compiles the large groups of triangles of a model into Radiance meshes
+/*!
+ Each TriangleSoup (see RadExporter::findTriangleSoups()) is written as a
+ Wavefront OBJ file and compiled with OBJ2MESH, in parallel. Meshes are much
+ more compact than one polygon per triangle, which makes oconv faster and 
+ the octrees smaller. 
+ 
+ The soups must then be set in the RadExporter (see 
+ RadExporter::setTriangleSoups()) so the triangles are replaced by the meshes.
+ 
+ @author German Molina
+ @param[in] meshPrefix The prefix of the mesh file names
+ @param[in] includeDefinitions Also look for triangles in the ComponentDefinitions
+ @param[in] exporter The RadianceExporter that writes the OBJ files
+ @param[out] soups The groups of triangles, with the name of their meshes
+ @param[out] meshes The names of the meshes created (for the caller to remove them)
+ @return success
+ */
+bool compileTriangleSoups(std::string meshPrefix, bool includeDefinitions, RadExporter exporter, std::vector<TriangleSoup> * soups, std::vector<std::string> * meshes);
+
+//! Freezes each ComponentDefinition of a model into its own octree
+/*!
+Definitions are processed by nesting depth (i.e. a definition is built
+after all the definitions it instances), and all the definitions within
+the same depth are built in parallel.
+
+@author German Molina
+@param[in] octreePrefix The prefix of the octree names (see RadExporter::getComponentOctreeName())
+@param[in] options The OconvOptions set
+@param[in] exporter The RadianceExporter that will write all the necessary geometry
+@param[out] componentOctrees The names of the octrees created (the files already in it are dependencies of every definition)
+@return success
+*/
+bool oconvComponents(std::string octreePrefix, OconvOptions * options, RadExporter exporter, std::vector<std::string> * componentOctrees);
 
 //! Calculates a single sky vector according to the Perez model
 /*!
@@ -149,6 +293,45 @@ bool oconv(std::string octreeName, OconvOptions * options, RadExporter exporter)
 int genPerezSkyVector(int month, int day, float hour, float direct, float diffuse, float albedo, float latitude, float longitude, float standardMeridian, int skyMF, bool sunOnly, bool sharpSun, float rotation, ColorMatrix * skyVec);
 
 
+//! Calculates the sky vector of a static sky (e.g. a CIE sky from GENSKY)
+/*!
+ The sky description is sampled into the Reinhart patches by 
+ Radiance's GENSKYVEC, so any sky (including its sun, which ends up 
+ in the patches around it) can be evaluated through a Daylight 
+ Coefficient matrix.
+ 
+ @author German Molina
+ @param sky The command that writes the sky description (e.g. "gensky -ang 45 40 -c -B 100")
+ @param skyMF The sky subdivition scheme
+ @param[out] skyVec The resulting nBins x 1 sky vector
+ @return success
+ */
+bool genSkyVector(std::string sky, int skyMF, ColorMatrix * skyVec);
+
+
+//! Calculates a set of sky vectors according to the Perez model
+/*!
+ The sky patches are initialized once per subdivision scheme and the
+ sun positions are taken from the InterpolatedWeather. The Perez
+ parameters are calculated for every timestep first, and then the
+ luminance of each patch is evaluated for all the timesteps at once
+ (see GenDayMtx::CalcSkyPatchLuminBatch()), so this is much cheaper
+ than calling genPerezSkyVector() for every timestep.
+ 
+ @author German Molina
+ @param weather The interpolated weather
+ @param firstStep The first timestep (in the interpolated weather) to calculate
+ @param nSteps The number of timesteps to calculate
+ @param albedo The albedo in the location
+ @param skyMF The sky subdivition scheme
+ @param sunOnly Option for avoiding the sky, calculating only the sun
+ @param sharpSun An option to use the -5 option in gendaymtx
+ @param rotation Rotate the sky (in degrees)
+ @param[out] skyMatrix The resulting nBins x nSteps sky matrix
+ @param[out] sharpPatches The patch that uses the sun in each timestep (may be nullptr)
+ */
+void genPerezSkyMatrix(const InterpolatedWeather * weather, size_t firstStep, size_t nSteps, float albedo, int skyMF, bool sunOnly, bool sharpSun, float rotation, ColorMatrix * skyMatrix, std::vector<int> * sharpPatches);
+
 void interpolatedDCTimestep(int interp, EmpModel * model, const ColorMatrix * DC, bool sunOnly, bool sharpSun, ColorMatrix * result);
 
 void calcCBDMScore(int interp, EmpModel * model, int firstMonth, int lastMonth, double early, double late, double minLux, double maxLux, const Matrix * input, Matrix * result, std::function<float(double v, double min, double max)> scoreCalculator);
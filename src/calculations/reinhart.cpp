@@ -21,27 +21,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "./reinhart.h"
 
 
-const size_t tnaz[7] = { 30, 30, 24, 24, 18, 12, 6 };
-
 size_t rnaz(size_t r, size_t MF)
 {
-  if (r > 7 * MF - 0.5) {
-    return 1;
-  }
-  else {
-    int i = (int)floor((r + 0.5f) / MF);
-    return MF*tnaz[i];
-  }
+  return reinhartRowPatches(r, MF);
 }
 
 size_t raccum(size_t r, size_t MF)
 {
-  if (r - 0.5 > 0) {
-    return rnaz(r - 1, MF) + raccum(r-1, MF);
-  }
-  else {
-    return 0;
-  }
+  if (MF >= 1 && MF <= EMP_MAX_TABULATED_MF && r <= 7 * MF + 1)
+    return reinhartRowOffsets.accum[MF][r];
+    
+  size_t ret = 0;
+  for (size_t i = 0; i < r; i++)
+    ret += rnaz(i, MF);
+  return ret;
 }
 
 size_t nReinhartBins(int MF)
@@ -66,29 +59,40 @@ int mfFromNBins(const int nbins)
 
 size_t Rfindrow(size_t r, size_t rem, size_t MF)
 {
+  // Skip the rows whose patches are all before 'rem'
   size_t rnazr = rnaz(r, MF);
-  int aux = (int)(rem - rnazr);
-  if (aux > 0.5) {
-    return Rfindrow(r + 1, rem - rnazr, MF);
-  }
-  else {
-    return r;
+  while (rem > rnazr) {
+    rem -= rnazr;
+    rnazr = rnaz(++r, MF);
   }
+  return r;
 }
 
 size_t Rfindrow(size_t rem, size_t MF)
 {
+    const ReinhartTable * table = getReinhartTable(MF);
+    if (table != nullptr && rem < table->nBins)
+        return table->row[rem];
+    
     return  Rfindrow(0, rem, MF);
 }
 
 
 Vector3D reinhartCenterDir(size_t nbin, size_t MF)
 {
+  const ReinhartTable * table = getReinhartTable(MF);
+  if (table != nullptr && nbin < table->nBins)
+    return table->centerDir[nbin];
+  
   return reinhartCenterDir(nbin, MF, NULL);
 }
 
 double reinhartSolidAngle(size_t nbin, size_t MF)
 {
+  const ReinhartTable * table = getReinhartTable(MF);
+  if (table != nullptr && nbin < table->nBins)
+    return table->solidAngle[nbin];
+  
   double ret;
   reinhartCenterDir(nbin, MF, &ret);
   return ret;
@@ -96,7 +100,14 @@ double reinhartSolidAngle(size_t nbin, size_t MF)
 
 Vector3D reinhartCenterDir(size_t nbin, size_t MF, double * solidAngle)
 {
-    return reinhartDir(nbin, MF, 0.5, 0.5, solidAngle) ;
+  const ReinhartTable * table = getReinhartTable(MF);
+  if (table != nullptr && nbin < table->nBins) {
+    if (solidAngle != NULL)
+      *solidAngle = table->solidAngle[nbin];
+    return table->centerDir[nbin];
+  }
+  
+  return reinhartDir(nbin, MF, 0.5, 0.5, solidAngle) ;
 }
 
 Vector3D reinhartDir(size_t nbin, size_t MF,  const double x1, const double x2)
@@ -104,22 +115,23 @@ Vector3D reinhartDir(size_t nbin, size_t MF,  const double x1, const double x2)
     return reinhartDir(nbin, MF, x1, x2, NULL);
 }
 
-Vector3D reinhartDir(size_t nbin, size_t MF,  const double x1, const double x2, double * solidAngle)
+//! Calculates a direction within a patch whose row is already known
+/*!
+@author German Molina
+@param[in] nbin The bin number
+@param[in] Rrow The row of the bin
+@param[in] MF the sky subdivition scheme
+@param[in] x1 The vertical relative position of the direction in the patch
+@param[in] x2 The horizontal relative position of the direction in the patch
+@param[out] solidAngle The solid angle of the patch (may be NULL)
+@return The direction
+*/
+static Vector3D reinhartDirInRow(size_t nbin, size_t Rrow, size_t MF, const double x1, const double x2, double * solidAngle)
 {
   const double PI = 3.141592654;
-  const double alpha = 90.0 / (MF * 7 + 0.5);  
+  const double alpha = 90.0 / (MF * 7 + 0.5);
   const double RAH = alpha *PI / 180.0;
   const size_t RowMax = 7 * MF + 1;
-  const size_t Rmax = raccum(RowMax,MF);
-  
-  size_t Rrow; 
-  if (nbin - (Rmax - .5) > 0) {
-    Rrow = RowMax - 1;
-  }
-  else {
-    Rrow = Rfindrow(0, nbin, MF);
-  }
-
 
   // Find Ralt
   double Ralt;
@@ -162,11 +174,77 @@ Vector3D reinhartDir(size_t nbin, size_t MF,  const double x1, const double x2,
   return Vector3D(dx, dy, dz);
 }
 
+Vector3D reinhartDir(size_t nbin, size_t MF,  const double x1, const double x2, double * solidAngle)
+{
+  const size_t RowMax = 7 * MF + 1;
+  const size_t Rmax = raccum(RowMax,MF);
+  
+  size_t Rrow; 
+  if (nbin - (Rmax - .5) > 0) {
+    Rrow = RowMax - 1;
+  }
+  else {
+    Rrow = Rfindrow(nbin, MF);
+  }
+
+  return reinhartDirInRow(nbin, Rrow, MF, x1, x2, solidAngle);
+}
+
 
 double coneSolidAngle(double angle)
 {
   return 2.0 * 3.141592654 * (1 - cos(angle));
 }
 
+//! Builds the tables for all the tabulated sky subdivitions
+/*!
+@author German Molina
+@return The tables, indexed by MF (index 0 is empty)
+*/
+static std::vector<ReinhartTable> buildReinhartTables()
+{
+  std::vector<ReinhartTable> tables = std::vector<ReinhartTable>(EMP_MAX_TABULATED_MF + 1);
+  
+  for (size_t mf = 1; mf <= EMP_MAX_TABULATED_MF; mf++) {
+    ReinhartTable * t = &tables[mf];
+    const size_t nRows = 7 * mf + 1;
+    
+    t->MF = mf;
+    t->nBins = 1 + reinhartRowOffsets.accum[mf][nRows];
+    t->row.reserve(t->nBins);
+    t->col.reserve(t->nBins);
+    t->centerDir.reserve(t->nBins);
+    t->solidAngle.reserve(t->nBins);
+    
+    // Ground (it is reported in row 0)
+    double sa;
+    t->row.push_back(0);
+    t->col.push_back(0);
+    t->centerDir.push_back(reinhartDirInRow(0, 0, mf, 0.5, 0.5, &sa));
+    t->solidAngle.push_back(sa);
+    
+    // Sky
+    for (size_t r = 0; r < nRows; r++) {
+      const size_t n = reinhartRowPatches(r, mf);
+      for (size_t c = 0; c < n; c++) {
+        const size_t bin = t->centerDir.size();
+        t->row.push_back((unsigned short)r);
+        t->col.push_back((unsigned short)c);
+        t->centerDir.push_back(reinhartDirInRow(bin, r, mf, 0.5, 0.5, &sa));
+        t->solidAngle.push_back(sa);
+      }
+    }
+  }
+  
+  return tables;
+}
 
-
+const ReinhartTable * getReinhartTable(size_t MF)
+{
+  if (MF < 1 || MF > EMP_MAX_TABULATED_MF)
+    return nullptr;
+  
+  // Built once, on first use (thread-safe since C++11)
+  static const std::vector<ReinhartTable> tables = buildReinhartTables();
+  return &tables[MF];
+}
@@ -20,8 +20,77 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <stddef.h>
+#include <vector>
 #include "../common/geometry/vector.h"
 
+/// The largest Reinhart subdivition scheme for which lookup tables are precomputed
+#define EMP_MAX_TABULATED_MF 12
+
+/// The number of patches in each row of the original (MF=1) Tregenza sky, without the polar cap
+constexpr size_t reinhartTnaz[7] = { 30, 30, 24, 24, 18, 12, 6 };
+
+//! Returns the number of patches in a sky row (see rnaz())
+/*!
+@author German Molina
+@param[in] r The row number
+@param[in] MF The sky divition scheme
+@return The number of patches
+*/
+constexpr size_t reinhartRowPatches(size_t r, size_t MF)
+{
+    return (r >= 7 * MF) ? 1 : MF * reinhartTnaz[r / MF];
+}
+
+//! The accumulated number of patches before each sky row, for every tabulated MF
+/*!
+accum[MF][r] is equivalent to raccum(r,MF), for r in [0, 7*MF+1]
+*/
+struct ReinhartRowOffsets {
+    size_t accum[EMP_MAX_TABULATED_MF + 1][7 * EMP_MAX_TABULATED_MF + 2] = {}; //!< The accumulated number of patches
+};
+
+//! Builds the ReinhartRowOffsets at compile time
+/*!
+@author German Molina
+@return The row offsets
+*/
+constexpr ReinhartRowOffsets buildReinhartRowOffsets()
+{
+    ReinhartRowOffsets t = ReinhartRowOffsets();
+    for (size_t mf = 1; mf <= EMP_MAX_TABULATED_MF; mf++) {
+        t.accum[mf][0] = 0;
+        for (size_t r = 1; r <= 7 * mf + 1; r++)
+            t.accum[mf][r] = t.accum[mf][r - 1] + reinhartRowPatches(r - 1, mf);
+    }
+    return t;
+}
+
+/// The row offsets of all tabulated sky subdivitions
+constexpr ReinhartRowOffsets reinhartRowOffsets = buildReinhartRowOffsets();
+
+//! Precomputed information of every patch in a Reinhart sky
+/*!
+Built once per MF (see getReinhartTable()), and shared read-only after that.
+*/
+class ReinhartTable {
+public:
+    size_t MF = 0; //!< The sky subdivition scheme
+    size_t nBins = 0; //!< The number of patches, including the ground
+    std::vector<unsigned short> row = std::vector<unsigned short>(); //!< The row of each patch
+    std::vector<unsigned short> col = std::vector<unsigned short>(); //!< The column of each patch within its row
+    std::vector<Vector3D> centerDir = std::vector<Vector3D>(); //!< The direction of the center of each patch
+    std::vector<double> solidAngle = std::vector<double>(); //!< The solid angle of each patch
+};
+
+//! Retrieves the precomputed table of a certain Reinhart subdivition
+/*!
+@author German Molina
+@param[in] MF The sky subdivition scheme
+@return The table, or nullptr if MF is not tabulated
+*/
+const ReinhartTable * getReinhartTable(size_t MF);
+
 //! Returns the number of patches in a sky row
 /*!
 Auxiliar function present in reinhart.cal and reinsrc.cal files
@@ -0,0 +1,160 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "./sensor_set.h"
+
+//! The number of sensors formatted before writing them to a file
+#define EMP_SENSOR_WRITE_BATCH 1024
+
+SensorSet::SensorSet()
+{
+    
+}
+
+SensorSet::SensorSet(size_t n)
+{
+    resize(n);
+}
+
+size_t SensorSet::size() const
+{
+    return areas.size();
+}
+
+void SensorSet::resize(size_t n)
+{
+    const size_t old = size();
+    origins.resize(3*n, 0);
+    directions.resize(3*n, 0);
+    areas.resize(n, 0);
+    ids.resize(n, -1);
+    
+    // Point up
+    for(size_t i = old; i < n; i++)
+        directions[3*i+2] = 1;
+}
+
+void SensorSet::reserve(size_t n)
+{
+    origins.reserve(3*n);
+    directions.reserve(3*n);
+    areas.reserve(n);
+    ids.reserve(n);
+}
+
+void SensorSet::clear()
+{
+    origins.clear();
+    directions.clear();
+    areas.clear();
+    ids.clear();
+}
+
+void SensorSet::append(const SensorSet * other)
+{
+    origins.insert(origins.end(), other->origins.begin(), other->origins.end());
+    directions.insert(directions.end(), other->directions.begin(), other->directions.end());
+    areas.insert(areas.end(), other->areas.begin(), other->areas.end());
+    ids.insert(ids.end(), other->ids.begin(), other->ids.end());
+}
+
+size_t SensorSet::addSensor(float ox, float oy, float oz, float dx, float dy, float dz, float area, int32_t id)
+{
+    origins.push_back(ox);
+    origins.push_back(oy);
+    origins.push_back(oz);
+    directions.push_back(dx);
+    directions.push_back(dy);
+    directions.push_back(dz);
+    areas.push_back(area);
+    ids.push_back(id);
+    return size() - 1;
+}
+
+void SensorSet::setOrigin(size_t i, float x, float y, float z)
+{
+    origins[3*i] = x;
+    origins[3*i+1] = y;
+    origins[3*i+2] = z;
+}
+
+void SensorSet::setDirection(size_t i, float x, float y, float z)
+{
+    directions[3*i] = x;
+    directions[3*i+1] = y;
+    directions[3*i+2] = z;
+}
+
+void SensorSet::setArea(size_t i, float area)
+{
+    areas[i] = area;
+}
+
+void SensorSet::setID(size_t i, int32_t id)
+{
+    ids[i] = id;
+}
+
+const float * SensorSet::getOrigin(size_t i) const
+{
+    return &origins[3*i];
+}
+
+const float * SensorSet::getDirection(size_t i) const
+{
+    return &directions[3*i];
+}
+
+float SensorSet::getArea(size_t i) const
+{
+    return areas[i];
+}
+
+int32_t SensorSet::getID(size_t i) const
+{
+    return ids[i];
+}
+
+bool SensorSet::write(FILE * file) const
+{
+    if(file == NULL)
+        return false;
+    
+    // Format in batches, so the file is written in big chunks
+    std::vector<char> buffer = std::vector<char>();
+    const size_t nSensors = size();
+    char line[512];
+    for(size_t i = 0; i < nSensors; i++){
+        const float * o = &origins[3*i];
+        const float * d = &directions[3*i];
+        int n = snprintf(line, sizeof(line), "%f %f %f %f %f %f\n", o[0], o[1], o[2], d[0], d[1], d[2]);
+        if(n < 0 || (size_t)n >= sizeof(line))
+            return false;
+        buffer.insert(buffer.end(), line, line + n);
+        
+        if((i+1) % EMP_SENSOR_WRITE_BATCH == 0 || i + 1 == nSensors){
+            if(fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+                return false;
+            buffer.clear();
+        }
+    }
+    
+    return true;
+}
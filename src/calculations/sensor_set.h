@@ -0,0 +1,189 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+//! A set of sensors, with an origin, a direction, an area and an ID each
+/*!
+ Sensors are stored as a struct of arrays of floats, so large sets
+ stay compact (32 bytes per sensor) and can be traversed without 
+ jumping around in memory. 
+ 
+ The area and ID are optional: sensors created from a Workplane have 
+ the area and index of the triangle they represent, while loose 
+ sensors have an area of 0 and an ID of -1.
+ */
+
+class SensorSet {
+    
+private:
+    std::vector<float> origins = std::vector<float>(); //!< The X, Y and Z of the origin of each sensor
+    std::vector<float> directions = std::vector<float>(); //!< The X, Y and Z of the direction of each sensor
+    std::vector<float> areas = std::vector<float>(); //!< The area represented by each sensor
+    std::vector<int32_t> ids = std::vector<int32_t>(); //!< The ID of each sensor
+    
+public:
+    
+    //! Default constructor
+    SensorSet();
+    
+    //! Constructor by size
+    /*!
+     Sensors are at the origin, pointing up
+     
+     @author German Molina
+     @param[in] n The number of sensors
+     */
+    SensorSet(size_t n);
+    
+    //! Retrieves the number of sensors
+    /*!
+     @author German Molina
+     @return The number of sensors
+     */
+    size_t size() const;
+    
+    //! Changes the number of sensors
+    /*!
+     New sensors are at the origin, pointing up
+     
+     @author German Molina
+     @param[in] n The new number of sensors
+     */
+    void resize(size_t n);
+    
+    //! Reserves memory for a number of sensors
+    /*!
+     @author German Molina
+     @param[in] n The number of sensors
+     */
+    void reserve(size_t n);
+    
+    //! Removes all the sensors
+    /*!
+     @author German Molina
+     */
+    void clear();
+    
+    //! Appends all the sensors of another SensorSet
+    /*!
+     @author German Molina
+     @param[in] other The SensorSet to copy the sensors from
+     */
+    void append(const SensorSet * other);
+    
+    //! Adds a sensor
+    /*!
+     @author German Molina
+     @param[in] ox The X component of the origin
+     @param[in] oy The Y component of the origin
+     @param[in] oz The Z component of the origin
+     @param[in] dx The X component of the direction
+     @param[in] dy The Y component of the direction
+     @param[in] dz The Z component of the direction
+     @param[in] area The area represented by the sensor
+     @param[in] id The ID of the sensor
+     @return The index of the new sensor
+     */
+    size_t addSensor(float ox, float oy, float oz, float dx, float dy, float dz, float area = 0, int32_t id = -1);
+    
+    //! Sets the origin of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @param[in] x The X component
+     @param[in] y The Y component
+     @param[in] z The Z component
+     */
+    void setOrigin(size_t i, float x, float y, float z);
+    
+    //! Sets the direction of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @param[in] x The X component
+     @param[in] y The Y component
+     @param[in] z The Z component
+     */
+    void setDirection(size_t i, float x, float y, float z);
+    
+    //! Sets the area represented by a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @param[in] area The area
+     */
+    void setArea(size_t i, float area);
+    
+    //! Sets the ID of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @param[in] id The ID
+     */
+    void setID(size_t i, int32_t id);
+    
+    //! Retrieves the origin of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @return A pointer to its X, Y and Z components
+     */
+    const float * getOrigin(size_t i) const;
+    
+    //! Retrieves the direction of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @return A pointer to its X, Y and Z components
+     */
+    const float * getDirection(size_t i) const;
+    
+    //! Retrieves the area represented by a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @return The area
+     */
+    float getArea(size_t i) const;
+    
+    //! Retrieves the ID of a sensor
+    /*!
+     @author German Molina
+     @param[in] i The index of the sensor
+     @return The ID
+     */
+    int32_t getID(size_t i) const;
+    
+    //! Writes the sensors in the format read by RTRACE and RCONTRIB
+    /*!
+     One sensor per line, with its origin and direction.
+     
+     @author German Molina
+     @param[in] file The file (or pipe) to write into
+     @return success
+     */
+    bool write(FILE * file) const;
+};
@@ -29,7 +29,7 @@ public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     
     //* Process a Workplane
@@ -60,7 +60,7 @@ public:
     /*!
      @author German Molina
      */
-    Calculate4CMDirectSkyMatrix(EmpModel * theModel, std::vector<RAY> * theRays, int theMF)
+    Calculate4CMDirectSkyMatrix(EmpModel * theModel, SensorSet * theRays, int theMF)
     {
         
         std::string name = "Create DirectSkyMatrix";
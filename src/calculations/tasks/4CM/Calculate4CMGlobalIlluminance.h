@@ -32,7 +32,7 @@ public:
     int skyMF; //!< The Reinhart subdivition scheme for the sky
     int sunMF; //!< The Reinhart subdivition scheme for the sun
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     RTraceOptions * options; //!< The options passed to rcontrib procsses
     ColorMatrix result; //!< The resulting matrix
     int interp; //!< The interpolation scheme
@@ -64,7 +64,7 @@ public:
     }
     
     
-    Calculate4CMGlobalIlluminance(EmpModel * theModel,  std::vector<RAY> * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
+    Calculate4CMGlobalIlluminance(EmpModel * theModel,  SensorSet * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
     {
         
         std::string name = "Calculate4CMGlobalIlluminance";
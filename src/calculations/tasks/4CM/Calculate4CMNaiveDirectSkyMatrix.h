@@ -27,7 +27,7 @@ public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     
     Calculate4CMNaiveDirectSkyMatrix(EmpModel * theModel, Workplane * wp, int theMF)
@@ -51,7 +51,7 @@ public:
         
     }
     
-    Calculate4CMNaiveDirectSkyMatrix(EmpModel * theModel, std::vector<RAY> * theRays, int theMF)
+    Calculate4CMNaiveDirectSkyMatrix(EmpModel * theModel, SensorSet * theRays, int theMF)
     {
         
         std::string name = "Create DirectSkyMatrix";
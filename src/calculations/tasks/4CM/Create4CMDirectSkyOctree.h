@@ -64,48 +64,47 @@ public:
         
         std::string octName = static_cast<OconvTask *>(getDependencyRef(0))->getName() + ".oct";
         octreeName = "DIRECT_SKY_" + octName;
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
         
         //remove(&octreeName[0]);
         
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "void light element 0 0 3 %f %f %f\n",elementBrighness,elementBrighness,elementBrighness);
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "void light element 0 0 3 %f %f %f\n",elementBrighness,elementBrighness,elementBrighness);
         
         
         
-        // define altitide
-        double altitude = dAngle/2.0;
+            // define altitide
+            double altitude = dAngle/2.0;
         
         
-        // The numbr of sources that fit a band
-        size_t nSourcesInBand;
+            // The numbr of sources that fit a band
+            size_t nSourcesInBand;
         
-        // Element width
-        double elementWidth;
+            // Element width
+            double elementWidth;
         
-        // Iterate going up
-        int band = 0;
-        while (altitude < 1.57079632679){
-            nSourcesInBand = (size_t)floor(pi * cos(altitude) / tan(dAngle/2.0));
+            // Iterate going up
+            int band = 0;
+            while (altitude < 1.57079632679){
+                nSourcesInBand = (size_t)floor(pi * cos(altitude) / tan(dAngle/2.0));
             
-            // Increase the solid angle
-            elementWidth = desiredElementWidth;
+                // Increase the solid angle
+                elementWidth = desiredElementWidth;
             
-            // Write
-            double dAz = 2*pi/nSourcesInBand;
-            double az = dAz/2;
-            for (int i = 0; i < nSourcesInBand; i++){
-                fprintf(octree,"element source %d_%d 0 0 4 %f %f %f %f\n", band, i, sin(az)*cos(altitude),cos(az)*cos(altitude),sin(altitude),elementWidth);
+                // Write
+                double dAz = 2*pi/nSourcesInBand;
+                double az = dAz/2;
+                for (int i = 0; i < nSourcesInBand; i++){
+                    fprintf(octree,"element source %d_%d 0 0 4 %f %f %f %f\n", band, i, sin(az)*cos(altitude),cos(az)*cos(altitude),sin(altitude),elementWidth);
                 
-                az += dAz;
+                    az += dAz;
+                }
+                band ++;
+                altitude += dAngle;
             }
-            band ++;
-            altitude += dAngle;
-        }
         
-        PCLOSE(octree);
+        });
         
-        return true;
+        return success;
     }
     
     //! Is mutex
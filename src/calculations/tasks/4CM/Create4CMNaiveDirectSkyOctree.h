@@ -61,24 +61,22 @@ public:
     
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = static_cast<OconvTask *>(getDependencyRef(0))->getName() + ".oct";
         octreeName = "NAIVE_DIRECT_SKY_" + octName;
         //remove(&octreeName[0]);
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
         
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "void light solar 0 0 3 1 1 1\n");
-        size_t nbins = nReinhartBins(mf);
-        Vector3D dir = Vector3D(0,0,0);
-        for(size_t bin = 1; bin <= nbins; bin++){
-            dir = reinhartCenterDir(bin,mf);
-            fprintf(octree, "solar source sun 0 0 4 %f %f %f 11.000\n", dir.getX(), dir.getY(), dir.getZ());
-        }
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "void light solar 0 0 3 1 1 1\n");
+            size_t nbins = nReinhartBins(mf);
+            Vector3D dir = Vector3D(0,0,0);
+            for(size_t bin = 1; bin <= nbins; bin++){
+                dir = reinhartCenterDir(bin,mf);
+                fprintf(octree, "solar source sun 0 0 4 %f %f %f 11.000\n", dir.getX(), dir.getY(), dir.getZ());
+            }
         
-        PCLOSE(octree);
+        });
         
-        return true;
+        return success;
     }
     
     //! Is mutex
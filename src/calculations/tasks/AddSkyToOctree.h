@@ -28,6 +28,20 @@
 #include "./OconvTask.h"
 #include "../../taskmanager/mutexes.h"
 
+//! Creates an octree with a sky and the (frozen) scene of an OconvTask
+/*!
+ The scene is frozen once, and each sky octree only holds the sky and
+ an 'instance' of the scene; so several skies on the same geometry do
+ not rebuild (or copy) the scene.
+ 
+ The frozen scene is its own OconvTask, so a run that also needs the
+ regular octree of the same model builds the scene twice (once frozen).
+ 
+ RADIANCE does not treat the light, glow and spotlight materials inside
+ an instance as light sources, so models with emitting materials (see
+ EmpModel::hasEmittingMaterials()) add the sky to a copy of the regular
+ octree instead (i.e. oconv -i).
+ */
 class AddSkyToOctree : public Task {
 
 public:
@@ -35,6 +49,7 @@ public:
     std::string octreeName; //!< The name of the final octree
     OconvOptions options;//!< The options passed to the octree
     std::string sky; //!< The sky to add to the octree
+    bool instanceScene; //!< Is the scene instanced (or copied)?
 
 
     AddSkyToOctree(EmpModel * theModel, OconvOptions * theOptions, std::string theSky)
@@ -46,8 +61,12 @@ public:
         std::string name = "Add sky "+theSky;
         setName(&name);
         
-        // Dependency 0: Add the oconv task
-        OconvTask * oconvTask = new OconvTask(model,&options);
+        // Dependency 0: Add the oconv task... frozen, so it can be instanced
+        instanceScene = !model->hasEmittingMaterials();
+        OconvOptions sceneOptions = options;
+        if (instanceScene)
+            sceneOptions.setOption(OCONV_FREEZE, true);
+        OconvTask * oconvTask = new OconvTask(model,&sceneOptions);
         addDependency(oconvTask);
         
         // Set octree name
@@ -65,24 +84,29 @@ public:
     {
         return (
                 model == static_cast<AddSkyToOctree *>(t)->model &&
-                sky == static_cast<AddSkyToOctree *>(t)->sky
+                sky == static_cast<AddSkyToOctree *>(t)->sky &&
+                options.isEqual(&static_cast<AddSkyToOctree *>(t)->options)
                 );
     }
     
     bool solve()
     {
         
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = (static_cast<OconvTask *>(getDependencyRef(0))->octreeName);
-                
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
         
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "!%s\n",&sky[0]);
-        fprintf(octree, RADIANCE_SKY_COMPLEMENT);
-        PCLOSE(octree);
+        if (!instanceScene) {
+            return addToOctree(octName, octreeName, [&](FILE * octree) {
+                fprintf(octree, "!%s\n",&sky[0]);
+                fprintf(octree, RADIANCE_SKY_COMPLEMENT);
+            });
+        }
         
-        return true;
+        std::vector<std::string> scene = std::vector<std::string>(1, octName);
+        return cachedOconv(octreeName, false, "", &scene, [&](FILE * octree) {
+            fprintf(octree, "void instance scene\n1 %s\n0\n0\n\n", &octName[0]);
+            fprintf(octree, "!%s\n",&sky[0]);
+            fprintf(octree, RADIANCE_SKY_COMPLEMENT);
+        });
     }
     
     //! Is mutex
@@ -31,7 +31,7 @@ private:
     int skyMF; //!< The Reinhart subdivition scheme for the sky
     int sunMF; //!< The Reinhart subdivition scheme for the sun
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     RTraceOptions * options; //!< The options passed to rcontrib procsses
     Matrix result; //!< The resulting matrix
     int interp; //!< The interpolation scheme
@@ -56,7 +56,7 @@ public:
     }
     
     
-    Calculate2PhaseGlobalIlluminance(EmpModel * theModel,  std::vector<RAY> * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
+    Calculate2PhaseGlobalIlluminance(EmpModel * theModel,  SensorSet * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
     {
         
         std::string n = "2-Phase Iluminance";
@@ -23,18 +23,27 @@
 #include "../radiance.h"
 #include "../oconv_options.h"
 #include "./AddSkyToOctree.h"
+#include "./TriangulateWorkplane.h"
+
+//! The maximum number of times the sensors of a Workplane are refined (see Workplane::setRefinementThreshold())
+#define EMP_ADAPTIVE_MAX_PASSES 4
+
+//! Triangles smaller than the Workplane's maximum area divided by this are not refined
+#define EMP_ADAPTIVE_MIN_AREA_FACTOR 8
 
 class CalculateStaticIlluminance : public Task {
     
 public:
     EmpModel * model; //!< The model
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix result; //!< The resulting matrix
     RTraceOptions * rtraceOptions; //!< The options passed to rcontrib
     OconvOptions * oconvOptions; //!< The OconvOptions
-    std::string ambientFileName; //!< The name of the ambient file used
+    std::string ambientFileName; //!< The name of the ambient file used when the ambient cache is disabled
     std::string sky; //!< The sky to add to the octree
+    bool refined = false; //!< Whether the sensors of the workplane were refined
+    TriangleMesh mesh = TriangleMesh(); //!< The refined sensors (see Workplane::setRefinementThreshold())
     
     CalculateStaticIlluminance(EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, OconvOptions * theOconvOptions, std::string theSky)
     {
@@ -58,7 +67,7 @@ public:
         setName(&name);
     }
     
-    CalculateStaticIlluminance(EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays , OconvOptions * theOconvOptions, std::string theSky)
+    CalculateStaticIlluminance(EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays , OconvOptions * theOconvOptions, std::string theSky)
     {
         model = theModel;
         rtraceOptions = theOptions;
@@ -108,13 +117,84 @@ public:
         
         ColorMatrix aux = ColorMatrix(nrays,1);
         
-        rtrace_I(rtraceOptions, &octname[0], ambientFileName, rays, &aux);
+        cachedRTrace_I(rtraceOptions, &octname[0], ambientFileName, rays, &aux);
         
         aux.calcIlluminance(&result);
         
+        if(workplane != nullptr && workplane->getRefinementThreshold() > 0)
+            refine(&octname[0]);
+        
         return true;
     }
     
+    //! Refines the sensors where the illuminance changes too fast
+    /*!
+     Starting from the result of the workplane's triangulation, the
+     triangles whose sensor's illuminance differs too much from their 
+     neighbors' are split (see TriangleMesh::refine()). Only the new sensors are 
+     traced, and this is repeated until nothing changes or 
+     EMP_ADAPTIVE_MAX_PASSES is reached.
+     
+     @author German Molina
+     @param[in] octname The name of the octree
+     */
+    void refine(char * octname)
+    {
+        const double threshold = workplane->getRefinementThreshold();
+        const double minArea = workplane->getMaxArea() / EMP_ADAPTIVE_MIN_AREA_FACTOR;
+        
+        mesh = static_cast<TriangulateWorkplane *>(getDependencyRef(1))->mesh;
+        refined = true;
+        
+        std::vector<double> values = std::vector<double>(result.nrows());
+        for(size_t i = 0; i < values.size(); i++)
+            values[i] = result.getElement(i,0);
+        
+        std::vector<char> changed = std::vector<char>();
+        SensorSet newRays = SensorSet();
+        for(int pass = 0; pass < EMP_ADAPTIVE_MAX_PASSES; pass++){
+            
+            const size_t nChanged = mesh.refine(&values, threshold, minArea, &changed);
+            if(nChanged == 0)
+                break;
+            
+            // Trace only the sensors that changed
+            TriangulateWorkplane::fillRays(&mesh, &newRays, &changed);
+            
+            ColorMatrix aux = ColorMatrix(nChanged,1);
+            Matrix illuminance = Matrix(nChanged,1);
+            cachedRTrace_I(rtraceOptions, octname, ambientFileName, &newRays, &aux);
+            aux.calcIlluminance(&illuminance);
+            
+            values.resize(changed.size());
+            size_t n = 0;
+            for(size_t i = 0; i < changed.size(); i++){
+                if(changed[i])
+                    values[i] = illuminance.getElement(n++,0);
+            }
+        }
+        
+        result.resize(values.size(),1);
+        for(size_t i = 0; i < values.size(); i++)
+            result.setElement(i,0,(float)values[i]);
+    }
+    
+    //! Retrieves the sensors on which the results were calculated
+    /*!
+     @author German Molina
+     @return The TriangleMesh (or nullptr if the task was not based on a Workplane)
+     */
+    const TriangleMesh * getMesh()
+    {
+        if(refined)
+            return &mesh;
+        
+        if(workplane == nullptr)
+            return nullptr;
+        
+        return &(static_cast<TriangulateWorkplane *>(getDependencyRef(1))->mesh);
+    }
+    
     bool isMutex(Task * t)
     {
         return (
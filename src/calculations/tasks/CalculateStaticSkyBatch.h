@@ -0,0 +1,189 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "../radiance.h"
+#include "./DDC/CalculateDDCGlobalMatrix.h"
+
+//! Calculates the illuminance under several static skies, tracing only once
+/*!
+ Instead of building an octree and running RTRACE for each sky (as 
+ CalculateStaticIlluminance does), a Daylight Coefficient matrix is 
+ calculated once for the Workplane or sensors (see CalculateDDCGlobalMatrix)
+ and each sky is evaluated as a matrix-vector product with its sky vector
+ (see genSkyVector()).
+ 
+ The result has one row per sensor and one column per sky. Suns are 
+ smeared into the sky patches around them, so sharp shadows are not 
+ resolved; this is meant for overcast and design skies.
+ */
+class CalculateStaticSkyBatch : public Task {
+    
+private:
+    EmpModel * model; //!< The model
+    int mf; //!< The Reinhart sky subdivition scheme
+    Workplane * workplane = nullptr; //!< The workplane to which the illuminance will be calculated
+    SensorSet * rays = nullptr; //!< The rays to process
+    RTraceOptions options; //!< The options passed to RContrib
+    std::vector<std::string> skies; //!< The skies to evaluate
+    Matrix result; //!< The resulting illuminance, one column per sky
+    
+public:
+    
+    //! Process a Workplane
+    /*!
+     @author German Molina
+     @param[in] theModel The model
+     @param[in] wp The workplane
+     @param[in] theSkies The skies to evaluate (e.g. "gensky -ang 45 40 -c -B 100")
+     @param[in] theMF The Reinhart sky subdivition scheme
+     @param[in] theOptions The options passed to RContrib
+     */
+    CalculateStaticSkyBatch(EmpModel * theModel, Workplane * wp, std::vector<std::string> theSkies, int theMF, RTraceOptions * theOptions)
+    {
+        std::string n = "Static sky batch "+wp->getName();
+        setName(&n);
+        model = theModel;
+        workplane = wp;
+        skies = theSkies;
+        mf = theMF;
+        options = *theOptions;
+        
+        // Dependency 0: The Daylight Coefficients
+        CalculateDDCGlobalMatrix * dcTask = new CalculateDDCGlobalMatrix(model, workplane, mf, &options);
+        addDependency(dcTask);
+    }
+    
+    //! Process a vector of rays
+    /*!
+     @author German Molina
+     @param[in] theModel The model
+     @param[in] theRays The sensors
+     @param[in] theSkies The skies to evaluate (e.g. "gensky -ang 45 40 -c -B 100")
+     @param[in] theMF The Reinhart sky subdivition scheme
+     @param[in] theOptions The options passed to RContrib
+     */
+    CalculateStaticSkyBatch(EmpModel * theModel, SensorSet * theRays, std::vector<std::string> theSkies, int theMF, RTraceOptions * theOptions)
+    {
+        std::string n = "Static sky batch";
+        setName(&n);
+        model = theModel;
+        rays = theRays;
+        skies = theSkies;
+        mf = theMF;
+        options = *theOptions;
+        
+        // Dependency 0: The Daylight Coefficients
+        CalculateDDCGlobalMatrix * dcTask = new CalculateDDCGlobalMatrix(model, rays, mf, &options);
+        addDependency(dcTask);
+    }
+    
+    //! Retrieves the results
+    /*!
+     @author German Molina
+     @return The illuminance, one row per sensor and one column per sky
+     */
+    Matrix * getResult()
+    {
+        return &result;
+    }
+    
+    //! Retrieves the skies evaluated
+    /*!
+     @author German Molina
+     @return The skies, in the order of the columns of the result
+     */
+    const std::vector<std::string> * getSkies() const
+    {
+        return &skies;
+    }
+    
+    bool isEqual(Task * t)
+    {
+        CalculateStaticSkyBatch * other = static_cast<CalculateStaticSkyBatch *>(t);
+        return (
+                model == other->model &&
+                mf == other->mf &&
+                workplane == other->workplane &&
+                rays == other->rays &&
+                skies == other->skies &&
+                options.isEqual(&other->options)
+                );
+    }
+    
+    bool solve()
+    {
+        const ColorMatrix * DC = static_cast<CalculateDDCGlobalMatrix *>(getDependencyRef(0))->getResult();
+        const size_t nSensors = DC->nrows();
+        const size_t nSkies = skies.size();
+        
+        // Sample the skies... they are cheap, compared to the DC
+        ColorMatrix skyMatrix = ColorMatrix(nReinhartBins(mf), nSkies);
+        for (size_t i = 0; i < nSkies; i++) {
+            ColorMatrix skyVec = ColorMatrix();
+            if (!genSkyVector(skies[i], mf, &skyVec))
+                return false;
+            
+            for (size_t bin = 0; bin < skyVec.nrows(); bin++) {
+                skyMatrix.r()->setElement(bin, i, skyVec.redChannel()->getElement(bin, 0));
+                skyMatrix.g()->setElement(bin, i, skyVec.greenChannel()->getElement(bin, 0));
+                skyMatrix.b()->setElement(bin, i, skyVec.blueChannel()->getElement(bin, 0));
+            }
+        }
+        
+        // All the skies at once
+        ColorMatrix irradiance = ColorMatrix(nSensors, nSkies);
+        if (!DC->multiply(&skyMatrix, &irradiance))
+            return false;
+        
+        result.resize(nSensors, nSkies);
+        irradiance.calcIlluminance(&result);
+        
+        return true;
+    }
+    
+    //! Is mutex
+    /*!
+     This method checks whether this Task is mutual exclusive with another Task;
+     but it is never mutual excusive, so it returns false
+     
+     @author German Molina
+     @param[in] t The other task
+     @return true or false
+     */
+    bool isMutex(Task * t)
+    {
+        return false;
+    }
+    
+    //! Submits the results into a json
+    /*!
+     @author German Molina
+     @param[out] results The results json object
+     @return true or false
+     */
+    bool submitResults(json * results)
+    {
+        return true;
+    }
+};
+
+extern CalculateStaticSkyBatch calcStaticSkyBatch;
@@ -51,7 +51,7 @@ CheckDACompliance::CheckDACompliance(std::string name, EmpModel * theModel, RTra
 
 
 
-CheckDACompliance::CheckDACompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, int sunMf, int skyMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
+CheckDACompliance::CheckDACompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int sunMf, int skyMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
 {
     
     model = theModel;
@@ -34,7 +34,7 @@ public:
     
     CheckDACompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, int sunMf, int skyMf, double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
     
-    CheckDACompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, int sunMf, int skyMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
+    CheckDACompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int sunMf, int skyMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
 
     GET_DEP_RESULTS(Calculate2PhaseGlobalIlluminance);
     
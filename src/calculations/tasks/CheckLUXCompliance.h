@@ -23,10 +23,15 @@
 #pragma once
 
 #include "./CalculateStaticIlluminance.h"
+#include "./CalculateStaticSkyBatch.h"
 #include "taskmanager/static_simulation_task.h"
 
 class CheckLUXCompliance : public StaticSimulationTask {
     
+private:
+    int skyIndex = -1; //!< The column of the CalculateStaticSkyBatch results used (-1 if the sky is traced on its own)
+    Matrix skyResult = Matrix(); //!< The illuminance under the sky, taken from the CalculateStaticSkyBatch
+    
 public:
     
     
@@ -47,7 +52,7 @@ public:
         setName(&name);
     }
     
-    CheckLUXCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, OconvOptions * theOconvOptions, std::string sky, double min, double max)
+    CheckLUXCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, OconvOptions * theOconvOptions, std::string sky, double min, double max)
     {
         model = theModel;
         rays = theRays;
@@ -64,9 +69,94 @@ public:
         setName(&name);
     }
     
+    //! Checks one of several skies evaluated together, on a Workplane
+    /*!
+     The illuminance is taken from a CalculateStaticSkyBatch, which is
+     shared by all the CheckLUXCompliance tasks created with the same
+     skies (the TaskManager merges the equal ones). So, a study with 
+     several skies traces the Workplane only once.
+     
+     @author German Molina
+     @param[in] name The name of the task
+     @param[in] theModel The model
+     @param[in] theOptions The options passed to RContrib
+     @param[in] wp The workplane
+     @param[in] skies All the skies of the study
+     @param[in] theSkyIndex The sky to check
+     @param[in] mf The Reinhart sky subdivition scheme
+     @param[in] min The minimum illuminance allowed
+     @param[in] max The maximum illuminance allowed
+     */
+    CheckLUXCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, std::vector<std::string> skies, size_t theSkyIndex, int mf, double min, double max)
+    {
+        model = theModel;
+        workplane = wp;
+        minLux = min;
+        maxLux = max;
+        skyIndex = (int)theSkyIndex;
+        
+        // Dependency
+        CalculateStaticSkyBatch * dep = new CalculateStaticSkyBatch(theModel, wp, skies, mf, theOptions);
+        addDependency(dep);
+        
+        // Set the name
+        setName(&name);
+    }
+    
+    //! Checks one of several skies evaluated together, on some sensors
+    /*!
+     @author German Molina
+     @param[in] name The name of the task
+     @param[in] theModel The model
+     @param[in] theOptions The options passed to RContrib
+     @param[in] theRays The sensors
+     @param[in] skies All the skies of the study
+     @param[in] theSkyIndex The sky to check
+     @param[in] mf The Reinhart sky subdivition scheme
+     @param[in] min The minimum illuminance allowed
+     @param[in] max The maximum illuminance allowed
+     */
+    CheckLUXCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, std::vector<std::string> skies, size_t theSkyIndex, int mf, double min, double max)
+    {
+        model = theModel;
+        rays = theRays;
+        minLux = min;
+        maxLux = max;
+        skyIndex = (int)theSkyIndex;
+        
+        // Dependency
+        CalculateStaticSkyBatch * dep = new CalculateStaticSkyBatch(theModel, theRays, skies, mf, theOptions);
+        addDependency(dep);
+        
+        // Set the name
+        setName(&name);
+    }
+    
     Matrix * getDependencyResults()
     {
-        return &(static_cast< CalculateStaticIlluminance *>(getDependencyRef(0))->result);
+        if(skyIndex < 0)
+            return &(static_cast< CalculateStaticIlluminance *>(getDependencyRef(0))->result);
+        
+        // Copy this sky's column
+        const Matrix * batch = static_cast< CalculateStaticSkyBatch *>(getDependencyRef(0))->getResult();
+        if((size_t)skyIndex >= batch->ncols())
+            throw "Sky index out of range when checking LUX compliance";
+        
+        const size_t nrows = batch->nrows();
+        skyResult.resize(nrows, 1);
+        for(size_t i = 0; i < nrows; i++)
+            skyResult.setElement(i, 0, batch->getElement(i, (size_t)skyIndex));
+        
+        return &skyResult;
+    }
+    
+    const TriangleMesh * getDependencyMesh()
+    {
+        // Skies in a batch are not refined
+        if(skyIndex >= 0)
+            return StaticSimulationTask::getDependencyMesh();
+        
+        return static_cast< CalculateStaticIlluminance *>(getDependencyRef(0))->getMesh();
     }
     
 };
@@ -50,7 +50,7 @@ CheckUDICompliance::CheckUDICompliance(std::string name, EmpModel * theModel, RT
     setName(&name);
 }
 
-CheckUDICompliance::CheckUDICompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, int sunMf, int skyMf,double theMinLux, double theMaxLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
+CheckUDICompliance::CheckUDICompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int sunMf, int skyMf,double theMinLux, double theMaxLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
 {
     
     model = theModel;
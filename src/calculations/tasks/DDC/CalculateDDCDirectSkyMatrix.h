@@ -23,13 +23,14 @@
 #pragma once
 
 #include "./CreateDDCDirectSkyOctree.h"
+#include "../RContribBatch.h"
 
 class CalculateDDCDirectSkyMatrix : public Task {
 public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     RTraceOptions options; //!< The options passed to rcontrib... will be modified
     
@@ -46,17 +47,12 @@ public:
         mf = theMF;
         workplane = wp;
         options = *theOptions;
+        options.setOption("ab",1);
         
-        // Dependency 0: oconv task
-        CreateDDCDirectSkyOctree * oconvTask = new CreateDDCDirectSkyOctree(model);
-        addDependency(oconvTask);
-        
-        // Dependecy 1: Triangulate workplane
-        TriangulateWorkplane * triangulateWorkplaneTask = new TriangulateWorkplane(wp);
-        addDependency(triangulateWorkplaneTask);
-        
-        
-        workplane = wp;
+        // Dependency 0: The RContrib batch of the octree (which triangulates the workplane)
+        RContribBatch<CreateDDCDirectSkyOctree> * batch = new RContribBatch<CreateDDCDirectSkyOctree>(model, new CreateDDCDirectSkyOctree(model), mf, "ground_glow", &options);
+        batch->addWorkplane(wp, &result);
+        addDependency(batch);
         
     }
     
@@ -64,7 +60,7 @@ public:
     /*!
      @author German Molina
      */
-    CalculateDDCDirectSkyMatrix(EmpModel * theModel, std::vector<RAY> * theRays, int theMF,RTraceOptions * theOptions)
+    CalculateDDCDirectSkyMatrix(EmpModel * theModel, SensorSet * theRays, int theMF,RTraceOptions * theOptions)
     {
         
         std::string name = "DDC Direct Sky Matrix";
@@ -72,14 +68,16 @@ public:
         model = theModel;
         mf = theMF;
         options = *theOptions;
-        
-        // Dependency 0: oconv task
-        CreateDDCDirectSkyOctree * oconvTask = new CreateDDCDirectSkyOctree(model);
-        addDependency(oconvTask);
+        options.setOption("ab",1);
         
         // Set the rays
         rays = theRays;
         
+        // Dependency 0: The RContrib batch of the octree
+        RContribBatch<CreateDDCDirectSkyOctree> * batch = new RContribBatch<CreateDDCDirectSkyOctree>(model, new CreateDDCDirectSkyOctree(model), mf, "ground_glow", &options);
+        batch->addRays(rays, &result);
+        addDependency(batch);
+        
     }
     
     bool isEqual(Task * t)
@@ -100,17 +98,7 @@ public:
     
     bool solve()
     {
-        std::string octname = static_cast<CreateDDCDirectSkyOctree *>(getDependencyRef(0))->octreeName;
-        options.setOption("ab",1);
-        
-        
-        // If there is a workplane, get rays from triangulation
-        if(workplane != nullptr){
-            rays = &(static_cast<TriangulateWorkplane *>(getDependencyRef(1))->rays);
-        }
-        result.resize(rays->size(),nReinhartBins(mf));
-        rcontrib(&options, &octname[0], false, true, rays, mf, "ground_glow", false, &result);
-        
+        // The RContrib batch has already put the rows in the result
         return true;
     }
     
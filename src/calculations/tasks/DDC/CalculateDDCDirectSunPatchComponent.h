@@ -28,7 +28,7 @@ public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme for the sky
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     RTraceOptions * options; //!< The options passed to rcontrib... will be modified
     int interp; //!< The interpolation scheme
@@ -56,7 +56,7 @@ public:
     /*!
      @author German Molina
      */
-    CalculateDDCDirectSunPatchComponent(EmpModel * theModel, std::vector<RAY> * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
+    CalculateDDCDirectSunPatchComponent(EmpModel * theModel, SensorSet * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
     {
         std::string name = "DDC Direct Sun Patch";
         setName(&name);
@@ -29,7 +29,7 @@ public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart subdivition scheme for the sky
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     RTraceOptions * options; //!< The options passed to rcontrib
     int interp; //!< The interpolation scheme
@@ -57,7 +57,7 @@ public:
     /*!
      @author German Molina
      */
-    CalculateDDCGlobalComponent(EmpModel * theModel, std::vector<RAY> * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
+    CalculateDDCGlobalComponent(EmpModel * theModel, SensorSet * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
     {
         std::string n = "DDC Global Illuminance";
         setName(&n);
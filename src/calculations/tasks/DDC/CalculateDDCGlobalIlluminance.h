@@ -33,7 +33,7 @@ private:
     int skyMF; //!< The Reinhart subdivition scheme for the sky
     int sunMF; //!< The Reinhart subdivition scheme for the sun
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     RTraceOptions * options; //!< The options passed to rcontrib procsses
     Matrix result; //!< The resulting matrix
     int interp; //!< The interpolation scheme
@@ -66,7 +66,7 @@ public:
     }
     
     
-    CalculateDDCGlobalIlluminance(EmpModel * theModel,  std::vector<RAY> * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
+    CalculateDDCGlobalIlluminance(EmpModel * theModel,  SensorSet * theRays, int theSunMF, int theSkyMF, RTraceOptions * theOptions, int interpolation)
     {
         
         std::string name = "DDC";
@@ -124,8 +124,7 @@ public:
             TriangulateWorkplane aux = TriangulateWorkplane(workplane);
             TaskManager * p = getParent();
             TriangulateWorkplane * triangulate = static_cast<TriangulateWorkplane *>( p->findTask(&aux) );
-            std::vector <Triangle *> * triangles = &(triangulate->triangles);
-            nSensors = triangles->size();
+            nSensors = triangulate->mesh.nSensors();
         }
         
         size_t nTimesteps = interp*(model->getLocation()->getWeatherSize());
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "./CreateDDCGlobalOctree.h"
+#include "../RContribBatch.h"
 
 class CalculateDDCGlobalMatrix : public Task {
 
@@ -29,7 +30,7 @@ private:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     RTraceOptions options; //!< The options passed to RContrib
 
@@ -48,14 +49,10 @@ public:
         mf = theMF;
         options = *theOptions;
         
-        // Dependency 0: oconv task
-        CreateDDCGlobalOctree * ot = new CreateDDCGlobalOctree(model);
-        addDependency(ot);
-        
-        // Dependecy 1: Triangulate workplane        
-        TriangulateWorkplane * triangulateWorkplaneTask = new TriangulateWorkplane(wp);
-        addDependency(triangulateWorkplaneTask);
-        
+        // Dependency 0: The RContrib batch of the octree (which triangulates the workplane)
+        RContribBatch<CreateDDCGlobalOctree> * batch = new RContribBatch<CreateDDCGlobalOctree>(model, new CreateDDCGlobalOctree(model), mf, "ground_glow", &options);
+        batch->addWorkplane(wp, &result);
+        addDependency(batch);
         
         workplane = wp;
         
@@ -65,7 +62,7 @@ public:
     /*!
      @author German Molina
      */
-    CalculateDDCGlobalMatrix(EmpModel * theModel, std::vector<RAY> * theRays, int theMF, RTraceOptions * theOptions)
+    CalculateDDCGlobalMatrix(EmpModel * theModel, SensorSet * theRays, int theMF, RTraceOptions * theOptions)
     {
         
         std::string n = "DDC Global Matrix";
@@ -74,13 +71,14 @@ public:
         mf = theMF;
         options = *theOptions;
         
-        // Dependency 0: oconv task
-        CreateDDCGlobalOctree * ot = new CreateDDCGlobalOctree(model);
-        addDependency(ot);
-        
         // Set the rays
         rays = theRays;
         
+        // Dependency 0: The RContrib batch of the octree
+        RContribBatch<CreateDDCGlobalOctree> * batch = new RContribBatch<CreateDDCGlobalOctree>(model, new CreateDDCGlobalOctree(model), mf, "ground_glow", &options);
+        batch->addRays(rays, &result);
+        addDependency(batch);
+        
     }
     
     ColorMatrix * getResult()
@@ -107,15 +105,7 @@ public:
     
     bool solve()
     {
-        std::string octname = static_cast<CreateDDCGlobalOctree *>(getDependencyRef(0))->octreeName;
-        
-        // If there is a workplane, get rays from triangulation
-        if(workplane != nullptr){
-            rays = &(static_cast<TriangulateWorkplane *>(getDependencyRef(1))->rays);
-        }
-        result.resize(rays->size(),nReinhartBins(mf));
-        rcontrib(&options, &octname[0], false, true, rays, mf, "ground_glow", false, &result);
-        
+        // The RContrib batch has already put the rows in the result
         return true;
     }
     
@@ -58,17 +58,15 @@ public:
     
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = (static_cast<OconvTask *>(getDependencyRef(0))->octreeName);
-        octreeName = "DDC_Global_" + octName;
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
+        octreeName = "DDC_Direct_Sky_" + octName;
         
-        FILE * octree = POPEN(&command[0], "w");
-        fprintf(octree, "void glow ground_glow 0 0 4 1 1 1 0\n");
-        fprintf(octree, "ground_glow source ground 0 0 4 0 0 1 360\n");
-        PCLOSE(octree);
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "void glow ground_glow 0 0 4 1 1 1 0\n");
+            fprintf(octree, "ground_glow source ground 0 0 4 0 0 1 360\n");
+        });
         
-        return true;
+        return success;
     }
     
     //! Is mutex
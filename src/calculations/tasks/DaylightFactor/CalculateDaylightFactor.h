@@ -31,10 +31,10 @@ class CalculateDaylightFactor : public Task {
 public:
     EmpModel * model; //!< The model
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix result; //!< The vector with the DF for each sensor
     RTraceOptions * rtraceOptions; //!< The options passed to rcontrib
-    std::string ambientFileName; //!< The name of the ambient file used
+    std::string ambientFileName; //!< The name of the ambient file used when the ambient cache is disabled
     
     CalculateDaylightFactor(EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp)
     {
@@ -58,7 +58,7 @@ public:
         setName(&name);
     }
     
-    CalculateDaylightFactor(EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays)
+    CalculateDaylightFactor(EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays)
     {
         generatesResults = false;
         
@@ -108,7 +108,7 @@ public:
         
         ColorMatrix aux = ColorMatrix(nrays,1);
         
-        rtrace_I(rtraceOptions, &octName[0], ambientFileName, rays, &aux);
+        cachedRTrace_I(rtraceOptions, &octName[0], ambientFileName, rays, &aux);
         
         aux.calcIrradiance(&result);
         
@@ -47,7 +47,7 @@ public:
         setName(&name);
     }
     
-    CheckDFCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, double min, double max)
+    CheckDFCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, double min, double max)
     {
         model = theModel;
         rays = theRays;
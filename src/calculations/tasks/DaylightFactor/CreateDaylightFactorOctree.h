@@ -60,21 +60,19 @@ public:
     
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = (static_cast<OconvTask *>(getDependencyRef(0))->octreeName);
         
         octreeName = "DAYLIGHT_FACTOR_" + octName;
         
         double albedo = model->getLocation()->getAlbedo();
         
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
         
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "!gensky -ang 45 40 -c -B %f -g %f\n",100.0,albedo);
-        fprintf(octree, RADIANCE_SKY_COMPLEMENT);
-        PCLOSE(octree);
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "!gensky -ang 45 40 -c -B %f -g %f\n",100.0,albedo);
+            fprintf(octree, RADIANCE_SKY_COMPLEMENT);
+        });
         
-        return true;
+        return success;
     }
     
     //! Is mutex
@@ -28,7 +28,7 @@ public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme for the sun
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix result; //!< The resulting matrix
     RTraceOptions * options; //!< Options passed to rcontrib
     int interp; //!< The interpolation scheme
@@ -56,7 +56,7 @@ public:
     /*!
      @author German Molina
      */
-    CalculateDirectSolarIlluminance(EmpModel * theModel, std::vector<RAY> * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
+    CalculateDirectSolarIlluminance(EmpModel * theModel, SensorSet * theRays, int theMF, RTraceOptions * theOptions, int interpolation)
     {
         std::string name = "DDC Direct Sun Illuminance";
         setName(&name);
@@ -21,13 +21,14 @@
 #pragma once
 
 #include "./CreateDirectSunOctree.h"
+#include "../RContribBatch.h"
 
 class CalculateDirectSunMatrix : public Task {
 public:
     EmpModel * model; //!< The model
     int mf; //!< The Reinhart sky subdivition scheme
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     ColorMatrix result; //!< The resulting matrix
     RTraceOptions options; //!< The options passed to rcontrib
     
@@ -40,19 +41,16 @@ public:
         mf = theMF;        
         workplane = wp;
         options = *theOptions;
+        setSunOptions();
         
-        // Dependency 0: oconv task
-        CreateDirectSunOctree * oconvTask = new CreateDirectSunOctree(model, mf);
-        addDependency(oconvTask);
-        
-        
-        // Dependecy 1: Triangulate workplane
-        TriangulateWorkplane * triangulateWorkplaneTask = new TriangulateWorkplane(wp);
-        addDependency(triangulateWorkplaneTask);
+        // Dependency 0: The RContrib batch of the octree (which triangulates the workplane)
+        RContribBatch<CreateDirectSunOctree> * batch = new RContribBatch<CreateDirectSunOctree>(model, new CreateDirectSunOctree(model, mf), mf, "solar", &options);
+        batch->addWorkplane(wp, &result);
+        addDependency(batch);
     }
     
     
-    CalculateDirectSunMatrix(EmpModel * theModel, std::vector<RAY> * theRays, int theMF, RTraceOptions * theOptions)
+    CalculateDirectSunMatrix(EmpModel * theModel, SensorSet * theRays, int theMF, RTraceOptions * theOptions)
     {
         
         std::string name = "Direct Sun Matrix";
@@ -60,12 +58,29 @@ public:
         model = theModel;
         mf = theMF;
         options = *theOptions;
-        
-        // Dependency 0: oconv task
-        CreateDirectSunOctree * oconvTask = new CreateDirectSunOctree(model, mf);
-        addDependency(oconvTask);
+        setSunOptions();
         
         rays = theRays;
+        
+        // Dependency 0: The RContrib batch of the octree
+        RContribBatch<CreateDirectSunOctree> * batch = new RContribBatch<CreateDirectSunOctree>(model, new CreateDirectSunOctree(model, mf), mf, "solar", &options);
+        batch->addRays(rays, &result);
+        addDependency(batch);
+    }
+    
+    //! Sets the RContrib options needed for tracing the sun only
+    /*!
+     @author German Molina
+     */
+    void setSunOptions()
+    {
+        options.setOption("ab",1);
+        options.setOption("dc",1);
+        options.setOption("dt",0);
+        options.setOption("st",1);
+        options.setOption("ss",0);
+        options.setOption("ad",5000);
+        options.setOption("lw",2e-5);
     }
     
     
@@ -89,26 +104,7 @@ public:
     
     bool solve()
     {
-        
-        
-        std::string octname = static_cast<CreateDirectSunOctree *>(getDependencyRef(0))->octreeName;
-        
-        options.setOption("ab",1);
-        options.setOption("dc",1);
-        options.setOption("dt",0);
-        options.setOption("st",1);
-        options.setOption("ss",0);
-        options.setOption("ad",5000);
-        options.setOption("lw",2e-5);
-        
-                
-        if(workplane != nullptr){
-            rays = &(static_cast<TriangulateWorkplane *>(getDependencyRef(1))->rays);
-        }
-        
-        result.resize(rays->size(),nReinhartBins(mf));
-        rcontrib(&options, &octname[0], false, true, rays, mf, "solar", false, &result);
-        
+        // The RContrib batch has already put the rows in the result
         return true;
     }
     
@@ -50,7 +50,7 @@ CheckASECompliance::CheckASECompliance(std::string name, EmpModel * theModel, RT
     setName(&name);
 }
 
-CheckASECompliance::CheckASECompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, int theMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
+CheckASECompliance::CheckASECompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int theMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime)
 {
     
     model = theModel;
@@ -34,7 +34,7 @@ public:
     CheckASECompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, int theMf, double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
     
     
-    CheckASECompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, int theMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
+    CheckASECompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int theMf,double theMinLux, float theEarly, float theLate, int minMonth, int maxMonth, float theMinTime);
     
     
     GET_DEP_RESULTS(CalculateDirectSolarIlluminance);    
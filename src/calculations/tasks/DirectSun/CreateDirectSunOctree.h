@@ -62,34 +62,32 @@ public:
     
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = (static_cast<OconvTask *>(getDependencyRef(0))->octreeName);
         
         octreeName = "DIRECT_SUN_" + octName;
         fixString(&octreeName);
         
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
         
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "void light solar 0 0 3 1e6 1e6 1e6\n");
-        size_t nbins = nReinhartBins(mf);
-        Vector3D dir = Vector3D(0,0,0);
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "void light solar 0 0 3 1e6 1e6 1e6\n");
+            size_t nbins = nReinhartBins(mf);
+            Vector3D dir = Vector3D(0,0,0);
         
-        const double latitude = model->getLocation()->getLatitude();
+            const double latitude = model->getLocation()->getLatitude();
         
-        for(size_t bin = 1; bin <= nbins; bin++){
-            dir = reinhartCenterDir(bin,mf);
+            for(size_t bin = 1; bin <= nbins; bin++){
+                dir = reinhartCenterDir(bin,mf);
             
-            if(!isInSolarTrajectory(dir,latitude, mf))
-                continue;
+                if(!isInSolarTrajectory(dir,latitude, mf))
+                    continue;
             
-            fprintf(octree, "solar source sun 0 0 4 %f %f %f 0.533\n", dir.getX(), dir.getY(), dir.getZ());
+                fprintf(octree, "solar source sun 0 0 4 %f %f %f 0.533\n", dir.getX(), dir.getY(), dir.getZ());
             
-        }
+            }
         
-        PCLOSE(octree);
+        });
         
-        return true;
+        return success;
     }
     
     //! Is mutex
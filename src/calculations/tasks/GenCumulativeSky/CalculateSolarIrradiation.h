@@ -25,32 +25,49 @@
 #include "../../oconv_options.h"
 #include "../OconvTask.h"
 #include "./CreateSolarIrradiationOctree.h"
+#include "../DDC/CalculateDDCGlobalMatrix.h"
 
 class CalculateSolarIrradiation : public Task {
     
 public:
     EmpModel * model; //!< The model
     Workplane * workplane = nullptr; //!< The workplane to which the matrix will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix result; //!< The vector with the DF for each sensor
     RTraceOptions * rtraceOptions; //!< The options passed to rcontrib
-    std::string ambientFileName; //!< The name of the ambient file used
+    std::string ambientFileName; //!< The name of the ambient file used when the ambient cache is disabled
+    int mf = 0; //!< If greater than zero, the Reinhart subdivition of the DC matrix used instead of ray-tracing the cumulative sky
     
-    CalculateSolarIrradiation(EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp)
+    //! Process a Workplane
+    /*!
+     If theMF is greater than zero, the result is calculated by multiplying the
+     Daylight Coefficients of the sensors (shared with any other DDC calculation
+     of the same Workplane) by the cumulative sky, instead of ray-tracing
+     
+     @author German Molina
+     */
+    CalculateSolarIrradiation(EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, int theMF = 0)
     {
         generatesResults = false;
         
         model = theModel;
         rtraceOptions = theOptions;
         workplane = wp;
-        
-        // Dependency 0
-        CreateSolarIrradiationOctree * oconvTask = new CreateSolarIrradiationOctree(model);
-        addDependency(oconvTask);
-        
-        // Dependency 1
-        TriangulateWorkplane * triangulateWorkplaneTask = new TriangulateWorkplane(wp);
-        addDependency(triangulateWorkplaneTask);
+        mf = theMF;
+        
+        if(mf > 0){
+            // Dependency 0
+            CalculateDDCGlobalMatrix * dcTask = new CalculateDDCGlobalMatrix(model, wp, mf, rtraceOptions);
+            addDependency(dcTask);
+        }else{
+            // Dependency 0
+            CreateSolarIrradiationOctree * oconvTask = new CreateSolarIrradiationOctree(model);
+            addDependency(oconvTask);
+            
+            // Dependency 1
+            TriangulateWorkplane * triangulateWorkplaneTask = new TriangulateWorkplane(wp);
+            addDependency(triangulateWorkplaneTask);
+        }
         
         // Set the name
         std::string name = "SolarIrradiadiation "+wp->getName();
@@ -58,17 +75,30 @@ public:
         setName(&name);
     }
     
-    CalculateSolarIrradiation(EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays)
+    //! Process a vector of rays
+    /*!
+     If theMF is greater than zero, the result is calculated by multiplying the
+     Daylight Coefficients of the rays by the cumulative sky, instead of ray-tracing
+     
+     @author German Molina
+     */
+    CalculateSolarIrradiation(EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, int theMF = 0)
     {
         generatesResults = false;
         
         model = theModel;
         rtraceOptions = theOptions;
         rays = theRays;
+        mf = theMF;
         
         // Dependency 0
-        CreateSolarIrradiationOctree * oconvTask = new CreateSolarIrradiationOctree(model);
-        addDependency(oconvTask);
+        if(mf > 0){
+            CalculateDDCGlobalMatrix * dcTask = new CalculateDDCGlobalMatrix(model, rays, mf, rtraceOptions);
+            addDependency(dcTask);
+        }else{
+            CreateSolarIrradiationOctree * oconvTask = new CreateSolarIrradiationOctree(model);
+            addDependency(oconvTask);
+        }
         
         // Set the name
         std::string name = "SolarIrradiadiation";
@@ -87,14 +117,28 @@ public:
         return (
                 rtraceOptions->isEqual(static_cast<CalculateSolarIrradiation *>(t)->rtraceOptions) &&
                 workplane == static_cast<CalculateSolarIrradiation *>(t)->workplane &&
-                rays == static_cast<CalculateSolarIrradiation *>(t)->rays
+                rays == static_cast<CalculateSolarIrradiation *>(t)->rays &&
+                mf == static_cast<CalculateSolarIrradiation *>(t)->mf
                 );
     }
     
     bool solve()
     {
+        if(mf > 0){
+            // One matrix-vector product with the shared DC matrix
+            ColorMatrix * DC = static_cast<CalculateDDCGlobalMatrix *>(getDependencyRef(0))->getResult();
+            
+            std::vector<double> cumulativeSky = std::vector<double>();
+            calcCumulativeSky(model->getLocation(), false, true, false, mf, &cumulativeSky);
+            
+            return cumulativeSkyExposure(DC, &cumulativeSky, &result);
+        }
+        
+        CreateSolarIrradiationOctree * octreeTask = static_cast<CreateSolarIrradiationOctree *>(getDependencyRef(0));
+        std::string octName = octreeTask->octreeName;
         
-        std::string octName = (static_cast<CreateSolarIrradiationOctree *>(getDependencyRef(0))->octreeName);
+        // The sky is in the .cal file, not in the octree
+        std::vector<std::string> skyFiles = {octreeTask->calFileName};
         
         
         if(workplane != nullptr){
@@ -107,7 +151,7 @@ public:
         
         ColorMatrix aux = ColorMatrix(nrays,1);
         
-        rtrace_I(rtraceOptions, &octName[0], ambientFileName, rays, &aux);
+        cachedRTrace_I(rtraceOptions, &octName[0], ambientFileName, rays, &aux, &skyFiles);
         
         aux.calcIrradiance(&result);
         
@@ -116,7 +160,7 @@ public:
     
     bool isMutex(Task * t)
     {
-        return true; // Mutex with all Daylight Factor calculations
+        return mf == 0; // Mutex with all Daylight Factor calculations (because of the ambient file)
     }
     
     bool submitResults(json * results)
@@ -28,7 +28,7 @@ class CheckSolarIrradiationCompliance : public StaticSimulationTask {
 public:
     
     
-    CheckSolarIrradiationCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, double min, double max)
+    CheckSolarIrradiationCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, Workplane * wp, double min, double max, int mf = 0)
     {
         model = theModel;
         workplane = wp;
@@ -36,7 +36,7 @@ public:
         maxLux = max;
         
         // Dependency
-        CalculateSolarIrradiation * dep = new CalculateSolarIrradiation(theModel, theOptions, wp);
+        CalculateSolarIrradiation * dep = new CalculateSolarIrradiation(theModel, theOptions, wp, mf);
         addDependency(dep);
         
         depResults = &(dep->result);
@@ -46,7 +46,7 @@ public:
         setName(&the_name);
     }
     
-    CheckSolarIrradiationCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, std::vector<RAY> * theRays, double min, double max)
+    CheckSolarIrradiationCompliance(std::string name, EmpModel * theModel, RTraceOptions * theOptions, SensorSet * theRays, double min, double max, int mf = 0)
     {
         model = theModel;
         rays = theRays;
@@ -54,7 +54,7 @@ public:
         maxLux = max;
         
         // Dependency
-        CalculateSolarIrradiation * dep = new CalculateSolarIrradiation(theModel, theOptions, theRays);
+        CalculateSolarIrradiation * dep = new CalculateSolarIrradiation(theModel, theOptions, theRays, mf);
         addDependency(dep);
         
         depResults = &(dep->result);
@@ -62,25 +62,23 @@ public:
     
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         std::string octName = (static_cast<OconvTask *>(getDependencyRef(0))->octreeName);
         
         octreeName = "SOLAR_EXPOSURE_" + octName;
         
         // Create the octree
-        std::string command = "oconv -i " + std::string(octName) + " - > " + octreeName;
-        FILE *octree = POPEN(&command[0], "w");
-        fprintf(octree, "void brightfunc skyfunc \
-                2 skybright ./%s \
-                0 \
-                0 \n", &calFileName[0]);
+        bool success = addToOctree(octName, octreeName, [&](FILE * octree) {
+            fprintf(octree, "void brightfunc skyfunc \
+                    2 skybright ./%s \
+                    0 \
+                    0 \n", &calFileName[0]);
         
-        fprintf(octree, RADIANCE_SKY_COMPLEMENT);
-        PCLOSE(octree);
+            fprintf(octree, RADIANCE_SKY_COMPLEMENT);
+        });
         // Write the cal file
         genCumulativeSky(model, true, true, calFileName);
         
-        return true;
+        return success;
     }
     
     //! Is mutex
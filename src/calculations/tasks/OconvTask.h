@@ -20,8 +20,10 @@
 
 #pragma once
 
+#include <cstdlib>
 
 #include "../../common/utilities/stringutils.h"
+#include "../../config_constants.h"
 
 
 #include "../../taskmanager/task.h"
@@ -39,6 +41,7 @@ public:
     EmpModel * model; //!< The model to Oconv
     OconvOptions options; //!< The Options passed to Oconv
     std::string octreeName; //!< The name of the created octree
+    std::vector<std::string> componentOctrees = std::vector<std::string>(); //!< The octrees of the ComponentDefinitions referenced by the octree
     
     
     
@@ -55,6 +58,8 @@ public:
     ~OconvTask()
     {
         remove(&octreeName[0]);
+        for (auto & componentOctree : componentOctrees)
+            remove(&componentOctree[0]);
     }
     
     bool isEqual(Task * t)
@@ -65,12 +70,29 @@ public:
                 );
     }
     
+    //! Optimizes the geometry of the model, if required
+    /*!
+     This is done before the task graph is solved, because it replaces
+     the Face objects that other Tasks may be reading. Set 
+     EMP_GEOMETRY_BENCHMARK to measure the octree before and after.
+     
+     @author German Molina
+     @return success
+     */
+    bool prepare()
+    {
+        if (options.getOption<bool>(std::string(OCONV_OPTIMIZE_GEOMETRY))) {
+            GeometryReport report = GeometryReport();
+            optimizeModelGeometry(model, &report, std::getenv(EMP_GEOMETRY_BENCHMARK) != nullptr);
+        }
+        return true;
+    }
+    
     bool solve()
     {
-        tbb::mutex::scoped_lock lock(oconvMutex);
         RadExporter exporter = RadExporter(model);
         
-        if (!oconv(octreeName, &options, exporter)) {
+        if (!oconv(octreeName, &options, exporter, &componentOctrees)) {
             FATAL(errmsg, "Impossible to oconv");
             return false;
         }
@@ -81,7 +103,8 @@ public:
     //! Is mutex
     /*!
      This method checks whether this Task is mutual exclusive with another Task;
-     but it is never mutual excusive, so it returns false
+     but it is never mutual excusive (each OconvTask writes its own octree 
+     and scratch files), so it returns false
      
      @author German Molina
      @param[in] t The other task
@@ -89,7 +112,7 @@ public:
      */
     bool isMutex(Task * t)
     {
-        return true;
+        return false;
     }
     
     //! Submits the results into a json
@@ -113,6 +136,10 @@ public:
         ret += options.getOption<bool>(std::string(OCONV_INCLUDE_WINDOWS)) ? ".1." : "0.";
         ret += options.getOption<bool>(std::string(OCONV_USE_BLACK_GEOMETRY)) ? "1." : "0.";
         ret += options.getOption<bool>(std::string(OCONV_LIGHTS_ON)) ? "1" : "0";
+        ret += options.getOption<bool>(std::string(OCONV_INSTANCE_COMPONENTS)) ? ".i" : "";
+        ret += options.getOption<bool>(std::string(OCONV_FREEZE)) ? ".f" : "";
+        ret += options.getOption<bool>(std::string(OCONV_MESH_TRIANGLES)) ? ".m" : "";
+        ret += options.getOption<bool>(std::string(OCONV_OPTIMIZE_GEOMETRY)) ? ".o" : "";
         
         return ret;
     }
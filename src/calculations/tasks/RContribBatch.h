@@ -0,0 +1,263 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "../radiance.h"
+#include "./TriangulateWorkplane.h"
+
+//! Runs a single RCONTRIB for the sensors of several Tasks
+/*!
+ Each Daylight Coefficient matrix Task (i.e. CalculateDDCGlobalMatrix)
+ depends on one of these, registering its Workplane or sensors and the
+ ColorMatrix where its rows should go. Batches that target the same
+ octree, modifier, sky subdivision and options are equal, so the 
+ TaskManager keeps only one of them and merge() makes it absorb the 
+ sensors of the others.
+ 
+ When solved, all the sensors are concatenated and sent to one RCONTRIB
+ process (so the octree is loaded only once), which traces them in 
+ parallel (see rcontrib()), and the resulting rows are scattered back 
+ to each registered ColorMatrix.
+ 
+ OctreeTask is the Task that builds the octree (e.g. CreateDDCGlobalOctree),
+ which needs to have a public octreeName member.
+ */
+template <class OctreeTask>
+class RContribBatch : public Task {
+    
+private:
+    
+    //! A set of sensors whose rows are calculated in the batch
+    struct Member {
+        Workplane * workplane; //!< The workplane (if any)
+        SensorSet * rays; //!< The sensors (if there is no workplane)
+        size_t dependency; //!< The index of the TriangulateWorkplane dependency (if there is a workplane)
+        ColorMatrix * result; //!< Where to put the rows
+    };
+    
+    EmpModel * model; //!< The model
+    int mf; //!< The Reinhart sky subdivition scheme
+    std::string modifier; //!< The modifier whose contributions are calculated
+    RTraceOptions options; //!< The options passed to RContrib
+    std::vector<Member> members = std::vector<Member>(); //!< The sensors in the batch
+    
+    //! Retrieves the sensors of a member
+    /*!
+     @author German Molina
+     @param[in] m The member
+     @return The sensors
+     */
+    SensorSet * getSensors(const Member * m)
+    {
+        if(m->workplane != nullptr)
+            return &(static_cast<TriangulateWorkplane *>(getDependencyRef(m->dependency))->rays);
+        return m->rays;
+    }
+    
+public:
+    
+    //! Constructor
+    /*!
+     @author German Molina
+     @param[in] theModel The model
+     @param[in] octreeTask The Task that builds the octree (becomes Dependency 0)
+     @param[in] theMF The Reinhart sky subdivition scheme
+     @param[in] theModifier The modifier whose contributions are calculated
+     @param[in] theOptions The options passed to RContrib
+     */
+    RContribBatch(EmpModel * theModel, OctreeTask * octreeTask, int theMF, std::string theModifier, RTraceOptions * theOptions)
+    {
+        std::string n = "RContrib batch " + theModifier;
+        setName(&n);
+        model = theModel;
+        mf = theMF;
+        modifier = theModifier;
+        options = *theOptions;
+        
+        // Dependency 0: The octree
+        addDependency(octreeTask);
+    }
+    
+    //! Adds the sensors of a Workplane to the batch
+    /*!
+     @author German Molina
+     @param[in] wp The workplane
+     @param[out] result The matrix where its rows will be put
+     */
+    void addWorkplane(Workplane * wp, ColorMatrix * result)
+    {
+        addDependency(new TriangulateWorkplane(wp));
+        members.push_back({wp, nullptr, countDependencies() - 1, result});
+    }
+    
+    //! Adds a set of sensors to the batch
+    /*!
+     @author German Molina
+     @param[in] rays The sensors
+     @param[out] result The matrix where its rows will be put
+     */
+    void addRays(SensorSet * rays, ColorMatrix * result)
+    {
+        members.push_back({nullptr, rays, 0, result});
+    }
+    
+    //! Counts the sets of sensors in the batch
+    /*!
+     @author German Molina
+     @return The number of Workplanes and SensorSets registered
+     */
+    size_t countMembers() const
+    {
+        return members.size();
+    }
+    
+    bool isEqual(Task * t)
+    {
+        RContribBatch<OctreeTask> * other = static_cast<RContribBatch<OctreeTask> *>(t);
+        return (
+                model == other->model &&
+                mf == other->mf &&
+                modifier == other->modifier &&
+                options.isEqual(&other->options) &&
+                getDependencyRef(0)->isEqual(other->getDependencyRef(0))
+                );
+    }
+    
+    //! Takes the sensors of an equal batch
+    /*!
+     The TaskManager registers the TriangulateWorkplane dependencies taken
+     from the other batch right after this.
+     
+     @author German Molina
+     @param[in] t The other RContribBatch, which is about to be deleted
+     */
+    void merge(Task * t)
+    {
+        RContribBatch<OctreeTask> * other = static_cast<RContribBatch<OctreeTask> *>(t);
+        for(Member m : other->members){
+            if(m.workplane != nullptr){
+                Task * triangulation = other->getDependencyRef(m.dependency);
+                addDependency(triangulation);
+                m.dependency = countDependencies() - 1;
+            }
+            members.push_back(m);
+        }
+    }
+    
+    //! Concatenates the sensors of all the members
+    /*!
+     A SensorSet registered by several members is added only once
+     
+     @author German Molina
+     @param[out] all The sensors
+     @param[out] firstRow The row of all where the sensors of each member start
+     */
+    void gather(SensorSet * all, std::vector<size_t> * firstRow)
+    {
+        const size_t nMembers = members.size();
+        firstRow->resize(nMembers);
+        for(size_t i = 0; i < nMembers; i++){
+            SensorSet * sensors = getSensors(&members[i]);
+            bool repeated = false;
+            for(size_t j = 0; j < i && !repeated; j++){
+                if(getSensors(&members[j]) == sensors){
+                    (*firstRow)[i] = (*firstRow)[j];
+                    repeated = true;
+                }
+            }
+            if(!repeated){
+                (*firstRow)[i] = all->size();
+                all->append(sensors);
+            }
+        }
+    }
+    
+    //! Copies the rows calculated for all the sensors into the result of each member
+    /*!
+     @author German Molina
+     @param[in] rows The rows, one per sensor gathered (see gather())
+     @param[in] firstRow The row where the sensors of each member start
+     */
+    void scatter(ColorMatrix * rows, const std::vector<size_t> * firstRow)
+    {
+        const size_t nMembers = members.size();
+        const size_t nbins = rows->ncols();
+        for(size_t i = 0; i < nMembers; i++){
+            const size_t nRows = getSensors(&members[i])->size();
+            ColorMatrix * target = members[i].result;
+            target->resize(nRows, nbins);
+            
+            Matrix * from[3] = {rows->r(), rows->g(), rows->b()};
+            Matrix * to[3] = {target->r(), target->g(), target->b()};
+            for(int channel = 0; channel < 3; channel++){
+                for(size_t row = 0; row < nRows; row++){
+                    for(size_t bin = 0; bin < nbins; bin++)
+                        to[channel]->setElement(row, bin, from[channel]->getElement((*firstRow)[i] + row, bin));
+                }
+            }
+        }
+    }
+    
+    bool solve()
+    {
+        std::string octname = static_cast<OctreeTask *>(getDependencyRef(0))->octreeName;
+        
+        SensorSet all = SensorSet();
+        std::vector<size_t> firstRow = std::vector<size_t>();
+        gather(&all, &firstRow);
+        
+        ColorMatrix result = ColorMatrix(all.size(), nReinhartBins(mf));
+        if(all.size() > 0 && !rcontrib(&options, &octname[0], false, true, &all, mf, modifier.c_str(), false, &result))
+            return false;
+        
+        scatter(&result, &firstRow);
+        
+        return true;
+    }
+    
+    //! Is mutex
+    /*!
+     This method checks whether this Task is mutual exclusive with another Task;
+     but it is never mutual excusive, so it returns false
+     
+     @author German Molina
+     @param[in] t The other task
+     @return true or false
+     */
+    bool isMutex(Task * t)
+    {
+        return false;
+    }
+    
+    //! Submits the results into a json
+    /*!
+     The rows are reported by the Tasks that registered them, so
+     this does nothing
+     
+     @author German Molina
+     @param[out] results The results json object
+     @return true
+     */
+    bool submitResults(json * results)
+    {
+        return true;
+    }
+};
@@ -25,22 +25,40 @@
 #include "../../taskmanager/task.h"
 #include "tbb/tbb.h"
 #include "../../common/geometry/triangulation.h"
+#include "../../common/geometry/trianglemesh.h"
 #include "../radiance.h"
+#include "../../config_constants.h"
+#include "../../os_definitions.h"
+#include "../../common/utilities/file.h"
+#include "../../taskmanager/compliance.h"
 
 #include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
 
 
 
 //! Triangulates a whole workplane
 /*!
- Triangulates all the Polygon3D inside of a workplane
+ Triangulates all the Polygon3D inside of a workplane. If the Workplane
+ has a grid spacing, rectilinear Polygon3D objects are meshed as a 
+ structured grid instead (see TriangleMesh::appendGrid())
+ 
+ The resulting TriangleMesh is cached in the EMP_CACHE directory (if
+ that variable is set), keyed by the Workplane's geometry hash (see
+ Workplane::getGeometryHash()) and the versions of the file format and 
+ of the meshing algorithms, so unchanged Workplanes are not meshed 
+ again in later runs.
  */
 class TriangulateWorkplane : public Task {
 public:
     
     Workplane * workplane; //!< The workplane to triangulate
-    std::vector <RAY> rays = std::vector <RAY>(); //!< The generated rays
-    std::vector <Triangle *> triangles =  std::vector <Triangle *> (); //!< The generated triangles
+    SensorSet rays = SensorSet(); //!< The generated rays (one per sensor of the mesh)
+    TriangleMesh mesh = TriangleMesh(); //!< The generated triangles
+    std::string cacheDir; //!< The directory where the meshes are cached (empty means no cache)
     
     //! Constructor
     /*!
@@ -62,16 +80,8 @@ public:
         std::string n = "Triangulate workplane " + aWorkplane->getName();
         setName(&n);
         
-    }
-    
-    //! Delete and clean
-    /*!
-     @author German Molina
-     */
-    ~TriangulateWorkplane()
-    {
-        for(auto t : triangles)
-            delete t;
+        const char * dir = std::getenv(EMP_CACHE);
+        cacheDir = (dir == nullptr) ? "" : dir;
     }
     
     //! Compares two of these tasks
@@ -92,6 +102,13 @@ public:
      */
     bool solve()
     {
+        // Try the cache first
+        std::string cacheFile = getCacheFileName();
+        if(!cacheFile.empty() && mesh.read(cacheFile)){
+            fillRays();
+            return true;
+        }
+        
         size_t nPols = workplane->getNumPolygons();
         
         // Initialize the triangulations
@@ -106,14 +123,33 @@ public:
         
         double maxArea = workplane->getMaxArea();
         double maxAspectRatio = workplane->getMaxAspectRatio();
+        double gridSpacing = workplane->getGridSpacing();
         
-        // Triangulate in parallel
+        // Each polygon is meshed on its own
+        std::vector<TriangleMesh> pieces = std::vector<TriangleMesh>(nPols);
+        TriangleMesh * piecesRef = pieces.data();
+        
+        // Mesh in parallel... big polygons are
+        // also split in cells that are refined in parallel
         tbb::parallel_for(tbb::blocked_range<size_t>(0, nPols),
                           [=](const tbb::blocked_range<size_t>& r) {
                               for (size_t i = r.begin(); i != r.end(); ++i) {
+                                
+                                Triangulation * t = triangulations.at(i);
+                                Polygon3D * polygon = t->getPolygon();
+                                
+                                // Rasterize if possible
+                                if(gridSpacing > 0 && piecesRef[i].appendGrid(polygon, gridSpacing))
+                                    continue;
+                                
+                                double area = polygon->getArea();
+                                size_t nCells = (size_t)(area / (maxArea * EMP_TRIANGULATION_CELL_SIZE));
+                                if(nCells > EMP_TRIANGULATION_MAX_CELLS)
+                                    nCells = EMP_TRIANGULATION_MAX_CELLS;
                             
-                                triangulations.at(i)->mesh(maxArea,maxAspectRatio);
-                                triangulations.at(i)->purge();
+                                t->mesh(maxArea,maxAspectRatio,nCells);
+                                t->purge();
+                                piecesRef[i].append(t, polygon->getNormal());
                             
                          }
                 },
@@ -121,46 +157,99 @@ public:
         );
         
         // Fill the results... in series
-        size_t rayCount = 0;
+        size_t nTriangles = 0;
+        size_t nVertices = 0;
+        for(size_t i=0; i < nPols; i++){
+            nTriangles += pieces[i].nTriangles();
+            nVertices += pieces[i].nVertices();
+        }
+        
+        mesh.clear();
+        mesh.reserve(nVertices, nTriangles);
         
         for(size_t i=0; i < nPols; i++){
-            Triangulation * t = triangulations.at(i);
-            size_t nTriangles = t->getNumTriangles();
-            
-            
-            for(size_t j = 0; j < nTriangles; j++){
-                
-                // Add a Ray
-                rays.push_back(RAY());
-                
-                // Get the Triangle
-                Triangle * tri = t->getTriangleRef(j);
-                
-                // Add the Triangle
-                //triangles.push_back(*triangle);
-                triangles.push_back(new Triangle(tri));
-                
-                // Add the center to the ray
-                Point3D o = tri->getCenter();
-                Vector3D n = t->getPolygon()->getNormal();
-                
-                FVECT origin = {(float)o.getX(),(float)o.getY(),(float)o.getZ()};
-                FVECT dir = {(float)n.getX(),(float)n.getY(),(float)n.getZ()};
-                
-                VCOPY(rays.at(rayCount).rorg, origin);
-                VCOPY(rays.at(rayCount).rdir, dir);
-                
-                // Increase ray count
-                rayCount++;
-            }
+            mesh.append(&pieces[i]);
             
             // Delete the Triangulation
-            delete t;
+            delete triangulations.at(i);
+        }
+        
+        fillRays();
+        
+        // Store in the cache... through a temporary file, 
+        // so other processes never read a half written mesh
+        if(!cacheFile.empty() && createdir(cacheDir)){
+            std::string tmpFile = cacheFile + "." + std::to_string(GETPID()) + "." + std::to_string((size_t)this) + ".tmp";
+            if(!mesh.write(tmpFile) || std::rename(&tmpFile[0], &cacheFile[0]) != 0)
+                remove(&tmpFile[0]);
         }
         
         return true;
     }
     
+    //! Creates one ray per sensor of the mesh, at its center
+    /*!
+     @author German Molina
+     */
+    void fillRays()
+    {
+        fillRays(&mesh, &rays);
+    }
+    
+    //! Retrieves the name of the file where the mesh of the workplane is cached
+    /*!
+     @author German Molina
+     @return The name of the file (empty if there is no cache)
+     */
+    std::string getCacheFileName() const
+    {
+        if(cacheDir.empty())
+            return "";
+        
+        std::stringstream name;
+        name << cacheDir << "/workplane_" << std::hex << std::setw(16) << std::setfill('0') << workplane->getGeometryHash() << "_v" << std::dec << EMP_TRIANGLEMESH_FILE_VERSION << "_a" << EMP_TRIANGULATION_ALGORITHM_VERSION << ".mesh";
+        return name.str();
+    }
+    
+    //! Sets a ray at the center of each sensor of a TriangleMesh, pointing in its normal
+    /*!
+     Each ray gets the area of its sensor, and the sensor's index as ID
+     (see TriangleMesh::getSensors())
+     
+     @author German Molina
+     @param[in] mesh The TriangleMesh
+     @param[out] rays The SensorSet
+     @param[in] which If not nullptr, only the sensors for which this is 1 are set (in order)
+     */
+    static void fillRays(const TriangleMesh * mesh, SensorSet * rays, const std::vector<char> * which = nullptr)
+    {
+        std::vector<double> centers = std::vector<double>();
+        std::vector<double> areas = std::vector<double>();
+        std::vector<float> normals = std::vector<float>();
+        mesh->getSensors(&centers, &areas, &normals);
+        
+        const size_t nSensors = mesh->nSensors();
+        size_t nRays = nSensors;
+        if(which != nullptr){
+            nRays = 0;
+            for(size_t s = 0; s < nSensors; s++)
+                nRays += (*which)[s] ? 1 : 0;
+        }
+        rays->resize(nRays);
+        
+        size_t i = 0;
+        for(size_t s = 0; s < nSensors; s++){
+            if(which != nullptr && !(*which)[s])
+                continue;
+            
+            rays->setOrigin(i, (float)centers[3*s], (float)centers[3*s+1], (float)centers[3*s+2]);
+            rays->setDirection(i, normals[3*s], normals[3*s+1], normals[3*s+2]);
+            rays->setArea(i, (float)areas[s]);
+            rays->setID(i, (int32_t)s);
+            i++;
+        }
+    }
+    
     //! Is mutex
     /*!
      This method checks whether this Task is mutual exclusive with another Task;
@@ -187,34 +276,16 @@ public:
     bool submitResults(json * j)
     {
         std::string wp = workplane->getName();
-        size_t nrows = triangles.size();
-        std::string n = workplane->getName();
         
         auto workplanes = (*j)["workplanes"];
         if( workplanes.is_null() )
             (*j)["workplanes"] = json::object();
         
-        (*j)["workplanes"][wp] = json::array();
-        Triangle * t;
-        Point3D a = Point3D(0,0,0);
-        Point3D b = Point3D(0,0,0);
-        Point3D c = Point3D(0,0,0);
-        
-        for(size_t row = 0; row < nrows; row++){
-            
-            t = triangles.at(row);
-            a = t->getVertex(0);
-            b = t->getVertex(1);
-            c = t->getVertex(2);
-            (*j)["workplanes"][n].push_back({
-                {a.getX(), a.getY() ,a.getZ() },
-                {b.getX(), b.getY() ,b.getZ() },
-                {c.getX(), c.getY() ,c.getZ() },
-            });
-        }
+        (*j)["workplanes"][wp] = sensorsIntoJSON(&mesh);
         
         return true;
     }
+
     
     
 };
@@ -36,14 +36,14 @@ Matrix4x4::Matrix4x4()
 {
 }
 
-Matrix4x4::Matrix4x4(Matrix4x4 * m)
+Matrix4x4::Matrix4x4(const Matrix4x4 * m)
 {
   for (int i = 0; i < 16; i++) {
-    data[i] = m->getElement(i);
+    data[i] = m->data[i];
   }
 }
 
-double Matrix4x4::getElement(int i)
+double Matrix4x4::getElement(int i) const
 {
   if (i >= 16 || i < 0)
     throw std::invalid_argument("index out of range when getting element from Matrix4x4");
@@ -51,7 +51,7 @@ double Matrix4x4::getElement(int i)
   return data[i];
 }
 
-double Matrix4x4::getElement(int row, int col)
+double Matrix4x4::getElement(int row, int col) const
 {
   if (row >= 4 || row < 0 || col >= 4 || col < 0)
     throw std::invalid_argument("Row or Column out of range when getting element from Matrix4x4");
@@ -67,43 +67,47 @@ void Matrix4x4::setElement(int row, int col, double value)
   data[4 * row + col] = value;
 }
 
+const double * Matrix4x4::getData() const
+{
+  return data;
+}
 
-Matrix4x4 * Matrix4x4::operator*(Matrix4x4 * m)
+Matrix4x4 Matrix4x4::operator*(const Matrix4x4 & m) const
 {
-  Matrix4x4 * ret = new Matrix4x4();
+  Matrix4x4 ret = Matrix4x4();
+  const double * b = m.data;
 
+  // Each row of the result is a linear combination of the rows 
+  // of m, which the compiler can turn into vector operations
   for (int row = 0; row < 4; row++) {
-    for (int col = 0; col < 4; col++) {
-
-      double v = 0;
-      for (int i = 0; i < 4; i++) {
-        v = v + getElement(row, i)*m->getElement(i, col);
-      }
-
-      ret->setElement(row, col, v);
-    }
+    const double * a = &data[4 * row];
+    double * r = &ret.data[4 * row];
+    for (int col = 0; col < 4; col++)
+      r[col] = a[0] * b[col] + a[1] * b[4 + col] + a[2] * b[8 + col] + a[3] * b[12 + col];
   }
 
   return ret;
 }
 
-void Matrix4x4::multiplyThis(Matrix4x4 * m)
+void Matrix4x4::multiplyThis(const Matrix4x4 * m)
 {
+  *this = (*this) * (*m);
+}
 
-  // Multiply
-  Matrix4x4 * res = (*this)*m;
-
-  // Copy data
-  for (int i = 0; i < 16; i++) {
-    data[i] = res->getElement(i);
+void Matrix4x4::transformPoints(const double * in, double * out, size_t n) const
+{
+  const double * d = data;
+  for (size_t i = 0; i < n; i++) {
+    const double x = in[3 * i];
+    const double y = in[3 * i + 1];
+    const double z = in[3 * i + 2];
+    out[3 * i]     = d[0] * x + d[1] * y + d[2] * z + d[3];
+    out[3 * i + 1] = d[4] * x + d[5] * y + d[6] * z + d[7];
+    out[3 * i + 2] = d[8] * x + d[9] * y + d[10] * z + d[11];
   }
-
-  // delete
-  delete res;
-
 }
 
-void Matrix4x4::print()
+void Matrix4x4::print() const
 {
   for (int row = 0; row < 4; row++) {
     for (int col = 0; col < 4; col++) {
@@ -21,6 +21,8 @@
 #ifndef MATRIX_4X4_H
 #define MATRIX_4X4_H
 
+#include <stddef.h>
+
 class Matrix4x4 {
 private:
   double data[16] = {1,0,0,0,   0,1,0,0,    0,0,1,0,    0,0,0,1};
@@ -35,7 +37,7 @@ public:
   /*!
   @author German Molina
   */
-  Matrix4x4(Matrix4x4 * m);
+  Matrix4x4(const Matrix4x4 * m);
 
   //! Retrieves an element from the matrix
   /*!
@@ -43,7 +45,7 @@ public:
   @return the element
   @param[in] i The index of the element
   */
-  double getElement(int i);
+  double getElement(int i) const;
 
   //! Retrieves a specific element from the matrix
   /*!
@@ -52,7 +54,7 @@ public:
   @param[in] row The row of the element (starts from 0)
   @param[in] col The column of the element (starts from 0)
   */
-  double getElement(int row, int col);
+  double getElement(int row, int col) const;
 
   //! Retrieves a specific element from the matrix
   /*!
@@ -64,20 +66,26 @@ public:
   */
   void setElement(int row, int col, double value);
 
+  //! Retrieves the 16 elements of the matrix, organized by row
+  /*!
+  @author German Molina
+  @return A pointer to the data
+  */
+  const double * getData() const;
+
   //! Multiplies a matrix by another matrix
   /*!
   @author German Molina
-  @param[in] m A pointer to the other matrix
-  @return A pointer to a new matrix
-  @note This method creates a new matrix that should be deleted
+  @param[in] m The other matrix
+  @return The product
   */
-  Matrix4x4 * operator*(Matrix4x4 * m);  
+  Matrix4x4 operator*(const Matrix4x4 & m) const;
 
   //! Prints the matrix in a readable format
   /*!
   @author German Molina  
   */
-  void print();
+  void print() const;
 
   //! Multiplies the Matrix4x4 by another Matrix4x4 object
   /*!
@@ -85,10 +93,23 @@ public:
   @author German Molina
   @param[in] m The pointer to the other matrix
   */
-  void multiplyThis(Matrix4x4 * m);
+  void multiplyThis(const Matrix4x4 * m);
+
+  //! Transforms several points at once
+  /*!
+  Points are stored as consecutive X, Y and Z components, and are
+  treated as having a fourth (homogeneous) component equal to 1.
+
+  @author German Molina
+  @param[in] in The points to transform
+  @param[out] out The transformed points (may be the same as in)
+  @param[in] n The number of points
+  */
+  void transformPoints(const double * in, double * out, size_t n) const;
 
 };
 
 extern Matrix4x4 matrix4x4;
 
 #endif
+
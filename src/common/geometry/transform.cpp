@@ -30,61 +30,61 @@ Transform::Transform()
 
 
 
-Matrix4x4 * Transform::getTranslationMatrix(double x, double y, double z)
+Matrix4x4 Transform::getTranslationMatrix(double x, double y, double z)
 {
-  Matrix4x4 * res = new Matrix4x4();
-  res->setElement(0, 3, x);
-  res->setElement(1, 3, y);
-  res->setElement(2, 3, z);
+  Matrix4x4 res = Matrix4x4();
+  res.setElement(0, 3, x);
+  res.setElement(1, 3, y);
+  res.setElement(2, 3, z);
 
   return res;
 }
 
 
-Matrix4x4 * Transform::getRotationXMatrix(double rotation)
+Matrix4x4 Transform::getRotationXMatrix(double rotation)
 {
-  Matrix4x4 * res = new Matrix4x4();
+  Matrix4x4 res = Matrix4x4();
   rotation = DEGREES(rotation);
-  res->setElement(1, 1, cos(rotation));
-  res->setElement(1, 2, -sin(rotation));
-  res->setElement(2, 1, sin(rotation));
-  res->setElement(2, 2, cos(rotation));
+  res.setElement(1, 1, cos(rotation));
+  res.setElement(1, 2, -sin(rotation));
+  res.setElement(2, 1, sin(rotation));
+  res.setElement(2, 2, cos(rotation));
 
   return res;
 }
 
 
-Matrix4x4 * Transform::getRotationYMatrix(double rotation)
+Matrix4x4 Transform::getRotationYMatrix(double rotation)
 {
-  Matrix4x4 * res = new Matrix4x4();
+  Matrix4x4 res = Matrix4x4();
   rotation = DEGREES(rotation);
-  res->setElement(0, 0, cos(rotation));
-  res->setElement(0, 2, sin(rotation));
-  res->setElement(2, 0, -sin(rotation));
-  res->setElement(2, 2, cos(rotation));
+  res.setElement(0, 0, cos(rotation));
+  res.setElement(0, 2, sin(rotation));
+  res.setElement(2, 0, -sin(rotation));
+  res.setElement(2, 2, cos(rotation));
 
   return res;
 }
 
 
-Matrix4x4 * Transform::getRotationZMatrix(double rotation)
+Matrix4x4 Transform::getRotationZMatrix(double rotation)
 {
-  Matrix4x4 * res = new Matrix4x4();
+  Matrix4x4 res = Matrix4x4();
   rotation = DEGREES(rotation);
-  res->setElement(0, 0, cos(rotation));
-  res->setElement(0, 1, -sin(rotation));
-  res->setElement(1, 0, sin(rotation));
-  res->setElement(1, 1, cos(rotation));
+  res.setElement(0, 0, cos(rotation));
+  res.setElement(0, 1, -sin(rotation));
+  res.setElement(1, 0, sin(rotation));
+  res.setElement(1, 1, cos(rotation));
 
   return res;
 }
 
-Matrix4x4 * Transform::getScaleMatrix(double scale)
+Matrix4x4 Transform::getScaleMatrix(double scale)
 {
-  Matrix4x4 * res = new Matrix4x4();
-  res->setElement(0, 0, scale);
-  res->setElement(1, 1, scale);
-  res->setElement(2, 2, scale);
+  Matrix4x4 res = Matrix4x4();
+  res.setElement(0, 0, scale);
+  res.setElement(1, 1, scale);
+  res.setElement(2, 2, scale);
 
   return res;
 }
@@ -94,18 +94,17 @@ Matrix4x4 * Transform::getMatrix()
   return &m;
 }
 
-void Transform::preMultiply(Transform * t)
+const Matrix4x4 * Transform::getMatrix() const
 {
-  // Clone the given matrix
-  Matrix4x4 aux = Matrix4x4(t->getMatrix());
-
-  // Multiply by this transform
-  aux.multiplyThis(&m);
-
-  // Clone
-  for (int row = 0; row < 4; row++) {
-    for (int col = 0; col < 4; col++) {
-      m.setElement(row,col, aux.getElement(row,col));
-    }
-  }
+  return &m;
+}
+
+void Transform::preMultiply(const Transform * t)
+{
+  m = t->m * m;
+}
+
+void Transform::transformPoints(const double * in, double * out, size_t n) const
+{
+  m.transformPoints(in, out, n);
 }
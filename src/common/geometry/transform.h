@@ -44,28 +44,28 @@ public:
   @param[in] y The translation on the Y axis
   @param[in] x The translation on the Z axis
   */
-  Matrix4x4 * getTranslationMatrix(double x, double y, double z);
+  static Matrix4x4 getTranslationMatrix(double x, double y, double z);
 
   //! Creates a Rotation matrix on axis X
   /*!
   @author German Molina
   @param[in] rotation The rotation
   */
-  Matrix4x4 * getRotationXMatrix(double rotation);
+  static Matrix4x4 getRotationXMatrix(double rotation);
 
   //! Creates a Rotation matrix on axis Y
   /*!
   @author German Molina
   @param[in] rotation The rotation
   */
-  Matrix4x4 * getRotationYMatrix(double rotation);
+  static Matrix4x4 getRotationYMatrix(double rotation);
 
   //! Creates a Rotation matrix on axis Z
   /*!
   @author German Molina
   @param[in] rotation The rotation
   */
-  Matrix4x4 * getRotationZMatrix(double rotation);
+  static Matrix4x4 getRotationZMatrix(double rotation);
 
 
   //! Creates a Scale matrix 
@@ -73,7 +73,7 @@ public:
   @author German Molina
   @param[in] scale The scale
   */
-  Matrix4x4 * getScaleMatrix(double scale);
+  static Matrix4x4 getScaleMatrix(double scale);
 
   //! Retrieves a pointer to the matrix
   /*!
@@ -82,6 +82,13 @@ public:
   */
   Matrix4x4 * getMatrix();
 
+  //! Retrieves a pointer to the matrix
+  /*!
+  @author German Molina
+  @return The Matrix4x4
+  */
+  const Matrix4x4 * getMatrix() const;
+
   //! Adds the transformation from a base transformation
   /*!
   Basically does (this) = t*(this)
@@ -89,10 +96,20 @@ public:
   @author German Molina
   @param[in] t The base transform
   */
-  void preMultiply(Transform * t);
+  void preMultiply(const Transform * t);
+
+  //! Transforms several points at once
+  /*!
+  @author German Molina
+  @param[in] in The X, Y and Z components of the points
+  @param[out] out The transformed points (may be the same as in)
+  @param[in] n The number of points
+  */
+  void transformPoints(const double * in, double * out, size_t n) const;
 
 };
 
 extern Transform transform;
 
 #endif
+
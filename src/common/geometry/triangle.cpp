@@ -26,6 +26,7 @@
 
 
 Triangle::Triangle(Point3D * a, Point3D * b, Point3D * c)
+	: segments{ Segment(a, b), Segment(b, c), Segment(c, a) }
 {
     if(a == nullptr || b == nullptr || c == nullptr){
         WARN(a, "Trying to create a Triangle with at least one NULL vertex");
@@ -33,14 +34,10 @@ Triangle::Triangle(Point3D * a, Point3D * b, Point3D * c)
 	vertices[0] = a;
 	vertices[1] = b;
 	vertices[2] = c;
-
-	segments[0] = new Segment(a, b);
-	segments[1] = new Segment(b, c);
-	segments[2] = new Segment(c, a);
-
 }
 
 Triangle::Triangle(Triangle * t)
+    : segments{ Segment(t->getVertex(0), t->getVertex(1)), Segment(t->getVertex(1), t->getVertex(2)), Segment(t->getVertex(2), t->getVertex(0)) }
 {
     if(t == nullptr){
         WARN(a, "Trying to clone a NULL triangle");
@@ -49,19 +46,11 @@ Triangle::Triangle(Triangle * t)
     vertices[1] = t->getVertex(1);
     vertices[2] = t->getVertex(2);
     
-    segments[0] = new Segment(vertices[0], vertices[1]);
-    segments[1] = new Segment(vertices[1], vertices[2]);
-    segments[2] = new Segment(vertices[2], vertices[0]);
-    
 }
 
 Triangle::~Triangle()
 {
-	for (int i = 0; i < 3; i++) {
-        
-        delete segments[i];
-        
-	}
+	
 }
 
 Point3D * Triangle::getVertex(int i)
@@ -78,9 +67,9 @@ double Triangle::getCircumradius()
 	if (circumradius > 0)
 		return circumradius;
 
-	double a = segments[0]->getLength();
-	double b = segments[1]->getLength();
-	double c = segments[2]->getLength();
+	double a = segments[0].getLength();
+	double b = segments[1].getLength();
+	double c = segments[2].getLength();
 	double s = (a + b + c)*(b + c - a)*(c + a - b)*(a + b - c);
 	circumradius = a*b*c / sqrt(s);
 	return circumradius;
@@ -93,8 +82,8 @@ double Triangle::getAspectRatio()
 
 	double minSegment = HUGE; 
 	for (int i = 0; i < 3; i++) {
-		if (segments[i]->getLength() < minSegment) {
-			minSegment = segments[i]->getLength();
+		if (segments[i].getLength() < minSegment) {
+			minSegment = segments[i].getLength();
 		}
 	}
 	aspectRatio = getCircumradius() / minSegment;
@@ -111,7 +100,7 @@ bool Triangle::setNeighbor(Triangle * t, int i,bool reciprocity)
 	
 	// reciprocity	
 	if (reciprocity && t != NULL)		
-		t->setNeighbor(this,t->getEdgeIndexByPoints(segments[i]->start, segments[i]->end),false);
+		t->setNeighbor(this,t->getEdgeIndexByPoints(segments[i].start, segments[i].end),false);
 	
 
 	return true;
@@ -124,7 +113,7 @@ Segment * Triangle::getSegment(int i)
       FATAL(errorMessage,"Impossible index when getting segment... index was '" + std::to_string(i) + "'");
 	  return NULL;
 	}
-	return segments[i];
+	return &segments[i];
 }
 
 
@@ -141,10 +130,10 @@ Triangle * Triangle::getNeighbor(int i)
 int Triangle::getEdgeIndexByPoints(Point3D * a, Point3D * b)
 {	
 	for (int i = 0; i < 3; i++) {
-		if (a->isEqual(segments[i]->start) && b->isEqual(segments[i]->end)) {
+		if (a->isEqual(segments[i].start) && b->isEqual(segments[i].end)) {
 			return i;
 		}
-		if (b->isEqual(segments[i]->start) && a->isEqual(segments[i]->end)) {
+		if (b->isEqual(segments[i].start) && a->isEqual(segments[i].end)) {
 			return i;
 		}
 	}
@@ -174,7 +163,7 @@ bool Triangle::setConstraint(int i)
 	constraints[i] = true;
 	
 	// reciprocate
-	Segment * s = segments[i];
+	Segment * s = &segments[i];
 	if (neighbors[i] != NULL) {
 		int aux = neighbors[i]->getEdgeIndexByPoints(s->start, s->end);
 		neighbors[i]->constraints[aux] = true;
@@ -224,9 +213,9 @@ Point3D Triangle::getCircumCenter()
 
 double Triangle::getArea()
 {
-	double a = segments[0]->getLength();
-	double b = segments[1]->getLength();
-	double c = segments[2]->getLength();
+	double a = segments[0].getLength();
+	double b = segments[1].getLength();
+	double c = segments[2].getLength();
 
 	return sqrt((c + b + a)*((c + b + a) / 2 - a)*((c + b + a) / 2 - b)*((c + b + a) / 2 - c) / 2);
 }
@@ -31,7 +31,7 @@ This class is used mainly in the triangulation routines
 class Triangle {
 private:
 	Point3D * vertices[3]; //!< The vertices
-	Segment * segments[3]; //!< The segments
+	Segment segments[3]; //!< The segments (stored inline, to avoid allocating them one by one)
 	double circumradius = -1; //!< The radius of the circle that coes thorugh the three vertices
 	double aspectRatio = -1; //!< The ratio of the Circumradius and the smallest edge
 	Triangle * neighbors[3] = {nullptr,nullptr,nullptr}; //!< Neighboring triangles
@@ -0,0 +1,205 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <cmath>
+#include "./trianglegrid.h"
+#include "../../config_constants.h"
+
+//! Retrieves a component of a Point3D
+/*!
+@author German Molina
+@param[in] p The point
+@param[in] axis The axis (0 is X, 1 is Y and 2 is Z)
+@return the component
+*/
+static double pointComponent(Point3D * p, int axis)
+{
+	if (axis == 0)
+		return p->getX();
+	if (axis == 1)
+		return p->getY();
+	return p->getZ();
+}
+
+void TriangleGrid::project(Point3D * p, double * u, double * v) const
+{
+	*u = pointComponent(p, uAxis);
+	*v = pointComponent(p, vAxis);
+}
+
+size_t TriangleGrid::getCell(double u, size_t nu, double min) const
+{
+	const double x = floor((u - min) / cellSize);
+	if (x <= 0)
+		return 0;
+	if (x >= (double)(nu - 1))
+		return nu - 1;
+	return (size_t)x;
+}
+
+bool TriangleGrid::isEmpty() const
+{
+	return cells.empty();
+}
+
+size_t TriangleGrid::size() const
+{
+	return cells.size();
+}
+
+void TriangleGrid::build(const std::vector<Triangle *> * triangles)
+{
+	cells.clear();
+
+	// Find the first valid triangle
+	Triangle * first = nullptr;
+	size_t nLive = 0;
+	for (auto t : *triangles) {
+		if (t == nullptr)
+			continue;
+		if (first == nullptr)
+			first = t;
+		nLive++;
+	}
+
+	if (first == nullptr)
+		return;
+
+	// Project into the plane where the triangles look bigger
+	Vector3D normal = (*first->getVertex(1) - first->getVertex(0)) % (*first->getVertex(2) - first->getVertex(0));
+	const double nx = std::abs(normal.getX());
+	const double ny = std::abs(normal.getY());
+	const double nz = std::abs(normal.getZ());
+	if (nz >= nx && nz >= ny) {
+		uAxis = 0;
+		vAxis = 1;
+	}
+	else if (ny >= nx) {
+		uAxis = 0;
+		vAxis = 2;
+	}
+	else {
+		uAxis = 1;
+		vAxis = 2;
+	}
+
+	// Bounding box
+	minU = EMP_HUGE;
+	minV = EMP_HUGE;
+	maxU = EMP_MINUS_HUGE;
+	maxV = EMP_MINUS_HUGE;
+	for (auto t : *triangles) {
+		if (t == nullptr)
+			continue;
+		for (int i = 0; i < 3; i++) {
+			double u, v;
+			project(t->getVertex(i), &u, &v);
+			minU = (u < minU) ? u : minU;
+			minV = (v < minV) ? v : minV;
+			maxU = (u > maxU) ? u : maxU;
+			maxV = (v > maxV) ? v : maxV;
+		}
+	}
+
+	// Leave some room for points that are barely outside (see Triangle::testPoint())
+	const double du = maxU - minU;
+	const double dv = maxV - minV;
+	const double margin = 1e-6 * (du > dv ? du : dv) + EMP_TINY;
+	minU -= margin;
+	minV -= margin;
+	maxU += margin;
+	maxV += margin;
+
+	// Square cells, about EMP_TRIANGLE_GRID_LOAD triangles each
+	const double area = (maxU - minU) * (maxV - minV);
+	const double nCells = (double)nLive / EMP_TRIANGLE_GRID_LOAD + 1;
+	cellSize = sqrt(area / nCells);
+	nU = (size_t)ceil((maxU - minU) / cellSize);
+	nV = (size_t)ceil((maxV - minV) / cellSize);
+	nU = (nU < 1) ? 1 : nU;
+	nV = (nV < 1) ? 1 : nV;
+
+	cells.resize(nU * nV);
+	for (size_t i = 0; i < triangles->size(); i++) {
+		if ((*triangles)[i] == nullptr)
+			continue;
+		addTriangle((*triangles)[i], i);
+	}
+}
+
+void TriangleGrid::addTriangle(Triangle * t, size_t index)
+{
+	const double margin = 1e-6 * cellSize;
+	double u0 = EMP_HUGE;
+	double v0 = EMP_HUGE;
+	double u1 = EMP_MINUS_HUGE;
+	double v1 = EMP_MINUS_HUGE;
+	for (int i = 0; i < 3; i++) {
+		double u, v;
+		project(t->getVertex(i), &u, &v);
+		u0 = (u < u0) ? u : u0;
+		v0 = (v < v0) ? v : v0;
+		u1 = (u > u1) ? u : u1;
+		v1 = (v > v1) ? v : v1;
+	}
+
+	const size_t iu0 = getCell(u0 - margin, nU, minU);
+	const size_t iu1 = getCell(u1 + margin, nU, minU);
+	const size_t iv0 = getCell(v0 - margin, nV, minV);
+	const size_t iv1 = getCell(v1 + margin, nV, minV);
+
+	for (size_t iv = iv0; iv <= iv1; iv++) {
+		for (size_t iu = iu0; iu <= iu1; iu++) {
+			cells[iv * nU + iu].push_back(index);
+		}
+	}
+}
+
+bool TriangleGrid::findTriangle(const std::vector<Triangle *> * triangles, Point3D * p, size_t * index, int * code)
+{
+	double u, v;
+	project(p, &u, &v);
+
+	// Nothing out of the bounding box
+	if (u < minU || u > maxU || v < minV || v > maxV)
+		return false;
+
+	std::vector<size_t> * cell = &cells[getCell(v, nV, minV) * nU + getCell(u, nU, minU)];
+
+	// Test all the triangles, removing the deleted ones on the way
+	size_t nValid = 0;
+	bool found = false;
+	for (size_t i = 0; i < cell->size(); i++) {
+		const size_t ti = (*cell)[i];
+		Triangle * t = (*triangles)[ti];
+		if (t == nullptr)
+			continue;
+
+		(*cell)[nValid++] = ti;
+
+		if (!found && t->testPoint(p, code)) {
+			found = true;
+			*index = ti;
+		}
+	}
+	cell->resize(nValid);
+
+	return found;
+}
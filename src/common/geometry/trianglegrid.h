@@ -0,0 +1,124 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+#include "./point3d.h"
+#include "./triangle.h"
+
+//! The target number of live triangles per cell when (re)building a TriangleGrid
+#define EMP_TRIANGLE_GRID_LOAD 2
+
+// A uniform grid that speeds up locating the Triangle that contains a Point3D
+/*!
+The triangles (which are assumed to be coplanar) are projected into the
+plane of their two less aligned axes, and each cell of the grid stores the
+indexes of the triangles whose bounding box overlap it. 
+
+Deleted triangles are not removed when deleted, but lazily when found 
+while searching (see TriangleGrid::findTriangle()). The indexes stored 
+in each cell are always sorted, so the triangle found is the same that 
+would be found by testing all the triangles in order.
+*/
+class TriangleGrid {
+
+private:
+	int uAxis = 0; //!< The axis of the points that is used as the first coordinate in the grid
+	int vAxis = 1; //!< The axis of the points that is used as the second coordinate in the grid
+	double minU = 0; //!< The minimum value of the first coordinate
+	double minV = 0; //!< The minimum value of the second coordinate
+	double maxU = 0; //!< The maximum value of the first coordinate
+	double maxV = 0; //!< The maximum value of the second coordinate
+	double cellSize = 1; //!< The size of each (square) cell
+	size_t nU = 0; //!< The number of cells in the first coordinate
+	size_t nV = 0; //!< The number of cells in the second coordinate
+	std::vector < std::vector<size_t> > cells = std::vector < std::vector<size_t> >(); //!< The indexes of the triangles in each cell
+
+	//! Retrieves the projected coordinates of a Point3D
+	/*!
+	@author German Molina
+	@param[in] p The point
+	@param[out] u The first coordinate
+	@param[out] v The second coordinate
+	*/
+	void project(Point3D * p, double * u, double * v) const;
+
+	//! Retrieves the cell of a projected coordinate
+	/*!
+	Coordinates outside the grid are clamped to the closest cell
+
+	@author German Molina
+	@param[in] u The first coordinate
+	@param[in] nu The number of cells in that direction
+	@param[in] min The minimum value of the coordinate
+	@return the cell
+	*/
+	size_t getCell(double u, size_t nu, double min) const;
+
+public:
+
+	//! Checks if the grid has been built
+	/*!
+	@author German Molina
+	@return is empty
+	*/
+	bool isEmpty() const;
+
+	//! Retrieves the number of cells in the grid
+	/*!
+	@author German Molina
+	@return the number of cells
+	*/
+	size_t size() const;
+
+	//! Builds the grid from a set of triangles
+	/*!
+	Previous content is discarded. NULL triangles are ignored.
+
+	@author German Molina
+	@param[in] triangles The triangles to index
+	*/
+	void build(const std::vector<Triangle *> * triangles);
+
+	//! Adds a Triangle to the grid
+	/*!
+	The index of the triangle needs to be larger than the index of 
+	all the triangles already in the grid
+
+	@author German Molina
+	@param[in] t The triangle
+	@param[in] index The position of the triangle in the indexed vector
+	*/
+	void addTriangle(Triangle * t, size_t index);
+
+	//! Finds the first Triangle that contains a Point3D
+	/*!
+	@author German Molina
+	@param[in] triangles The triangles that were indexed
+	@param[in] p The point
+	@param[out] index The index of the triangle found
+	@param[out] code The position of the point in the triangle (see Triangle::testPoint())
+	@return found
+	*/
+	bool findTriangle(const std::vector<Triangle *> * triangles, Point3D * p, size_t * index, int * code);
+};
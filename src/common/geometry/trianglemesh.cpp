@@ -0,0 +1,747 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "./trianglemesh.h"
+#include "./triangulation.h"
+#include "./triangle.h"
+#include "./polygon.h"
+#include "../../config_constants.h"
+
+//! The coordinates of a vertex, used for finding repeated vertices
+struct VertexKey {
+	double x; //!< The X component
+	double y; //!< The Y component
+	double z; //!< The Z component
+
+	bool operator==(const VertexKey & other) const
+	{
+		return x == other.x && y == other.y && z == other.z;
+	}
+};
+
+//! Hashes a VertexKey
+struct VertexKeyHash {
+	size_t operator()(const VertexKey & k) const
+	{
+		std::hash<double> h;
+		size_t ret = h(k.x);
+		ret ^= h(k.y) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+		ret ^= h(k.z) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+		return ret;
+	}
+};
+
+void TriangleMesh::reserve(size_t nV, size_t nT)
+{
+	coordinates.reserve(3 * nV);
+	vertexIndexes.reserve(3 * nT);
+	neighborIndexes.reserve(3 * nT);
+	normals.reserve(3 * nT);
+	sensorIndexes.reserve(nT);
+}
+
+void TriangleMesh::clear()
+{
+	std::vector<double>().swap(coordinates);
+	std::vector<int32_t>().swap(vertexIndexes);
+	std::vector<int32_t>().swap(neighborIndexes);
+	std::vector<float>().swap(normals);
+	std::vector<int32_t>().swap(sensorIndexes);
+	sensorCount = 0;
+}
+
+size_t TriangleMesh::nVertices() const
+{
+	return coordinates.size() / 3;
+}
+
+size_t TriangleMesh::nTriangles() const
+{
+	return vertexIndexes.size() / 3;
+}
+
+size_t TriangleMesh::nSensors() const
+{
+	return (size_t)sensorCount;
+}
+
+int32_t TriangleMesh::addVertex(double x, double y, double z)
+{
+	coordinates.push_back(x);
+	coordinates.push_back(y);
+	coordinates.push_back(z);
+	return (int32_t)(nVertices() - 1);
+}
+
+size_t TriangleMesh::addTriangle(int32_t a, int32_t b, int32_t c, Vector3D normal, int32_t sensor)
+{
+	vertexIndexes.push_back(a);
+	vertexIndexes.push_back(b);
+	vertexIndexes.push_back(c);
+	for (int i = 0; i < 3; i++)
+		neighborIndexes.push_back(-1);
+	normals.push_back((float)normal.getX());
+	normals.push_back((float)normal.getY());
+	normals.push_back((float)normal.getZ());
+	sensorIndexes.push_back(sensor < 0 ? sensorCount++ : sensor);
+	return nTriangles() - 1;
+}
+
+void TriangleMesh::append(Triangulation * t, Vector3D normal)
+{
+	const size_t nT = t->getNumTriangles();
+	const size_t firstTriangle = nTriangles();
+	reserve(nVertices() + nT + 2, firstTriangle + nT);
+
+	// Vertices are identified by their coordinates, because different
+	// Point3D objects may be created at the same place (e.g. by two 
+	// cells of a Triangulation meshed in parallel)
+	std::unordered_map<VertexKey, int32_t, VertexKeyHash> vertexMap = std::unordered_map<VertexKey, int32_t, VertexKeyHash>();
+	vertexMap.reserve(nT + 2);
+
+	std::vector<int32_t> newIndex = std::vector<int32_t>(nT, -1);
+	for (size_t i = 0; i < nT; i++) {
+		Triangle * triangle = t->getTriangleRef(i);
+		if (triangle == NULL)
+			continue;
+
+		int32_t v[3];
+		for (int j = 0; j < 3; j++) {
+			Point3D * p = triangle->getVertex(j);
+			const VertexKey key = { p->getX(), p->getY(), p->getZ() };
+			auto found = vertexMap.find(key);
+			if (found == vertexMap.end()) {
+				v[j] = addVertex(key.x, key.y, key.z);
+				vertexMap[key] = v[j];
+			}
+			else {
+				v[j] = found->second;
+			}
+		}
+		newIndex[i] = (int32_t)addTriangle(v[0], v[1], v[2], normal);
+	}
+
+	// Now the neighbors
+	for (size_t i = 0; i < nT; i++) {
+		Triangle * triangle = t->getTriangleRef(i);
+		if (triangle == NULL)
+			continue;
+
+		for (int j = 0; j < 3; j++) {
+			Triangle * neighbor = triangle->getNeighbor(j);
+			if (neighbor == NULL)
+				continue;
+
+			// Make sure the index is current
+			const size_t n = neighbor->getIndex();
+			if (n < nT && t->getTriangleRef(n) == neighbor)
+				setNeighbor(newIndex[i], j, newIndex[n]);
+		}
+	}
+}
+
+void TriangleMesh::append(const TriangleMesh * other)
+{
+	const int32_t vertexOffset = (int32_t)nVertices();
+	const int32_t triangleOffset = (int32_t)nTriangles();
+
+	coordinates.insert(coordinates.end(), other->coordinates.begin(), other->coordinates.end());
+	normals.insert(normals.end(), other->normals.begin(), other->normals.end());
+
+	vertexIndexes.reserve(vertexIndexes.size() + other->vertexIndexes.size());
+	for (auto v : other->vertexIndexes)
+		vertexIndexes.push_back(v + vertexOffset);
+
+	neighborIndexes.reserve(neighborIndexes.size() + other->neighborIndexes.size());
+	for (auto n : other->neighborIndexes)
+		neighborIndexes.push_back(n < 0 ? -1 : n + triangleOffset);
+
+	sensorIndexes.reserve(sensorIndexes.size() + other->sensorIndexes.size());
+	for (auto i : other->sensorIndexes)
+		sensorIndexes.push_back(i + sensorCount);
+	sensorCount += other->sensorCount;
+}
+
+//! Sorts some values and merges those closer than a tolerance
+/*!
+@author German Molina
+@param[in] values The values
+@param[in] tolerance The tolerance
+*/
+static void sortAndMerge(std::vector<double> * values, double tolerance)
+{
+	std::sort(values->begin(), values->end());
+	size_t n = 0;
+	for (size_t i = 0; i < values->size(); i++) {
+		if (n > 0 && (*values)[i] - (*values)[n - 1] <= tolerance)
+			continue;
+		(*values)[n++] = (*values)[i];
+	}
+	values->resize(n);
+}
+
+//! Adds evenly spaced grid lines to the (sorted) lines of the edges of a Polygon3D
+/*!
+Grid lines closer than a tolerance to an edge are snapped onto 
+it (i.e. not added), so they do not create thin slivers.
+
+@author German Molina
+@param[in] lines The sorted lines of the edges (the grid lines are added)
+@param[in] min The first grid line
+@param[in] max The end of the grid
+@param[in] spacing The distance between grid lines
+@param[in] snap The snapping tolerance
+*/
+static void addGridLines(std::vector<double> * lines, double min, double max, double spacing, double snap)
+{
+	const size_t nEdges = lines->size();
+	for (double x = min + spacing; x < max; x += spacing) {
+		auto next = std::lower_bound(lines->begin(), lines->begin() + nEdges, x);
+		if (next != lines->begin() + nEdges && *next - x <= snap)
+			continue;
+		if (next != lines->begin() && x - *(next - 1) <= snap)
+			continue;
+		lines->push_back(x);
+	}
+	std::sort(lines->begin(), lines->end());
+}
+
+bool TriangleMesh::appendGrid(Polygon3D * polygon, double spacing)
+{
+	if (spacing <= 0)
+		return false;
+
+	// Gather the loops
+	std::vector< std::vector<Point3D *> > loops = std::vector< std::vector<Point3D *> >();
+	auto addLoop = [&](Loop * loop) {
+		std::vector<Point3D *> l = std::vector<Point3D *>();
+		for (size_t i = 0; i < loop->size(); i++) {
+			Point3D * p = loop->getVertexRef(i);
+			if (p != nullptr)
+				l.push_back(p);
+		}
+		if (l.size() >= 3)
+			loops.push_back(l);
+	};
+	addLoop(polygon->getOuterLoopRef());
+	if (loops.empty())
+		return false;
+	for (size_t i = 0; i < polygon->countInnerLoops(); i++)
+		addLoop(polygon->getInnerLoopRef(i));
+
+	// Build the local axes... U is aligned with the first edge
+	Vector3D normal = polygon->getNormal();
+	if (normal.isZero())
+		return false;
+	normal.normalize();
+
+	Point3D origin = *(loops[0][0]);
+	Vector3D u = Vector3D(0, 0, 0);
+	for (size_t i = 1; i < loops[0].size() && u.isZero(); i++)
+		u = *(loops[0][i]) - origin;
+	if (u.isZero())
+		return false;
+	u.normalize();
+	Vector3D v = normal % u;
+
+	// Project the loops
+	std::vector< std::vector<double> > xs = std::vector< std::vector<double> >(loops.size());
+	std::vector< std::vector<double> > ys = std::vector< std::vector<double> >(loops.size());
+	double minX = EMP_HUGE, maxX = EMP_MINUS_HUGE, minY = EMP_HUGE, maxY = EMP_MINUS_HUGE;
+	for (size_t l = 0; l < loops.size(); l++) {
+		for (auto p : loops[l]) {
+			Vector3D d = *p - origin;
+			const double x = d * u;
+			const double y = d * v;
+			xs[l].push_back(x);
+			ys[l].push_back(y);
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+		}
+	}
+	const double tolerance = EMP_GRID_TOLERANCE * std::max(maxX - minX, maxY - minY);
+
+	// The lines of the edges of the polygon
+	std::vector<double> gridX = std::vector<double>();
+	std::vector<double> gridY = std::vector<double>();
+	std::vector<double> crossingX = std::vector<double>(); //!< The X of each vertical edge
+	std::vector<double> crossingY0 = std::vector<double>(); //!< The start of each vertical edge
+	std::vector<double> crossingY1 = std::vector<double>(); //!< The end of each vertical edge
+	for (size_t l = 0; l < loops.size(); l++) {
+		const size_t n = xs[l].size();
+		for (size_t i = 0; i < n; i++) {
+			const double dx = xs[l][(i + 1) % n] - xs[l][i];
+			const double dy = ys[l][(i + 1) % n] - ys[l][i];
+			if (std::abs(dx) <= tolerance) {
+				if (std::abs(dy) <= tolerance)
+					continue; // repeated vertex
+				const double x = (xs[l][(i + 1) % n] + xs[l][i]) / 2;
+				gridX.push_back(x);
+				crossingX.push_back(x);
+				crossingY0.push_back(std::min(ys[l][i], ys[l][(i + 1) % n]));
+				crossingY1.push_back(std::max(ys[l][i], ys[l][(i + 1) % n]));
+			}
+			else if (std::abs(dy) <= tolerance) {
+				gridY.push_back((ys[l][(i + 1) % n] + ys[l][i]) / 2);
+			}
+			else {
+				return false; // not rectilinear
+			}
+		}
+	}
+	sortAndMerge(&gridX, tolerance);
+	sortAndMerge(&gridY, tolerance);
+
+	// Plus the grid lines that are not too close to those
+	// (the bounding box is made of edges, so it is already there)
+	const double snap = EMP_GRID_SNAP_TOLERANCE * spacing;
+	addGridLines(&gridX, minX, maxX, spacing, snap);
+	addGridLines(&gridY, minY, maxY, spacing, snap);
+
+	// Now, every rectangle in the grid is either inside or outside
+	const size_t nX = gridX.size() - 1;
+	const size_t nY = gridY.size() - 1;
+	std::vector<int32_t> vertexIndex = std::vector<int32_t>((nX + 1)*(nY + 1), -1);
+	std::vector<int32_t> firstTriangle = std::vector<int32_t>(nX * nY, -1);
+	auto getVertex = [&](size_t i, size_t j) -> int32_t {
+		int32_t * index = &vertexIndex[j * (nX + 1) + i];
+		if (*index < 0) {
+			Point3D p = origin + u * gridX[i] + v * gridY[j];
+			*index = addVertex(p.getX(), p.getY(), p.getZ());
+		}
+		return *index;
+	};
+
+	std::vector<double> crossings = std::vector<double>();
+	for (size_t j = 0; j < nY; j++) {
+		// Find where the polygon's edges cross the middle of this row
+		const double y = (gridY[j] + gridY[j + 1]) / 2;
+		crossings.clear();
+		for (size_t e = 0; e < crossingX.size(); e++) {
+			if (crossingY0[e] < y && y < crossingY1[e])
+				crossings.push_back(crossingX[e]);
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		// Then walk the row... inside after an odd number of crossings
+		size_t nCrossings = 0;
+		for (size_t i = 0; i < nX; i++) {
+			const double x = (gridX[i] + gridX[i + 1]) / 2;
+			while (nCrossings < crossings.size() && crossings[nCrossings] < x)
+				nCrossings++;
+
+			if (nCrossings % 2 == 0)
+				continue;
+
+			const int32_t a = getVertex(i, j);
+			const int32_t b = getVertex(i + 1, j);
+			const int32_t c = getVertex(i + 1, j + 1);
+			const int32_t d = getVertex(i, j + 1);
+			const int32_t t = (int32_t)addTriangle(a, b, c, normal);
+			addTriangle(a, c, d, normal, getSensor(t));
+			firstTriangle[j * nX + i] = t;
+		}
+	}
+
+	// Link the triangles... the first one in each rectangle is the 
+	// lower-right one, the second one is the upper-left.
+	auto getTriangle = [&](size_t i, size_t j, int32_t which) -> int32_t {
+		if (i >= nX || j >= nY || firstTriangle[j * nX + i] < 0)
+			return -1;
+		return firstTriangle[j * nX + i] + which;
+	};
+	for (size_t j = 0; j < nY; j++) {
+		for (size_t i = 0; i < nX; i++) {
+			const int32_t t = firstTriangle[j * nX + i];
+			if (t < 0)
+				continue;
+
+			// i - 1 and j - 1 wrap around for the first row and column,
+			// which are then treated as out of the grid
+			setNeighbor(t, 0, getTriangle(i, j - 1, 1));
+			setNeighbor(t, 1, getTriangle(i + 1, j, 1));
+			setNeighbor(t, 2, t + 1);
+			setNeighbor(t + 1, 0, t);
+			setNeighbor(t + 1, 1, getTriangle(i, j + 1, 0));
+			setNeighbor(t + 1, 2, getTriangle(i - 1, j, 0));
+		}
+	}
+
+	return true;
+}
+
+Point3D TriangleMesh::getVertex(size_t i) const
+{
+	return Point3D(coordinates[3 * i], coordinates[3 * i + 1], coordinates[3 * i + 2]);
+}
+
+Point3D TriangleMesh::getVertex(size_t triangle, int i) const
+{
+	return getVertex(vertexIndexes[3 * triangle + i]);
+}
+
+int32_t TriangleMesh::getVertexIndex(size_t triangle, int i) const
+{
+	return vertexIndexes[3 * triangle + i];
+}
+
+int32_t TriangleMesh::getNeighbor(size_t triangle, int i) const
+{
+	return neighborIndexes[3 * triangle + i];
+}
+
+void TriangleMesh::setNeighbor(size_t triangle, int i, int32_t neighbor)
+{
+	neighborIndexes[3 * triangle + i] = neighbor;
+}
+
+Vector3D TriangleMesh::getNormal(size_t triangle) const
+{
+	return Vector3D(normals[3 * triangle], normals[3 * triangle + 1], normals[3 * triangle + 2]);
+}
+
+Point3D TriangleMesh::getCenter(size_t triangle) const
+{
+	double dX = 0;
+	double dY = 0;
+	double dZ = 0;
+	for (int i = 0; i < 3; i++) {
+		const size_t v = 3 * vertexIndexes[3 * triangle + i];
+		dX += coordinates[v];
+		dY += coordinates[v + 1];
+		dZ += coordinates[v + 2];
+	}
+	return Point3D(dX / 3, dY / 3, dZ / 3);
+}
+
+double TriangleMesh::getArea(size_t triangle) const
+{
+	Point3D a = getVertex(triangle, 0);
+	Point3D b = getVertex(triangle, 1);
+	Point3D c = getVertex(triangle, 2);
+	return ((b - a) % (c - a)).getLength() / 2.0;
+}
+
+int32_t TriangleMesh::getSensor(size_t triangle) const
+{
+	return sensorIndexes[triangle];
+}
+
+void TriangleMesh::getSensors(std::vector<double> * centers, std::vector<double> * areas, std::vector<float> * sensorNormals) const
+{
+	const size_t nS = nSensors();
+	centers->assign(3 * nS, 0);
+	areas->assign(nS, 0);
+	sensorNormals->assign(3 * nS, 0);
+
+	// The plain average is used for sensors with no area
+	std::vector<double> sums = std::vector<double>(3 * nS, 0);
+	std::vector<int> counts = std::vector<int>(nS, 0);
+
+	const size_t nT = nTriangles();
+	for (size_t i = 0; i < nT; i++) {
+		const size_t s = sensorIndexes[i];
+		const double area = getArea(i);
+		Point3D c = getCenter(i);
+		const double xyz[3] = { c.getX(), c.getY(), c.getZ() };
+		for (int j = 0; j < 3; j++) {
+			(*centers)[3 * s + j] += area * xyz[j];
+			sums[3 * s + j] += xyz[j];
+			(*sensorNormals)[3 * s + j] = normals[3 * i + j];
+		}
+		(*areas)[s] += area;
+		counts[s]++;
+	}
+
+	for (size_t s = 0; s < nS; s++) {
+		for (int j = 0; j < 3; j++) {
+			if ((*areas)[s] > 0)
+				(*centers)[3 * s + j] /= (*areas)[s];
+			else if (counts[s] > 0)
+				(*centers)[3 * s + j] = sums[3 * s + j] / counts[s];
+		}
+	}
+}
+
+void TriangleMesh::getSensorOutlines(std::vector< std::vector<int32_t> > * outlines) const
+{
+	outlines->assign(nSensors(), std::vector<int32_t>());
+
+	const size_t nT = nTriangles();
+	for (size_t i = 0; i < nT; i++) {
+		std::vector<int32_t> * outline = &(*outlines)[sensorIndexes[i]];
+		const int32_t * v = &vertexIndexes[3 * i];
+		if (outline->empty()) {
+			outline->assign(v, v + 3);
+			continue;
+		}
+
+		// Insert the vertex that is not in the outline 
+		// yet within the edge shared with it
+		for (int j = 0; j < 3; j++) {
+			const int32_t a = v[j];
+			const int32_t b = v[(j + 1) % 3];
+			const int32_t c = v[(j + 2) % 3];
+			if (std::find(outline->begin(), outline->end(), c) != outline->end())
+				continue;
+
+			// The shared edge goes from B to A in the outline
+			const size_t n = outline->size();
+			for (size_t k = 0; k < n; k++) {
+				if ((*outline)[k] == b && (*outline)[(k + 1) % n] == a) {
+					outline->insert(outline->begin() + k + 1, c);
+					break;
+				}
+			}
+			break;
+		}
+	}
+}
+
+void TriangleMesh::splitEdge(size_t triangle, int edge)
+{
+	const int32_t a = getVertexIndex(triangle, edge);
+	const int32_t b = getVertexIndex(triangle, (edge + 1) % 3);
+
+	// Add the midpoint
+	Point3D pa = getVertex(a);
+	Point3D pb = getVertex(b);
+	const int32_t m = addVertex((pa.getX() + pb.getX()) / 2, (pa.getY() + pb.getY()) / 2, (pa.getZ() + pb.getZ()) / 2);
+
+	// Triangles only share sensors with their neighbors, 
+	// so a bisected triangle is given a sensor of its own
+	// if any of them has the same one
+	auto detach = [&](size_t t) {
+		for (int i = 0; i < 3; i++) {
+			const int32_t n = getNeighbor(t, i);
+			if (n >= 0 && sensorIndexes[n] == sensorIndexes[t]) {
+				sensorIndexes[t] = sensorCount++;
+				return;
+			}
+		}
+	};
+
+	// Bisects a triangle, so that the original index keeps the
+	// first half of the edge. Returns the index of the second half
+	auto bisect = [&](size_t t, int e) -> int32_t {
+		const int32_t v0 = getVertexIndex(t, e);
+		const int32_t v1 = getVertexIndex(t, (e + 1) % 3);
+		const int32_t v2 = getVertexIndex(t, (e + 2) % 3);
+		const int32_t n1 = getNeighbor(t, (e + 1) % 3);
+		const int32_t n2 = getNeighbor(t, (e + 2) % 3);
+
+		detach(t);
+		const int32_t other = (int32_t)addTriangle(m, v1, v2, getNormal(t));
+
+		vertexIndexes[3 * t] = v0;
+		vertexIndexes[3 * t + 1] = m;
+		vertexIndexes[3 * t + 2] = v2;
+		setNeighbor(t, 0, -1);
+		setNeighbor(t, 1, other);
+		setNeighbor(t, 2, n2);
+
+		setNeighbor(other, 0, -1);
+		setNeighbor(other, 1, n1);
+		setNeighbor(other, 2, (int32_t)t);
+
+		// The old neighbor of the second half now sees it
+		if (n1 >= 0) {
+			for (int i = 0; i < 3; i++) {
+				if (getNeighbor(n1, i) == (int32_t)t)
+					setNeighbor(n1, i, other);
+			}
+		}
+		return other;
+	};
+
+	const int32_t neighbor = getNeighbor(triangle, edge);
+	int neighborEdge = -1;
+	if (neighbor >= 0) {
+		for (int i = 0; i < 3; i++) {
+			if (getNeighbor(neighbor, i) == (int32_t)triangle)
+				neighborEdge = i;
+		}
+	}
+
+	const int32_t other = bisect(triangle, edge);
+	if (neighborEdge < 0)
+		return;
+
+	// The neighbor goes from B to A, so its first half touches the
+	// second half of the triangle, and vice versa
+	const int32_t neighborOther = bisect(neighbor, neighborEdge);
+	setNeighbor(triangle, 0, neighborOther);
+	setNeighbor(neighborOther, 0, (int32_t)triangle);
+	setNeighbor(other, 0, neighbor);
+	setNeighbor(neighbor, 0, other);
+}
+
+size_t TriangleMesh::refine(const std::vector<double> * values, double threshold, double minArea, std::vector<char> * changed)
+{
+	const size_t nT = nTriangles();
+	const size_t nS = nSensors();
+	changed->assign(nS, 0);
+
+	// Mark first, so the values still match the sensors
+	std::vector<char> marked = std::vector<char>(nT, 0);
+	for (size_t i = 0; i < nT; i++) {
+		const double v = (*values)[sensorIndexes[i]];
+		for (int j = 0; j < 3; j++) {
+			const int32_t n = getNeighbor(i, j);
+			if (n < 0 || sensorIndexes[n] == sensorIndexes[i])
+				continue;
+
+			const double w = (*values)[sensorIndexes[n]];
+			const double average = (std::abs(v) + std::abs(w)) / 2;
+			if (average > 0 && std::abs(v - w) > threshold * average) {
+				marked[i] = 1;
+				break;
+			}
+		}
+	}
+
+	// Split... each triangle at most once
+	std::vector<char> split = std::vector<char>(nT, 0);
+	for (size_t i = 0; i < nT; i++) {
+		if (!marked[i] || split[i] || getArea(i) < minArea)
+			continue;
+
+		// Find the longest edge
+		int longest = 0;
+		double maxLength = -1;
+		for (int j = 0; j < 3; j++) {
+			const double l = (getVertex(i, (j + 1) % 3) - getVertex(i, j)).getSquaredLength();
+			if (l > maxLength) {
+				maxLength = l;
+				longest = j;
+			}
+		}
+
+		// The old sensors lose a piece (or they are the piece)
+		// (new sensors are marked afterwards)
+		auto markChanged = [&](size_t t) {
+			split[t] = 1;
+			if ((size_t)sensorIndexes[t] < nS)
+				(*changed)[sensorIndexes[t]] = 1;
+		};
+		const int32_t neighbor = getNeighbor(i, longest);
+		markChanged(i);
+		if (neighbor >= 0 && (size_t)neighbor < nT)
+			markChanged(neighbor);
+		splitEdge(i, longest);
+	}
+
+	// Everything that was added has changed as well
+	changed->resize(nSensors(), 1);
+
+	size_t nChanged = 0;
+	for (auto c : *changed)
+		nChanged += c;
+	return nChanged;
+}
+
+//! The first bytes of a file written by TriangleMesh::write()
+static const char meshFileMagic[8] = { 'E','M','P','M','E','S','H','\0' };
+
+bool TriangleMesh::write(std::string filename) const
+{
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	const uint32_t version = EMP_TRIANGLEMESH_FILE_VERSION;
+	const uint64_t nV = nVertices();
+	const uint64_t nT = nTriangles();
+	const uint64_t nS = nSensors();
+
+	file.write(meshFileMagic, sizeof(meshFileMagic));
+	file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+	file.write(reinterpret_cast<const char *>(&nV), sizeof(nV));
+	file.write(reinterpret_cast<const char *>(&nT), sizeof(nT));
+	file.write(reinterpret_cast<const char *>(&nS), sizeof(nS));
+	file.write(reinterpret_cast<const char *>(coordinates.data()), coordinates.size() * sizeof(double));
+	file.write(reinterpret_cast<const char *>(vertexIndexes.data()), vertexIndexes.size() * sizeof(int32_t));
+	file.write(reinterpret_cast<const char *>(neighborIndexes.data()), neighborIndexes.size() * sizeof(int32_t));
+	file.write(reinterpret_cast<const char *>(normals.data()), normals.size() * sizeof(float));
+	file.write(reinterpret_cast<const char *>(sensorIndexes.data()), sensorIndexes.size() * sizeof(int32_t));
+
+	return file.good();
+}
+
+bool TriangleMesh::read(std::string filename)
+{
+	clear();
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[sizeof(meshFileMagic)];
+	uint32_t version = 0;
+	uint64_t nV = 0;
+	uint64_t nT = 0;
+	uint64_t nS = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char *>(&version), sizeof(version));
+	file.read(reinterpret_cast<char *>(&nV), sizeof(nV));
+	file.read(reinterpret_cast<char *>(&nT), sizeof(nT));
+	file.read(reinterpret_cast<char *>(&nS), sizeof(nS));
+	if (!file.good() || !std::equal(magic, magic + sizeof(magic), meshFileMagic) || version != EMP_TRIANGLEMESH_FILE_VERSION)
+		return false;
+
+	// Do not trust the sizes... check them against the file
+	const std::streamoff start = file.tellg();
+	file.seekg(0, std::ios::end);
+	const uint64_t expected = nV * 3 * sizeof(double) + nT * 3 * (2 * sizeof(int32_t) + sizeof(float)) + nT * sizeof(int32_t);
+	if (nV > INT32_MAX || nT > INT32_MAX || nS > nT || (uint64_t)(file.tellg() - start) != expected)
+		return false;
+	file.seekg(start);
+
+	coordinates.resize(3 * nV);
+	vertexIndexes.resize(3 * nT);
+	neighborIndexes.resize(3 * nT);
+	normals.resize(3 * nT);
+	sensorIndexes.resize(nT);
+	file.read(reinterpret_cast<char *>(coordinates.data()), coordinates.size() * sizeof(double));
+	file.read(reinterpret_cast<char *>(vertexIndexes.data()), vertexIndexes.size() * sizeof(int32_t));
+	file.read(reinterpret_cast<char *>(neighborIndexes.data()), neighborIndexes.size() * sizeof(int32_t));
+	file.read(reinterpret_cast<char *>(normals.data()), normals.size() * sizeof(float));
+	file.read(reinterpret_cast<char *>(sensorIndexes.data()), sensorIndexes.size() * sizeof(int32_t));
+	sensorCount = (int32_t)nS;
+
+	bool success = file.good();
+	for (auto v : vertexIndexes)
+		success = success && v >= 0 && (uint64_t)v < nV;
+	for (auto n : neighborIndexes)
+		success = success && n >= -1 && (int64_t)n < (int64_t)nT;
+	for (auto i : sensorIndexes)
+		success = success && i >= 0 && (uint64_t)i < nS;
+
+	if (!success)
+		clear();
+	return success;
+}
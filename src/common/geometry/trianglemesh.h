@@ -0,0 +1,331 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./point3d.h"
+#include "./vector.h"
+
+class Triangulation;
+class Polygon3D;
+
+//! The tolerance (relative to the size of a Polygon3D) used when meshing it as a grid (see TriangleMesh::appendGrid())
+#define EMP_GRID_TOLERANCE 1e-6
+
+//! The distance (relative to the spacing) under which a grid line is snapped onto an edge of the Polygon3D (see TriangleMesh::appendGrid())
+#define EMP_GRID_SNAP_TOLERANCE 0.25
+
+//! The version of the binary format written by TriangleMesh::write()
+#define EMP_TRIANGLEMESH_FILE_VERSION 2
+
+// A compact, indexed representation of a set of triangles
+/*!
+Vertices are stored in a single array of coordinates, and triangles as
+int32 indexes to those vertices (three per triangle). The neighbors of 
+each triangle are stored in the same way (-1 meaning no neighbor), 
+following the convention of Triangle::getNeighbor().
+
+Each triangle also belongs to a sensor (i.e. a point where results are
+calculated). By default, every triangle is a sensor on its own, but 
+the two triangles of a cell of a structured grid (see 
+TriangleMesh::appendGrid()) share one.
+
+All the data lives in a handful of contiguous buffers, which are allocated
+in bulk (see TriangleMesh::reserve()) and released together. This is what
+the Triangulation of a Workplane is turned into once finished, so the
+(heavier) Triangle objects can be freed.
+*/
+class TriangleMesh {
+
+private:
+	std::vector<double> coordinates = std::vector<double>(); //!< The X, Y and Z components of each vertex
+	std::vector<int32_t> vertexIndexes = std::vector<int32_t>(); //!< The three vertices of each triangle
+	std::vector<int32_t> neighborIndexes = std::vector<int32_t>(); //!< The three neighbors of each triangle (-1 if none)
+	std::vector<float> normals = std::vector<float>(); //!< The normal of each triangle
+	std::vector<int32_t> sensorIndexes = std::vector<int32_t>(); //!< The sensor of each triangle
+	int32_t sensorCount = 0; //!< The number of sensors
+
+public:
+
+	//! Reserves space for some vertices and triangles
+	/*!
+	@author German Molina
+	@param[in] nVertices The number of vertices
+	@param[in] nTriangles The number of triangles
+	*/
+	void reserve(size_t nVertices, size_t nTriangles);
+
+	//! Removes all the content
+	/*!
+	Also releases the memory
+
+	@author German Molina
+	*/
+	void clear();
+
+	//! Retrieves the number of vertices
+	/*!
+	@author German Molina
+	@return The number of vertices
+	*/
+	size_t nVertices() const;
+
+	//! Retrieves the number of triangles
+	/*!
+	@author German Molina
+	@return The number of triangles
+	*/
+	size_t nTriangles() const;
+
+	//! Retrieves the number of sensors
+	/*!
+	@author German Molina
+	@return The number of sensors
+	*/
+	size_t nSensors() const;
+
+	//! Adds a vertex
+	/*!
+	@author German Molina
+	@param[in] x The X component
+	@param[in] y The Y component
+	@param[in] z The Z component
+	@return The index of the new vertex
+	*/
+	int32_t addVertex(double x, double y, double z);
+
+	//! Adds a triangle
+	/*!
+	Its neighbors are set to -1
+
+	@author German Molina
+	@param[in] a The index of the first vertex
+	@param[in] b The index of the second vertex
+	@param[in] c The index of the third vertex
+	@param[in] normal The normal of the triangle
+	@param[in] sensor The sensor the triangle belongs to (-1 means a new one)
+	@return The index of the new triangle
+	*/
+	size_t addTriangle(int32_t a, int32_t b, int32_t c, Vector3D normal, int32_t sensor = -1);
+
+	//! Appends all the (non NULL) triangles of a Triangulation
+	/*!
+	Vertices shared by several Triangle objects (i.e. at the same
+	position) are stored once. The Triangulation should have been 
+	purged (see Triangulation::purge()).
+
+	@author German Molina
+	@param[in] t The triangulation
+	@param[in] normal The normal of all the triangles
+	*/
+	void append(Triangulation * t, Vector3D normal);
+
+	//! Appends all the triangles of another TriangleMesh
+	/*!
+	@author German Molina
+	@param[in] other The other TriangleMesh
+	*/
+	void append(const TriangleMesh * other);
+
+	//! Appends a Polygon3D meshed as a structured grid
+	/*!
+	The Polygon3D is rasterized into square cells of the given size, 
+	aligned with its first edge. The cells are clipped by the edges of 
+	the Polygon3D, and each resulting rectangle is split into two 
+	triangles along its diagonal, which share a single sensor at the 
+	center of the rectangle. This takes linear time on the number
+	of cells.
+
+	Grid lines closer than EMP_GRID_SNAP_TOLERANCE times the spacing to
+	an edge of the Polygon3D are snapped onto that edge, so the cells 
+	next to the edges may be slightly bigger than spacing^2, but there
+	are no thin slivers.
+
+	Only rectilinear Polygon3D objects (i.e. all their edges, including 
+	the ones in the inner loops, are parallel or perpendicular to the 
+	first edge of the outer loop) are supported.
+
+	@author German Molina
+	@param[in] polygon The Polygon3D
+	@param[in] spacing The size of the cells
+	@return success (false if the Polygon3D is not rectilinear)
+	*/
+	bool appendGrid(Polygon3D * polygon, double spacing);
+
+	//! Writes the TriangleMesh into a binary file
+	/*!
+	The file is written in the native byte order, so it is meant to 
+	be read back by the same machine (e.g. as a cache).
+
+	@author German Molina
+	@param[in] filename The name of the file
+	@return success
+	*/
+	bool write(std::string filename) const;
+
+	//! Reads a TriangleMesh from a binary file (see TriangleMesh::write())
+	/*!
+	The current content is replaced. If the file does not exist or 
+	is not a valid TriangleMesh, the TriangleMesh is left empty.
+
+	@author German Molina
+	@param[in] filename The name of the file
+	@return success
+	*/
+	bool read(std::string filename);
+
+	//! Retrieves a vertex
+	/*!
+	@author German Molina
+	@param[in] i The index of the vertex
+	@return The vertex
+	*/
+	Point3D getVertex(size_t i) const;
+
+	//! Retrieves a vertex of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@param[in] i The vertex of the triangle (0, 1 or 2)
+	@return The vertex
+	*/
+	Point3D getVertex(size_t triangle, int i) const;
+
+	//! Retrieves the index of a vertex of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@param[in] i The vertex of the triangle (0, 1 or 2)
+	@return The index of the vertex
+	*/
+	int32_t getVertexIndex(size_t triangle, int i) const;
+
+	//! Retrieves a neighbor of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@param[in] i The edge (0, 1 or 2)
+	@return The index of the neighbor, or -1
+	*/
+	int32_t getNeighbor(size_t triangle, int i) const;
+
+	//! Sets a neighbor of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@param[in] i The edge (0, 1 or 2)
+	@param[in] neighbor The index of the neighbor, or -1
+	*/
+	void setNeighbor(size_t triangle, int i, int32_t neighbor);
+
+	//! Retrieves the normal of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@return The normal
+	*/
+	Vector3D getNormal(size_t triangle) const;
+
+	//! Calculates the center of a triangle (average of its vertices)
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@return The center
+	*/
+	Point3D getCenter(size_t triangle) const;
+
+	//! Calculates the area of a triangle
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@return The area
+	*/
+	double getArea(size_t triangle) const;
+
+	//! Retrieves the sensor a triangle belongs to
+	/*!
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@return The index of the sensor
+	*/
+	int32_t getSensor(size_t triangle) const;
+
+	//! Calculates the position, size and orientation of every sensor
+	/*!
+	The center of a sensor is the area-weighted average of the centers
+	of its triangles, and its area is the sum of theirs.
+
+	@author German Molina
+	@param[out] centers The X, Y and Z components of the center of each sensor
+	@param[out] areas The area of each sensor
+	@param[out] sensorNormals The X, Y and Z components of the normal of each sensor
+	*/
+	void getSensors(std::vector<double> * centers, std::vector<double> * areas, std::vector<float> * sensorNormals) const;
+
+	//! Calculates the outline of every sensor
+	/*!
+	The outline of a sensor made of a single triangle is that triangle,
+	and the one of a cell of a structured grid is its rectangle.
+
+	@author German Molina
+	@param[out] outlines The indexes of the vertices of each sensor, counter clockwise
+	*/
+	void getSensorOutlines(std::vector< std::vector<int32_t> > * outlines) const;
+
+	//! Splits an edge of a triangle by its midpoint
+	/*!
+	The triangle is bisected from the midpoint to its opposite 
+	vertex, and so is the neighbor that shares the edge (if any), 
+	so the TriangleMesh remains conforming. 
+
+	The triangle (and its neighbor) keep their index and become 
+	the half that contains the first vertex of the edge; the other
+	halves are added at the end of the TriangleMesh, as new sensors.
+	A bisected triangle that shared its sensor with a neighbor (i.e.
+	a cell of a structured grid) is given a sensor of its own.
+
+	@author German Molina
+	@param[in] triangle The index of the triangle
+	@param[in] edge The edge to split (0, 1 or 2)
+	*/
+	void splitEdge(size_t triangle, int edge);
+
+	//! Splits the triangles where some value changes too fast
+	/*!
+	A triangle is split (through its longest edge, see 
+	TriangleMesh::splitEdge()) when the value of its sensor differs 
+	from the one of any of its neighbors by more than a threshold, 
+	relative to their average. Triangles smaller than a minimum area 
+	are never split.
+
+	@author German Molina
+	@param[in] values One value per sensor
+	@param[in] threshold The maximum relative difference allowed between neighbors
+	@param[in] minArea The area of the smallest triangle that can be split
+	@param[out] changed Set to 1 for every sensor that was modified or added, and to 0 for the rest
+	@return The number of sensors that were modified or added
+	*/
+	size_t refine(const std::vector<double> * values, double threshold, double minArea, std::vector<char> * changed);
+};
@@ -25,6 +25,10 @@
 #include "../utilities/io.h"
 #include "../../config_constants.h"
 #include "../../os_definitions.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include "tbb/tbb.h"
 
 
 #define MPE_POLY2TRI_IMPLEMENTATION
@@ -53,10 +57,25 @@ Triangulation::~Triangulation()
 }
 
 
+Point3D * Triangulation::createPoint(double x, double y, double z)
+{
+	// Pointers to the elements of a chunk remain valid because chunks never grow beyond their capacity
+	if (pointArena.empty() || pointArena.back().size() == EMP_TRIANGULATION_ARENA_CHUNK) {
+		pointArena.push_back(std::vector<Point3D>());
+		pointArena.back().reserve(EMP_TRIANGULATION_ARENA_CHUNK);
+	}
+	pointArena.back().push_back(Point3D(x, y, z));
+	return &(pointArena.back().back());
+}
+
 size_t Triangulation::addTriangle(Triangle * t) {
 	t->setIndex(nTriangles);
 	
 	triangles.push_back(t);
+
+	// Keep the point-location index up to date
+	if (!grid.isEmpty())
+		grid.addTriangle(t, nTriangles);
 	
 	nTriangles += 1;
 	return nTriangles;
@@ -96,18 +115,17 @@ bool Triangulation::addPointToTriangle(size_t index, Point3D * point, int code)
 
 bool Triangulation::addPoint(Point3D * point, bool warn)
 {
-	// Iterate through triangles to check
-	int code;
-	for (size_t i = 0; i < triangles.size(); i++) {
-		// skip triangle if it has been deleted
-		if (triangles[i] == nullptr)
-			continue;
-		
-		if (triangles[i]->testPoint( point, &code))
-			return addPointToTriangle(i, point, code);
-					
+	// (Re)build the index if it does not exist or is too crowded
+	if (grid.isEmpty() || nTriangles > 2 * gridBuiltAt) {
+		grid.build(&triangles);
+		gridBuiltAt = nTriangles;
 	}
 
+	int code;
+	size_t i;
+	if (grid.findTriangle(&triangles, point, &i, &code))
+		return addPointToTriangle(i, point, code);
+
     if (warn) {
 	  FATAL(errorMessage,"Point is not in any triangle");
     }
@@ -284,6 +302,38 @@ double Triangulation::getBestAspectRatio(Triangle * t, int i)
 }
 
 
+//! Finds the neighbor with which a Triangle should flip its diagonal, if any
+/*!
+@author German Molina
+@param[in] triangulation The triangulation
+@param[in] t The triangle
+@return The edge to flip, or -1 if flipping is not worth it
+*/
+static int getEdgeToFlip(Triangulation * triangulation, Triangle * t)
+{
+	double currentAspectRatio = t->getAspectRatio();
+
+	if (currentAspectRatio < MAX_ASPECT_RATIO)
+		return -1;
+	
+	// Check if it is worth flipping
+	int bestNeighbor = -1;
+	double bestAspectRatio = EMP_HUGE;
+	// Found an ugly triangle
+	for (int j = 0; j < 3; j++) { // Check three edges for flipping 
+		// calculate possible aspect ratio		
+		double ar = triangulation->getBestAspectRatio(t, j);
+		if (ar == -1) // Null neighbor or constraint
+			continue;
+		
+		if ( (currentAspectRatio - ar) > EMP_TINY  &&  (bestAspectRatio-ar) > EMP_TINY) {
+			bestNeighbor = j;
+			bestAspectRatio = ar;
+		}		
+	}
+	return bestNeighbor;
+}
+
 void Triangulation::restoreDelaunay()
 {	
 	
@@ -292,26 +342,7 @@ void Triangulation::restoreDelaunay()
 		if (triangles[i] == NULL)
 			continue;
 
-		double currentAspectRatio = triangles[i]->getAspectRatio();
-
-		if (currentAspectRatio < MAX_ASPECT_RATIO)
-			continue;
-		
-		// Check if it is worth flipping
-		int bestNeighbor = -1;
-		double bestAspectRatio = EMP_HUGE;
-		// Found an ugly triangle
-		for (int j = 0; j < 3; j++) { // Check three edges for flipping 
-			// calculate possible aspect ratio		
-			double ar = getBestAspectRatio(triangles[i], j);
-			if (ar == -1) // Null neighbor or constraint
-				continue;
-			
-			if ( (currentAspectRatio - ar) > EMP_TINY  &&  (bestAspectRatio-ar) > EMP_TINY) {
-				bestNeighbor = j;
-				bestAspectRatio = ar;
-			}		
-		}
+		int bestNeighbor = getEdgeToFlip(this, triangles[i]);
 
 		// Flip if needed.
 		if (bestNeighbor >= 0 ) { 
@@ -322,6 +353,38 @@ void Triangulation::restoreDelaunay()
 	}
 }
 
+void Triangulation::restoreDelaunay(size_t firstTriangle)
+{
+	// The triangles that may need flipping
+	std::vector<size_t> suspects = std::vector<size_t>();
+	for (size_t i = nTriangles; i > firstTriangle; i--)
+		suspects.push_back(i - 1);
+
+	while (!suspects.empty()) {
+		size_t i = suspects.back();
+		suspects.pop_back();
+
+		if (triangles[i] == NULL)
+			continue;
+
+		int bestNeighbor = getEdgeToFlip(this, triangles[i]);
+		if (bestNeighbor < 0)
+			continue;
+
+		flipDiagonal(i, bestNeighbor);
+
+		// The two new triangles, and whoever is next to them, need to be checked again
+		for (size_t n = nTriangles - 2; n < nTriangles; n++) {
+			for (int j = 0; j < 3; j++) {
+				Triangle * neighbor = triangles[n]->getNeighbor(j);
+				if (neighbor != NULL)
+					suspects.push_back(neighbor->getIndex());
+			}
+			suspects.push_back(n);
+		}
+	}
+}
+
 
 bool Triangulation::splitTriangle(size_t i, Point3D * p)
 {	
@@ -541,10 +604,16 @@ void Triangulation::clean()
 
 void Triangulation::refine(double maxArea, double maxAspectRatio)
 {	
+	// Start from a good triangulation... after that, each 
+	// insertion only needs to be fixed locally
+	restoreDelaunay();
+
 	for (size_t i = 0; i < nTriangles; i++) {
 		if (triangles[i] == nullptr)
 			continue;
 
+		const size_t firstNew = nTriangles;
+
 		double area = triangles[i]->getArea();
 
 		if (area < 9e-3)
@@ -566,40 +635,49 @@ void Triangulation::refine(double maxArea, double maxAspectRatio)
 			double dX = s->start->getX() + s->end->getX(); 
 			double dY = s->start->getY() + s->end->getY(); 
 			double dZ = s->start->getZ() + s->end->getZ();
-			addPointToTriangle(i,new Point3D(dX/2,dY/2,dZ/2), longestSegmentIndex + 3);
-			restoreDelaunay();
+			addPointToTriangle(i,createPoint(dX/2,dY/2,dZ/2), longestSegmentIndex + 3);
+			restoreDelaunay(firstNew);
 		} 
 		else if (area > maxArea) { 
 			// if it is a skinny triangle, try to add the circumcenter
-			Point3D * cCenter = new Point3D(triangles[i]->getCircumCenter());
+			Point3D center = triangles[i]->getCircumCenter();
+			Point3D * cCenter = createPoint(center.getX(), center.getY(), center.getZ());
 			// Since the circumcenter may be in another triangle, we need 
 			// to search for it.
-            if(!addPoint(cCenter,false)){
-                // What should I do if the circumcenter is out of the polygon?
-                delete cCenter;
-                
-                //... for now, lets try adding the average of the triangle
-                Point3D * a = triangles[i]->getVertex(0);
-                Point3D * b = triangles[i]->getVertex(1);
-                Point3D * c = triangles[i]->getVertex(2);
-                
-                double x = a->getX()+b->getX()+c->getX();
-                double y = a->getY()+b->getY()+c->getY();
-                double z = a->getZ()+b->getZ()+c->getZ();
-                
-                // This one we KNOW will be inside itself, actually
-                Point3D * gCenter = new Point3D(x/3, y/3, z/3);
-                //addPoint(gCenter,false);
-                splitTriangle(i, gCenter);
-                
+            bool added = addPoint(cCenter,false);
+            if(added && nTriangles > firstNew){
+                // The circumcenter may have split another triangle,
+                // leaving this one as it was... check it again
+                restoreDelaunay(firstNew);
+                if(triangles[i] != nullptr)
+                    i--;
+                continue;
             }
-			restoreDelaunay();			
+            
+            // What should I do if the circumcenter is out of the polygon
+            // (or if it is already a vertex)?
+            
+            //... for now, lets split the longest edge
+            Segment * s = triangles[i]->getSegment(0);
+            int longestSegmentIndex= 0;
+            for (int j = 1; j < 3; j++) {
+                if (s->getLength() < triangles[i]->getSegment(j)->getLength()) {
+                    longestSegmentIndex = j;
+                    s = triangles[i]->getSegment(j);
+                }
+            }
+            double dX = s->start->getX() + s->end->getX(); 
+            double dY = s->start->getY() + s->end->getY(); 
+            double dZ = s->start->getZ() + s->end->getZ();
+            addPointToTriangle(i,createPoint(dX/2,dY/2,dZ/2), longestSegmentIndex + 3);
+            
+			restoreDelaunay(firstNew);
 		}
 	}
 }
 
 
-bool Triangulation::mesh(double maxArea, double maxAspectRatio)
+bool Triangulation::mesh(double maxArea, double maxAspectRatio, size_t nCells)
 {	
     Loop * outerLoop = polygon->getOuterLoopRef();
 	// Is it really needed to do a CDT?
@@ -623,11 +701,439 @@ bool Triangulation::mesh(double maxArea, double maxAspectRatio)
             return false;
     }
   
-  refine(maxArea, maxAspectRatio);
+  if (nCells > 1)
+    refineInCells(maxArea, maxAspectRatio, nCells);
+  else
+    refine(maxArea, maxAspectRatio);
   return true;
 }
 
 
+//! An edge shared by two cells (see Triangulation::refineInCells())
+struct CutEdge {
+	Point3D * a; //!< The start of the edge
+	Point3D * b; //!< The end of the edge
+	size_t cells[2]; //!< The cells at each side of the edge
+};
+
+//! A piece of a CutEdge, as seen from one of its cells
+struct CutEdgeSegment {
+	double t0; //!< The position of the start of the segment along the CutEdge
+	double t1; //!< The position of the end of the segment along the CutEdge
+	Point3D * start; //!< The start of the segment
+	Point3D * end; //!< The end of the segment
+	Triangle * triangle; //!< The Triangle that has the segment as an edge
+	size_t index; //!< The index of the Triangle
+	int edge; //!< The edge of the Triangle
+};
+
+//! The tolerance (relative to the length of a CutEdge) used when comparing points on it
+#define EMP_CUT_EDGE_TOLERANCE 1e-6
+
+//! Calculates the position of a Point3D along a CutEdge
+/*!
+@author German Molina
+@param[in] e The CutEdge
+@param[in] p The Point3D
+@param[out] t The position (0 at the start, 1 at the end)
+@return Is p on e?
+*/
+static bool getCutEdgeParameter(CutEdge * e, Point3D * p, double * t)
+{
+	Vector3D ab = *(e->b) - *(e->a);
+	Vector3D ap = *p - *(e->a);
+	const double l2 = ab.getSquaredLength();
+	*t = (ap * ab) / l2;
+	if (*t < -EMP_CUT_EDGE_TOLERANCE || *t > 1 + EMP_CUT_EDGE_TOLERANCE)
+		return false;
+
+	Vector3D d = ap - ab * (*t);
+	return d.getSquaredLength() <= EMP_CUT_EDGE_TOLERANCE * EMP_CUT_EDGE_TOLERANCE * l2;
+}
+
+//! Assigns a cell to each Triangle by recursively bisecting their centers
+/*!
+Each group is split in two along the longest side of its bounding box,
+giving each half a number of triangles proportional to its number of cells.
+
+@author German Molina
+@param[in] ids The indexes of the triangles (reordered by this function)
+@param[in] centers The center of each triangle
+@param[in] begin The first element of ids in the group
+@param[in] end The element of ids after the last one in the group
+@param[in] firstCell The first cell of the group
+@param[in] nCells The number of cells in the group
+@param[out] cellOf The cell of each triangle
+*/
+static void bisectTriangles(std::vector<size_t> * ids, std::vector<Point3D> * centers, size_t begin, size_t end, size_t firstCell, size_t nCells, std::vector<size_t> * cellOf)
+{
+	if (nCells == 1) {
+		for (size_t i = begin; i < end; i++)
+			(*cellOf)[(*ids)[i]] = firstCell;
+		return;
+	}
+
+	auto coordinate = [=](size_t triangle, int axis) {
+		Point3D * c = &(*centers)[triangle];
+		return axis == 0 ? c->getX() : (axis == 1 ? c->getY() : c->getZ());
+	};
+
+	// Find the longest side of the bounding box
+	int axis = 0;
+	double longest = -1;
+	for (int k = 0; k < 3; k++) {
+		double min = EMP_HUGE;
+		double max = EMP_MINUS_HUGE;
+		for (size_t i = begin; i < end; i++) {
+			const double v = coordinate((*ids)[i], k);
+			min = v < min ? v : min;
+			max = v > max ? v : max;
+		}
+		if (max - min > longest) {
+			longest = max - min;
+			axis = k;
+		}
+	}
+
+	const size_t nLeft = nCells / 2;
+	const size_t mid = begin + (end - begin) * nLeft / nCells;
+	std::nth_element(ids->begin() + begin, ids->begin() + mid, ids->begin() + end, [&](size_t a, size_t b) {
+		return coordinate(a, axis) < coordinate(b, axis);
+	});
+
+	bisectTriangles(ids, centers, begin, mid, firstCell, nLeft, cellOf);
+	bisectTriangles(ids, centers, mid, end, firstCell + nLeft, nCells - nLeft, cellOf);
+}
+
+//! Finds the edges of the Triangle objects of a cell that lie on its CutEdge objects
+/*!
+@author German Molina
+@param[in] cell The Triangulation of the cell
+@param[in] cellIndex The index of the cell
+@param[in] cutEdges All the CutEdge objects
+@param[in] cellCutEdges The indexes of the CutEdge objects of this cell
+@param[out] segments The segments of each side of each CutEdge (two per CutEdge)
+*/
+static void collectCutEdgeSegments(Triangulation * cell, size_t cellIndex, std::vector<CutEdge> * cutEdges, const std::vector<size_t> * cellCutEdges, std::vector< std::vector<CutEdgeSegment> > * segments)
+{
+	for (auto k : *cellCutEdges) {
+		const int side = (*cutEdges)[k].cells[0] == cellIndex ? 0 : 1;
+		(*segments)[2 * k + side].clear();
+	}
+
+	const size_t nTriangles = cell->getNumTriangles();
+	for (size_t i = 0; i < nTriangles; i++) {
+		Triangle * t = cell->getTriangleRef(i);
+		if (t == nullptr)
+			continue;
+
+		for (int j = 0; j < 3; j++) {
+			// Only the boundaries of the cell can be on a CutEdge
+			if (t->getNeighbor(j) != nullptr)
+				continue;
+
+			Point3D * start = t->getVertex(j);
+			Point3D * end = t->getVertex((j + 1) % 3);
+			for (auto k : *cellCutEdges) {
+				CutEdge * e = &(*cutEdges)[k];
+				double t0, t1;
+				if (getCutEdgeParameter(e, start, &t0) && getCutEdgeParameter(e, end, &t1)) {
+					const int side = e->cells[0] == cellIndex ? 0 : 1;
+					(*segments)[2 * k + side].push_back({ t0, t1, start, end, t, i, j });
+					break;
+				}
+			}
+		}
+	}
+}
+
+//! Adds to one side of a CutEdge the points that are only in the other side
+/*!
+@author German Molina
+@param[in] cell The Triangulation of the cell receiving the points
+@param[in] to The segments of the side receiving the points
+@param[in] from The segments of the other side
+@return Whether the cell was modified, or could not be updated because a segment was outdated
+*/
+static bool copyCutEdgePoints(Triangulation * cell, const std::vector<CutEdgeSegment> * to, const std::vector<CutEdgeSegment> * from)
+{
+	// Points already there
+	std::vector<double> existing = std::vector<double>();
+	existing.reserve(2 * to->size());
+	for (auto & s : *to) {
+		existing.push_back(s.t0);
+		existing.push_back(s.t1);
+	}
+	std::sort(existing.begin(), existing.end());
+
+	// Points to add, grouped by the segment containing them
+	std::vector< std::vector< std::pair<double, Point3D *> > > missing = std::vector< std::vector< std::pair<double, Point3D *> > >(to->size());
+	bool changed = false;
+	for (auto & s : *from) {
+		const double t = s.t0;
+		auto found = std::lower_bound(existing.begin(), existing.end(), t - EMP_CUT_EDGE_TOLERANCE);
+		if (found != existing.end() && *found <= t + EMP_CUT_EDGE_TOLERANCE)
+			continue;
+
+		for (size_t m = 0; m < to->size(); m++) {
+			const CutEdgeSegment * seg = &(*to)[m];
+			if (t > std::min(seg->t0, seg->t1) && t < std::max(seg->t0, seg->t1)) {
+				// Sort by distance to the start of the segment
+				missing[m].push_back(std::make_pair(std::abs(t - seg->t0), s.start));
+				break;
+			}
+		}
+	}
+
+	for (size_t m = 0; m < to->size(); m++) {
+		if (missing[m].empty())
+			continue;
+
+		changed = true;
+		const CutEdgeSegment * seg = &(*to)[m];
+
+		// The Triangle may have been split when adding points to another CutEdge
+		if (cell->getTriangleRef(seg->index) != seg->triangle)
+			continue;
+
+		std::sort(missing[m].begin(), missing[m].end());
+		size_t index = seg->index;
+		int edge = seg->edge;
+		for (auto & p : missing[m]) {
+			cell->addPointToTriangle(index, p.second, edge + 3);
+
+			// The rest of the segment is the first edge of
+			// the last Triangle added (see Triangulation::splitEdge())
+			index = cell->getNumTriangles() - 1;
+			edge = 0;
+		}
+	}
+	return changed;
+}
+
+//! Checks whether a Triangulation has triangles that Triangulation::refine() would split
+/*!
+@author German Molina
+@param[in] t The Triangulation
+@param[in] maxArea The maximum area
+@param[in] maxAspectRatio The maximum aspect ratio
+@return Is any Triangle too big or too skinny?
+*/
+static bool breaksLimits(Triangulation * t, double maxArea, double maxAspectRatio)
+{
+	const size_t n = t->getNumTriangles();
+	for (size_t i = 0; i < n; i++) {
+		Triangle * triangle = t->getTriangleRef(i);
+		if (triangle == nullptr)
+			continue;
+
+		// Same criteria as Triangulation::refine()
+		const double area = triangle->getArea();
+		if (area >= 9e-3 && (area > maxArea || triangle->getAspectRatio() > maxAspectRatio))
+			return true;
+	}
+	return false;
+}
+
+void Triangulation::refineInCells(double maxArea, double maxAspectRatio, size_t nCells)
+{
+	// Refine coarsely first, so there is enough triangles to split
+	double area = 0;
+	for (size_t i = 0; i < nTriangles; i++) {
+		if (triangles[i] != nullptr)
+			area += triangles[i]->getArea();
+	}
+	const double coarseArea = area / (double)(nCells * EMP_TRIANGULATION_TRIANGLES_PER_CELL);
+	if (coarseArea > maxArea)
+		refine(coarseArea, maxAspectRatio);
+	purge();
+
+	if (nCells > nTriangles)
+		nCells = nTriangles;
+
+	if (nCells < 2) {
+		refine(maxArea, maxAspectRatio);
+		return;
+	}
+
+	// Split the triangles
+	std::vector<Point3D> centers = std::vector<Point3D>();
+	std::vector<size_t> ids = std::vector<size_t>(nTriangles);
+	centers.reserve(nTriangles);
+	for (size_t i = 0; i < nTriangles; i++) {
+		centers.push_back(triangles[i]->getCenter());
+		ids[i] = i;
+	}
+	std::vector<size_t> cellOf = std::vector<size_t>(nTriangles);
+	bisectTriangles(&ids, &centers, 0, nTriangles, 0, nCells, &cellOf);
+
+	// Create the cells, and find the edges between them
+	std::vector<Triangulation *> cells = std::vector<Triangulation *>(nCells);
+	for (size_t c = 0; c < nCells; c++)
+		cells[c] = new Triangulation(polygon);
+
+	std::vector<Triangle *> copies = std::vector<Triangle *>(nTriangles);
+	for (size_t i = 0; i < nTriangles; i++) {
+		Triangle * t = triangles[i];
+		copies[i] = new Triangle(t->getVertex(0), t->getVertex(1), t->getVertex(2));
+		for (int j = 0; j < 3; j++) {
+			if (t->isContraint(j))
+				copies[i]->setConstraint(j);
+		}
+		cells[cellOf[i]]->addTriangle(copies[i]);
+	}
+
+	std::vector<CutEdge> cutEdges = std::vector<CutEdge>();
+	std::vector< std::vector<size_t> > cellCutEdges = std::vector< std::vector<size_t> >(nCells);
+	for (size_t i = 0; i < nTriangles; i++) {
+		for (int j = 0; j < 3; j++) {
+			Triangle * neighbor = triangles[i]->getNeighbor(j);
+			if (neighbor == nullptr)
+				continue;
+
+			const size_t n = neighbor->getIndex();
+			if (cellOf[n] == cellOf[i]) {
+				copies[i]->setNeighbor(copies[n], j, false);
+			}
+			else if (i < n) {
+				cellCutEdges[cellOf[i]].push_back(cutEdges.size());
+				cellCutEdges[cellOf[n]].push_back(cutEdges.size());
+				cutEdges.push_back({ triangles[i]->getVertex(j), triangles[i]->getVertex((j + 1) % 3), { cellOf[i], cellOf[n] } });
+			}
+		}
+	}
+
+	// The coarse triangles are no longer needed
+	for (size_t i = 0; i < nTriangles; i++)
+		delete triangles[i];
+	triangles.clear();
+	nTriangles = 0;
+	grid = TriangleGrid();
+	gridBuiltAt = 0;
+
+	// Refine all cells, and stitch them until they match
+	std::vector<size_t> pending = std::vector<size_t>(nCells);
+	for (size_t c = 0; c < nCells; c++)
+		pending[c] = c;
+
+	std::vector< std::vector<CutEdgeSegment> > segments = std::vector< std::vector<CutEdgeSegment> >(2 * cutEdges.size());
+	std::vector<char> unrefined = std::vector<char>(nCells, 0);
+	for (int stitch = 0; ; stitch++) {
+		if (stitch <= EMP_TRIANGULATION_MAX_STITCHES) {
+			tbb::parallel_for(tbb::blocked_range<size_t>(0, pending.size()),
+				[&](const tbb::blocked_range<size_t>& r) {
+				for (size_t i = r.begin(); i != r.end(); ++i)
+					cells[pending[i]]->refine(maxArea, maxAspectRatio);
+			},
+				tbb::auto_partitioner()
+				);
+		}
+
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, nCells),
+			[&](const tbb::blocked_range<size_t>& r) {
+			for (size_t c = r.begin(); c != r.end(); ++c)
+				collectCutEdgeSegments(cells[c], c, &cutEdges, &cellCutEdges[c], &segments);
+		},
+			tbb::auto_partitioner()
+			);
+
+		std::vector<size_t> firstNew = std::vector<size_t>(nCells);
+		for (size_t c = 0; c < nCells; c++)
+			firstNew[c] = cells[c]->getNumTriangles();
+
+		std::vector<char> changed = std::vector<char>(nCells, 0);
+		for (size_t k = 0; k < cutEdges.size(); k++) {
+			for (int side = 0; side < 2; side++) {
+				const size_t c = cutEdges[k].cells[side];
+				if (copyCutEdgePoints(cells[c], &segments[2 * k + side], &segments[2 * k + 1 - side]))
+					changed[c] = 1;
+			}
+		}
+
+		pending.clear();
+		for (size_t c = 0; c < nCells; c++) {
+			if (!changed[c])
+				continue;
+
+			cells[c]->restoreDelaunay(firstNew[c]);
+			pending.push_back(c);
+
+			// Cells stitched after the last refinement may break the limits
+			if (stitch >= EMP_TRIANGULATION_MAX_STITCHES)
+				unrefined[c] = 1;
+		}
+
+		if (pending.empty())
+			break;
+	}
+
+	// Report the cells that could not be refined after stitching
+	size_t nBroken = 0;
+	for (size_t c = 0; c < nCells; c++) {
+		if (unrefined[c] && breaksLimits(cells[c], maxArea, maxAspectRatio))
+			nBroken++;
+	}
+	if (nBroken > 0) {
+		WARN(msg, std::to_string(nBroken) + " cells of a Triangulation exceed the maximum area or aspect ratio after " + std::to_string(EMP_TRIANGULATION_MAX_STITCHES) + " stitches");
+	}
+
+	// Link the cells through their CutEdge objects
+	for (size_t k = 0; k < cutEdges.size(); k++) {
+		std::vector<CutEdgeSegment> * a = &segments[2 * k];
+		std::vector<CutEdgeSegment> * b = &segments[2 * k + 1];
+		if (a->size() != b->size()) {
+			WARN(msg, "Inconsistent edges between the cells of a Triangulation");
+			continue;
+		}
+
+		auto byStart = [](const CutEdgeSegment & x, const CutEdgeSegment & y) {
+			return std::min(x.t0, x.t1) < std::min(y.t0, y.t1);
+		};
+		std::sort(a->begin(), a->end(), byStart);
+		std::sort(b->begin(), b->end(), byStart);
+		for (size_t m = 0; m < a->size(); m++) {
+			CutEdgeSegment * sa = &(*a)[m];
+			CutEdgeSegment * sb = &(*b)[m];
+			sa->triangle->setNeighbor(sb->triangle, sa->edge, false);
+			sb->triangle->setNeighbor(sa->triangle, sb->edge, false);
+
+			// Points added by both cells independently may differ
+			// in the last digits... make them identical
+			Point3D * aFirst = sa->t0 < sa->t1 ? sa->start : sa->end;
+			Point3D * aLast = sa->t0 < sa->t1 ? sa->end : sa->start;
+			Point3D * bFirst = sb->t0 < sb->t1 ? sb->start : sb->end;
+			Point3D * bLast = sb->t0 < sb->t1 ? sb->end : sb->start;
+			if (bFirst != aFirst)
+				*bFirst = *aFirst;
+			if (bLast != aLast)
+				*bLast = *aLast;
+		}
+	}
+
+	for (size_t c = 0; c < nCells; c++) {
+		absorb(cells[c]);
+		delete cells[c];
+	}
+}
+
+void Triangulation::absorb(Triangulation * other)
+{
+	for (size_t i = 0; i < other->nTriangles; i++) {
+		if (other->triangles[i] != nullptr)
+			addTriangle(other->triangles[i]);
+	}
+	other->triangles.clear();
+	other->nTriangles = 0;
+	other->grid = TriangleGrid();
+	other->gridBuiltAt = 0;
+
+	// Chunks keep their buffers when moved, so the points do not move
+	for (auto & chunk : other->pointArena)
+		pointArena.push_back(std::move(chunk));
+	other->pointArena.clear();
+}
+
+
 bool Triangulation::doCDT() {
 
 	// Create a 2D version of this polygon
@@ -707,6 +1213,20 @@ bool Triangulation::doCDT() {
 		
         MPE_PolyTriangulate(&PolyContext);
         
+        // Each point of the CDT is transformed (and allocated) only once
+        std::unordered_map<MPEPolyPoint *, Point3D *> points3D = std::unordered_map<MPEPolyPoint *, Point3D *>();
+        auto get3DPoint = [&](MPEPolyPoint * p) -> Point3D * {
+            auto found = points3D.find(p);
+            if (found != points3D.end())
+                return found->second;
+            
+            Point3D p2d = Point3D(p->X, p->Y, z);
+            Point3D p3d = p2d.transform(i, j, k);
+            Point3D * ret = createPoint(p3d.getX(), p3d.getY(), p3d.getZ());
+            points3D[p] = ret;
+            return ret;
+        };
+        
         // The resulting triangles can be used like so
         for (uxx TriangleIndex = 0; TriangleIndex < PolyContext.TriangleCount; ++TriangleIndex)
         {
@@ -715,13 +1235,10 @@ bool Triangulation::doCDT() {
             MPEPolyPoint* PointB = polytriangle->Points[1];
             MPEPolyPoint* PointC = polytriangle->Points[2];
             
-            // add a Triangle, transformed back into 3D
-            Point3D a2d = Point3D(PointA->X, PointA->Y, z);
-            Point3D b2d = Point3D(PointB->X, PointB->Y, z);
-            Point3D c2d = Point3D(PointC->X, PointC->Y, z);
-            Point3D * a = new Point3D(a2d.transform(i, j, k));
-            Point3D * b = new Point3D(b2d.transform(i, j, k));
-            Point3D * c = new Point3D(c2d.transform(i, j, k));
+            // add a Triangle, transformed back into 3D... vertices are shared 
+            Point3D * a = get3DPoint(PointA);
+            Point3D * b = get3DPoint(PointB);
+            Point3D * c = get3DPoint(PointC);
             Triangle * t = new Triangle(a, b, c);
             
             // Set constraints.... this was reversed engineered; so I am not sure
@@ -822,10 +1339,13 @@ void Triangulation::purge()
         if (triangle == nullptr)
             continue;
 
+        triangle->setIndex(count);
         realTriangles[count++] = triangle;
 
     }
-    // Update
+    // Update... indexes change, so the grid is no longer valid
+    grid = TriangleGrid();
+    gridBuiltAt = 0;
     nTriangles = realN;
     triangles.resize(realN);
     triangles = std::vector<Triangle *>(realTriangles);
@@ -25,9 +25,28 @@
 #include "./point3d.h"
 #include "./polygon.h"
 #include "./triangle.h"
+#include "./trianglegrid.h"
 
 #define MAX_ASPECT_RATIO 1.3
 
+//! The number of Point3D objects allocated at once by a Triangulation
+#define EMP_TRIANGULATION_ARENA_CHUNK 1024
+
+//! The number of coarse Triangle objects given to each cell when meshing in parallel (see Triangulation::mesh())
+#define EMP_TRIANGULATION_TRIANGLES_PER_CELL 8
+
+//! The area of a Polygon3D (measured in maximum Triangle areas) that justifies meshing it in an extra cell (see TriangulateWorkplane)
+#define EMP_TRIANGULATION_CELL_SIZE 4096
+
+//! The maximum number of cells in which a Polygon3D is meshed (see TriangulateWorkplane)
+#define EMP_TRIANGULATION_MAX_CELLS 64
+
+//! The number of times the cells of a Triangulation are refined again after stitching them (see Triangulation::mesh())
+#define EMP_TRIANGULATION_MAX_STITCHES 16
+
+//! The version of the meshing algorithms (i.e. Triangulation::mesh() and TriangleMesh::appendGrid()), which is part of the key of cached meshes (see TriangulateWorkplane). Increase it whenever they produce different triangles
+#define EMP_TRIANGULATION_ALGORITHM_VERSION 1
+
 // Represents a Triangulation.
 /*!
 This class is used before exporting a Workplane object, which has to be 
@@ -44,6 +63,38 @@ private:
 	std::vector < Triangle * > triangles; //!< The current triangles
 	Polygon3D * polygon; //!< The polygon to triangulate
 	size_t nTriangles = 0; //!< The number of triangles available    
+	TriangleGrid grid = TriangleGrid(); //!< The index used for locating points (see Triangulation::addPoint())
+	std::vector < std::vector<Point3D> > pointArena = std::vector < std::vector<Point3D> >(); //!< The storage of the Point3D objects created by the Triangulation
+	size_t gridBuiltAt = 0; //!< The value of nTriangles when the grid was last built
+
+	//! Refines the Triangulation by splitting it into cells that are refined in parallel
+	/*!
+	The current (coarse) Triangulation is split into nCells groups of
+	Triangle objects by recursive bisection, and each group is copied into
+	its own Triangulation (a cell). The edges shared by two cells become
+	boundaries of both, and the cells are refined concurrently.
+
+	Since each cell may split the shared edges on its own, the points on
+	them are then copied from each cell to its neighbors, and the
+	cells that received any are refined again. This is repeated until the
+	shared edges match, at which point all the cells are moved back into
+	this Triangulation and linked to each other.
+
+	@author German Molina
+	@param[in] maxArea The maxArea param given to Triangulation::refine() method
+	@param[in] maxAspectRatio The maximum aspect ratio allowed
+	@param[in] nCells The number of cells
+	*/
+	void refineInCells(double maxArea, double maxAspectRatio, size_t nCells);
+
+	//! Moves all the Triangle and Point3D objects of another Triangulation into this one
+	/*!
+	The other Triangulation ends up empty
+
+	@author German Molina
+	@param[in] other The other Triangulation
+	*/
+	void absorb(Triangulation * other);
 
 public:
 
@@ -62,11 +113,25 @@ public:
 
   //! Destructor
   /*!	
-  Destroys all the triangles as well.
+  Destroys all the triangles as well, and all the Point3D 
+  objects created by the Triangulation (see Triangulation::createPoint())
   @author German Molina
   */
   ~Triangulation();
 
+  //! Creates a Point3D that lives as long as the Triangulation
+  /*!
+  Points are allocated in chunks of EMP_TRIANGULATION_ARENA_CHUNK
+  elements, and freed all together when the Triangulation is destroyed.
+
+  @author German Molina
+  @param[in] x The X component
+  @param[in] y The Y component
+  @param[in] z The Z component
+  @return The pointer to the new Point3D
+  */
+  Point3D * createPoint(double x, double y, double z);
+
   //! Adds a triangle to the Triangulation
   /*!
   Receives a pointer to a Triangle, and adds it to the
@@ -112,7 +177,9 @@ public:
   //! Adds a Point3D to the Triangulation
   /*!
   Looks for the first Triangle on which the Point3D
-  given is contained, and adds it to it. 
+  given is contained, and adds it to it. The search
+  is done through a TriangleGrid, which is rebuilt
+  every time the number of triangles doubles.
 
   Neighboring Triangles will be updated if needed 
   (see Triangulation::splitTriangle() and 
@@ -167,6 +234,23 @@ public:
   */
   void restoreDelaunay();
 
+  //! Restores the best possible Constrained Delaunay Triangulation around the newest Triangle objects
+  /*!
+  Lawson-style alternative to Triangulation::restoreDelaunay(), meant to be
+  called after each insertion. Only the Triangle objects with index
+  firstTriangle or higher (i.e. the ones created by the insertion) are
+  suspects initially. Each suspect is checked as in restoreDelaunay(), and
+  every flip makes the two new Triangle objects and their neighbors suspects
+  as well.
+
+  Every flip reduces the worst aspect ratio of the pair of triangles involved,
+  so this always terminates.
+
+  @author German Molina
+  @param[in] firstTriangle The index of the first Triangle to check
+  */
+  void restoreDelaunay(size_t firstTriangle);
+
   //! Splits a Triangle by inserting a Point3D inside it
   /*!
   When a Point3D added to the Triangulation falls inside a Triangle,
@@ -236,6 +320,11 @@ public:
   algorithm for quality 2-dimensional mesh generation. Journal of 
   algorithms, 18(3), 548-585."
 
+  Every Triangle with an area of 9e-3 or more ends up satisfying both
+  constraints: too big triangles are split by their circumcenter
+  (checking them again if it falls in another Triangle), or by the
+  midpoint of their longest edge if that is not possible.
+
   @param[in] maxArea The maximum desired area of each Triangle
   @param[in] maxAspectRatio The maximum aspect ratio allowed
   @todo Check if the maxArea param makes any sense.
@@ -244,11 +333,17 @@ public:
 
   //! Performs constrained delaunay triangulation and refines a Triangulation
   /*!
+  When nCells is larger than 1, the Triangulation is first refined 
+  coarsely and then split in (up to) nCells regions that are refined
+  in parallel and stitched back together into a single conforming 
+  Triangulation.
+
   @author German Molina
   @param[in] maxArea The maxArea param given to Triangulation::refine() method
   @param[in] maxAspectRatio The maximum aspect ratio allowed
+  @param[in] nCells The number of regions to refine in parallel
   */
-  bool mesh(double maxArea, double maxAspectRatio);
+  bool mesh(double maxArea, double maxAspectRatio, size_t nCells = 1);
 
   //! Analizes the Triangle objects in the Triangulation, and sets all the neighbors
   /*!
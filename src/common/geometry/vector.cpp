@@ -197,11 +197,8 @@ void Vector3D::print() const
 
 Vector3D Vector3D::transform(Transform * t) const
 {
-    
-    Matrix4x4 * m = t->getMatrix();
-    double xv = x*m->getElement(0, 0) + y*m->getElement(0,1) + z*m->getElement(0,2) + m->getElement(0,3);
-    double yv = x*m->getElement(1, 0) + y*m->getElement(1, 1) + z*m->getElement(1, 2) + m->getElement(1, 3);
-    double zv = x*m->getElement(2, 0) + y*m->getElement(2, 1) + z*m->getElement(2, 2) + m->getElement(2, 3);
-    
-    return Vector3D(xv, yv, zv);
+    double p[3] = { x, y, z };
+    t->transformPoints(p, p, 1);
+
+    return Vector3D(p[0], p[1], p[2]);
 }
@@ -25,6 +25,9 @@
 #include <sstream>
 #include <string>
 #include <algorithm> 
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
 
 bool stringInclude(std::string word, std::string substring) 
 {
@@ -168,3 +171,62 @@ void downCase(std::string * s)
 {
     std::transform(s->begin(), s->end(), s->begin(), ::tolower);
 }
+
+size_t formatFixed(double value, char * buffer)
+{
+    // Large (and non finite) values go through printf
+    if (!(std::fabs(value) < 1e12))
+        return (size_t)snprintf(buffer, EMP_FIXED_BUFFER_SIZE, "%f", value);
+    
+    char * p = buffer;
+    if (std::signbit(value))
+        *p++ = '-';
+    
+    // Split the value, which is exact, and round the decimals
+    // once... fma() gives the error of the scaled fraction, so 
+    // exact halves (e.g. 2^-7) can be told from near ones
+    const double absolute = std::fabs(value);
+    const double whole = std::floor(absolute);
+    const double fraction = absolute - whole;
+    const double scaled = fraction * 1e6;
+    const double error = std::fma(fraction, 1e6, -scaled);
+    const double floorScaled = std::floor(scaled);
+    const double remainder = (scaled - floorScaled) - 0.5;
+    
+    uint64_t integer = (uint64_t)whole;
+    uint64_t decimals = (uint64_t)floorScaled;
+    if (remainder > 0 || (remainder == 0 && (error > 0 || (error == 0 && decimals % 2 == 1))))
+        decimals++; // Ties go to even, like printf does
+    if (decimals == 1000000) {
+        integer++;
+        decimals = 0;
+    }
+    
+    // Integer part, backwards
+    char digits[24];
+    size_t nDigits = 0;
+    do {
+        digits[nDigits++] = (char)('0' + integer % 10);
+        integer /= 10;
+    } while (integer > 0);
+    while (nDigits > 0)
+        *p++ = digits[--nDigits];
+    
+    // Decimals
+    *p++ = '.';
+    for (int i = 5; i >= 0; i--) {
+        p[i] = (char)('0' + decimals % 10);
+        decimals /= 10;
+    }
+    p += 6;
+    *p = '\0';
+    
+    return (size_t)(p - buffer);
+}
+
+void appendFixed(double value, std::string * s)
+{
+    char buffer[EMP_FIXED_BUFFER_SIZE];
+    size_t n = formatFixed(value, buffer);
+    s->append(buffer, n);
+}
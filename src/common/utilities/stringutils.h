@@ -166,4 +166,30 @@ extern std::string downCase(std::string s);
  */
 extern void downCase(std::string * s);
 
+//! The size of the buffer needed by formatFixed()
+#define EMP_FIXED_BUFFER_SIZE 64
+
+//! Writes a number with six decimals, like printf's "%f" does
+/*!
+This is much faster than printf, which parses the format on every call.
+The decimals are rounded from the exact binary value, with ties to even,
+so the result is the same as printf's. Very large and non-finite values 
+are passed on to printf.
+
+@author German Molina
+@param[in] value The number to write
+@param[out] buffer The buffer to write to (at least EMP_FIXED_BUFFER_SIZE chars)
+@return The number of chars written (excluding the terminating null)
+*/
+extern size_t formatFixed(double value, char * buffer);
+
+//! Appends a number with six decimals to a string
+/*!
+@author German Molina
+@param[in] value The number to write
+@param[out] s The string to append to
+@see formatFixed()
+*/
+extern void appendFixed(double value, std::string * s);
+
 /* @} */
@@ -37,15 +37,51 @@ This module defines constants that are used in the rest of the program.
 /// The emppath to store as environmental variable; where the lua scripts are stored
 #define EMPATH "EMPATH"
 
+/// The environmental variable with the directory where cached results (e.g. triangulated workplanes) are stored... nothing is cached when it is not set
+#define EMP_CACHE "EMPCACHE"
+
+/// The environmental variable with the maximum size of the octree cache, in megabytes (0 means unbounded)
+#define EMP_OCTREE_CACHE_SIZE "EMPOCTREECACHESIZE"
+
+/// The maximum size of the octree cache, in megabytes, when EMP_OCTREE_CACHE_SIZE is not set
+#define EMP_DEFAULT_OCTREE_CACHE_SIZE 4096
+
+/// The environmental variable with the maximum size of the ambient cache, in megabytes (0 means unbounded)
+#define EMP_AMBIENT_CACHE_SIZE "EMPAMBIENTCACHESIZE"
+
+/// The maximum size of the ambient cache, in megabytes, when EMP_AMBIENT_CACHE_SIZE is not set
+#define EMP_DEFAULT_AMBIENT_CACHE_SIZE 1024
+
+/// The environmental variable that enables pre-warming new ambient files, tracing one of every N sensors first (0 or unset disables it)
+#define EMP_AMBIENT_PREWARM "EMPAMBIENTPREWARM"
+
+/// The environmental variable with the number of processes (-n) of each RCONTRIB call (by default, the cores are shared by the calls running at once)
+#define EMP_RCONTRIB_PROCESSES "EMPRCONTRIBPROCESSES"
+
+/// The environmental variable that, when set, makes the geometry optimization build (and time) the octree before and after optimizing
+#define EMP_GEOMETRY_BENCHMARK "EMPGEOMETRYBENCHMARK"
+
 /// The separator used when writing files
 #define EMP_TAB "   " //!< This is the separator used when writing Radiance files
 
 /// The interpolation scheme...
 #define EMP_TIME_INTERPOLATION 3
 
+/// The number of timesteps whose skies are generated together in annual simulations
+#define EMP_SKY_BATCH_SIZE 64
+
 /// Maximum interior loops
 #define EMP_TOO_MANY_LOOPS 40 //!< The number of interior loops that are considered too many in a face 
 
+/// The distance (in meters) under which two vertices are considered the same when optimizing geometry
+#define EMP_GEOMETRY_TOLERANCE 1e-4
+
+/// The maximum number of vertices of a Face created by merging coplanar faces
+#define EMP_MERGE_MAX_VERTICES 256
+
+/// The minimum number of triangles (of a Layer, with the same Material) that are exported as a Radiance mesh
+#define EMP_MESH_MIN_TRIANGLES 1000
+
 /// Huge number
 #define EMP_HUGE 9e9 //!< This is a huge number that may be used by several sections of the program
 
@@ -223,6 +223,11 @@ void EmpModel::addPolygonToWorkplane(std::string * workplaneName, Polygon3D * po
 	workplanes.push_back(wp);	
 }
 
+void EmpModel::addWorkplane(Workplane * workplane)
+{
+	workplanes.push_back(workplane);
+}
+
 
 void EmpModel::addWindowToGroup(std::string * windowGroupName, Face * face) 
 {
@@ -398,6 +403,16 @@ Material * EmpModel::getMaterialRef(size_t i)
 	return materials[i];
 }
 
+bool EmpModel::hasEmittingMaterials()
+{
+    for (auto material : materials) {
+        std::string type = material->getType();
+        if (type == "light" || type == "glow" || type == "spotlight")
+            return true;
+    }
+    return false;
+}
+
 Material *  EmpModel::getMaterialByName(std::string * materialName)
 {
     for (size_t i = 0; i < materials.size(); i++) {
@@ -493,3 +508,19 @@ const json * EmpModel::getTask(std::string name) const
     
     return nullptr;
 }
+
+void EmpModel::optimizeGeometry(double tolerance, GeometryReport * report)
+{
+    for (auto layer : layers)
+        layer->optimizeGeometry(tolerance, report);
+    
+    for (auto definition : definitions)
+        definition->optimizeGeometry(tolerance, report);
+    
+    geometryOptimized = true;
+}
+
+bool EmpModel::isGeometryOptimized() const
+{
+    return geometryOptimized;
+}
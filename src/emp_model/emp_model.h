@@ -89,6 +89,7 @@ private:
 	RTraceOptions rtraceOptions = RTraceOptions(); //< The options related to Ray Tracing (RTRACE program)
 	//Observers // **	
 	float northCorrection = 0.0f; //!< The north correction (i.e. the model should be rotated when calculating)
+    bool geometryOptimized = false; //!< Has optimizeGeometry() been called?
 
 public:
 
@@ -246,6 +247,13 @@ public:
 	*/
 	void addPolygonToWorkplane(std::string * workplaneName, Polygon3D * polygon);
 
+	//! Adds a Workplane to the model
+	/*!
+	@author German Molina
+	@param[in] workplane The Workplane to add
+	*/
+	void addWorkplane(Workplane * workplane);
+
 	//! Adds a new window to a certain Window Group
 	/*!
 	Searches for the corresponding window group, and adds the Faces
@@ -370,6 +378,13 @@ public:
 	*/
 	Material * getMaterialRef(size_t i);
 
+    //! Checks whether any Material emits light (i.e. light, glow or spotlight)
+    /*!
+     @author German Molina
+     @return has emitters?
+     */
+    bool hasEmittingMaterials();
+
     //! Retrieves a Layer from the model by name
     /*!
      Will return NULL if not found
@@ -479,6 +494,25 @@ public:
      @return The pointer to the task
      */
     const json * getTask(std::string name) const;
+    
+    //! Cleans and simplifies the geometry in all the Layer and ComponentDefinition
+    /*!
+     This is optional, and meant to be called before exporting the model
+     (i.e. before solving any Task). 
+     
+     @author German Molina
+     @param[in] tolerance The distance under which two vertices are considered the same
+     @param[out] report The report to add the counts to
+     @see Layer::optimizeGeometry()
+     */
+    void optimizeGeometry(double tolerance, GeometryReport * report);
+    
+    //! Checks whether optimizeGeometry() has been called
+    /*!
+     @author German Molina
+     @return is optimized?
+     */
+    bool isGeometryOptimized() const;
 
     
 
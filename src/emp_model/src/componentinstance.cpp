@@ -110,45 +110,21 @@ const ComponentDefinition * const ComponentInstance::getDefinitionRef() const
 	return definition;
 }
 
-Transform * ComponentInstance::getTransform() const
+Transform ComponentInstance::getTransform() const
 {
 
-  Transform * res = new Transform();
-  Matrix4x4 * m = res->getMatrix();
+  Transform res = Transform();
+  Matrix4x4 * m = res.getMatrix();
 
   // Scale
   /*
-  double s = getScale();
-  Matrix4x4 * scale = res->getScaleMatrix(s);
-  m->multiplyThis(scale);
-  delete scale;
+  *m = (*m) * Transform::getScaleMatrix(getScale());
   */
-  // Translation
-  Matrix4x4 * translation = res->getTranslationMatrix(x, y, z);
-  m->multiplyThis(translation);
-  delete translation;
-
-  
-  // Rotation X
-  double rx = rotationX;
-  Matrix4x4 * rotationX = res->getRotationXMatrix(rx);
-  m->multiplyThis(rotationX);
-  delete rotationX;
-
-
-  // Rotation Y
-  double ry = rotationY;
-  Matrix4x4 * rotationY = res->getRotationYMatrix(ry);
-  m->multiplyThis(rotationY);
-  delete rotationY;
-
-  // Rotation Z
-  double rz = rotationZ;
-  Matrix4x4 * rotationZ = res->getRotationZMatrix(rz);
-  m->multiplyThis(rotationZ);
-  delete rotationZ;
-
-  
+  // Translation, then rotations on X, Y and Z
+  *m = (*m) * Transform::getTranslationMatrix(x, y, z);
+  *m = (*m) * Transform::getRotationXMatrix(rotationX);
+  *m = (*m) * Transform::getRotationYMatrix(rotationY);
+  *m = (*m) * Transform::getRotationZMatrix(rotationZ);
 
   return res;
 }
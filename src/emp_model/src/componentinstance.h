@@ -176,6 +176,6 @@ public:
     @author German Molina
     @return The Transform
     */
-    Transform * getTransform() const;
+    Transform getTransform() const;
 
 };
@@ -0,0 +1,45 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! A summary of what the geometry optimization did to a Layer or EmpModel
+/*!
+ Filled by Layer::optimizeGeometry() and EmpModel::optimizeGeometry(),
+ which add their counts to whatever is already in it. The octree
+ figures are only known after building an octree (see measureOconv()
+ and optimizeModelGeometry()).
+ */
+struct GeometryReport {
+    size_t objectsBefore = 0; //!< The number of primitives before optimizing
+    size_t objectsAfter = 0; //!< The number of primitives after optimizing
+    size_t verticesBefore = 0; //!< The number of polygon vertices before optimizing
+    size_t verticesAfter = 0; //!< The number of polygon vertices after optimizing
+    size_t degenerateFaces = 0; //!< The number of faces removed because they had (almost) no area
+    size_t duplicateFaces = 0; //!< The number of faces removed because they repeated another one
+    size_t mergedFaces = 0; //!< The number of faces removed by merging them into a coplanar neighbor
+    double oconvSecondsBefore = -1; //!< The time it took to build the octree before optimizing (-1 if it was not measured)
+    uint64_t octreeSizeBefore = 0; //!< The size of the octree before optimizing, in bytes
+    double oconvSeconds = -1; //!< The time it took to build the resulting octree (-1 if it was not measured)
+    uint64_t octreeSize = 0; //!< The size of the resulting octree, in bytes
+};
@@ -0,0 +1,116 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "./interpolatedweather.h"
+#include "../../calculations/solar.h"
+
+void InterpolatedWeather::fill(const Weather * weather, int interpolation, float latitude, float longitude, float meridian)
+{
+    clear();
+
+    if(!weather->hasData())
+        throw "Fatal: Cannot interpolate a Weather that has no data";
+
+    if(interpolation < 1)
+        throw "Impossible interpolation scheme when interpolating Weather";
+
+    const size_t weaSize = weather->data.size();
+    const size_t nSteps = weaSize * interpolation;
+
+    month.resize(nSteps);
+    day.resize(nSteps);
+    hour.resize(nSteps);
+    direct_normal.resize(nSteps);
+    diffuse_horizontal.resize(nSteps);
+    isDaytime.resize(nSteps);
+    altitude.resize(nSteps);
+    azimuth.resize(nSteps);
+
+    const double lat = DegToRad(latitude);
+    const double lon = DegToRad(longitude);
+    const double mer = DegToRad(meridian);
+    const float floatInter = (float)interpolation;
+
+    size_t nstep = 0;
+    for(size_t timestep = 0; timestep < weaSize; timestep++){
+        const HourlyData * startData = &(weather->data[timestep]);
+        const HourlyData * endData = &(weather->data[(timestep + 1) % weaSize]);
+
+        // If it is night in both, diffuse and direct are Zero
+        const bool night = startData->diffuse_horizontal < 1e-3 && endData->diffuse_horizontal < 1e-3;
+
+        for(int i = 0; i < interpolation; i++){
+            const float q = (float)i / floatInter;
+
+            month[nstep] = startData->month;
+            day[nstep] = startData->day;
+            hour[nstep] = startData->hour + q*(endData->hour - startData->hour);
+
+            if(night){
+                direct_normal[nstep] = 0;
+                diffuse_horizontal[nstep] = 0;
+            }else{
+                direct_normal[nstep] = startData->direct_normal + q*(endData->direct_normal - startData->direct_normal);
+                diffuse_horizontal[nstep] = startData->diffuse_horizontal + q*(endData->diffuse_horizontal - startData->diffuse_horizontal);
+            }
+
+            isDaytime[nstep] = diffuse_horizontal[nstep] > EMP_NIGHT_THRESHOLD ? 1 : 0;
+
+            // Position of the sun
+            if(isDaytime[nstep]){
+                const int jd = jdate(month[nstep], day[nstep]);
+                const double sda = sdec(jd);
+                const double sta = stadj(jd, lon, mer);
+                altitude[nstep] = (float)salt(sda, hour[nstep]+sta, lat);
+                azimuth[nstep] = (float)(sazi(sda, hour[nstep]+sta, lat) + PI);
+            }else{
+                altitude[nstep] = 0;
+                azimuth[nstep] = 0;
+            }
+
+            nstep++;
+        }
+    }
+
+    interp = interpolation;
+}
+
+void InterpolatedWeather::clear()
+{
+    interp = 0;
+    month.clear();
+    day.clear();
+    hour.clear();
+    direct_normal.clear();
+    diffuse_horizontal.clear();
+    isDaytime.clear();
+    altitude.clear();
+    azimuth.clear();
+}
+
+int InterpolatedWeather::getInterp() const
+{
+    return interp;
+}
+
+size_t InterpolatedWeather::size() const
+{
+    return month.size();
+}
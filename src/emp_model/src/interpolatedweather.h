@@ -0,0 +1,85 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include "./weather.h"
+
+//! The diffuse horizontal irradiance under which a timestep is considered night
+#define EMP_NIGHT_THRESHOLD 1e-4
+
+//! The time axis of an annual simulation
+/*!
+	Holds the Weather data interpolated according to an interpolation
+	scheme, together with the position of the sun at each timestep.
+
+	It is stored as a struct of arrays, with one element per (interpolated)
+	timestep, and is meant to be calculated once per run and then shared
+	(read only) by all the tasks that need to iterate the year.
+*/
+
+class InterpolatedWeather {
+private:
+	int interp = 0; //!< The interpolation scheme used to fill the table (0 means empty)
+
+public:
+	std::vector<int> month = std::vector<int>(); //!< The month of each timestep
+	std::vector<int> day = std::vector<int>(); //!< The day of each timestep
+	std::vector<float> hour = std::vector<float>(); //!< The hour of each timestep
+	std::vector<float> direct_normal = std::vector<float>(); //!< The direct normal irradiance
+	std::vector<float> diffuse_horizontal = std::vector<float>(); //!< The diffuse horizontal irradiance
+	std::vector<char> isDaytime = std::vector<char>(); //!< Whether there is daylight in the timestep
+	std::vector<float> altitude = std::vector<float>(); //!< The solar altitude, in radians
+	std::vector<float> azimuth = std::vector<float>(); //!< The solar azimuth, in radians (before North correction)
+
+	//! Fills the table with the interpolated Weather
+	/*!
+	@author German Molina
+	@param[in] weather The weather to interpolate
+	@param[in] interpolation The interpolation scheme
+	@param[in] latitude The latitude in degrees
+	@param[in] longitude The longitude in degrees
+	@param[in] meridian The standard meridian in degrees
+	*/
+	void fill(const Weather * weather, int interpolation, float latitude, float longitude, float meridian);
+
+	//! Empties the table
+	/*!
+	@author German Molina
+	*/
+	void clear();
+
+	//! Retrieves the interpolation scheme used to fill the table
+	/*!
+	@author German Molina
+	@return The interpolation scheme (0 if it has not been filled)
+	*/
+	int getInterp() const;
+
+	//! Retrieves the number of timesteps in the table
+	/*!
+	@author German Molina
+	@return The number of timesteps
+	*/
+	size_t size() const;
+};
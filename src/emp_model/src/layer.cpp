@@ -18,9 +18,17 @@
 
 *****************************************************************************/
 
+#include <map>
+#include <set>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
 #include "./componentinstance.h"
 #include "./layer.h"
+#include "./otypes/face.h"
 #include "../../common/utilities/io.h"
+#include "../../config_constants.h"
 
 Layer::Layer(std::string * layerName) 
 {
@@ -92,3 +100,337 @@ bool Layer::isEmpty() const
 {
 	return (objects.size() == 0 && instances.size() == 0);
 }
+
+
+//! A vertex snapped to the grid defined by the tolerance
+typedef std::array<int64_t, 3> SnappedVertex;
+
+//! A directed edge between two snapped vertices
+typedef std::array<int64_t, 6> SnappedEdge;
+
+//! Snaps a Point3D to the grid defined by the tolerance
+/*!
+ @author German Molina
+ @param[in] p The point
+ @param[in] tolerance The size of the grid
+ @return The snapped vertex
+ */
+static SnappedVertex snap(Point3D p, double tolerance)
+{
+    return {(int64_t)std::llround(p.getX()/tolerance), (int64_t)std::llround(p.getY()/tolerance), (int64_t)std::llround(p.getZ()/tolerance)};
+}
+
+//! Builds the key of the directed edge between two vertices
+/*!
+ @author German Molina
+ @param[in] a The start
+ @param[in] b The end
+ @return The key
+ */
+static SnappedEdge edgeKey(const SnappedVertex & a, const SnappedVertex & b)
+{
+    return {a[0], a[1], a[2], b[0], b[1], b[2]};
+}
+
+//! Gathers the non-NULL vertices of a Loop
+/*!
+ @author German Molina
+ @param[in] loop The loop
+ @param[out] points The vertices
+ */
+static void gatherVertices(Loop * loop, std::vector<Point3D> * points)
+{
+    points->clear();
+    for (size_t i = 0; i < loop->size(); i++) {
+        Point3D * p = loop->getVertexRef(i);
+        if (p != NULL)
+            points->push_back(Point3D(p));
+    }
+}
+
+//! Calculates the vector area of a closed sequence of vertices (Newell's method)
+/*!
+ @author German Molina
+ @param[in] points The vertices
+ @return A vector whose length is the area and whose direction is the normal
+ */
+static Vector3D vectorArea(std::vector<Point3D> * points)
+{
+    Vector3D ret = Vector3D(0, 0, 0);
+    const size_t n = points->size();
+    if (n < 3)
+        return ret;
+    
+    // Relative to the first vertex, for precision
+    Point3D origin = (*points)[0];
+    for (size_t i = 1; i + 1 < n; i++)
+        ret = ret + (((*points)[i] - origin) % ((*points)[i + 1] - origin));
+    
+    return ret * 0.5;
+}
+
+//! Removes the vertices that are aligned with their neighbors (including spikes)
+/*!
+ @author German Molina
+ @param[in,out] points The vertices
+ @param[in] tolerance The distance under which a vertex is considered to be on the line between its neighbors
+ */
+static void removeCollinear(std::vector<Point3D> * points, double tolerance)
+{
+    bool changed = true;
+    while (changed && points->size() >= 3) {
+        changed = false;
+        const size_t n = points->size();
+        for (size_t i = 0; i < n; i++) {
+            Point3D prev = (*points)[(i + n - 1) % n];
+            Point3D next = (*points)[(i + 1) % n];
+            Vector3D a = (*points)[i] - prev;
+            Vector3D b = next - prev;
+            const double length = b.getLength();
+            
+            // Distance to the line (or to prev, if next and prev coincide)
+            const double distance = length < tolerance ? a.getLength() : (a % b).getLength() / length;
+            if (distance < tolerance) {
+                points->erase(points->begin() + i);
+                changed = true;
+                break;
+            }
+        }
+    }
+}
+
+//! A Face that may be merged with its neighbors
+struct MergeCandidate {
+    Face * face; //!< The face
+    std::vector<Point3D> points; //!< Its (possibly merged) vertices
+    std::vector<SnappedVertex> snapped; //!< Its vertices, snapped
+    Vector3D normal = Vector3D(0, 0, 0); //!< Its unit normal
+    double area; //!< Its area
+    bool alive = true; //!< False if it was merged into another one
+    bool modified = false; //!< True if it was merged (so its Polygon3D has to be rebuilt)
+};
+
+//! Snaps the vertices of a MergeCandidate and calculates its normal and area
+/*!
+ @author German Molina
+ @param[in,out] c The candidate
+ @param[in] tolerance The size of the grid
+ */
+static void updateCandidate(MergeCandidate * c, double tolerance)
+{
+    c->snapped.clear();
+    for (auto & p : c->points)
+        c->snapped.push_back(snap(p, tolerance));
+    
+    Vector3D v = vectorArea(&c->points);
+    c->area = v.getLength();
+    c->normal = c->area > 0 ? v / c->area : v;
+}
+
+//! Merges two candidates through their shared edge
+/*!
+ The edge goes from vertex i to i+1 in 'a', and from j to j+1 in 'b' (in the
+ opposite direction)
+ 
+ @author German Molina
+ @param[in] a The first candidate
+ @param[in] i The start of the shared edge in 'a'
+ @param[in] b The second candidate
+ @param[in] j The start of the shared edge in 'b'
+ @param[out] points The vertices of the merged polygon
+ */
+static void mergeCandidates(const MergeCandidate * a, size_t i, const MergeCandidate * b, size_t j, std::vector<Point3D> * points)
+{
+    const size_t na = a->points.size();
+    const size_t nb = b->points.size();
+    points->clear();
+    
+    // All of 'a', from the end of the edge to its start...
+    for (size_t k = 0; k < na; k++)
+        points->push_back(a->points[(i + 1 + k) % na]);
+    
+    // ... and the rest of 'b'
+    for (size_t k = 2; k < nb; k++)
+        points->push_back(b->points[(j + k) % nb]);
+}
+
+void Layer::optimizeGeometry(double tolerance, GeometryReport * report)
+{
+    std::vector<Otype *> kept = std::vector<Otype *>();
+    std::set< std::pair<const Material *, std::vector<int64_t> > > seen = std::set< std::pair<const Material *, std::vector<int64_t> > >();
+    std::vector<MergeCandidate> candidates = std::vector<MergeCandidate>();
+    std::vector<Point3D> points = std::vector<Point3D>();
+    
+    // 1. Remove degenerate and duplicate faces
+    for (auto object : objects) {
+        report->objectsBefore++;
+        
+        Face * face = dynamic_cast<Face *>(object);
+        if (face == nullptr) {
+            kept.push_back(object);
+            continue;
+        }
+        
+        Polygon3D * polygon = face->polygon;
+        report->verticesBefore += polygon->countRealPoints();
+        
+        // Area, discounting the holes
+        gatherVertices(polygon->getOuterLoopRef(), &points);
+        const Vector3D normal = vectorArea(&points);
+        double area = normal.getLength();
+        std::vector<int64_t> key = std::vector<int64_t>();
+        std::vector<SnappedVertex> loopKey = std::vector<SnappedVertex>();
+        for (auto & p : points)
+            loopKey.push_back(snap(p, tolerance));
+        
+        for (size_t i = 0; i < polygon->countInnerLoops(); i++) {
+            std::vector<Point3D> hole = std::vector<Point3D>();
+            gatherVertices(polygon->getInnerLoopRef(i), &hole);
+            area -= vectorArea(&hole).getLength();
+            for (auto & p : hole)
+                loopKey.push_back(snap(p, tolerance));
+        }
+        
+        if (points.size() < 3 || area < tolerance * tolerance) {
+            report->degenerateFaces++;
+            delete face;
+            continue;
+        }
+        
+        // The same vertices (in any order), Material and orientation... so
+        // back-to-back faces (i.e. both sides of a partition) are kept
+        std::sort(loopKey.begin(), loopKey.end());
+        for (auto & v : loopKey)
+            key.insert(key.end(), v.begin(), v.end());
+        
+        const double n[3] = {normal.getX(), normal.getY(), normal.getZ()};
+        size_t axis = 0;
+        for (size_t i = 1; i < 3; i++) {
+            if (std::abs(n[i]) > std::abs(n[axis]))
+                axis = i;
+        }
+        key.push_back(n[axis] < 0 ? -1 : 1);
+        
+        if (!seen.insert(std::make_pair(face->getMaterial(), key)).second) {
+            report->duplicateFaces++;
+            delete face;
+            continue;
+        }
+        
+        kept.push_back(object);
+        
+        if (!polygon->hasInnerLoops()) {
+            MergeCandidate c = MergeCandidate();
+            c.face = face;
+            c.points = points;
+            removeCollinear(&c.points, tolerance);
+            updateCandidate(&c, tolerance);
+            if (c.points.size() >= 3)
+                candidates.push_back(c);
+        }
+    }
+    
+    // 2. Merge coplanar neighbors, in passes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        
+        std::map<SnappedEdge, size_t> edges = std::map<SnappedEdge, size_t>();
+        for (size_t c = 0; c < candidates.size(); c++) {
+            if (!candidates[c].alive)
+                continue;
+            const size_t n = candidates[c].snapped.size();
+            for (size_t i = 0; i < n; i++)
+                edges.insert(std::make_pair(edgeKey(candidates[c].snapped[i], candidates[c].snapped[(i + 1) % n]), c));
+        }
+        
+        // Candidates merged in this pass are not in the edge map anymore
+        std::vector<char> dirty = std::vector<char>(candidates.size(), 0);
+        
+        for (size_t c = 0; c < candidates.size(); c++) {
+            MergeCandidate * a = &candidates[c];
+            if (!a->alive || dirty[c])
+                continue;
+            
+            const size_t na = a->snapped.size();
+            for (size_t i = 0; i < na; i++) {
+                auto found = edges.find(edgeKey(a->snapped[(i + 1) % na], a->snapped[i]));
+                if (found == edges.end() || found->second == c || dirty[found->second])
+                    continue;
+                
+                MergeCandidate * b = &candidates[found->second];
+                if (!b->alive || b->face->getMaterial() != a->face->getMaterial())
+                    continue;
+                
+                // Coplanar, facing the same way
+                if (a->normal * b->normal < 1 - 1e-6 || std::abs(a->normal * (b->points[0] - a->points[0])) > tolerance)
+                    continue;
+                
+                // Sharing more than one edge would create holes or spikes
+                size_t nShared = 0;
+                for (size_t k = 0; k < na; k++) {
+                    auto other = edges.find(edgeKey(a->snapped[(k + 1) % na], a->snapped[k]));
+                    if (other != edges.end() && other->second == found->second)
+                        nShared++;
+                }
+                if (nShared != 1)
+                    continue;
+                
+                if (na + b->snapped.size() - 2 > EMP_MERGE_MAX_VERTICES)
+                    continue;
+                
+                // Find the edge in 'b'
+                const size_t nb = b->snapped.size();
+                size_t j = 0;
+                while (j < nb && !(b->snapped[j] == a->snapped[(i + 1) % na] && b->snapped[(j + 1) % nb] == a->snapped[i]))
+                    j++;
+                
+                mergeCandidates(a, i, b, j, &points);
+                removeCollinear(&points, tolerance);
+                
+                a->points = points;
+                updateCandidate(a, tolerance);
+                a->modified = true;
+                b->alive = false;
+                dirty[c] = 1;
+                dirty[found->second] = 1;
+                report->mergedFaces++;
+                changed = true;
+                break;
+            }
+        }
+    }
+    
+    // 3. Rebuild the merged faces and remove those that were absorbed
+    std::set<Otype *> removed = std::set<Otype *>();
+    for (auto & c : candidates) {
+        if (!c.alive) {
+            removed.insert(c.face);
+            continue;
+        }
+        if (!c.modified)
+            continue;
+        
+        Polygon3D * polygon = new Polygon3D();
+        Loop * loop = polygon->getOuterLoopRef();
+        for (auto & p : c.points)
+            loop->addVertex(new Point3D(p.getX(), p.getY(), p.getZ()));
+        polygon->setNormal(c.normal);
+        polygon->setArea(c.area);
+        c.face->setPolygon(polygon);
+    }
+    
+    objects.clear();
+    for (auto object : kept) {
+        if (removed.count(object) > 0) {
+            delete object;
+            continue;
+        }
+        objects.push_back(object);
+        
+        report->objectsAfter++;
+        Face * face = dynamic_cast<Face *>(object);
+        if (face != nullptr)
+            report->verticesAfter += face->polygon->countRealPoints();
+    }
+}
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "./otype.h"
+#include "./geometryreport.h"
 //#include "./componentinstance.h"
 
 class ComponentInstance;
@@ -141,6 +142,21 @@ public:
 	@return is empty ?
 	*/
 	bool isEmpty() const;
+    
+    //! Cleans and simplifies the Face objects in the Layer
+    /*!
+     Removes the faces with (almost) no area and those that repeat
+     another face with the same Material and orientation (back-to-back
+     faces are kept), and merges the coplanar faces
+     with the same Material that share exactly one edge (only faces
+     without holes are merged). This reduces the number of primitives
+     that are exported to Radiance.
+     
+     @author German Molina
+     @param[in] tolerance The distance under which two vertices are considered the same
+     @param[out] report The report to add the counts to
+     */
+    void optimizeGeometry(double tolerance, GeometryReport * report);
 };
 
 extern Layer layer;
@@ -42,6 +42,7 @@ float Location::getLatitude() const
 void Location::setLatitude(float l)
 {
 	latitude = l;
+	clearInterpolatedWeather();
 }
 float Location::getLongitude() const
 {
@@ -50,6 +51,7 @@ float Location::getLongitude() const
 void Location::setLongitude(float l)
 {
 	longitude = l;
+	clearInterpolatedWeather();
 }
 float Location::getTimeZone() const
 {
@@ -58,6 +60,7 @@ float Location::getTimeZone() const
 void Location::setTimeZone(float t)
 {
 	timeZone = t;
+	clearInterpolatedWeather();
 }
 
 std::string Location::getCity() const
@@ -93,6 +96,7 @@ float Location::getAlbedo() const
 bool Location::fillWeatherFromJSON(json * j)
 {
 	elevation = j->at("elevation").get<float>();
+	clearInterpolatedWeather();
 	return weather.fillFromJSON(j);
 }
 
@@ -228,6 +232,7 @@ size_t Location::getWeatherSize() const
 void Location::addHourlyData(HourlyData h)
 {
     weather.data.push_back(h);
+    clearInterpolatedWeather();
 }
 
 void Location::markWeatherAsFilled()
@@ -269,6 +274,26 @@ void Location::getInterpolatedData(int beg,float i,HourlyData * data) const
     data->direct_normal = startData->direct_normal + i*(endData->direct_normal - startData->direct_normal);
 }
 
+void Location::clearInterpolatedWeather()
+{
+    tbb::mutex::scoped_lock lock(interpolatedWeatherMutex);
+    interpolatedWeathers.clear();
+}
+
+std::shared_ptr<const InterpolatedWeather> Location::getInterpolatedWeather(int interp) const
+{
+    tbb::mutex::scoped_lock lock(interpolatedWeatherMutex);
+    
+    auto found = interpolatedWeathers.find(interp);
+    if(found != interpolatedWeathers.end())
+        return found->second;
+    
+    std::shared_ptr<InterpolatedWeather> table = std::make_shared<InterpolatedWeather>();
+    table->fill(&weather, interp, latitude, longitude, timeZone*(-15.0f));
+    interpolatedWeathers[interp] = table;
+    return table;
+}
+
 void Location::getDataByDate(int month, int day, float hour, HourlyData * data) const
 {
     const int weaSize = (int)weather.data.size();
@@ -23,6 +23,10 @@
 
 #include <string>
 #include "./weather.h"
+#include "./interpolatedweather.h"
+#include <map>
+#include <memory>
+#include "tbb/mutex.h"
 
 //! Represents a Location
 
@@ -40,6 +44,16 @@ private:
 	float albedo = 0.2f; //!< The albedo in the location
 	Weather weather = Weather(); //!< The weather of the location obtained from a weather file
 	float elevation = 0; //!< The elevation
+	mutable std::map<int, std::shared_ptr<const InterpolatedWeather> > interpolatedWeathers = std::map<int, std::shared_ptr<const InterpolatedWeather> >(); //!< The interpolated weather of each interpolation scheme, calculated on demand and never modified after that
+	mutable tbb::mutex interpolatedWeatherMutex; //!< Protects interpolatedWeathers
+
+	//! Forgets the interpolated weather, after the weather or the location change
+	/*!
+	Tables already handed out remain valid for whoever holds them
+	
+	@author German Molina
+	*/
+	void clearInterpolatedWeather();
 
 public:
 	
@@ -219,6 +233,18 @@ public:
      */
     void getInterpolatedData(int step,float i,HourlyData * data) const;
     
+    //! Retrieves the interpolated weather table
+    /*!
+     The table of each interpolation scheme is calculated the first time 
+     it is requested and shared (read only) by all the tasks after that. 
+     Tasks with different interpolation schemes get different tables.
+     
+     @author German Molina
+     @param interp The interpolation scheme
+     @return A shared pointer to the InterpolatedWeather
+     */
+    std::shared_ptr<const InterpolatedWeather> getInterpolatedWeather(int interp) const;
+    
     
     //! Retrieves weather data by date and time
     /*!
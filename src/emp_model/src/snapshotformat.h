@@ -0,0 +1,57 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+//! The first bytes of every model snapshot file
+#define EMP_SNAPSHOT_MAGIC "EMPSNAP"
+
+//! The length of EMP_SNAPSHOT_MAGIC, including the terminating zero
+#define EMP_SNAPSHOT_MAGIC_SIZE 8
+
+//! The version of the snapshot format. Bump it whenever the layout changes
+#define EMP_SNAPSHOT_VERSION 1
+
+//! A known value written in the header, to detect files written with another byte order
+#define EMP_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+//! Indicates that an Otype has no Material (or a ComponentInstance no ComponentDefinition)
+#define EMP_SNAPSHOT_NONE -1
+
+/*! 
+ A snapshot is a binary copy of an EmpModel, meant to be loaded much
+ faster than parsing the original model (see SnapshotWriter and 
+ SnapshotReader). All values are written in native byte order; strings
+ are written as a uint32_t length followed by their characters; and 
+ the geometry of each Polygon3D as flat arrays of loop sizes and 
+ vertex coordinates. 
+ 
+ The sections follow the header in this order: model info (north 
+ correction, date, location and weather), RTraceOptions, Material, 
+ ComponentDefinition, Layer, Workplane, WindowGroup, IllumGroup, View,
+ Photosensor and tasks.
+ */
+struct SnapshotHeader {
+    char magic[EMP_SNAPSHOT_MAGIC_SIZE]; //!< Always EMP_SNAPSHOT_MAGIC
+    uint32_t version; //!< The EMP_SNAPSHOT_VERSION of the writer
+    uint32_t byteOrder; //!< Always EMP_SNAPSHOT_BYTE_ORDER
+};
@@ -83,6 +83,86 @@ void Workplane::setMaxAspectRatio(const double v)
     maxAspectRatio = v;
 }
 
+const double Workplane::getGridSpacing() const
+{
+    return gridSpacing;
+}
+
+void Workplane::setGridSpacing(const double v)
+{
+    gridSpacing = v;
+}
+
+const double Workplane::getRefinementThreshold() const
+{
+    return refinementThreshold;
+}
+
+void Workplane::setRefinementThreshold(const double v)
+{
+    refinementThreshold = v;
+}
+
+//! Adds some bytes to a 64-bit FNV-1a hash
+/*!
+@author German Molina
+@param[in] data The bytes
+@param[in] size The number of bytes
+@param[in,out] hash The hash
+*/
+static void hashBytes(const void * data, size_t size, uint64_t * hash)
+{
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    for(size_t i = 0; i < size; i++){
+        *hash ^= bytes[i];
+        *hash *= 1099511628211ULL;
+    }
+}
+
+//! Adds the vertices of a Loop to a hash
+/*!
+@author German Molina
+@param[in] loop The Loop
+@param[in,out] hash The hash
+*/
+static void hashLoop(Loop * loop, uint64_t * hash)
+{
+    const uint64_t n = loop->size();
+    hashBytes(&n, sizeof(n), hash);
+    for(size_t i = 0; i < n; i++){
+        Point3D * p = loop->getVertexRef(i);
+        if(p == nullptr)
+            continue;
+        const double xyz[3] = {p->getX(), p->getY(), p->getZ()};
+        hashBytes(xyz, sizeof(xyz), hash);
+    }
+}
+
+uint64_t Workplane::getGeometryHash() const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    
+    const double parameters[3] = {maxArea, maxAspectRatio, gridSpacing};
+    hashBytes(parameters, sizeof(parameters), &hash);
+    
+    const uint64_t nPolygons = polygons.size();
+    hashBytes(&nPolygons, sizeof(nPolygons), &hash);
+    for(auto polygon : polygons){
+        Vector3D normal = polygon->getNormal();
+        const double n[3] = {normal.getX(), normal.getY(), normal.getZ()};
+        hashBytes(n, sizeof(n), &hash);
+        
+        hashLoop(polygon->getOuterLoopRef(), &hash);
+        
+        const uint64_t nInner = polygon->countInnerLoops();
+        hashBytes(&nInner, sizeof(nInner), &hash);
+        for(size_t i = 0; i < nInner; i++)
+            hashLoop(polygon->getInnerLoopRef(i), &hash);
+    }
+    
+    return hash;
+}
+
 void Workplane::addTask(const std::string taskName)
 {
     tasks.push_back(taskName);
@@ -22,6 +22,7 @@
 
 #include <string>
 #include <vector>
+#include <stdint.h>
 
 #include "../../common/geometry/polygon.h"
 
@@ -43,6 +44,8 @@ private:
 	std::vector <Polygon3D * > polygons; //!< The polygons in the workplane.
     double maxArea = 0.25; //!< The desired 'pixel' resolution when triangulating
     double maxAspectRatio = 1.3; //!< The desired maximum aspect ratio
+    double gridSpacing = 0; //!< The size of the cells when meshing as a structured grid (0 means triangulate)
+    double refinementThreshold = 0; //!< The relative illuminance difference between neighboring sensors that triggers a refinement (0 means no refinement)
     std::vector <std::string> tasks = std::vector<std::string>(0); //!< The tasks assigned to the workplane
     
 public:
@@ -125,6 +128,53 @@ public:
      */
     void setMaxAspectRatio(const double v);
     
+    //! Retrieves the size of the cells when meshing the Workplane as a structured grid
+    /*!
+     @author German Molina
+     @return the spacing (0 if the Workplane is triangulated)
+     */
+    const double getGridSpacing() const;
+    
+    //! Sets the size of the cells when meshing the Workplane as a structured grid
+    /*!
+     Rectilinear Polygon3D objects are then rasterized into square
+     cells, which is much faster than triangulating them. Other 
+     Polygon3D objects are still triangulated.
+     
+     @author German Molina
+     @param v The value (0 to always triangulate)
+     */
+    void setGridSpacing(const double v);
+    
+    //! Retrieves the threshold for refining the sensors adaptively
+    /*!
+     @author German Molina
+     @return the threshold (0 if the Workplane is not refined)
+     */
+    const double getRefinementThreshold() const;
+    
+    //! Sets the threshold for refining the sensors adaptively
+    /*!
+     When calculating static illuminance, the sensors whose illuminance
+     differs from the one of a neighbor by more than this fraction 
+     of their average are split, and only the new sensors are traced.
+     
+     @author German Molina
+     @param v The value (0 to disable the refinement)
+     */
+    void setRefinementThreshold(const double v);
+    
+    //! Calculates a hash of everything that defines the Workplane's triangulation
+    /*!
+     This includes the vertices of all the Polygon3D objects, their 
+     normals, the maximum area, the maximum aspect ratio and the grid 
+     spacing. Workplanes with the same hash are meshed identically.
+     
+     @author German Molina
+     @return The hash
+     */
+    uint64_t getGeometryHash() const;
+    
     //! Adds a task to the Workplane
     /*!
      @author German Molina
@@ -29,6 +29,7 @@
 #define FSCANF fscanf_s
 #define MKDIR(x) _mkdir(x)
 #define ACCESS(x,y) _access(x,y)
+#define GETPID() _getpid()
 
 #else
 #include <unistd.h>
@@ -39,4 +40,5 @@
 #define FSCANF fscanf
 #define MKDIR(x) mkdir(x,0777)
 #define ACCESS(x,y) access(x,y)
+#define GETPID() getpid()
 #endif
@@ -1582,6 +1582,14 @@ void SKPreader::loadWorkplanesPreferences() const
         Workplane * wp = model->getWorkplaneByName(&name);
         wp->setMaxArea(size);
         
+        // Optionally, mesh as a structured grid
+        if(it->find("grid_spacing") != it->end())
+            wp->setGridSpacing((*it)["grid_spacing"].get<double>());
+        
+        // Optionally, refine adaptively
+        if(it->find("refinement_threshold") != it->end())
+            wp->setRefinementThreshold((*it)["refinement_threshold"].get<double>());
+        
         // Iterate array
         for (json task : tasks.get<json>()) {            
             wp->addTask(task);
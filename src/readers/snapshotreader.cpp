@@ -0,0 +1,563 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "./snapshotreader.h"
+#include "../common/utilities/io.h"
+#include "../os_definitions.h"
+
+#ifndef WIN
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+SnapshotReader::SnapshotReader(EmpModel * theModel)
+{
+    model = theModel;
+}
+
+bool SnapshotReader::readString(std::string * s)
+{
+    uint32_t length;
+    if (!readValue<uint32_t>(&length) || !hasRoomFor(length, 1))
+        return false;
+    s->assign(cursor, length);
+    cursor += length;
+    return true;
+}
+
+bool SnapshotReader::readXYZ(double * x, double * y, double * z)
+{
+    return readValue<double>(x) && readValue<double>(y) && readValue<double>(z);
+}
+
+bool SnapshotReader::readPoint(Point3D * p)
+{
+    double x, y, z;
+    if (!readXYZ(&x, &y, &z))
+        return false;
+    *p = Point3D(x, y, z);
+    return true;
+}
+
+bool SnapshotReader::readVector(Vector3D * v)
+{
+    double x, y, z;
+    if (!readXYZ(&x, &y, &z))
+        return false;
+    *v = Vector3D(x, y, z);
+    return true;
+}
+
+Polygon3D * SnapshotReader::readPolygon()
+{
+    Vector3D normal = Vector3D(0, 0, 0);
+    double area;
+    uint32_t nLoops;
+    if (!readVector(&normal) || !readValue<double>(&area) || !readValue<uint32_t>(&nLoops) || nLoops < 1 || !hasRoomFor(nLoops, sizeof(uint32_t)))
+        return nullptr;
+    
+    // Loop sizes
+    std::vector<uint32_t> sizes = std::vector<uint32_t>(nLoops);
+    size_t nVertices = 0;
+    for (uint32_t i = 0; i < nLoops; i++) {
+        if (!readValue<uint32_t>(&sizes[i]))
+            return nullptr;
+        nVertices += sizes[i];
+    }
+    
+    if (!hasRoomFor(nVertices, 3 * sizeof(double)))
+        return nullptr;
+    
+    // Coordinates
+    Polygon3D * polygon = new Polygon3D();
+    for (uint32_t i = 0; i < nLoops; i++) {
+        Loop * loop = i == 0 ? polygon->getOuterLoopRef() : polygon->addInnerLoop();
+        for (uint32_t j = 0; j < sizes[i]; j++) {
+            double xyz[3];
+            memcpy(xyz, cursor, sizeof(xyz));
+            cursor += sizeof(xyz);
+            loop->addVertex(new Point3D(xyz[0], xyz[1], xyz[2]));
+        }
+    }
+    
+    polygon->setNormal(normal);
+    polygon->setArea(area);
+    return polygon;
+}
+
+Material * SnapshotReader::readMaterial()
+{
+    std::string type, name;
+    uint32_t nParams;
+    if (!readString(&type) || !readString(&name) || !readValue<uint32_t>(&nParams) || !hasRoomFor(nParams, sizeof(double)))
+        return nullptr;
+    
+    std::vector<double> p = std::vector<double>(nParams);
+    for (uint32_t i = 0; i < nParams; i++) {
+        if (!readValue<double>(&p[i]))
+            return nullptr;
+    }
+    
+    // The parameters are in the same order as in 
+    // the Radiance primitives (see Material::parsePrimitive())
+    if (type == "dielectric" && nParams == 5) {
+        Dielectric * m = new Dielectric(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->refractionIndex = p[3]; m->hartmannConstant = p[4];
+        return m;
+    } else if (type == "glass" && nParams == 3) {
+        Glass * m = new Glass(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2];
+        return m;
+    } else if (type == "glow" && nParams == 4) {
+        Glow * m = new Glow(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->maxRadius = p[3];
+        return m;
+    } else if (type == "interface" && nParams == 8) {
+        Interface * m = new Interface(&name);
+        m->r1 = p[0]; m->g1 = p[1]; m->b1 = p[2]; m->refractionIndex1 = p[3];
+        m->r2 = p[4]; m->g2 = p[5]; m->b2 = p[6]; m->refractionIndex2 = p[7];
+        return m;
+    } else if (type == "light" && nParams == 3) {
+        Light * m = new Light(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2];
+        return m;
+    } else if (type == "metal" && nParams == 5) {
+        Metal * m = new Metal(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->specularity = p[3]; m->roughness = p[4];
+        return m;
+    } else if (type == "plastic" && nParams == 5) {
+        Plastic * m = new Plastic(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->specularity = p[3]; m->roughness = p[4];
+        return m;
+    } else if (type == "spotlight" && nParams == 7) {
+        Spotlight * m = new Spotlight(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->angle = p[3];
+        m->direction = Vector3D(p[4], p[5], p[6]);
+        return m;
+    } else if (type == "trans" && nParams == 7) {
+        Trans * m = new Trans(&name);
+        m->r = p[0]; m->g = p[1]; m->b = p[2]; m->specularity = p[3]; m->roughness = p[4];
+        m->transmissivity = p[5]; m->tspec = p[6];
+        return m;
+    }
+    
+    WARN(wMsg, "Unknown Material type '" + type + "' when reading a snapshot");
+    return nullptr;
+}
+
+Otype * SnapshotReader::readOtype()
+{
+    std::string type, name;
+    int32_t materialIndex;
+    if (!readString(&type) || !readString(&name) || !readValue<int32_t>(&materialIndex))
+        return nullptr;
+    
+    Otype * object = nullptr;
+    bool success = false;
+    if (type == "bubble") {
+        Bubble * o = new Bubble(&name);
+        success = readPoint(&o->center) && readValue<double>(&o->radius);
+        object = o;
+    } else if (type == "cone") {
+        Cone * o = new Cone(&name);
+        success = readPoint(&o->p0) && readPoint(&o->p1) && readValue<double>(&o->r0) && readValue<double>(&o->r1);
+        object = o;
+    } else if (type == "cup") {
+        Cup * o = new Cup(&name);
+        success = readPoint(&o->p0) && readPoint(&o->p1) && readValue<double>(&o->r0) && readValue<double>(&o->r1);
+        object = o;
+    } else if (type == "cylinder") {
+        Cylinder * o = new Cylinder(&name);
+        success = readPoint(&o->p0) && readPoint(&o->p1) && readValue<double>(&o->radius);
+        object = o;
+    } else if (type == "polygon") {
+        Face * o = new Face(&name);
+        Polygon3D * polygon = readPolygon();
+        success = polygon != nullptr;
+        if (success)
+            o->setPolygon(polygon);
+        object = o;
+    } else if (type == "ring") {
+        Ring * o = new Ring(&name);
+        success = readPoint(&o->center) && readVector(&o->direction) && readValue<double>(&o->r0) && readValue<double>(&o->r1);
+        object = o;
+    } else if (type == "source") {
+        Source * o = new Source(&name);
+        success = readVector(&o->direction) && readValue<double>(&o->angle);
+        object = o;
+    } else if (type == "sphere") {
+        Sphere * o = new Sphere(&name);
+        success = readPoint(&o->center) && readValue<double>(&o->radius);
+        object = o;
+    } else if (type == "tube") {
+        Tube * o = new Tube(&name);
+        success = readPoint(&o->p0) && readPoint(&o->p1) && readValue<double>(&o->radius);
+        object = o;
+    } else {
+        WARN(wMsg, "Unknown Otype '" + type + "' when reading a snapshot");
+        return nullptr;
+    }
+    
+    if (success && materialIndex != EMP_SNAPSHOT_NONE) {
+        success = materialIndex >= 0 && (size_t)materialIndex < model->getNumMaterials();
+        if (success)
+            object->setMaterial(model->getMaterialRef(materialIndex));
+    }
+    
+    if (!success) {
+        delete object;
+        return nullptr;
+    }
+    return object;
+}
+
+bool SnapshotReader::readLayer(Layer * layer)
+{
+    uint32_t nObjects;
+    if (!readValue<uint32_t>(&nObjects))
+        return false;
+    for (uint32_t i = 0; i < nObjects; i++) {
+        Otype * object = readOtype();
+        if (object == nullptr)
+            return false;
+        layer->addObject(object);
+    }
+    
+    uint32_t nInstances;
+    if (!readValue<uint32_t>(&nInstances))
+        return false;
+    for (uint32_t i = 0; i < nInstances; i++) {
+        int32_t definitionIndex;
+        double x, y, z, rx, ry, rz, scale;
+        if (!readValue<int32_t>(&definitionIndex) || !readXYZ(&x, &y, &z) || !readXYZ(&rx, &ry, &rz) || !readValue<double>(&scale))
+            return false;
+        
+        ComponentDefinition * definition = nullptr;
+        if (definitionIndex != EMP_SNAPSHOT_NONE) {
+            if (definitionIndex < 0 || (size_t)definitionIndex >= model->getNumComponentDefinitions())
+                return false;
+            definition = model->getComponentDefinitionRef(definitionIndex);
+        }
+        
+        ComponentInstance * instance = new ComponentInstance(definition);
+        instance->setX(x);
+        instance->setY(y);
+        instance->setZ(z);
+        instance->setRotationX(rx);
+        instance->setRotationY(ry);
+        instance->setRotationZ(rz);
+        instance->setScale(scale);
+        layer->addComponentInstance(instance);
+    }
+    
+    return true;
+}
+
+bool SnapshotReader::readHeader()
+{
+    SnapshotHeader header;
+    if (!readValue<SnapshotHeader>(&header) || strncmp(header.magic, EMP_SNAPSHOT_MAGIC, EMP_SNAPSHOT_MAGIC_SIZE) != 0) {
+        WARN(wMsg, "File is not a model snapshot");
+        return false;
+    }
+    if (header.byteOrder != EMP_SNAPSHOT_BYTE_ORDER) {
+        WARN(wMsg, "Model snapshot was written with a different byte order");
+        return false;
+    }
+    if (header.version != EMP_SNAPSHOT_VERSION) {
+        WARN(wMsg, "Model snapshot version " + std::to_string(header.version) + " is not supported (expected " + std::to_string(EMP_SNAPSHOT_VERSION) + ")");
+        return false;
+    }
+    
+    return true;
+}
+
+bool SnapshotReader::readModel()
+{
+    // Model info
+    float northCorrection;
+    int32_t month, day, hour, minute;
+    if (!readValue<float>(&northCorrection) || !readValue<int32_t>(&month) || !readValue<int32_t>(&day) || !readValue<int32_t>(&hour) || !readValue<int32_t>(&minute))
+        return false;
+    model->setNorthCorrection(northCorrection);
+    Date * date = model->getDate();
+    date->setMonth(month);
+    date->setDay(day);
+    date->setHour(hour);
+    date->setMinute(minute);
+    
+    float latitude, longitude, timeZone, albedo, elevation;
+    std::string city, country;
+    uint8_t hasWeather;
+    uint32_t weatherSize;
+    if (!readValue<float>(&latitude) || !readValue<float>(&longitude) || !readValue<float>(&timeZone) || !readString(&city) || !readString(&country) || !readValue<float>(&albedo) || !readValue<float>(&elevation) || !readValue<uint8_t>(&hasWeather) || !readValue<uint32_t>(&weatherSize))
+        return false;
+    Location * location = model->getLocation();
+    location->setLatitude(latitude);
+    location->setLongitude(longitude);
+    location->setTimeZone(timeZone);
+    location->setCity(city);
+    location->setCountry(country);
+    location->setAlbedo(albedo);
+    location->setElevation(elevation);
+    // Each record holds two int32_t and three float
+    if (!hasRoomFor(weatherSize, 2 * sizeof(int32_t) + 3 * sizeof(float)))
+        return false;
+    for (uint32_t i = 0; i < weatherSize; i++) {
+        HourlyData data;
+        if (!readValue<int32_t>(&data.month) || !readValue<int32_t>(&data.day) || !readValue<float>(&data.hour) || !readValue<float>(&data.diffuse_horizontal) || !readValue<float>(&data.direct_normal))
+            return false;
+        location->addHourlyData(data);
+    }
+    if (hasWeather)
+        location->markWeatherAsFilled();
+    
+    // RTraceOptions
+    std::string options;
+    if (!readString(&options))
+        return false;
+    json jOptions = json::parse(options, nullptr, false);
+    if (jOptions.is_discarded())
+        return false;
+    RTraceOptions * rtraceOptions = model->getRTraceOptions();
+    for (auto it = jOptions.begin(); it != jOptions.end(); ++it) {
+        if (rtraceOptions->hasOption(it.key()))
+            rtraceOptions->setOption<json>(it.key(), it.value());
+    }
+    
+    // Materials
+    uint32_t nMaterials;
+    if (!readValue<uint32_t>(&nMaterials))
+        return false;
+    for (uint32_t i = 0; i < nMaterials; i++) {
+        Material * material = readMaterial();
+        if (material == nullptr)
+            return false;
+        model->addMaterial(material);
+    }
+    
+    // Component definitions
+    uint32_t nDefinitions;
+    if (!readValue<uint32_t>(&nDefinitions))
+        return false;
+    const size_t firstDefinition = model->getNumComponentDefinitions();
+    for (uint32_t i = 0; i < nDefinitions; i++) {
+        std::string name;
+        if (!readString(&name))
+            return false;
+        model->addComponentDefinition(&name);
+    }
+    for (uint32_t i = 0; i < nDefinitions; i++) {
+        if (!readLayer(model->getComponentDefinitionRef(firstDefinition + i)))
+            return false;
+    }
+    
+    // Layers
+    uint32_t nLayers;
+    if (!readValue<uint32_t>(&nLayers))
+        return false;
+    for (uint32_t i = 0; i < nLayers; i++) {
+        std::string name;
+        if (!readString(&name))
+            return false;
+        model->addLayer(&name);
+        if (!readLayer(model->getLayerRef(model->getNumLayers() - 1)))
+            return false;
+    }
+    
+    // Workplanes
+    uint32_t nWorkplanes;
+    if (!readValue<uint32_t>(&nWorkplanes))
+        return false;
+    for (uint32_t i = 0; i < nWorkplanes; i++) {
+        std::string name;
+        double maxArea, maxAspectRatio, gridSpacing, refinementThreshold;
+        uint32_t nTasks;
+        if (!readString(&name) || !readValue<double>(&maxArea) || !readValue<double>(&maxAspectRatio) || !readValue<double>(&gridSpacing) || !readValue<double>(&refinementThreshold) || !readValue<uint32_t>(&nTasks))
+            return false;
+        
+        Workplane * workplane = new Workplane(name);
+        model->addWorkplane(workplane);
+        workplane->setMaxArea(maxArea);
+        workplane->setMaxAspectRatio(maxAspectRatio);
+        workplane->setGridSpacing(gridSpacing);
+        workplane->setRefinementThreshold(refinementThreshold);
+        
+        for (uint32_t j = 0; j < nTasks; j++) {
+            std::string task;
+            if (!readString(&task))
+                return false;
+            workplane->addTask(task);
+        }
+        
+        uint32_t nPolygons;
+        if (!readValue<uint32_t>(&nPolygons))
+            return false;
+        for (uint32_t j = 0; j < nPolygons; j++) {
+            Polygon3D * polygon = readPolygon();
+            if (polygon == nullptr)
+                return false;
+            workplane->addPolygon(polygon);
+        }
+    }
+    
+    // Window groups
+    uint32_t nWindowGroups;
+    if (!readValue<uint32_t>(&nWindowGroups))
+        return false;
+    for (uint32_t i = 0; i < nWindowGroups; i++) {
+        std::string name;
+        uint32_t nWindows;
+        if (!readString(&name) || !readValue<uint32_t>(&nWindows))
+            return false;
+        for (uint32_t j = 0; j < nWindows; j++) {
+            Otype * object = readOtype();
+            Face * window = dynamic_cast<Face *>(object);
+            if (window == nullptr) {
+                delete object;
+                return false;
+            }
+            model->addWindowToGroup(&name, window);
+        }
+    }
+    
+    // Illum groups
+    uint32_t nIllumGroups;
+    if (!readValue<uint32_t>(&nIllumGroups))
+        return false;
+    for (uint32_t i = 0; i < nIllumGroups; i++) {
+        std::string name;
+        uint32_t nPolygons;
+        if (!readString(&name) || !readValue<uint32_t>(&nPolygons))
+            return false;
+        for (uint32_t j = 0; j < nPolygons; j++) {
+            Polygon3D * polygon = readPolygon();
+            if (polygon == nullptr)
+                return false;
+            model->addIllumToGroup(&name, polygon);
+        }
+    }
+    
+    // Views
+    uint32_t nViews;
+    if (!readValue<uint32_t>(&nViews))
+        return false;
+    for (uint32_t i = 0; i < nViews; i++) {
+        View * view = new View();
+        if (!readString(&view->name) || !readPoint(&view->viewPoint) || !readVector(&view->viewDirection) || !readVector(&view->viewUp) || !readValue<double>(&view->viewHorizontal) || !readValue<double>(&view->viewVertical) || !readValue<int32_t>(&view->viewType) || !readValue<double>(&view->foreClippingDistance) || !readValue<double>(&view->aftClippingDistance)) {
+            delete view;
+            return false;
+        }
+        model->addView(view);
+    }
+    
+    // Photosensors
+    uint32_t nPhotosensors;
+    if (!readValue<uint32_t>(&nPhotosensors))
+        return false;
+    for (uint32_t i = 0; i < nPhotosensors; i++) {
+        std::string name;
+        Point3D position = Point3D(0, 0, 0);
+        Vector3D direction = Vector3D(0, 0, 1);
+        if (!readString(&name) || !readPoint(&position) || !readVector(&direction))
+            return false;
+        Photosensor * photosensor = new Photosensor(name);
+        photosensor->setPosition(position);
+        photosensor->setDirection(direction);
+        model->addPhotosensor(photosensor);
+    }
+    
+    // Tasks
+    uint32_t nTasks;
+    if (!readValue<uint32_t>(&nTasks))
+        return false;
+    for (uint32_t i = 0; i < nTasks; i++) {
+        std::string task;
+        if (!readString(&task))
+            return false;
+        json j = json::parse(task, nullptr, false);
+        if (j.is_discarded())
+            return false;
+        model->addTask(j);
+    }
+    
+    return cursor == end;
+}
+
+bool SnapshotReader::read(std::string filename)
+{
+    bool success = false;
+    bool validHeader = false;
+    
+#ifndef WIN
+    int fd = open(&filename[0], O_RDONLY);
+    if (fd < 0) {
+        WARN(wMsg, "Impossible to open snapshot file '" + filename + "'");
+        return false;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        WARN(wMsg, "Snapshot file '" + filename + "' is empty");
+        return false;
+    }
+    
+    size_t size = (size_t)status.st_size;
+    void * data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        WARN(wMsg, "Impossible to map snapshot file '" + filename + "'");
+        return false;
+    }
+    
+    cursor = static_cast<const char *>(data);
+    end = cursor + size;
+    validHeader = readHeader();
+    success = validHeader && readModel();
+    munmap(data, size);
+#else
+    FOPEN(file, &filename[0], "rb");
+    if (file == NULL) {
+        WARN(wMsg, "Impossible to open snapshot file '" + filename + "'");
+        return false;
+    }
+    
+    std::string data = std::string();
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.append(chunk, n);
+    fclose(file);
+    
+    cursor = data.data();
+    end = cursor + data.size();
+    validHeader = readHeader();
+    success = validHeader && readModel();
+#endif
+    
+    cursor = nullptr;
+    end = nullptr;
+    
+    if (validHeader && !success) {
+        WARN(wMsg, "Snapshot file '" + filename + "' is corrupt");
+    }
+    return success;
+}
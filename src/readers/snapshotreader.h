@@ -0,0 +1,173 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#ifndef SNAPSHOT_READER_H
+#define SNAPSHOT_READER_H
+
+#include <cstring>
+
+#include "../emp_model/emp_model.h"
+#include "../emp_model/src/snapshotformat.h"
+
+//! Object that reads a snapshot (see SnapshotWriter) and fills a EmpModel
+/*!
+ This object has a short life, and it is only meant to load a snapshot
+ into a EmpModel. The file is memory-mapped (or read at once, where
+ memory-mapping is not available) and the model is built directly from
+ it, without any parsing.
+ */
+class SnapshotReader {
+private:
+    EmpModel * model; //!< The model to be populated
+    const char * cursor = nullptr; //!< The position of the next value to read
+    const char * end = nullptr; //!< The end of the snapshot
+    
+    //! Reads a value and advances the cursor
+    /*!
+     @author German Molina
+     @param[out] value The value
+     @return success (false if the snapshot is truncated)
+     */
+    template<typename T>
+    bool readValue(T * value)
+    {
+        if ((size_t)(end - cursor) < sizeof(T))
+            return false;
+        memcpy(value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+    
+    //! Checks that the rest of the snapshot can hold a number of elements
+    /*!
+     Used before allocating anything whose size comes from the snapshot,
+     so a corrupt count fails instead of exhausting the memory
+     
+     @author German Molina
+     @param[in] count The number of elements
+     @param[in] size The size in bytes of each element
+     @return true if there are at least count * size bytes left
+     */
+    bool hasRoomFor(size_t count, size_t size) const
+    {
+        return count <= (size_t)(end - cursor) / size;
+    }
+    
+    //! Reads a string and advances the cursor
+    /*!
+     @author German Molina
+     @param[out] s The string
+     @return success
+     */
+    bool readString(std::string * s);
+    
+    //! Reads three doubles and advances the cursor
+    /*!
+     @author German Molina
+     @param[out] x The X component
+     @param[out] y The Y component
+     @param[out] z The Z component
+     @return success
+     */
+    bool readXYZ(double * x, double * y, double * z);
+    
+    //! Reads a Point3D and advances the cursor
+    /*!
+     @author German Molina
+     @param[out] p The Point3D
+     @return success
+     */
+    bool readPoint(Point3D * p);
+    
+    //! Reads a Vector3D and advances the cursor
+    /*!
+     @author German Molina
+     @param[out] v The Vector3D
+     @return success
+     */
+    bool readVector(Vector3D * v);
+    
+    //! Reads a Polygon3D and advances the cursor
+    /*!
+     @author German Molina
+     @return The new Polygon3D (NULL if the snapshot is corrupt)
+     */
+    Polygon3D * readPolygon();
+    
+    //! Reads a Material and advances the cursor
+    /*!
+     @author German Molina
+     @return The new Material (NULL if the snapshot is corrupt)
+     */
+    Material * readMaterial();
+    
+    //! Reads an Otype and advances the cursor
+    /*!
+     @author German Molina
+     @return The new Otype (NULL if the snapshot is corrupt)
+     */
+    Otype * readOtype();
+    
+    //! Reads the objects and ComponentInstance of a Layer (or ComponentDefinition)
+    /*!
+     @author German Molina
+     @param[out] layer The Layer to fill
+     @return success
+     */
+    bool readLayer(Layer * layer);
+    
+    //! Reads and verifies the header of the snapshot
+    /*!
+     @author German Molina
+     @return success (false if the file is not a snapshot, or it is not compatible)
+     */
+    bool readHeader();
+    
+    //! Reads the whole snapshot, after the header
+    /*!
+     @author German Molina
+     @return success
+     */
+    bool readModel();
+    
+public:
+    
+    //! Constructor
+    /*!
+     @author German Molina
+     @param[in] model The EmpModel to fill (should be empty)
+     */
+    SnapshotReader(EmpModel * model);
+    
+    //! Loads a snapshot into the model
+    /*!
+     Fails (without throwing) if the file is not a snapshot, if it was
+     written by another version of the format or with another byte order,
+     or if it is truncated. The model may be partially filled in the 
+     latter case.
+     
+     @author German Molina
+     @param[in] filename The name of the snapshot file
+     @return success
+     */
+    bool read(std::string filename);
+};
+
+#endif
@@ -42,7 +42,7 @@ protected:
     int interp = EMP_TIME_INTERPOLATION; //!< The interpolation scheme
     EmpModel * model; //!< The model
     Workplane * workplane = nullptr; //!< The workplane to which the metric will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix * depResults = nullptr; //!< The dependency results
     double minLux = 0; //!< The minimum illuminance allowed
     double maxLux = EMP_HUGE; //!< The maximum illuminance allowed
@@ -99,9 +99,9 @@ public:
             TriangulateWorkplane aux = TriangulateWorkplane(workplane);
             TaskManager * p = getParent();
             TriangulateWorkplane * triangulate = static_cast<TriangulateWorkplane *>( p->findTask(&aux) );
-            std::vector <Triangle *> triangles = triangulate->triangles;
+            const TriangleMesh * mesh = &(triangulate->mesh);
             
-            compliance = calcWorkplaneCompliance(&triangles, minTime,  maxTime, &result);
+            compliance = calcWorkplaneCompliance(mesh, minTime,  maxTime, &result);
         }
         
         
@@ -20,7 +20,7 @@
 
 #include "./compliance.h"
 
-float calcRaysCompliance(const std::vector<RAY> * rays, double minTime, double maxTime, const Matrix * result)
+float calcRaysCompliance(const SensorSet * rays, double minTime, double maxTime, const Matrix * result)
 {
     float compliance = 0;
     
@@ -38,18 +38,18 @@ float calcRaysCompliance(const std::vector<RAY> * rays, double minTime, double m
     return compliance / ((float)nrays/100.0f);
 }
 
-float calcWorkplaneCompliance(const std::vector <Triangle *> * triangles, double minTime, double maxTime, const Matrix * result)
+float calcWorkplaneCompliance(const TriangleMesh * mesh, double minTime, double maxTime, const Matrix * result)
 {
     float compliance = 0;
-    size_t nTriangles = triangles->size();
+    size_t nTriangles = mesh->nTriangles();
     float totalArea = 0;
     
+    // Results are given per sensor, which may span several triangles
     double v;
     for(size_t i = 0; i<nTriangles; i++){
-        Triangle * t = triangles->at(i);
-        double area = t->getArea();
+        double area = mesh->getArea(i);
         totalArea += (float)area;
-        v = result->getElement(i,0);
+        v = result->getElement(mesh->getSensor(i),0);
         
         if(v >= minTime && v <= maxTime)
             compliance += (float)area;
@@ -98,3 +98,36 @@ void bulkResultsIntoJSON(std::string taskName, std::string wpName, const Matrix
     }    
                
 }
+
+void meshIntoJSON(std::string taskName, std::string wpName, const TriangleMesh * mesh, json * j)
+{
+    // Ensure it exists
+    auto meshes = (*j)["meshes"];
+    if( meshes.is_null() )
+        (*j)["meshes"] = json::object();
+    
+    auto aux = (*j)["meshes"][taskName];
+    if(aux.is_null())
+        (*j)["meshes"][taskName] = json::object();
+    
+    // Fill... same format as the workplanes
+    (*j)["meshes"][taskName][wpName] = sensorsIntoJSON(mesh);
+}
+
+json sensorsIntoJSON(const TriangleMesh * mesh)
+{
+    // One polygon per sensor, so they match the rows of the results
+    std::vector< std::vector<int32_t> > outlines = std::vector< std::vector<int32_t> >();
+    mesh->getSensorOutlines(&outlines);
+    
+    json ret = json::array();
+    for(auto & outline : outlines){
+        json polygon = json::array();
+        for(auto v : outline){
+            Point3D p = mesh->getVertex(v);
+            polygon.push_back({p.getX(), p.getY(), p.getZ()});
+        }
+        ret.push_back(polygon);
+    }
+    return ret;
+}
@@ -20,12 +20,18 @@
 
 #pragma once
 #include "../calculations/radiance.h"
-#include "../common/geometry/triangle.h"
+#include "../common/geometry/trianglemesh.h"
 
-float calcRaysCompliance(const std::vector<RAY> * rays, double minTime, double maxTime, const Matrix * result);
+float calcRaysCompliance(const SensorSet * rays, double minTime, double maxTime, const Matrix * result);
 
 
-float calcWorkplaneCompliance(const std::vector <Triangle *> * triangles, double minTime, double maxTime, const Matrix * result);
+float calcWorkplaneCompliance(const TriangleMesh * mesh, double minTime, double maxTime, const Matrix * result);
 
 
 void bulkResultsIntoJSON(std::string taskName, std::string wpName, const Matrix * results, double compliance, json * j);
+
+
+void meshIntoJSON(std::string taskName, std::string wpName, const TriangleMesh * mesh, json * j);
+
+
+json sensorsIntoJSON(const TriangleMesh * mesh);
@@ -19,4 +19,5 @@
  *****************************************************************************/
 #include "./mutexes.h"
 
-tbb::mutex oconvMutex;
+tbb::mutex skyPatchesMutex;
+tbb::mutex octreeKeysMutex;
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "tbb/mutex.h"
-extern tbb::mutex oconvMutex;
+extern tbb::mutex skyPatchesMutex;
+extern tbb::mutex octreeKeysMutex;
 
 
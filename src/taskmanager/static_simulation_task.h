@@ -32,10 +32,11 @@ public:
     float compliance = 0; //!< Percentage of space that is over daylit
     EmpModel * model; //!< The model
     Workplane * workplane = nullptr; //!< The workplane to which the metric will be calculated
-    std::vector<RAY> * rays = nullptr; //!< The rays to process
+    SensorSet * rays = nullptr; //!< The rays to process
     Matrix * depResults = nullptr; //!< The dependency results
     double minLux = 0; //!< The minimum illuminance allowed
     double maxLux = EMP_HUGE; //!< The maximum illuminance allowed
+    const TriangleMesh * mesh = nullptr; //!< The sensors on which the results were calculated
     
     StaticSimulationTask()
     {
@@ -58,13 +59,8 @@ public:
         if(workplane == nullptr){
             compliance = calcRaysCompliance(rays,minLux,maxLux,depResults);
         }else{
-            // Get the workplane's triangulation
-            TriangulateWorkplane aux = TriangulateWorkplane(workplane);
-            TaskManager * p = getParent();
-            TriangulateWorkplane * triangulate = static_cast<TriangulateWorkplane *>(p->findTask(&aux));
-            std::vector <Triangle *> * triangles = &(triangulate->triangles);
-            
-            compliance = calcWorkplaneCompliance(triangles, minLux,maxLux,depResults);
+            mesh = getDependencyMesh();
+            compliance = calcWorkplaneCompliance(mesh, minLux,maxLux,depResults);
         }
         
         return true;
@@ -79,11 +75,40 @@ public:
     {
         std::string wpName = workplane->getName();
         bulkResultsIntoJSON(getName(), wpName, depResults, compliance, j);
+        
+        // Refined sensors do not match the workplane's triangles
+        if(mesh != nullptr && mesh != &(getTriangulation()->mesh))
+            meshIntoJSON(getName(), wpName, mesh, j);
+        
         return true;
     }
     
     virtual Matrix * getDependencyResults() = 0;    
     
+    //! Retrieves the TriangulateWorkplane task of the workplane
+    /*!
+     @author German Molina
+     @return The task
+     */
+    TriangulateWorkplane * getTriangulation()
+    {
+        TriangulateWorkplane aux = TriangulateWorkplane(workplane);
+        TaskManager * p = getParent();
+        return static_cast<TriangulateWorkplane *>(p->findTask(&aux));
+    }
+    
+    //! Retrieves the sensors on which the dependency results were calculated
+    /*!
+     By default, these are the triangles of the workplane
+     
+     @author German Molina
+     @return The TriangleMesh
+     */
+    virtual const TriangleMesh * getDependencyMesh()
+    {
+        return &(getTriangulation()->mesh);
+    }
+    
 };
 
 //extern StaticSimulationTask staticSimulationTask;
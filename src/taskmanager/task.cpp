@@ -82,6 +82,16 @@ void Task::replaceDependency(Task * a, Task * b)
   }
 }
 
+void Task::merge(Task * t)
+{
+    
+}
+
+bool Task::prepare()
+{
+    return true;
+}
+
 void Task::setParent(TaskManager * tm)
 {
     parent = tm;
@@ -182,6 +182,32 @@ public:
     */
     virtual bool isMutex(Task * t) = 0;
 
+    //! Absorbs a redundant Task
+    /*!
+    Called by the TaskManager right before deleting a Task that was found
+    to be equal to this one. Tasks that gather the work of several others
+    (i.e. an RContribBatch) use it to take over whatever the redundant
+    Task was carrying. Dependencies added here are registered in the
+    TaskManager afterwards. By default, it does nothing.
+    
+    @author German Molina
+    @param[in] t The pointer to the redundant Task
+    */
+    virtual void merge(Task * t);
+
+    //! Prepares the shared data before any Task is solved
+    /*!
+    Called by the TaskManager on every Task, one at a time, before the
+    task graph is solved. Tasks that modify data shared with other Tasks
+    (i.e. an OconvTask that optimizes the geometry of its EmpModel) do it
+    here, because solve() may run concurrently with other Tasks reading
+    the same data. By default, it does nothing.
+    
+    @author German Molina
+    @return success
+    */
+    virtual bool prepare();
+
     //! Adds the Task reuslts to a result JSON
     /*!
     @author German Molina
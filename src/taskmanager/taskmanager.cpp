@@ -65,6 +65,16 @@ size_t TaskManager::addTask(Task * t)
               t->getDependencyRef(j)->replaceDependency(t, tasks[i]);
             }
             
+            // let the existing Task absorb the redundant one, and
+            // register whatever dependencies it took from it
+            Task * existing = tasks[i];
+            size_t nBefore = existing->countDependencies();
+            existing->merge(t);
+            size_t nAfter = existing->countDependencies();
+            for (size_t j = nBefore; j < nAfter; j++) {
+              addTask(existing->getDependencyRef(j));
+            }
+            
             //delete, 
             delete t;
 
@@ -115,6 +125,13 @@ bool TaskManager::solve(json * results)
 #endif
         return true;
     }
+    
+    // Let the tasks modify shared data while nothing else runs
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (!tasks[i]->prepare())
+            return false;
+    }
+    
 	// Create a vector to store all the nodes
 	std::vector< tbb::flow::continue_node<tbb::flow::continue_msg> > nodes;
 	nodes.reserve(tasks.size());
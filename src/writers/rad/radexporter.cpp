@@ -29,6 +29,82 @@
 #include "../../common/utilities/stringutils.h"
 
 #include <fstream>
+#include <algorithm>
+#include <map>
+#include <array>
+#include "tbb/tbb.h"
+
+//! The number of scene items (instances or objects) formatted by each task
+#define EMP_EXPORT_CHUNK_SIZE 256
+
+//! The number of chunks formatted (in parallel) before writing them
+#define EMP_EXPORT_BATCH_SIZE 256
+
+//! An in-memory FILE, where a chunk of the scene is formatted
+/*!
+ It relies on open_memstream() where available, and on
+ tmpfile() otherwise.
+ */
+class SceneBuffer {
+private:
+    FILE * file = nullptr; //!< The FILE to write to
+    char * data = nullptr; //!< The contents (when using open_memstream)
+    size_t size = 0; //!< The size of the contents (when using open_memstream)
+    
+public:
+    
+    ~SceneBuffer()
+    {
+        if (file != nullptr)
+            fclose(file);
+        free(data);
+    }
+    
+    //! Opens the buffer
+    /*!
+     @author German Molina
+     @return The FILE to write to (NULL on error)
+     */
+    FILE * open()
+    {
+#ifdef WIN
+        file = tmpfile();
+#else
+        file = open_memstream(&data, &size);
+#endif
+        return file;
+    }
+    
+    //! Writes the contents of the buffer into a file, and closes the buffer
+    /*!
+     @author German Molina
+     @param[in] out The file to write to
+     @return success
+     */
+    bool writeTo(FILE * out)
+    {
+        if (file == nullptr)
+            return false;
+        
+#ifdef WIN
+        std::vector<char> block = std::vector<char>(1 << 16);
+        rewind(file);
+        size_t n;
+        while ((n = fread(&block[0], 1, block.size(), file)) > 0) {
+            if (fwrite(&block[0], 1, n, out) != n)
+                return false;
+        }
+        fclose(file);
+        file = nullptr;
+        return true;
+#else
+        fclose(file);
+        file = nullptr;
+        return fwrite(data, 1, size, out) == size;
+#endif
+    }
+};
+
 
 
 RadExporter::RadExporter(EmpModel * the_model)
@@ -36,6 +112,100 @@ RadExporter::RadExporter(EmpModel * the_model)
 	model = the_model;
 }
 
+void RadExporter::findTriangleSoups(const Layer * layer, size_t minTriangles, std::vector<TriangleSoup> * soups) const
+{
+    // Group triangles by material, keeping the order of the materials
+    std::vector<TriangleSoup> groups = std::vector<TriangleSoup>();
+    for (auto object : *(layer->getObjectsRef())) {
+        const Face * face = dynamic_cast<const Face *>(object);
+        if (face == nullptr || face->hasInnerLoops() || face->getMaterial() == nullptr || face->getOuterLoopRef()->realSize() != 3)
+            continue;
+        
+        size_t g = 0;
+        while (g < groups.size() && groups[g].material != face->getMaterial())
+            g++;
+        
+        if (g == groups.size())
+            groups.push_back({layer, face->getMaterial()});
+        
+        groups[g].faces.push_back(face);
+    }
+    
+    for (auto & group : groups) {
+        if (group.faces.size() >= minTriangles)
+            soups->push_back(group);
+    }
+}
+
+bool RadExporter::writeOBJ(FILE * file, const TriangleSoup * soup) const
+{
+    std::map<std::array<double, 3>, size_t> vertices = std::map<std::array<double, 3>, size_t>();
+    std::string vText = std::string();
+    std::string fText = std::string();
+    
+    for (auto face : soup->faces) {
+        Loop * loop = face->getOuterLoopRef();
+        fText += 'f';
+        for (size_t i = 0; i < loop->size(); i++) {
+            Point3D * p = loop->getVertexRef(i);
+            if (p == NULL)
+                continue;
+            
+            std::array<double, 3> v = {p->getX(), p->getY(), p->getZ()};
+            auto found = vertices.find(v);
+            size_t index;
+            if (found == vertices.end()) {
+                // OBJ indices start at 1
+                index = vertices.size() + 1;
+                vertices[v] = index;
+                vText += 'v';
+                for (int k = 0; k < 3; k++) {
+                    vText += ' ';
+                    appendFixed(v[k], &vText);
+                }
+                vText += '\n';
+            } else {
+                index = found->second;
+            }
+            fText += ' ' + std::to_string(index);
+        }
+        fText += '\n';
+    }
+    
+    return fwrite(vText.data(), 1, vText.size(), file) == vText.size() && fwrite(fText.data(), 1, fText.size(), file) == fText.size();
+}
+
+void RadExporter::setTriangleSoups(const std::vector<TriangleSoup> * soups)
+{
+    triangleSoups = soups;
+}
+
+void RadExporter::writeTriangleSoups(FILE * file, const Layer * layer, std::string * newMaterial, std::set<const Otype *> * meshed) const
+{
+    if (triangleSoups == nullptr)
+        return;
+    
+    for (auto & soup : *triangleSoups) {
+        if (soup.layer != layer)
+            continue;
+        
+        std::string materialName = newMaterial == nullptr ? soup.material->getName() : *newMaterial;
+        fixString(&materialName);
+        std::string meshName = soup.layer->getName() + "_" + soup.material->getName();
+        fixString(&meshName);
+        
+        fprintf(file, "%s mesh %s\n1 %s\n0\n0\n\n", &materialName[0], &meshName[0], &soup.meshName[0]);
+        
+        for (auto face : soup.faces)
+            meshed->insert(face);
+    }
+}
+
+EmpModel * RadExporter::getModel() const
+{
+	return model;
+}
+
 
 bool RadExporter::writeModelInfo(const char * filename) const
 {
@@ -250,51 +420,126 @@ bool RadExporter::writeLayers(const char * dir) const
 
 bool RadExporter::writeLayersInOneFile(FILE * file, std::string * newMaterial) const
 {
+    return writeLayersInOneFile(file, newMaterial, nullptr);
+}
 
-    size_t numLayers = model->getNumLayers();
+bool RadExporter::writeLayersInOneFile(FILE * file) const
+{
+    return writeLayersInOneFile(file, nullptr);
+}
 
+bool RadExporter::writeLayersInOneFile(FILE * file, std::string * newMaterial, const std::string * octreePrefix) const
+{
+    // List everything, in the order it is written... the
+    // instances of each layer, a separator and its objects
+    std::vector<SceneItem> items = std::vector<SceneItem>();
+    std::set<const Otype *> meshed = std::set<const Otype *>();
+    size_t numLayers = model->getNumLayers();
     for (size_t i = 0; i < numLayers; i++) {
-        
-        // get the layer
         Layer * layer = model->getLayerRef(i);
         
-        /* WRITE COMPONENT INSTANCES */
+        // The meshes go first, so their triangles are skipped
+        writeTriangleSoups(file, layer, newMaterial, &meshed);
         
-        // Create an Identity transformation
-        Transform transform = Transform();
-        double scale = 1;
-        // Get the instances
-        const std::vector < ComponentInstance * > * const instances = layer->getComponentInstancesRef();
+        for (auto instance : *(layer->getComponentInstancesRef()))
+            items.push_back({instance, nullptr});
         
-        // Iterate the instances
-        size_t numInstances = instances->size();
-        for (size_t j = 0; j < numInstances; j++) {
-            writeComponentInstance(file, layer->getComponentInstanceRef(j), &transform, scale, newMaterial);
+        items.push_back({nullptr, nullptr});
+        
+        for (auto object : *(layer->getObjectsRef())) {
+            if (meshed.count(object) == 0)
+                items.push_back({nullptr, object});
         }
+    }
+    
+    return writeSceneItems(file, &items, newMaterial, octreePrefix);
+}
 
-        fprintf(file, "\n\n");
+bool RadExporter::writeComponentDefinition(FILE * file, const ComponentDefinition * definition, std::string * newMaterial, const std::string * octreePrefix) const
+{
+    std::vector<SceneItem> items = std::vector<SceneItem>();
+    std::set<const Otype *> meshed = std::set<const Otype *>();
+    writeTriangleSoups(file, definition, newMaterial, &meshed);
+    
+    for (auto instance : *(definition->getComponentInstancesRef()))
+        items.push_back({instance, nullptr});
+    
+    items.push_back({nullptr, nullptr});
+    
+    for (auto object : *(definition->getObjectsRef())) {
+        if (meshed.count(object) == 0)
+            items.push_back({nullptr, object});
+    }
+    
+    return writeSceneItems(file, &items, newMaterial, octreePrefix);
+}
 
-        /* WRITE THE OBJECTS */
+bool RadExporter::writeSceneItems(FILE * file, const std::vector<SceneItem> * items, std::string * newMaterial, const std::string * octreePrefix) const
+{
+    const size_t nItems = items->size();
+    const size_t nChunks = (nItems + EMP_EXPORT_CHUNK_SIZE - 1) / EMP_EXPORT_CHUNK_SIZE;
+    
+    // Format a batch of chunks in parallel, then write them in order
+    for (size_t firstChunk = 0; firstChunk < nChunks; firstChunk += EMP_EXPORT_BATCH_SIZE) {
+        const size_t nBatch = std::min((size_t)EMP_EXPORT_BATCH_SIZE, nChunks - firstChunk);
+        std::vector<SceneBuffer> buffers = std::vector<SceneBuffer>(nBatch);
         
-        // Get the objects
-        const std::vector < Otype * > * const objects = layer->getObjectsRef();
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, nBatch),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t c = r.begin(); c != r.end(); ++c) {
+                    FILE * chunk = buffers[c].open();
+                    if (chunk == nullptr)
+                        continue;
+                    
+                    Transform transform = Transform();
+                    const size_t start = (firstChunk + c) * EMP_EXPORT_CHUNK_SIZE;
+                    const size_t end = std::min(start + EMP_EXPORT_CHUNK_SIZE, nItems);
+                    for (size_t i = start; i < end; i++) {
+                        const SceneItem & item = items->at(i);
+                        if (item.instance != nullptr) {
+                            if (octreePrefix == nullptr)
+                                writeComponentInstance(chunk, item.instance, &transform, 1, newMaterial);
+                            else
+                                writeComponentInstance(chunk, item.instance, octreePrefix);
+                        }
+                        else if (item.object != nullptr) {
+                            writeOtype(item.object, chunk, newMaterial);
+                        }
+                        else {
+                            fprintf(chunk, "\n\n");
+                        }
+                    }
+                }
+            }
+        );
         
-        // Count the objects
-        size_t numObjs = objects->size();
-
-        // Iterate
-        for (size_t j = 0; j < numObjs; j++) {
-            // Get object
-            writeOtype(objects->at(j), file, newMaterial, &transform, 1);
+        for (auto & buffer : buffers) {
+            if (!buffer.writeTo(file)) {
+                warn("Impossible to export scene chunk");
+                return false;
+            }
         }
-
     }
+    
     return true;
 }
 
-bool RadExporter::writeLayersInOneFile(FILE * file) const
+std::string RadExporter::getComponentOctreeName(const std::string * octreePrefix, const ComponentDefinition * definition) const
 {
-    return writeLayersInOneFile(file, nullptr);
+    std::string componentName = definition->getName();
+    
+    // Names that only differ in the characters replaced by 
+    // fixString() would collide, so the raw name is hashed (FNV-1a)
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : componentName) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+    
+    fixString(&componentName);
+    return *octreePrefix + "_" + componentName + "_" + hex + ".oct";
 }
 
 void RadExporter::writeComponentInstance(FILE * file, const ComponentInstance * const instance) const
@@ -349,16 +594,16 @@ void RadExporter::writeComponentInstance(FILE * file, const ComponentInstance *
     }
 
     // Create a transformation with this instance's location
-    Transform * transform = instance->getTransform();
+    Transform transform = instance->getTransform();
 
     // Add the parent transform
-    transform->preMultiply(parentTransform);
+    transform.preMultiply(parentTransform);
     scale *= instance->getScale();
     
     // write instances within the model
     if (numInstances > 0) {
         for (size_t j = 0; j < numInstances; j++) {
-          writeComponentInstance(file, definition->getComponentInstanceRef(j), transform, scale, newMaterial);
+          writeComponentInstance(file, definition->getComponentInstanceRef(j), &transform, scale, newMaterial);
         }
         fprintf(file, "\n\n");
     }
@@ -366,14 +611,44 @@ void RadExporter::writeComponentInstance(FILE * file, const ComponentInstance *
     // Iterate
     for (size_t j = 0; j < numObjects; j++) {
         // Get object
-        writeOtype(definition->getObjectRef(j), file, newMaterial, transform, scale);
+        writeOtype(definition->getObjectRef(j), file, newMaterial, &transform, scale);
     }
-    
-    delete transform;
   
 }
 
 
+void RadExporter::writeComponentInstance(FILE * file, const ComponentInstance * const instance, const std::string * octreePrefix) const
+{
+    const ComponentDefinition * definition = instance->getDefinitionRef();
+    if (definition == nullptr) {
+        warn("Trying to export an instance with nullptr definition... instance ignored.");
+        return;
+    }
+    
+    // Empty definitions have no octree
+    if (definition->getObjectsRef()->size() < 1 && definition->getComponentInstancesRef()->size() < 1) {
+        WARN(wMsg,"Empty ComponentDefinition '" + definition->getName() + "'");
+        return;
+    }
+    
+    std::string octreeName = getComponentOctreeName(octreePrefix, definition);
+    std::string instanceName = definition->getName();
+    fixString(&instanceName);
+    
+    fprintf(file, "void instance %s\n13 %s -s %f -rz %f -ry %f -rx %f -t %f %f %f\n0\n0\n\n",
+            &instanceName[0],
+            &octreeName[0],
+            instance->getScale(),
+            instance->getRotationZ(),
+            instance->getRotationY(),
+            instance->getRotationX(),
+            instance->getX(),
+            instance->getY(),
+            instance->getZ()
+            );
+}
+
+
 bool RadExporter::writeWindows(const char * dir) const
 {
 	size_t numGroups = model->getNumWindowGroups();
@@ -867,25 +1142,43 @@ bool RadExporter::writeFace(const Face * const face, const std::string * oName,
     // Print number of 3 x vertices
     fprintf(file,"%zd\n",3 * finalLoop->realSize());
     
-    // Print the loop
+    // Gather the loop
     size_t numVertices = finalLoop->size();
+    std::vector<double> coordinates = std::vector<double>();
+    coordinates.reserve(3 * numVertices);
     
-    for (int i = 0; i < numVertices; i++) {
+    for (size_t i = 0; i < numVertices; i++) {
         Point3D * point = finalLoop->getVertexRef(i);
         
         if (point == NULL)
             continue;
         
-        fprintf(file, "\t");
-        if (transform == nullptr) {
-            fprintf(file, "%f %f %f\n", point->getX(), point->getY(), point->getZ());
-        }
-        else {
-            Point3D p = Point3D(scale*point->getX(), scale*point->getY(), scale*point->getZ());
-            p = p.transform(transform);
-            fprintf(file, "%f %f %f\n", p.getX(), p.getY(), p.getZ());
-        }
+        coordinates.push_back(point->getX());
+        coordinates.push_back(point->getY());
+        coordinates.push_back(point->getZ());
+    }
+    
+    // Transform all the vertices at once
+    size_t numPoints = coordinates.size() / 3;
+    if (transform != nullptr && numPoints > 0) {
+        for (auto & c : coordinates)
+            c *= scale;
+        transform->transformPoints(&coordinates[0], &coordinates[0], numPoints);
+    }
+    
+    // Print the loop, in one go
+    std::string text = std::string();
+    text.reserve(numPoints * 3 * 16);
+    for (size_t i = 0; i < numPoints; i++) {
+        text += '\t';
+        appendFixed(coordinates[3 * i], &text);
+        text += ' ';
+        appendFixed(coordinates[3 * i + 1], &text);
+        text += ' ';
+        appendFixed(coordinates[3 * i + 2], &text);
+        text += '\n';
     }
+    fwrite(text.data(), 1, text.size(), file);
     
     
     if (needToDelete) {
@@ -21,9 +21,29 @@
 #ifndef RAD_EXPORTER_H
 #define RAD_EXPORTER_H
 
+#include <set>
+
 #include "../../emp_model/emp_model.h"
 #include "../../common/geometry/transform.h"
 
+//! An item of a scene: either a ComponentInstance, an object, or a separator (both NULL)
+struct SceneItem {
+    const ComponentInstance * instance; //!< The ComponentInstance
+    const Otype * object; //!< The object
+};
+
+//! A group of triangular Face objects exported as a single Radiance 'mesh'
+/*!
+ All the triangles belong to the same Layer (or ComponentDefinition) and
+ share a Material (see RadExporter::findTriangleSoups()).
+ */
+struct TriangleSoup {
+    const Layer * layer; //!< The Layer (or ComponentDefinition) of the triangles
+    const Material * material; //!< The Material of the triangles
+    std::vector<const Face *> faces = std::vector<const Face *>(); //!< The triangles
+    std::string meshName = ""; //!< The name of the compiled (i.e. OBJ2MESH) mesh file (empty until compiled)
+};
+
 //! The main object for exporting a EmpModel in Radiance format.
 /*!
 The file distribution will be the one used by Groundhog (www.groundhoglighting.com).
@@ -33,6 +53,31 @@ The main function to be called is RadExporter::exportModel()
 class RadExporter {
 private:	
 	EmpModel * model; //!< The EmpModel to export
+    const std::vector<TriangleSoup> * triangleSoups = nullptr; //!< The triangles written as meshes instead of polygons (NULL means none)
+    
+    //! Writes the meshes of the TriangleSoup objects of a Layer
+    /*!
+     @author German Molina
+     @param[in] file The file
+     @param[in] layer The Layer (or ComponentDefinition)
+     @param[in] newMaterial The name of the material (or NULL)
+     @param[out] meshed The faces that were included in a mesh
+     */
+    void writeTriangleSoups(FILE * file, const Layer * layer, std::string * newMaterial, std::set<const Otype *> * meshed) const;
+
+    //! Writes a list of scene items, formatting them in parallel
+    /*!
+     Items are split in chunks that are formatted in parallel
+     into memory buffers, which are then written in order.
+     
+     @author German Molina
+     @return success
+     @param[in] file The file
+     @param[in] items The items to write
+     @param[in] newMaterial The name of the material (or NULL)
+     @param[in] octreePrefix The prefix of the ComponentDefinition octrees (NULL for expanding instances)
+     */
+    bool writeSceneItems(FILE * file, const std::vector<SceneItem> * items, std::string * newMaterial, const std::string * octreePrefix) const;
 
 public:
 
@@ -43,6 +88,48 @@ public:
 	@author German Molina
 	*/
 	RadExporter(EmpModel * model);
+
+	//! Retrieves the EmpModel being exported
+	/*!
+	@author German Molina
+	@return The EmpModel
+	*/
+	EmpModel * getModel() const;
+    
+    //! Finds the groups of triangles of a Layer that are worth writing as a mesh
+    /*!
+     Triangular Face objects (without holes) are grouped by Material, and
+     the groups with at least minTriangles are returned. Their meshName
+     is left empty.
+     
+     @author German Molina
+     @param[in] layer The Layer (or ComponentDefinition)
+     @param[in] minTriangles The minimum number of triangles of a group
+     @param[out] soups The groups found
+     */
+    void findTriangleSoups(const Layer * layer, size_t minTriangles, std::vector<TriangleSoup> * soups) const;
+    
+    //! Writes a TriangleSoup in Wavefront OBJ format, to be compiled by OBJ2MESH
+    /*!
+     Vertices shared by several triangles are written only once
+     
+     @author German Molina
+     @return success
+     @param[in] file The file
+     @param[in] soup The triangles
+     */
+    bool writeOBJ(FILE * file, const TriangleSoup * soup) const;
+    
+    //! Sets the triangles that are written as meshes instead of polygons
+    /*!
+     From then on, the Layer and ComponentDefinition objects are written 
+     with a 'mesh' primitive for each of their TriangleSoup, which must have
+     been compiled already, and without the triangles in them.
+     
+     @author German Molina
+     @param[in] soups The TriangleSoup objects (NULL to write all polygons again)
+     */
+    void setTriangleSoups(const std::vector<TriangleSoup> * soups);
 	
 	
 	//! Writes the information of the model (north correction and location)
@@ -121,6 +208,49 @@ public:
      */
     bool writeLayersInOneFile(FILE * file) const;
 
+    //! Writes all the layers in a single file, referencing component octrees
+    /*!
+     Same as writeLayersInOneFile(FILE *, std::string *), but every
+     ComponentInstance is written as a Radiance 'instance' primitive that
+     points to the octree of its ComponentDefinition (see
+     getComponentOctreeName()) instead of expanding its geometry. If
+     octreePrefix is a NULL pointer, instances are expanded as usual.
+     
+     @author German Molina
+     @return success
+     @param[in] file The file
+     @param[in] newMaterial The name of the material
+     @param[in] octreePrefix The prefix of the ComponentDefinition octrees
+     */
+    bool writeLayersInOneFile(FILE * file, std::string * newMaterial, const std::string * octreePrefix) const;
+
+    //! Writes the contents of a ComponentDefinition, to be frozen into its own octree
+    /*!
+     The objects are written without transformation, and the nested
+     ComponentInstance objects are written as 'instance' primitives
+     referencing their own octrees.
+     
+     @author German Molina
+     @return success
+     @param[in] file The file
+     @param[in] definition The ComponentDefinition to write
+     @param[in] newMaterial The name of the material (or NULL)
+     @param[in] octreePrefix The prefix of the ComponentDefinition octrees
+     */
+    bool writeComponentDefinition(FILE * file, const ComponentDefinition * definition, std::string * newMaterial, const std::string * octreePrefix) const;
+
+    //! Builds the name of the octree that holds a ComponentDefinition
+    /*!
+     The name includes a hash of the ComponentDefinition's name, so it
+     is unique even if fixString() makes two names equal.
+     
+     @author German Molina
+     @return The name of the octree
+     @param[in] octreePrefix The prefix of the ComponentDefinition octrees
+     @param[in] definition The ComponentDefinition
+     */
+    std::string getComponentOctreeName(const std::string * octreePrefix, const ComponentDefinition * definition) const;
+
     
 	//! Writes an XFORM call to a ComponentInstance in Radiance format
 	/*!
@@ -145,6 +275,19 @@ public:
     */
     void writeComponentInstance(FILE * file, const ComponentInstance * const instance, Transform * transform, double scale, std::string * newMaterial) const;
 
+    //! Writes a ComponentInstance as a Radiance 'instance' primitive
+    /*!
+    The instance references the octree of its ComponentDefinition, using
+    the same transformation that writeComponentInstance(FILE *, const ComponentInstance * const)
+    passes to XFORM.
+
+    @author German Molina
+    @param[in] file The file to write this in
+    @param[in] instance The ComponentInstance to write
+    @param[in] octreePrefix The prefix of the ComponentDefinition octrees
+    */
+    void writeComponentInstance(FILE * file, const ComponentInstance * const instance, const std::string * octreePrefix) const;
+
 
 	//! Writes all the window groups in Radiance format
 	/*!
@@ -89,30 +89,28 @@ public:
         TriangulateWorkplane * dependency = static_cast<TriangulateWorkplane *>(getDependencyRef(0));
         
         // Write down all polygons in triangulation
+        const TriangleMesh * mesh = &(dependency->mesh);
         size_t nRays = dependency->rays.size();
         
         // Iterate
         for (size_t i = 0; i < nRays; i++) {
             
-            // Get the Triangle and ray
-            Triangle * triangle = dependency->triangles.at(i);
-            RAY * ray = &(dependency->rays.at(i));
-            
-            if (triangle == NULL)
-                continue;
+            // Get the sensor
+            const float * origin = dependency->rays.getOrigin(i);
+            const float * dir = dependency->rays.getDirection(i);
             
             // Write in Pixel file
             for (int l = 0; l < 3; l++) {
-                Point3D * p = triangle->getVertex(l);
-                double px = p->getX();
-                double py = p->getY();
-                double pz = p->getZ();
+                Point3D p = mesh->getVertex(i, l);
+                double px = p.getX();
+                double py = p.getY();
+                double pz = p.getZ();
                 pxlFile << px << EMP_TAB << py << EMP_TAB << pz << EMP_TAB;
             }
             pxlFile << "\n";
             
-            ptsFile << ray->rorg[0] << EMP_TAB << ray->rorg[1] << EMP_TAB << ray->rorg[2] << EMP_TAB;
-            ptsFile << ray->rdir[0] << EMP_TAB << ray->rdir[1] << EMP_TAB << ray->rdir[2] << "\n";
+            ptsFile << origin[0] << EMP_TAB << origin[1] << EMP_TAB << origin[2] << EMP_TAB;
+            ptsFile << dir[0] << EMP_TAB << dir[1] << EMP_TAB << dir[2] << "\n";
             
             
         }
@@ -0,0 +1,386 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <cstring>
+
+#include "./snapshotwriter.h"
+#include "../../common/utilities/io.h"
+#include "../../os_definitions.h"
+
+SnapshotWriter::SnapshotWriter(EmpModel * theModel)
+{
+    model = theModel;
+}
+
+void SnapshotWriter::writeString(const std::string & s)
+{
+    writeValue<uint32_t>((uint32_t)s.size());
+    buffer.append(s);
+}
+
+void SnapshotWriter::writeXYZ(double x, double y, double z)
+{
+    writeValue<double>(x);
+    writeValue<double>(y);
+    writeValue<double>(z);
+}
+
+void SnapshotWriter::writePoint(Point3D p)
+{
+    writeXYZ(p.getX(), p.getY(), p.getZ());
+}
+
+void SnapshotWriter::writeVector(Vector3D v)
+{
+    writeXYZ(v.getX(), v.getY(), v.getZ());
+}
+
+void SnapshotWriter::writePolygon(Polygon3D * polygon)
+{
+    Vector3D normal = polygon->getNormal();
+    writeVector(normal);
+    writeValue<double>(polygon->getArea());
+    
+    std::vector<Loop *> loops = std::vector<Loop *>();
+    loops.push_back(polygon->getOuterLoopRef());
+    size_t nInner = polygon->countInnerLoops();
+    for (size_t i = 0; i < nInner; i++)
+        loops.push_back(polygon->getInnerLoopRef(i));
+    
+    writeValue<uint32_t>((uint32_t)loops.size());
+    for (auto loop : loops)
+        writeValue<uint32_t>((uint32_t)loop->realSize());
+    
+    for (auto loop : loops) {
+        size_t nVertices = loop->size();
+        for (size_t i = 0; i < nVertices; i++) {
+            Point3D * p = loop->getVertexRef(i);
+            if (p != NULL)
+                writePoint(*p);
+        }
+    }
+}
+
+bool SnapshotWriter::writeMaterial(const Material * material)
+{
+    // The parameters are written in the same order as in 
+    // the Radiance primitives (see Material::parsePrimitive())
+    std::string type = material->getType();
+    std::vector<double> params = std::vector<double>();
+    
+    if (type == "dielectric") {
+        const Dielectric * m = static_cast<const Dielectric *>(material);
+        params = {m->r, m->g, m->b, m->refractionIndex, m->hartmannConstant};
+    } else if (type == "glass") {
+        const Glass * m = static_cast<const Glass *>(material);
+        params = {m->r, m->g, m->b};
+    } else if (type == "glow") {
+        const Glow * m = static_cast<const Glow *>(material);
+        params = {m->r, m->g, m->b, m->maxRadius};
+    } else if (type == "interface") {
+        const Interface * m = static_cast<const Interface *>(material);
+        params = {m->r1, m->g1, m->b1, m->refractionIndex1, m->r2, m->g2, m->b2, m->refractionIndex2};
+    } else if (type == "light") {
+        const Light * m = static_cast<const Light *>(material);
+        params = {m->r, m->g, m->b};
+    } else if (type == "metal") {
+        const Metal * m = static_cast<const Metal *>(material);
+        params = {m->r, m->g, m->b, m->specularity, m->roughness};
+    } else if (type == "plastic") {
+        const Plastic * m = static_cast<const Plastic *>(material);
+        params = {m->r, m->g, m->b, m->specularity, m->roughness};
+    } else if (type == "spotlight") {
+        const Spotlight * m = static_cast<const Spotlight *>(material);
+        params = {m->r, m->g, m->b, m->angle, m->direction.getX(), m->direction.getY(), m->direction.getZ()};
+    } else if (type == "trans") {
+        const Trans * m = static_cast<const Trans *>(material);
+        params = {m->r, m->g, m->b, m->specularity, m->roughness, m->transmissivity, m->tspec};
+    } else {
+        FATAL(errmsg, "Unknown Material type '" + type + "' when writing a snapshot");
+        return false;
+    }
+    
+    writeString(type);
+    writeString(material->getName());
+    writeValue<uint32_t>((uint32_t)params.size());
+    for (auto p : params)
+        writeValue<double>(p);
+    
+    return true;
+}
+
+bool SnapshotWriter::writeOtype(const Otype * object)
+{
+    std::string type = object->getType();
+    writeString(type);
+    writeString(object->getName());
+    
+    auto found = materialIndices.find(object->getMaterial());
+    writeValue<int32_t>(found == materialIndices.end() ? EMP_SNAPSHOT_NONE : found->second);
+    
+    if (type == "bubble") {
+        const Bubble * o = static_cast<const Bubble *>(object);
+        writePoint(o->center);
+        writeValue<double>(o->radius);
+    } else if (type == "cone") {
+        const Cone * o = static_cast<const Cone *>(object);
+        writePoint(o->p0);
+        writePoint(o->p1);
+        writeValue<double>(o->r0);
+        writeValue<double>(o->r1);
+    } else if (type == "cup") {
+        const Cup * o = static_cast<const Cup *>(object);
+        writePoint(o->p0);
+        writePoint(o->p1);
+        writeValue<double>(o->r0);
+        writeValue<double>(o->r1);
+    } else if (type == "cylinder") {
+        const Cylinder * o = static_cast<const Cylinder *>(object);
+        writePoint(o->p0);
+        writePoint(o->p1);
+        writeValue<double>(o->radius);
+    } else if (type == "polygon") {
+        const Face * o = static_cast<const Face *>(object);
+        writePolygon(o->polygon);
+    } else if (type == "ring") {
+        const Ring * o = static_cast<const Ring *>(object);
+        writePoint(o->center);
+        writeVector(o->direction);
+        writeValue<double>(o->r0);
+        writeValue<double>(o->r1);
+    } else if (type == "source") {
+        const Source * o = static_cast<const Source *>(object);
+        writeVector(o->direction);
+        writeValue<double>(o->angle);
+    } else if (type == "sphere") {
+        const Sphere * o = static_cast<const Sphere *>(object);
+        writePoint(o->center);
+        writeValue<double>(o->radius);
+    } else if (type == "tube") {
+        const Tube * o = static_cast<const Tube *>(object);
+        writePoint(o->p0);
+        writePoint(o->p1);
+        writeValue<double>(o->radius);
+    } else {
+        FATAL(errmsg, "Unknown Otype '" + type + "' in object called '" + object->getName() + "' when writing a snapshot");
+        return false;
+    }
+    
+    return true;
+}
+
+bool SnapshotWriter::writeLayer(const Layer * layer)
+{
+    const std::vector<Otype *> * objects = layer->getObjectsRef();
+    writeValue<uint32_t>((uint32_t)objects->size());
+    for (auto object : *objects) {
+        if (!writeOtype(object))
+            return false;
+    }
+    
+    const std::vector<ComponentInstance *> * instances = layer->getComponentInstancesRef();
+    writeValue<uint32_t>((uint32_t)instances->size());
+    for (auto instance : *instances) {
+        auto found = definitionIndices.find(instance->getDefinitionRef());
+        writeValue<int32_t>(found == definitionIndices.end() ? EMP_SNAPSHOT_NONE : found->second);
+        writeXYZ(instance->getX(), instance->getY(), instance->getZ());
+        writeXYZ(instance->getRotationX(), instance->getRotationY(), instance->getRotationZ());
+        writeValue<double>(instance->getScale());
+    }
+    
+    return true;
+}
+
+bool SnapshotWriter::write(std::string filename)
+{
+    buffer.clear();
+    materialIndices.clear();
+    definitionIndices.clear();
+    
+    // Header
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, EMP_SNAPSHOT_MAGIC, EMP_SNAPSHOT_MAGIC_SIZE);
+    header.version = EMP_SNAPSHOT_VERSION;
+    header.byteOrder = EMP_SNAPSHOT_BYTE_ORDER;
+    buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    
+    // Model info
+    writeValue<float>(model->getNorthCorrection());
+    Date * date = model->getDate();
+    writeValue<int32_t>(date->getMonth());
+    writeValue<int32_t>(date->getDay());
+    writeValue<int32_t>(date->getHour());
+    writeValue<int32_t>(date->getMinute());
+    
+    Location * location = model->getLocation();
+    writeValue<float>(location->getLatitude());
+    writeValue<float>(location->getLongitude());
+    writeValue<float>(location->getTimeZone());
+    writeString(location->getCity());
+    writeString(location->getCountry());
+    writeValue<float>(location->getAlbedo());
+    writeValue<float>(location->getElevation());
+    writeValue<uint8_t>(location->hasWeather() ? 1 : 0);
+    size_t weatherSize = location->getWeatherSize();
+    writeValue<uint32_t>((uint32_t)weatherSize);
+    for (size_t i = 0; i < weatherSize; i++) {
+        const HourlyData * data = location->getHourlyData(i);
+        writeValue<int32_t>(data->month);
+        writeValue<int32_t>(data->day);
+        writeValue<float>(data->hour);
+        writeValue<float>(data->diffuse_horizontal);
+        writeValue<float>(data->direct_normal);
+    }
+    
+    // RTraceOptions, as JSON
+    RTraceOptions * options = model->getRTraceOptions();
+    json jOptions = json({});
+    for (auto it = options->begin(); it != options->end(); ++it)
+        jOptions[it.key()] = it.value();
+    writeString(jOptions.dump());
+    
+    // Materials
+    size_t nMaterials = model->getNumMaterials();
+    writeValue<uint32_t>((uint32_t)nMaterials);
+    for (size_t i = 0; i < nMaterials; i++) {
+        const Material * material = model->getMaterialRef(i);
+        materialIndices[material] = (int32_t)i;
+        if (!writeMaterial(material))
+            return false;
+    }
+    
+    // Component definitions... names first, so instances can reference any of them
+    size_t nDefinitions = model->getNumComponentDefinitions();
+    writeValue<uint32_t>((uint32_t)nDefinitions);
+    for (size_t i = 0; i < nDefinitions; i++) {
+        const ComponentDefinition * definition = model->getComponentDefinitionRef(i);
+        definitionIndices[definition] = (int32_t)i;
+        writeString(definition->getName());
+    }
+    for (size_t i = 0; i < nDefinitions; i++) {
+        if (!writeLayer(model->getComponentDefinitionRef(i)))
+            return false;
+    }
+    
+    // Layers
+    size_t nLayers = model->getNumLayers();
+    writeValue<uint32_t>((uint32_t)nLayers);
+    for (size_t i = 0; i < nLayers; i++) {
+        const Layer * layer = model->getLayerRef(i);
+        writeString(layer->getName());
+        if (!writeLayer(layer))
+            return false;
+    }
+    
+    // Workplanes
+    size_t nWorkplanes = model->getNumWorkplanes();
+    writeValue<uint32_t>((uint32_t)nWorkplanes);
+    for (size_t i = 0; i < nWorkplanes; i++) {
+        const Workplane * workplane = model->getWorkplaneRef(i);
+        writeString(workplane->getName());
+        writeValue<double>(workplane->getMaxArea());
+        writeValue<double>(workplane->getMaxAspectRatio());
+        writeValue<double>(workplane->getGridSpacing());
+        writeValue<double>(workplane->getRefinementThreshold());
+        
+        const std::vector<std::string> * tasks = workplane->getTasks();
+        writeValue<uint32_t>((uint32_t)tasks->size());
+        for (auto & task : *tasks)
+            writeString(task);
+        
+        size_t nPolygons = workplane->getNumPolygons();
+        writeValue<uint32_t>((uint32_t)nPolygons);
+        for (size_t j = 0; j < nPolygons; j++)
+            writePolygon(workplane->getPolygonRef(j));
+    }
+    
+    // Window groups
+    size_t nWindowGroups = model->getNumWindowGroups();
+    writeValue<uint32_t>((uint32_t)nWindowGroups);
+    for (size_t i = 0; i < nWindowGroups; i++) {
+        WindowGroup * group = model->getWindowGroupRef(i);
+        writeString(group->getName());
+        size_t nWindows = group->size();
+        writeValue<uint32_t>((uint32_t)nWindows);
+        for (size_t j = 0; j < nWindows; j++) {
+            if (!writeOtype(group->getWindowRef(j)))
+                return false;
+        }
+    }
+    
+    // Illum groups
+    size_t nIllumGroups = model->getNumIllumGroups();
+    writeValue<uint32_t>((uint32_t)nIllumGroups);
+    for (size_t i = 0; i < nIllumGroups; i++) {
+        IllumGroup * group = model->getIllumGroupRef(i);
+        writeString(group->getName());
+        size_t nPolygons = group->size();
+        writeValue<uint32_t>((uint32_t)nPolygons);
+        for (size_t j = 0; j < nPolygons; j++)
+            writePolygon(group->getPolygonRef(j));
+    }
+    
+    // Views
+    size_t nViews = model->getNumViews();
+    writeValue<uint32_t>((uint32_t)nViews);
+    for (size_t i = 0; i < nViews; i++) {
+        const View * view = model->getViewRef(i);
+        writeString(view->name);
+        writePoint(view->viewPoint);
+        writeVector(view->viewDirection);
+        writeVector(view->viewUp);
+        writeValue<double>(view->viewHorizontal);
+        writeValue<double>(view->viewVertical);
+        writeValue<int32_t>(view->viewType);
+        writeValue<double>(view->foreClippingDistance);
+        writeValue<double>(view->aftClippingDistance);
+    }
+    
+    // Photosensors
+    size_t nPhotosensors = model->countPhotosensors();
+    writeValue<uint32_t>((uint32_t)nPhotosensors);
+    for (size_t i = 0; i < nPhotosensors; i++) {
+        Photosensor * photosensor = model->getPhotosensorRef(i);
+        writeString(photosensor->getName());
+        Point3D position = photosensor->getPosition();
+        Vector3D direction = photosensor->getDirection();
+        writePoint(position);
+        writeVector(direction);
+    }
+    
+    // Tasks, as JSON
+    size_t nTasks = model->countTasks();
+    writeValue<uint32_t>((uint32_t)nTasks);
+    for (size_t i = 0; i < nTasks; i++)
+        writeString(model->getTask(i)->dump());
+    
+    // Write it all at once
+    FOPEN(file, &filename[0], "wb");
+    if (file == NULL) {
+        WARN(wMsg, "Impossible to write snapshot file '" + filename + "'");
+        return false;
+    }
+    bool success = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    fclose(file);
+    
+    buffer.clear();
+    return success;
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+	Emp
+
+    Copyright (C) 2018  German Molina (germolinal@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#ifndef SNAPSHOT_WRITER_H
+#define SNAPSHOT_WRITER_H
+
+#include <map>
+
+#include "../../emp_model/emp_model.h"
+#include "../../emp_model/src/snapshotformat.h"
+
+//! Writes a EmpModel as a binary snapshot, to be loaded by a SnapshotReader
+/*!
+ The snapshot is a versioned binary copy of the whole model (see 
+ snapshotformat.h), meant to avoid parsing the original model (e.g. a 
+ SketchUp file) every time it is simulated.
+ 
+ The whole snapshot is built in memory and written at once.
+ */
+class SnapshotWriter {
+private:
+    EmpModel * model; //!< The EmpModel to write
+    std::string buffer = std::string(); //!< The snapshot being written
+    std::map<const Material *, int32_t> materialIndices = std::map<const Material *, int32_t>(); //!< The index of each Material in the model
+    std::map<const ComponentDefinition *, int32_t> definitionIndices = std::map<const ComponentDefinition *, int32_t>(); //!< The index of each ComponentDefinition in the model
+    
+    //! Appends the bytes of a value to the buffer
+    /*!
+     @author German Molina
+     @param[in] value The value
+     */
+    template<typename T>
+    void writeValue(const T value)
+    {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    
+    //! Appends a string (length and characters) to the buffer
+    /*!
+     @author German Molina
+     @param[in] s The string
+     */
+    void writeString(const std::string & s);
+    
+    //! Appends the coordinates of a Point3D (or Vector3D) to the buffer
+    /*!
+     @author German Molina
+     @param[in] x The X component
+     @param[in] y The Y component
+     @param[in] z The Z component
+     */
+    void writeXYZ(double x, double y, double z);
+    
+    //! Appends a Point3D to the buffer
+    /*!
+     @author German Molina
+     @param[in] p The Point3D
+     */
+    void writePoint(Point3D p);
+    
+    //! Appends a Vector3D to the buffer
+    /*!
+     @author German Molina
+     @param[in] v The Vector3D
+     */
+    void writeVector(Vector3D v);
+    
+    //! Appends a Polygon3D to the buffer
+    /*!
+     The normal and area are followed by the number of loops, the number
+     of vertices of each loop and a flat array with all the coordinates.
+     Removed (i.e. NULL) vertices are skipped.
+     
+     @author German Molina
+     @param[in] polygon The Polygon3D
+     */
+    void writePolygon(Polygon3D * polygon);
+    
+    //! Appends a Material to the buffer
+    /*!
+     @author German Molina
+     @param[in] material The Material
+     @return success
+     */
+    bool writeMaterial(const Material * material);
+    
+    //! Appends an Otype to the buffer
+    /*!
+     @author German Molina
+     @param[in] object The Otype
+     @return success
+     */
+    bool writeOtype(const Otype * object);
+    
+    //! Appends the objects and ComponentInstance of a Layer (or ComponentDefinition) to the buffer
+    /*!
+     @author German Molina
+     @param[in] layer The Layer
+     @return success
+     */
+    bool writeLayer(const Layer * layer);
+    
+public:
+    
+    //! Constructor
+    /*!
+     @author German Molina
+     @param[in] model The EmpModel to write
+     */
+    SnapshotWriter(EmpModel * model);
+    
+    //! Writes the snapshot of the model
+    /*!
+     @author German Molina
+     @param[in] filename The name of the file to write
+     @return success
+     */
+    bool write(std::string filename);
+};
+
+#endif
@@ -20,10 +20,10 @@ TEST(FourCM, UnitDirectSkyLightSources)
     
     FVECT origin = {0,0,0};
     FVECT dir = {0,0,1};
-    std::vector<RAY> rays = std::vector<RAY>(1);
+    SensorSet rays = SensorSet(1);
     
-    VCOPY(rays.at(0).rorg, origin);
-    VCOPY(rays.at(0).rdir, dir);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
     
     // Create options
     RTraceOptions options = RTraceOptions();
@@ -56,10 +56,10 @@ TEST(FourCM, DirectSkyMatrix)
     
     FVECT origin = {0,0,0};
     FVECT dir = {0,0,1};
-    std::vector<RAY> rays = std::vector<RAY>(1);
+    SensorSet rays = SensorSet(1);
     
-    VCOPY(rays.at(0).rorg, origin);
-    VCOPY(rays.at(0).rdir, dir);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
     
     // Create options
     RTraceOptions options = RTraceOptions();
@@ -166,7 +166,7 @@ const double simpleReference[48][5] = {
     {0,0,0,0}
 };
 
-std::vector<RAY> rays = std::vector<RAY>(1);
+SensorSet rays = SensorSet(1);
 
 
 
@@ -242,8 +242,8 @@ for(int i=0; i<48; i++){
 // Create rays... at the origin, pointing up
 FVECT origin = {0,0,0};
 FVECT dir = {0,0,1};
-VCOPY(rays.at(0).rorg, origin);
-VCOPY(rays.at(0).rdir, dir);
+rays.setOrigin(0, origin[0], origin[1], origin[2]);
+rays.setDirection(0, dir[0], dir[1], dir[2]);
 
 
 
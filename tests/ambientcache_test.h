@@ -0,0 +1,133 @@
+/* ambientcache_test.h */
+
+#include "../include/emp_core.h"
+#include "../src/calculations/ambient_cache.h"
+#include "../src/calculations/gencumulativesky.h"
+
+TEST(AmbientCacheTest, keys)
+{
+    RTraceOptions options = RTraceOptions();
+    const uint64_t key = AmbientCache::getKey(1, &options);
+    
+    // Same octree and options
+    RTraceOptions same = RTraceOptions();
+    ASSERT_EQ(key, AmbientCache::getKey(1, &same));
+    
+    // Other octree
+    ASSERT_NE(key, AmbientCache::getKey(2, &options));
+    
+    // The ambient options matter
+    RTraceOptions moreBounces = RTraceOptions();
+    moreBounces.setOption("ab", 3);
+    ASSERT_NE(key, AmbientCache::getKey(1, &moreBounces));
+    
+    RTraceOptions moreDivisions = RTraceOptions();
+    moreDivisions.setOption("ad", 4096);
+    ASSERT_NE(key, AmbientCache::getKey(1, &moreDivisions));
+    
+    RTraceOptions weighted = RTraceOptions();
+    weighted.setOption("aw", 64);
+    ASSERT_NE(key, AmbientCache::getKey(1, &weighted));
+    
+    // The others do not
+    RTraceOptions otherDirect = RTraceOptions();
+    otherDirect.setOption("dt", 0.5);
+    ASSERT_EQ(key, AmbientCache::getKey(1, &otherDirect));
+}
+
+TEST_F(CacheTest, getAmbientFile)
+{
+    AmbientCache cache = AmbientCache(dir, 0, 0);
+    ASSERT_TRUE(cache.isEnabled());
+    
+    RTraceOptions options = RTraceOptions();
+    OctreeCache::setOctreeKey("ambient_test.oct", 777);
+    
+    std::string amb;
+    ASSERT_TRUE(cache.getAmbientFile("ambient_test.oct", &options, &amb));
+    ASSERT_EQ(amb, cache.getFileName(AmbientCache::getKey(777, &options)));
+    
+    // The same file is used every time
+    std::string again;
+    ASSERT_TRUE(cache.getAmbientFile("ambient_test.oct", &options, &again));
+    ASSERT_EQ(amb, again);
+    
+    // Octrees that cannot be read have no ambient file
+    ASSERT_FALSE(cache.getAmbientFile("not_an_ambient_test.oct", &options, &amb));
+    
+    // Disabled cache
+    AmbientCache disabled = AmbientCache("", 0, 0);
+    ASSERT_FALSE(disabled.isEnabled());
+    ASSERT_FALSE(disabled.getAmbientFile("ambient_test.oct", &options, &amb));
+}
+
+TEST_F(CacheTest, ambientDependencies)
+{
+    AmbientCache cache = AmbientCache(dir, 0, 0);
+    createdir(dir);
+    
+    RTraceOptions options = RTraceOptions();
+    OctreeCache::setOctreeKey("ambient_sky.oct", 555);
+    
+    // The octree only references the sky by name
+    std::string calFile = dir + "/annual_solar_irradiance.cal";
+    std::vector<std::string> skyFiles = {calFile};
+    
+    EmpModel santiago = EmpModel();
+    santiago.getLocation()->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+    genCumulativeSky(&santiago, false, true, calFile);
+    
+    std::string santiagoAmb;
+    ASSERT_TRUE(cache.getAmbientFile("ambient_sky.oct", &options, &santiagoAmb, &skyFiles));
+    ASSERT_NE(santiagoAmb, cache.getFileName(AmbientCache::getKey(555, &options)));
+    
+    std::string again;
+    ASSERT_TRUE(cache.getAmbientFile("ambient_sky.oct", &options, &again, &skyFiles));
+    ASSERT_EQ(santiagoAmb, again);
+    
+    // Another weather file... a cache miss
+    EmpModel oslo = EmpModel();
+    oslo.getLocation()->fillWeatherFromEPWFile("../../tests/weather/Oslo.epw");
+    genCumulativeSky(&oslo, false, true, calFile);
+    
+    std::string osloAmb;
+    ASSERT_TRUE(cache.getAmbientFile("ambient_sky.oct", &options, &osloAmb, &skyFiles));
+    ASSERT_NE(santiagoAmb, osloAmb);
+    
+    // No cache if the sky cannot be read
+    remove(&calFile[0]);
+    ASSERT_FALSE(cache.getAmbientFile("ambient_sky.oct", &options, &osloAmb, &skyFiles));
+    
+    OctreeCache::clearOctreeKey("ambient_sky.oct");
+}
+
+TEST_F(CacheTest, ambientEvict)
+{
+    // Room for two ambient files
+    AmbientCache cache = AmbientCache(dir, 250, 0);
+    createdir(dir);
+    
+    for(uint64_t key = 1; key <= 3; key++){
+        std::string entry = cache.getFileName(key);
+        FILE * file = fopen(&entry[0], "wb");
+        for(size_t i = 0; i < 100; i++)
+            fputc('a', file);
+        fclose(file);
+        
+        // Make sure the modification times differ
+        struct utimbuf times;
+        times.actime = times.modtime = (time_t)(1000 * key);
+        utime(&entry[0], &times);
+    }
+    
+    // Octrees in the same directory are not touched
+    OctreeCache octrees = OctreeCache(dir, 0);
+    writeFakeOctree("ambient_evict.oct", 100, 'b');
+    ASSERT_TRUE(octrees.store(9, "ambient_evict.oct"));
+    remove("ambient_evict.oct");
+    
+    ASSERT_EQ(cache.evict(), 1);
+    ASSERT_FALSE(fexists(cache.getFileName(1)));
+    ASSERT_TRUE(fexists(cache.getFileName(3)));
+    ASSERT_TRUE(fexists(octrees.getFileName(9)));
+}
@@ -1,15 +1,163 @@
 
 #include "../include/emp_core.h"
+#include "../src/calculations/reinhart.h"
+#include "../src/calculations/GenCumSky/cPerezSkyModel.h"
+
+//! Integrates a cumulative sky over a horizontal surface
+static double horizontalCumulativeSky(const std::vector<double> * sky, int mf)
+{
+    double ret = 0;
+    for (size_t i = 1; i < sky->size(); i++) {
+        double solidAngle;
+        Vector3D dir = reinhartCenterDir(i, mf, &solidAngle);
+        ret += (*sky)[i] * solidAngle * dir.getZ();
+    }
+    return ret;
+}
 
 
 TEST(GenCumulativeSkyTest, test1) {
-    
+
 
     EmpModel model = EmpModel();
     Location * l = model.getLocation();
     l->fillWeatherFromEPWFile("../../tests/weather/Oslo.epw");
     genCumulativeSky(&model,false,true,"cumulative.cal");
-    
-	ASSERT_TRUE(false);
 
+    ASSERT_TRUE(fexists("cumulative.cal"));
+    remove("cumulative.cal");
+
+}
+
+TEST(GenCumulativeSkyTest, diffuseMatchesWeather) {
+
+    EmpModel model = EmpModel();
+    Location * l = model.getLocation();
+    l->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+
+    // Total diffuse horizontal irradiation
+    double expected = 0;
+    for (size_t i = 0; i < l->getWeatherSize(); i++)
+        expected += l->getHourlyData(i)->diffuse_horizontal;
+
+    for (int mf = 1; mf <= 4; mf++) {
+        std::vector<double> sky = std::vector<double>();
+        calcCumulativeSky(l, false, true, false, mf, &sky);
+
+        ASSERT_EQ(sky.size(), nReinhartBins(mf));
+        ASSERT_EQ(sky[0], 0.0);
+
+        // Every hour of the sky integrates its diffuse horizontal
+        // irradiance (except for the few hours without sun)
+        const double found = horizontalCumulativeSky(&sky, mf);
+        ASSERT_NEAR(found, expected, 0.01*expected);
+    }
+}
+
+TEST(GenCumulativeSkyTest, sunAddsDirect) {
+
+    EmpModel model = EmpModel();
+    Location * l = model.getLocation();
+    l->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+
+    std::vector<double> diffuse = std::vector<double>();
+    std::vector<double> direct = std::vector<double>();
+    std::vector<double> both = std::vector<double>();
+    calcCumulativeSky(l, false, true, false, 1, &diffuse);
+    calcCumulativeSky(l, false, false, true, 1, &direct);
+    calcCumulativeSky(l, false, true, true, 1, &both);
+
+    for (size_t i = 0; i < both.size(); i++)
+        ASSERT_NEAR(both[i], diffuse[i] + direct[i], 1e-6*(1 + both[i]));
+
+    ASSERT_GT(horizontalCumulativeSky(&direct, 1), 0);
+}
+
+TEST(GenCumulativeSkyTest, deterministic) {
+
+    EmpModel model = EmpModel();
+    Location * l = model.getLocation();
+    l->fillWeatherFromEPWFile("../../tests/weather/Oslo.epw");
+
+    std::vector<double> a = std::vector<double>();
+    std::vector<double> b = std::vector<double>();
+    calcCumulativeSky(l, true, true, true, 2, &a);
+    calcCumulativeSky(l, true, true, true, 2, &b);
+
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++)
+        ASSERT_EQ(a[i], b[i]);
+}
+
+TEST(GenCumulativeSkyTest, exposureThroughDC) {
+
+    EmpModel model = EmpModel();
+    Location * l = model.getLocation();
+    l->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+
+    const int mf = 2;
+    std::vector<double> sky = std::vector<double>();
+    calcCumulativeSky(l, false, true, true, mf, &sky);
+
+    // An unobstructed, horizontal sensor sees each patch
+    // according to its solid angle and cosine
+    const size_t nbins = nReinhartBins(mf);
+    ColorMatrix DC = ColorMatrix(1, nbins);
+    for (size_t bin = 1; bin < nbins; bin++) {
+        double solidAngle;
+        Vector3D dir = reinhartCenterDir(bin, mf, &solidAngle);
+        const float v = (float)(solidAngle * dir.getZ());
+        DC.r()->setElement(0, bin, v);
+        DC.g()->setElement(0, bin, v);
+        DC.b()->setElement(0, bin, v);
+    }
+
+    Matrix result = Matrix();
+    ASSERT_TRUE(cumulativeSkyExposure(&DC, &sky, &result));
+    ASSERT_EQ(result.nrows(), 1);
+
+    const double expected = horizontalCumulativeSky(&sky, mf);
+    ASSERT_NEAR(result.getElement(0, 0), expected, 1e-3*expected);
+
+    // Wrong sizes
+    ColorMatrix wrongDC = ColorMatrix(1, nbins - 1);
+    ASSERT_FALSE(cumulativeSkyExposure(&wrongDC, &sky, &result));
+}
+
+TEST(GenCumulativeSkyTest, relativeLuminancesMatchPerPatch) {
+
+    // Patches all over the sky
+    std::vector<double> alt, az, sinAlt, cosAlt, sinAz, cosAz;
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 24; j++) {
+            alt.push_back((i + 0.5) * M_PI / 16);
+            az.push_back(j * M_PI / 12);
+            sinAlt.push_back(sin(alt.back()));
+            cosAlt.push_back(cos(alt.back()));
+            sinAz.push_back(sin(az.back()));
+            cosAz.push_back(cos(az.back()));
+        }
+    }
+    const int nPatches = (int)alt.size();
+    std::vector<double> lv = std::vector<double>(nPatches);
+
+    cSun sun = cSun(-33.4 * M_PI / 180);
+    cPerezSkyModel skyModel = cPerezSkyModel();
+    for (int day : {15, 172, 300}) {
+        ASSERT_TRUE(sun.SetDay(day));
+        for (double hourAngle : {2.0, 2.8, M_PI, 4.0}) {
+            ASSERT_TRUE(sun.SetHourAngle(hourAngle));
+            for (double Ibh : {0.0, 150.0, 600.0}) {
+                if (!skyModel.SetSkyConditions(120, Ibh, &sun))
+                    continue;
+                ASSERT_TRUE(skyModel.GetRelativeLuminances(nPatches, &sinAlt[0], &cosAlt[0], &sinAz[0], &cosAz[0], &lv[0]));
+
+                // Against the original, one patch at a time
+                for (int i = 0; i < nPatches; i++) {
+                    const double expected = skyModel.GetRelativeLuminance(alt[i], az[i]);
+                    ASSERT_NEAR(lv[i], expected, 1e-6 * expected + 1e-9);
+                }
+            }
+        }
+    }
 }
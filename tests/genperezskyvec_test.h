@@ -382,3 +382,57 @@ TEST(GenPerezSkyVec, FullSkySharpSun)
         }
     }
 }
+
+
+// genPerezSkyVector() evaluates one timestep through GenDayMtx::ComputeSky(),
+// patch by patch (as gendaymtx does), while genPerezSkyMatrix() evaluates the
+// patches of all the timesteps at once. The only other difference is that the
+// interpolated weather stores the position of the sun in single precision.
+TEST(GenPerezSkyVec, BatchMatchesSingleTimestep)
+{
+    Location location = Location();
+    ASSERT_NO_THROW(location.fillWeatherFromEPWFile( "../../tests/weather/Santiago.epw") );
+    
+    const float albedo = 0.2f;
+    const float rotation = 23.0f;
+    const float meridian = location.getTimeZone()*(-15.0f);
+    std::shared_ptr<const InterpolatedWeather> sharedWeather = location.getInterpolatedWeather(2);
+    const InterpolatedWeather * weather = sharedWeather.get();
+    
+    for(int mf = 1; mf <= 2; mf++){
+        for(int sunOnly = 0; sunOnly < 2; sunOnly++){
+            for(int sharpSun = 0; sharpSun < 2; sharpSun++){
+                
+                // Summer and winter days
+                for(size_t firstStep : {24*2*10, 24*2*180}){
+                    const size_t nSteps = 24*2;
+                    size_t nbins = nReinhartBins(mf);
+                    
+                    ColorMatrix skies = ColorMatrix(nbins,nSteps);
+                    std::vector<int> sharpPatches = std::vector<int>();
+                    genPerezSkyMatrix(weather, firstStep, nSteps, albedo, mf, sunOnly, sharpSun, rotation, &skies, &sharpPatches);
+                    ASSERT_EQ(sharpPatches.size(), nSteps);
+                    
+                    for(size_t col = 0; col < nSteps; col++){
+                        const size_t nstep = firstStep + col;
+                        ColorMatrix skyVec = ColorMatrix(nbins,1);
+                        int sharpPatch = genPerezSkyVector(weather->month[nstep], weather->day[nstep], weather->hour[nstep], weather->direct_normal[nstep], weather->diffuse_horizontal[nstep], albedo, location.getLatitude(), location.getLongitude(), meridian, mf, sunOnly, sharpSun, rotation, &skyVec);
+                        
+                        if(sharpSun && sunOnly)
+                            ASSERT_EQ(sharpPatch, sharpPatches[col]);
+                        
+                        for(size_t bin = 0; bin < nbins; bin++){
+                            float single = skyVec.redChannel()->getElement(bin,0);
+                            float batch = skies.redChannel()->getElement(bin,col);
+                            ASSERT_NEAR(single, batch, 1e-2*single + 1e-5);
+                            
+                            single = skyVec.blueChannel()->getElement(bin,0);
+                            batch = skies.blueChannel()->getElement(bin,col);
+                            ASSERT_NEAR(single, batch, 1e-2*single + 1e-5);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,180 @@
+/* geometryoptimization_test.h */
+
+#include "../include/emp_core.h"
+
+//! Adds an axis aligned rectangle (on the XY plane) to a Layer
+static void addRectangle(EmpModel * model, std::string layerName, Material * material, double x0, double y0, double x1, double y1)
+{
+    Polygon3D * p = new Polygon3D();
+    Loop * outerLoop = p->getOuterLoopRef();
+    outerLoop->addVertex(new Point3D(x0,y0,0));
+    outerLoop->addVertex(new Point3D(x1,y0,0));
+    outerLoop->addVertex(new Point3D(x1,y1,0));
+    outerLoop->addVertex(new Point3D(x0,y1,0));
+    p->setNormal(Vector3D(0,0,1));
+    
+    std::string faceName = "face";
+    Face * face = new Face(&faceName);
+    face->setPolygon(p);
+    face->setMaterial(material);
+    model->addObjectToLayer(&layerName, face);
+}
+
+TEST(GeometryOptimizationTest, cleanAndMerge)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    Material * glass = model.addDefaultGlass();
+    
+    // A row of three squares... becomes one rectangle
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    addRectangle(&model, layerName, material, 1, 0, 2, 1);
+    addRectangle(&model, layerName, material, 2, 0, 3, 1);
+    
+    // A duplicate
+    addRectangle(&model, layerName, material, 1, 0, 2, 1);
+    
+    // A sliver
+    addRectangle(&model, layerName, material, 0, 5, 1, 5 + 1e-9);
+    
+    // A neighbor with another material
+    addRectangle(&model, layerName, glass, 3, 0, 4, 1);
+    
+    GeometryReport report = GeometryReport();
+    model.optimizeGeometry(EMP_GEOMETRY_TOLERANCE, &report);
+    
+    ASSERT_EQ(report.objectsBefore, 6);
+    ASSERT_EQ(report.objectsAfter, 2);
+    ASSERT_EQ(report.verticesBefore, 24);
+    ASSERT_EQ(report.verticesAfter, 8);
+    ASSERT_EQ(report.degenerateFaces, 1);
+    ASSERT_EQ(report.duplicateFaces, 1);
+    ASSERT_EQ(report.mergedFaces, 2);
+    
+    Layer * layer = model.getLayerRef(0);
+    ASSERT_EQ(layer->getObjectsRef()->size(), 2);
+    
+    // The merged face covers the three squares
+    const Face * merged = dynamic_cast<const Face *>(layer->getObjectRef(0));
+    ASSERT_NEAR(merged->polygon->getArea(), 3, 1e-9);
+    ASSERT_TRUE(merged->polygon->testPoint(Point3D(2.5, 0.5, 0)));
+    ASSERT_FALSE(merged->polygon->testPoint(Point3D(3.5, 0.5, 0)));
+    
+    // Nothing else to do
+    GeometryReport again = GeometryReport();
+    model.optimizeGeometry(EMP_GEOMETRY_TOLERANCE, &again);
+    ASSERT_EQ(again.objectsAfter, 2);
+    ASSERT_EQ(again.mergedFaces, 0);
+}
+
+TEST(GeometryOptimizationTest, keepsNonCoplanar)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    
+    // Two faces of a box, sharing an edge
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    
+    Polygon3D * p = new Polygon3D();
+    Loop * outerLoop = p->getOuterLoopRef();
+    outerLoop->addVertex(new Point3D(1,0,0));
+    outerLoop->addVertex(new Point3D(0,0,0));
+    outerLoop->addVertex(new Point3D(0,0,1));
+    outerLoop->addVertex(new Point3D(1,0,1));
+    std::string faceName = "side";
+    Face * face = new Face(&faceName);
+    face->setPolygon(p);
+    face->setMaterial(material);
+    model.addObjectToLayer(&layerName, face);
+    
+    GeometryReport report = GeometryReport();
+    model.optimizeGeometry(EMP_GEOMETRY_TOLERANCE, &report);
+    
+    ASSERT_EQ(report.objectsAfter, 2);
+    ASSERT_EQ(report.mergedFaces, 0);
+}
+
+TEST(GeometryOptimizationTest, keepsBackToBack)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    
+    // Both sides of a thin partition
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    
+    Polygon3D * p = new Polygon3D();
+    Loop * outerLoop = p->getOuterLoopRef();
+    outerLoop->addVertex(new Point3D(0,0,0));
+    outerLoop->addVertex(new Point3D(0,1,0));
+    outerLoop->addVertex(new Point3D(1,1,0));
+    outerLoop->addVertex(new Point3D(1,0,0));
+    p->setNormal(Vector3D(0,0,-1));
+    std::string faceName = "back";
+    Face * face = new Face(&faceName);
+    face->setPolygon(p);
+    face->setMaterial(material);
+    model.addObjectToLayer(&layerName, face);
+    
+    // ... and a real duplicate of the front
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    
+    GeometryReport report = GeometryReport();
+    model.optimizeGeometry(EMP_GEOMETRY_TOLERANCE, &report);
+    
+    ASSERT_EQ(report.duplicateFaces, 1);
+    ASSERT_EQ(report.mergedFaces, 0);
+    ASSERT_EQ(report.objectsAfter, 2);
+}
+
+TEST(GeometryOptimizationTest, throughOconvTask)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    addRectangle(&model, layerName, material, 1, 0, 2, 1);
+    
+    OconvOptions options = OconvOptions();
+    ASSERT_FALSE(options.getOption<bool>(OCONV_OPTIMIZE_GEOMETRY));
+    
+    // Without the option, nothing changes
+    OconvTask plain = OconvTask(&model, &options);
+    ASSERT_TRUE(plain.prepare());
+    ASSERT_FALSE(model.isGeometryOptimized());
+    
+    // The task optimizes the model before the task graph is solved
+    options.setOption(OCONV_OPTIMIZE_GEOMETRY, true);
+    OconvTask task = OconvTask(&model, &options);
+    ASSERT_NE(task.getName(), plain.getName());
+    ASSERT_TRUE(task.prepare());
+    
+    ASSERT_TRUE(model.isGeometryOptimized());
+    ASSERT_EQ(model.getLayerRef(0)->getObjectsRef()->size(), 1);
+    
+    // ... only once
+    GeometryReport report = GeometryReport();
+    ASSERT_FALSE(optimizeModelGeometry(&model, &report, false));
+    ASSERT_EQ(report.objectsBefore, 0);
+}
+
+TEST(GeometryOptimizationTest, measureOnlyWhenAsked)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    addRectangle(&model, layerName, material, 0, 0, 1, 1);
+    
+    GeometryReport report = GeometryReport();
+    ASSERT_TRUE(optimizeModelGeometry(&model, &report, false));
+    ASSERT_EQ(report.objectsAfter, 1);
+    ASSERT_EQ(report.oconvSecondsBefore, -1);
+    ASSERT_EQ(report.oconvSeconds, -1);
+}
@@ -240,3 +240,87 @@ TEST(LocationTest, getDataByDate) {
 	
 }
 
+
+TEST(LocationTest, getInterpolatedWeather) {
+    
+    Location l = Location();
+    l.setLatitude(latitude);
+    l.setLongitude(longitude);
+    l.setTimeZone(time_zone);
+    l.markWeatherAsFilled();
+    
+    // Add some weather
+    for(int i=0; i<48; i++){
+        HourlyData h = HourlyData();
+        h.month = (int)wea[i][0];
+        h.day = (int)wea[i][1];
+        h.hour = (float)wea[i][2];
+        h.direct_normal = (float)wea[i][3];
+        h.diffuse_horizontal= (float)wea[i][4];
+        l.addHourlyData(h);
+    }
+    
+    const int interp = 4;
+    std::shared_ptr<const InterpolatedWeather> table = l.getInterpolatedWeather(interp);
+    ASSERT_EQ(table->getInterp(),interp);
+    ASSERT_EQ(table->size(),(size_t)(48*interp));
+    
+    // Asking again should return the cached table
+    ASSERT_EQ(table,l.getInterpolatedWeather(interp));
+    
+    // Every element should match getInterpolatedData
+    size_t nstep = 0;
+    for(int i=0; i<48; i++){
+        for(int j=0; j<interp; j++){
+            HourlyData d = HourlyData();
+            l.getInterpolatedData(i,(float)j/(float)interp,&d);
+            
+            ASSERT_EQ(table->month[nstep],d.month);
+            ASSERT_EQ(table->day[nstep],d.day);
+            ASSERT_EQ(table->hour[nstep],d.hour);
+            ASSERT_EQ(table->direct_normal[nstep],d.direct_normal);
+            ASSERT_EQ(table->diffuse_horizontal[nstep],d.diffuse_horizontal);
+            ASSERT_EQ((bool)table->isDaytime[nstep], d.diffuse_horizontal > EMP_NIGHT_THRESHOLD);
+            
+            // The sun should be up during the day
+            if(table->isDaytime[nstep] && d.hour > 8 && d.hour < 17)
+                ASSERT_TRUE(table->altitude[nstep] > 0);
+            
+            nstep++;
+        }
+    }
+    
+    // Another scheme gets its own table
+    std::shared_ptr<const InterpolatedWeather> other = l.getInterpolatedWeather(2);
+    ASSERT_EQ(other->getInterp(),2);
+    ASSERT_EQ(table->getInterp(),interp);
+    
+    // Adding data replaces the table, but the old one is still usable
+    l.addHourlyData(HourlyData());
+    std::shared_ptr<const InterpolatedWeather> updated = l.getInterpolatedWeather(interp);
+    ASSERT_NE(table,updated);
+    ASSERT_EQ(updated->size(),(size_t)(49*interp));
+    ASSERT_EQ(table->size(),(size_t)(48*interp));
+}
+
+TEST(LocationTest, getInterpolatedWeatherConcurrently) {
+    
+    Location l = Location();
+    ASSERT_NO_THROW(l.fillWeatherFromEPWFile("../../tests/weather/Santiago.epw"));
+    const size_t weaSize = l.getWeatherSize();
+    
+    // Several studies with different interpolation schemes at once
+    std::vector<char> ok = std::vector<char>(64, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, ok.size(), 1),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                const int interp = 1 + (int)(i % 4);
+                std::shared_ptr<const InterpolatedWeather> table = l.getInterpolatedWeather(interp);
+                ok[i] = table->getInterp() == interp && table->size() == weaSize*interp;
+            }
+        }
+    );
+    
+    for (auto v : ok)
+        ASSERT_TRUE(v);
+}
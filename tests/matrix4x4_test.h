@@ -37,21 +37,20 @@ TEST(Matrix4x4_TEST, Multiplication) {
   b.setElement(3, 1, 23);
 
   // Compare
-  Matrix4x4 * res = a*&b;
+  Matrix4x4 product = a*b;
+  Matrix4x4 * res = &product;
 
   
   for (int i = 0; i < 16; i++) {
     ASSERT_EQ(b.getElement(i), res->getElement(i));
   }
 
-  delete res;
-
   // Change some elements in a
   a.setElement(3, 2, 14);
   a.setElement(3, 3, 14);
   a.setElement(0, 3, -23);
 
-  res = a*&b;
+  product = a*b;
 
   int i = 0;
   ASSERT_EQ(res->getElement(i++), 1);
@@ -75,7 +74,6 @@ TEST(Matrix4x4_TEST, Multiplication) {
   ASSERT_EQ(res->getElement(i++), 322);
   ASSERT_EQ(res->getElement(i++), 14);
   ASSERT_EQ(res->getElement(i++), 14);
-  delete res;
 
   // TEST MULTIPLY THIS
   a.multiplyThis(&b); 
@@ -103,3 +101,36 @@ TEST(Matrix4x4_TEST, Multiplication) {
   ASSERT_EQ(res->getElement(i++), 14);
   ASSERT_EQ(res->getElement(i++), 14);
 }
+
+TEST(Matrix4x4_TEST, transformPoints) {
+
+  // Translate, then rotate 90 degrees around Z
+  Transform t = Transform();
+  Matrix4x4 * m = t.getMatrix();
+  *m = Transform::getTranslationMatrix(1, 2, 3) * Transform::getRotationZMatrix(90);
+
+  double points[6] = { 1, 0, 0,   0, 0, 5 };
+  t.transformPoints(points, points, 2);
+
+  ASSERT_NEAR(points[0], 1, 1e-9);
+  ASSERT_NEAR(points[1], 3, 1e-9);
+  ASSERT_NEAR(points[2], 3, 1e-9);
+  ASSERT_NEAR(points[3], 1, 1e-9);
+  ASSERT_NEAR(points[4], 2, 1e-9);
+  ASSERT_NEAR(points[5], 8, 1e-9);
+
+  // Same as transforming them one by one
+  Point3D p = Point3D(1, 0, 0).transform(&t);
+  ASSERT_NEAR(p.getX(), 1, 1e-9);
+  ASSERT_NEAR(p.getY(), 3, 1e-9);
+  ASSERT_NEAR(p.getZ(), 3, 1e-9);
+
+  // Composing with the parent
+  Transform parent = Transform();
+  *(parent.getMatrix()) = Transform::getScaleMatrix(2);
+  t.preMultiply(&parent);
+  p = Point3D(1, 0, 0).transform(&t);
+  ASSERT_NEAR(p.getX(), 2, 1e-9);
+  ASSERT_NEAR(p.getY(), 6, 1e-9);
+  ASSERT_NEAR(p.getZ(), 6, 1e-9);
+}
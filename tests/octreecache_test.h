@@ -0,0 +1,109 @@
+/* octreecache_test.h */
+
+#include "../include/emp_core.h"
+#include "../src/calculations/octree_cache.h"
+#include <utime.h>
+#include <dirent.h>
+
+//! Writes a fake octree of a certain size
+static void writeFakeOctree(std::string name, size_t size, char c)
+{
+    FILE * file = fopen(&name[0], "wb");
+    for(size_t i = 0; i < size; i++)
+        fputc(c, file);
+    fclose(file);
+}
+
+//! Gives each test its own cache directory, removed (with its contents) afterwards
+class CacheTest : public ::testing::Test {
+protected:
+    std::string dir; //!< The cache directory of the test
+    
+    void SetUp() override
+    {
+        dir = ::testing::TempDir() + "emp_cache_test_" + ::testing::UnitTest::GetInstance()->current_test_info()->name() + "_" + std::to_string(GETPID());
+    }
+    
+    void TearDown() override
+    {
+        DIR * d = opendir(&dir[0]);
+        if(d == nullptr)
+            return;
+        struct dirent * ent;
+        while((ent = readdir(d)) != nullptr){
+            std::string name = std::string(ent->d_name);
+            if(name != "." && name != "..")
+                remove(&(dir + "/" + name)[0]);
+        }
+        closedir(d);
+        remove(&dir[0]);
+    }
+};
+
+TEST_F(CacheTest, octreeStoreAndFetch)
+{
+    OctreeCache cache = OctreeCache(dir, 0);
+    ASSERT_TRUE(cache.isEnabled());
+    
+    writeFakeOctree("cached.oct", 100, 'a');
+    
+    uint64_t key;
+    ASSERT_TRUE(OctreeCache::getOctreeKey("cached.oct", &key));
+    ASSERT_FALSE(cache.fetch(key, "fetched.oct"));
+    ASSERT_TRUE(cache.store(key, "cached.oct"));
+    ASSERT_TRUE(fexists(cache.getFileName(key)));
+    
+    // The task removes its octree... the cache keeps it
+    remove("cached.oct");
+    ASSERT_TRUE(cache.fetch(key, "fetched.oct"));
+    
+    uint64_t fetchedKey;
+    ASSERT_TRUE(OctreeCache::getOctreeKey("fetched.oct", &fetchedKey));
+    ASSERT_EQ(key, fetchedKey);
+    
+    remove("fetched.oct");
+    
+    // Disabled cache
+    OctreeCache disabled = OctreeCache("", 0);
+    ASSERT_FALSE(disabled.isEnabled());
+    ASSERT_FALSE(disabled.fetch(key, "fetched.oct"));
+}
+
+TEST(OctreeCacheTest, registeredKeys)
+{
+    OctreeCache::setOctreeKey("not_a_file.oct", 12345);
+    uint64_t key;
+    ASSERT_TRUE(OctreeCache::getOctreeKey("not_a_file.oct", &key));
+    ASSERT_EQ(key, 12345);
+    
+    // Once cleared, the file is needed again
+    OctreeCache::clearOctreeKey("not_a_file.oct");
+    ASSERT_FALSE(OctreeCache::getOctreeKey("not_a_file.oct", &key));
+    
+    ASSERT_FALSE(OctreeCache::getOctreeKey("neither_a_file.oct", &key));
+}
+
+TEST_F(CacheTest, octreeEvict)
+{
+    // Room for two octrees
+    OctreeCache cache = OctreeCache(dir, 250);
+    
+    for(uint64_t key = 1; key <= 3; key++){
+        writeFakeOctree("evict.oct", 100, (char)key);
+        ASSERT_TRUE(cache.store(key, "evict.oct"));
+        remove("evict.oct");
+        
+        // Make sure the modification times differ
+        std::string entry = cache.getFileName(key);
+        struct utimbuf times;
+        times.actime = times.modtime = (time_t)(1000 * key);
+        utime(&entry[0], &times);
+    }
+    
+    // The first one was the least recently used
+    ASSERT_FALSE(fexists(cache.getFileName(1)));
+    ASSERT_TRUE(fexists(cache.getFileName(3)));
+    
+    // Evicting again does nothing
+    ASSERT_EQ(cache.evict(), 0);
+}
@@ -1,6 +1,7 @@
 
 #include <stdio.h>
 #include <fstream>
+#include <thread>
 
 #include "../include/emp_core.h"
 //#include "calculations/radiance.h"
@@ -26,10 +27,10 @@ TEST(RTraceTest, calcDF)
 
     FVECT origin = {0,0,0};
     FVECT dir = {0,0,1};
-    std::vector<RAY> rays = std::vector<RAY>(1);
+    SensorSet rays = SensorSet(1);
     
-    VCOPY(rays.at(0).rorg, origin);
-    VCOPY(rays.at(0).rdir, dir);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
 
     // Create options
     RTraceOptions options = RTraceOptions();
@@ -49,6 +50,29 @@ TEST(RTraceTest, calcDF)
     
 }
 
+TEST(RContribTest, processes)
+{
+    // The cores are shared by the calls running at once
+    const unsigned int nCores = std::thread::hardware_concurrency();
+    ASSERT_GE(rcontribProcesses(1), 1);
+    ASSERT_GE(rcontribProcesses(0), 1);
+    ASSERT_GE(rcontribProcesses(1000000), 1);
+    if (nCores > 1) {
+        ASSERT_EQ(rcontribProcesses(1), nCores);
+        ASSERT_EQ(rcontribProcesses(2), nCores / 2);
+    }
+    
+#ifndef WIN
+    // Or set explicitly
+    setenv(EMP_RCONTRIB_PROCESSES, "3", 1);
+    ASSERT_EQ(rcontribProcesses(1), 3);
+    ASSERT_EQ(rcontribProcesses(8), 3);
+    setenv(EMP_RCONTRIB_PROCESSES, "0", 1);
+    ASSERT_EQ(rcontribProcesses(1), 1);
+    unsetenv(EMP_RCONTRIB_PROCESSES);
+#endif
+}
+
 
 /*
 #include <chrono>
@@ -104,12 +128,12 @@ TEST(FourCM_SERIAL_BENCHMARK, 4CMvsDDC)
             
             
             // Set sensors
-            std::vector<RAY> rays = std::vector<RAY>(nsensors);
+            SensorSet rays = SensorSet(nsensors);
             for(size_t i=0; i<nsensors; i++){
                 FVECT origin = {static_cast<float>(RANDOM(20.0)),static_cast<float>(RANDOM(20.0)),0.1};
                 FVECT dir = {0,0,1};
-                VCOPY(rays.at(0).rorg, origin);
-                VCOPY(rays.at(0).rdir, dir);
+                rays.setOrigin(0, origin[0], origin[1], origin[2]);
+                rays.setDirection(0, dir[0], dir[1], dir[2]);
             }
             
             
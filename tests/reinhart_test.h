@@ -1,5 +1,6 @@
 
 #include "../include/emp_core.h"
+#include <chrono>
 //#include "../src/common/geometry/segment.h"
 //#include "calculations/reinhart.h"
 
@@ -217,3 +218,137 @@ TEST(ReinhartTest, Rfindrow){
     
 }
 
+
+
+/* The recursive implementation that was replaced by the lookup tables */
+size_t legacyRnaz(size_t r, size_t MF)
+{
+    const size_t tnaz[7] = { 30, 30, 24, 24, 18, 12, 6 };
+    if (r > 7 * MF - 0.5) {
+        return 1;
+    }
+    else {
+        int i = (int)floor((r + 0.5f) / MF);
+        return MF*tnaz[i];
+    }
+}
+
+size_t legacyRaccum(size_t r, size_t MF)
+{
+    if (r - 0.5 > 0) {
+        return legacyRnaz(r - 1, MF) + legacyRaccum(r-1, MF);
+    }
+    else {
+        return 0;
+    }
+}
+
+size_t legacyRfindrow(size_t r, size_t rem, size_t MF)
+{
+    size_t rnazr = legacyRnaz(r, MF);
+    int aux = (int)(rem - rnazr);
+    if (aux > 0.5) {
+        return legacyRfindrow(r + 1, rem - rnazr, MF);
+    }
+    else {
+        return r;
+    }
+}
+
+Vector3D legacyReinhartCenterDir(size_t nbin, size_t MF, double * solidAngle)
+{
+    const double PI_ = 3.141592654;
+    const double alpha = 90.0 / (MF * 7 + 0.5);
+    const double RAH = alpha *PI_ / 180.0;
+    const size_t RowMax = 7 * MF + 1;
+    const size_t Rmax = legacyRaccum(RowMax,MF);
+    
+    size_t Rrow;
+    if (nbin - (Rmax - .5) > 0) {
+        Rrow = RowMax - 1;
+    }
+    else {
+        Rrow = legacyRfindrow(0, nbin, MF);
+    }
+    
+    double Ralt = (nbin - 0.5 > 0) ? (Rrow + 0.5)*RAH : asin(-0.5);
+    size_t nBins = legacyRnaz(Rrow, MF);
+    const size_t Rcol = nbin - legacyRaccum(Rrow,MF) -1 ;
+    double Razi_width = 2 * PI_ / nBins;
+    double Razi = (nbin > 0) ? (Rcol + 0.5 - .5)*Razi_width : 2 * PI_*0.5;
+    double cos_ralt = cos(Ralt);
+    
+    if (Rrow == (RowMax-1)) {
+        *solidAngle = coneSolidAngle(RAH/2.0);
+    }
+    else {
+        *solidAngle = 2.0 * PI_ * (sin(Ralt + RAH/2.0)-sin(Ralt - RAH/2.0)) / (double)nBins;
+    }
+    
+    return Vector3D(sin(Razi)*cos_ralt, cos(Razi)*cos_ralt, sin(Ralt));
+}
+
+TEST(ReinhartTest, tablesMatchRecursiveImplementation){
+    
+    for(size_t mf = 1; mf <= EMP_MAX_TABULATED_MF; mf++){
+        
+        const size_t nbins = nReinhartBins((int)mf);
+        ASSERT_EQ(nbins, 1+legacyRaccum(7*mf+1, mf));
+        
+        for(size_t r = 0; r <= 7*mf+1; r++){
+            ASSERT_EQ(rnaz(r,mf), legacyRnaz(r,mf));
+            ASSERT_EQ(raccum(r,mf), legacyRaccum(r,mf));
+        }
+        
+        for(size_t bin = 0; bin < nbins; bin++){
+            // The polar cap is handled before Rfindrow in reinhartDir()
+            if(bin < nbins-1)
+                ASSERT_EQ(Rfindrow(bin,mf), legacyRfindrow(0,bin,mf));
+            
+            double sa, legacySa;
+            Vector3D dir = reinhartCenterDir(bin, mf, &sa);
+            Vector3D legacyDir = legacyReinhartCenterDir(bin, mf, &legacySa);
+            
+            ASSERT_EQ(sa, legacySa);
+            ASSERT_EQ(reinhartSolidAngle(bin, mf), legacySa);
+            ASSERT_EQ(dir.getX(), legacyDir.getX());
+            ASSERT_EQ(dir.getY(), legacyDir.getY());
+            ASSERT_EQ(dir.getZ(), legacyDir.getZ());
+        }
+    }
+}
+
+TEST(ReinhartTest, tablesBenchmark){
+    
+    const size_t mf = 6;
+    const size_t nbins = nReinhartBins((int)mf);
+    const int nRepetitions = 10;
+    
+    // Make sure the table is built before timing
+    ASSERT_TRUE(getReinhartTable(mf) != nullptr);
+    
+    double legacySum = 0;
+    auto legacyStart = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < nRepetitions; i++){
+        for(size_t bin = 0; bin < nbins; bin++){
+            double sa;
+            Vector3D dir = legacyReinhartCenterDir(bin, mf, &sa);
+            legacySum += dir.getZ() + sa;
+        }
+    }
+    std::chrono::duration<double> legacyTime = std::chrono::high_resolution_clock::now() - legacyStart;
+    
+    double sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < nRepetitions; i++){
+        for(size_t bin = 0; bin < nbins; bin++){
+            double sa;
+            Vector3D dir = reinhartCenterDir(bin, mf, &sa);
+            sum += dir.getZ() + sa;
+        }
+    }
+    std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+    
+    ASSERT_EQ(sum, legacySum);
+    std::cout << "     ... Reinhart MF:" << mf << " patches -- recursive: " << legacyTime.count() << "s, tables: " << time.count() << "s (" << legacyTime.count()/time.count() << "x faster)" << std::endl;
+}
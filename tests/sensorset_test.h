@@ -0,0 +1,83 @@
+/* sensorset_test.h */
+
+#include "../include/emp_core.h"
+#include "../src/calculations/sensor_set.h"
+
+TEST(SensorSetTest, addAndResize)
+{
+    SensorSet sensors = SensorSet(2);
+    ASSERT_EQ(sensors.size(), 2);
+    
+    // Default sensors are at the origin, pointing up
+    ASSERT_EQ(sensors.getOrigin(1)[0], 0);
+    ASSERT_EQ(sensors.getDirection(1)[2], 1);
+    ASSERT_EQ(sensors.getArea(1), 0);
+    ASSERT_EQ(sensors.getID(1), -1);
+    
+    size_t i = sensors.addSensor(1, 2, 3, 0, 1, 0, 0.5f, 7);
+    ASSERT_EQ(i, 2);
+    ASSERT_EQ(sensors.size(), 3);
+    ASSERT_EQ(sensors.getOrigin(2)[1], 2);
+    ASSERT_EQ(sensors.getDirection(2)[1], 1);
+    ASSERT_EQ(sensors.getArea(2), 0.5f);
+    ASSERT_EQ(sensors.getID(2), 7);
+    
+    sensors.setOrigin(0, 4, 5, 6);
+    sensors.setDirection(0, 1, 0, 0);
+    sensors.setArea(0, 2);
+    sensors.setID(0, 3);
+    ASSERT_EQ(sensors.getOrigin(0)[2], 6);
+    ASSERT_EQ(sensors.getDirection(0)[0], 1);
+    ASSERT_EQ(sensors.getArea(0), 2);
+    ASSERT_EQ(sensors.getID(0), 3);
+    
+    // Resizing keeps the existing sensors
+    sensors.resize(5);
+    ASSERT_EQ(sensors.getOrigin(2)[0], 1);
+    ASSERT_EQ(sensors.getDirection(4)[2], 1);
+    
+    sensors.clear();
+    ASSERT_EQ(sensors.size(), 0);
+}
+
+TEST(SensorSetTest, append)
+{
+    SensorSet a = SensorSet(2);
+    SensorSet b = SensorSet();
+    b.addSensor(1, 2, 3, 0, 1, 0, 0.5f, 7);
+    
+    a.append(&b);
+    ASSERT_EQ(a.size(), 3);
+    ASSERT_EQ(a.getOrigin(2)[2], 3);
+    ASSERT_EQ(a.getDirection(2)[1], 1);
+    ASSERT_EQ(a.getArea(2), 0.5f);
+    ASSERT_EQ(a.getID(2), 7);
+    
+    // The first sensors are untouched
+    ASSERT_EQ(a.getDirection(0)[2], 1);
+    ASSERT_EQ(b.size(), 1);
+}
+
+TEST(SensorSetTest, write)
+{
+    SensorSet sensors = SensorSet();
+    const size_t n = 2500;
+    for(size_t i = 0; i < n; i++)
+        sensors.addSensor((float)i, 0.5f, 1, 0, 0, 1);
+    
+    FILE * file = tmpfile();
+    ASSERT_TRUE(sensors.write(file));
+    rewind(file);
+    
+    float ox, oy, oz, dx, dy, dz;
+    size_t count = 0;
+    while(fscanf(file, "%f %f %f %f %f %f", &ox, &oy, &oz, &dx, &dy, &dz) == 6){
+        ASSERT_EQ(ox, (float)count);
+        ASSERT_EQ(oy, 0.5f);
+        ASSERT_EQ(dz, 1);
+        count++;
+    }
+    fclose(file);
+    
+    ASSERT_EQ(count, n);
+}
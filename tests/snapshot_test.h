@@ -0,0 +1,223 @@
+/* snapshot_test.h */
+
+#include "../include/emp_core.h"
+
+//! Builds a small model that uses most of what a snapshot can hold
+static void buildSnapshotModel(EmpModel * model)
+{
+    Material * material = model->addDefaultMaterial();
+    model->addDefaultGlass();
+    
+    model->setNorthCorrection(12.5);
+    model->getDate()->setMonth(3);
+    model->getRTraceOptions()->setOption("ab", 7);
+    
+    Location * location = model->getLocation();
+    location->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+    location->setAlbedo(0.3f);
+    
+    // A layer with a face (with a hole) and a sphere
+    std::string layerName = "Layer";
+    model->addLayer(&layerName);
+    
+    Polygon3D * p = new Polygon3D();
+    Loop * outerLoop = p->getOuterLoopRef();
+    outerLoop->addVertex(new Point3D(0,0,0));
+    outerLoop->addVertex(new Point3D(4,0,0));
+    outerLoop->addVertex(new Point3D(4,4,0));
+    outerLoop->addVertex(new Point3D(0,4,0));
+    Loop * hole = p->addInnerLoop();
+    hole->addVertex(new Point3D(1,1,0));
+    hole->addVertex(new Point3D(1,2,0));
+    hole->addVertex(new Point3D(2,2,0));
+    p->setNormal(Vector3D(0,0,1));
+    
+    std::string faceName = "face";
+    Face * face = new Face(&faceName);
+    face->setPolygon(p);
+    face->setMaterial(material);
+    model->addObjectToLayer(&layerName, face);
+    
+    std::string sphereName = "sphere";
+    Sphere * sphere = new Sphere(&sphereName);
+    sphere->center = Point3D(1,2,3);
+    sphere->radius = 0.5;
+    sphere->setMaterial(material);
+    model->addObjectToLayer(&layerName, sphere);
+    
+    // A component, instanced in the layer
+    std::string definitionName = "Component";
+    model->addComponentDefinition(&definitionName);
+    ComponentDefinition * definition = model->getComponentDefinitionRef(0);
+    std::string ballName = "ball";
+    Sphere * ball = new Sphere(&ballName);
+    ball->setMaterial(material);
+    definition->addObject(ball);
+    
+    ComponentInstance * instance = new ComponentInstance(definition);
+    instance->setX(10);
+    instance->setRotationZ(90);
+    instance->setScale(2);
+    model->getLayerRef(0)->addComponentInstance(instance);
+    
+    // A workplane
+    Polygon3D * wp = new Polygon3D();
+    wp->getOuterLoopRef()->addVertex(new Point3D(0,0,1));
+    wp->getOuterLoopRef()->addVertex(new Point3D(1,0,1));
+    wp->getOuterLoopRef()->addVertex(new Point3D(1,1,1));
+    wp->setNormal(Vector3D(0,0,1));
+    std::string workplaneName = "WP";
+    model->addPolygonToWorkplane(&workplaneName, wp);
+    Workplane * workplane = model->getWorkplaneRef(0);
+    workplane->setMaxArea(0.1);
+    workplane->addTask("DF");
+    
+    // Others
+    Photosensor * photosensor = new Photosensor("sensor");
+    photosensor->setPosition(Point3D(1,1,1));
+    photosensor->setDirection(Vector3D(0,1,0));
+    model->addPhotosensor(photosensor);
+    
+    View * view = new View();
+    std::string viewName = "view";
+    view->setName(&viewName);
+    view->setViewHorizontal(60);
+    model->addView(view);
+    
+    model->addTask({{"name", "DF"}, {"class", "Daylight Factor"}});
+}
+
+TEST(SnapshotTest, roundTrip)
+{
+    EmpModel model = EmpModel();
+    buildSnapshotModel(&model);
+    
+    std::string filename = "model.snapshot";
+    SnapshotWriter writer = SnapshotWriter(&model);
+    ASSERT_TRUE(writer.write(filename));
+    
+    EmpModel loaded = EmpModel();
+    SnapshotReader reader = SnapshotReader(&loaded);
+    ASSERT_TRUE(reader.read(filename));
+    remove(&filename[0]);
+    
+    // Model info
+    ASSERT_EQ(loaded.getNorthCorrection(), 12.5);
+    ASSERT_EQ(loaded.getDate()->getMonth(), 3);
+    ASSERT_EQ(loaded.getRTraceOptions()->getOption<int>("ab"), 7);
+    
+    Location * location = loaded.getLocation();
+    ASSERT_EQ(location->getLatitude(), model.getLocation()->getLatitude());
+    ASSERT_EQ(location->getCity(), model.getLocation()->getCity());
+    ASSERT_EQ(location->getAlbedo(), 0.3f);
+    ASSERT_TRUE(location->hasWeather());
+    ASSERT_EQ(location->getWeatherSize(), model.getLocation()->getWeatherSize());
+    ASSERT_EQ(location->getHourlyData(4000)->direct_normal, model.getLocation()->getHourlyData(4000)->direct_normal);
+    
+    // Materials
+    ASSERT_EQ(loaded.getNumMaterials(), 2);
+    ASSERT_EQ(loaded.getMaterialRef(1)->getType(), "glass");
+    ASSERT_EQ(static_cast<Glass *>(loaded.getMaterialRef(1))->r, static_cast<Glass *>(model.getMaterialRef(1))->r);
+    
+    // Geometry
+    ASSERT_EQ(loaded.getNumLayers(), 1);
+    Layer * layer = loaded.getLayerRef(0);
+    ASSERT_EQ(layer->getName(), "Layer");
+    ASSERT_EQ(layer->getObjectsRef()->size(), 2);
+    
+    const Face * face = dynamic_cast<const Face *>(layer->getObjectsRef()->at(0));
+    ASSERT_NE(face, nullptr);
+    ASSERT_EQ(face->getMaterial(), loaded.getMaterialRef(0));
+    ASSERT_EQ(face->getOuterLoopRef()->size(), 4);
+    ASSERT_EQ(face->polygon->countInnerLoops(), 1);
+    ASSERT_EQ(face->polygon->getInnerLoopRef(0)->size(), 3);
+    ASSERT_EQ(face->getOuterLoopRef()->getVertexRef(2)->getX(), 4);
+    ASSERT_TRUE(face->polygon->getNormal().isEqual(Vector3D(0,0,1)));
+    
+    const Sphere * sphere = dynamic_cast<const Sphere *>(layer->getObjectsRef()->at(1));
+    ASSERT_NE(sphere, nullptr);
+    ASSERT_EQ(sphere->radius, 0.5);
+    
+    // Components
+    ASSERT_EQ(loaded.getNumComponentDefinitions(), 1);
+    ASSERT_EQ(loaded.getComponentDefinitionRef(0)->getObjectsRef()->size(), 1);
+    ASSERT_EQ(layer->getComponentInstancesRef()->size(), 1);
+    const ComponentInstance * instance = layer->getComponentInstancesRef()->at(0);
+    ASSERT_EQ(instance->getDefinitionRef(), loaded.getComponentDefinitionRef(0));
+    ASSERT_EQ(instance->getX(), 10);
+    ASSERT_EQ(instance->getRotationZ(), 90);
+    ASSERT_EQ(instance->getScale(), 2);
+    
+    // Workplanes, sensors, views and tasks
+    ASSERT_EQ(loaded.getNumWorkplanes(), 1);
+    Workplane * workplane = loaded.getWorkplaneRef(0);
+    ASSERT_EQ(workplane->getName(), "WP");
+    ASSERT_EQ(workplane->getMaxArea(), 0.1);
+    ASSERT_EQ(workplane->getTasks()->size(), 1);
+    ASSERT_EQ(workplane->getGeometryHash(), model.getWorkplaneRef(0)->getGeometryHash());
+    
+    ASSERT_EQ(loaded.countPhotosensors(), 1);
+    ASSERT_TRUE(loaded.getPhotosensorRef(0)->getDirection().isEqual(Vector3D(0,1,0)));
+    
+    ASSERT_EQ(loaded.getNumViews(), 1);
+    ASSERT_EQ(loaded.getViewRef(0)->getViewHorizontal(), 60);
+    
+    ASSERT_EQ(loaded.countTasks(), 1);
+    ASSERT_EQ(*loaded.getTask(0), *model.getTask(0));
+}
+
+TEST(SnapshotTest, rejectsInvalid)
+{
+    EmpModel model = EmpModel();
+    buildSnapshotModel(&model);
+    
+    std::string filename = "model.snapshot";
+    SnapshotWriter writer = SnapshotWriter(&model);
+    ASSERT_TRUE(writer.write(filename));
+    
+    // Read it all
+    FOPEN(in, &filename[0], "rb");
+    std::string data = std::string();
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        data.append(chunk, n);
+    fclose(in);
+    
+    // Truncated
+    FOPEN(truncated, &filename[0], "wb");
+    fwrite(data.data(), 1, data.size() / 2, truncated);
+    fclose(truncated);
+    EmpModel a = EmpModel();
+    ASSERT_FALSE(SnapshotReader(&a).read(filename));
+    
+    // Another version
+    std::string other = data;
+    other[EMP_SNAPSHOT_MAGIC_SIZE] += 1;
+    FOPEN(versioned, &filename[0], "wb");
+    fwrite(other.data(), 1, other.size(), versioned);
+    fclose(versioned);
+    EmpModel b = EmpModel();
+    ASSERT_FALSE(SnapshotReader(&b).read(filename));
+    ASSERT_EQ(b.getNumLayers(), 0);
+    
+    // A corrupt count must fail before allocating
+    std::string materialName = "Default Material";
+    size_t countPosition = data.find(materialName);
+    ASSERT_NE(countPosition, std::string::npos);
+    std::string absurd = data;
+    const uint32_t nParams = 0xFFFFFFFF;
+    memcpy(&absurd[countPosition + materialName.size()], &nParams, sizeof(nParams));
+    FOPEN(corrupt, &filename[0], "wb");
+    fwrite(absurd.data(), 1, absurd.size(), corrupt);
+    fclose(corrupt);
+    EmpModel d = EmpModel();
+    ASSERT_FALSE(SnapshotReader(&d).read(filename));
+    ASSERT_EQ(d.getNumMaterials(), 0);
+    
+    // Not a snapshot
+    EmpModel c = EmpModel();
+    ASSERT_FALSE(SnapshotReader(&c).read("../../tests/weather/Santiago.epw"));
+    
+    remove(&filename[0]);
+}
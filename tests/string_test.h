@@ -9,3 +9,46 @@ TEST(StringTest, downCase)
     downCase(&s1);
     ASSERT_EQ("hola que tal!",s1);
 }
+
+TEST(StringTest, formatFixed)
+{
+    char fast[EMP_FIXED_BUFFER_SIZE];
+    char slow[EMP_FIXED_BUFFER_SIZE];
+    
+    const double values[] = {0, -0.0, 1, -1, 0.5, 123.456789, -98765.4321, 1e-7, -1e-7, 0.9999996, 1234567.0000004, 3e11, 2e13, -5e15};
+    for (double v : values) {
+        size_t n = formatFixed(v, fast);
+        snprintf(slow, EMP_FIXED_BUFFER_SIZE, "%f", v);
+        ASSERT_STREQ(fast, slow);
+        ASSERT_EQ(n, strlen(slow));
+    }
+    
+    // Random numbers match printf
+    srand(1);
+    for (int i = 0; i < 100000; i++) {
+        double v = ((double)rand() / RAND_MAX - 0.5) * pow(10, rand() % 13);
+        formatFixed(v, fast);
+        snprintf(slow, EMP_FIXED_BUFFER_SIZE, "%f", v);
+        ASSERT_STREQ(fast, slow);
+    }
+    
+    // And so do the exact halves (odd multiples of 2^-7 are 
+    // exactly half way between two 6 decimal numbers), and
+    // the numbers right next to them
+    for (int i = 0; i < 10000; i++) {
+        double v = (double)(rand() % 1000000) + (double)(2 * (rand() % 64) + 1) / 128.0;
+        if (rand() % 2)
+            v = -v;
+        
+        const double near[3] = {v, nextafter(v, 0), nextafter(v, 2 * v)};
+        for (double w : near) {
+            formatFixed(w, fast);
+            snprintf(slow, EMP_FIXED_BUFFER_SIZE, "%f", w);
+            ASSERT_STREQ(fast, slow);
+        }
+    }
+    
+    std::string s = "x ";
+    appendFixed(2.25, &s);
+    ASSERT_EQ(s, "x 2.250000");
+}
@@ -170,3 +170,102 @@ TEST(TaskManagerTest, clean)
 
   ASSERT_EQ(0, m.countTasks());
 }
+
+
+// A Task that gathers the TaskA of every equal one
+class TaskSum : public Task {
+public:
+    int result;
+    
+    TaskSum(int a)
+    {
+        std::string name = "Task Sum";
+        setName(&name);
+        addDependency(new TaskA(a));
+    }
+    
+    bool isEqual(Task * t)
+    {
+        return true;
+    }
+    
+    void merge(Task * t)
+    {
+        size_t n = t->countDependencies();
+        for (size_t i = 0; i < n; i++)
+            addDependency(t->getDependencyRef(i));
+    }
+    
+    bool solve()
+    {
+        result = 0;
+        size_t n = countDependencies();
+        for (size_t i = 0; i < n; i++)
+            result += static_cast<TaskA *>(getDependencyRef(i))->result;
+        return true;
+    }
+    
+    bool isMutex(Task * t)
+    {
+        return false;
+    }
+    
+    bool submitResults(json * results)
+    {
+        return true;
+    }
+};
+
+// A Task that reads a TaskSum
+class TaskD : public Task {
+public:
+    int result;
+    
+    TaskD(int a)
+    {
+        std::string name = "Task D";
+        setName(&name);
+        addDependency(new TaskSum(a));
+    }
+    
+    bool isEqual(Task * t)
+    {
+        return false;
+    }
+    
+    bool solve()
+    {
+        result = static_cast<TaskSum *>(getDependencyRef(0))->result;
+        return true;
+    }
+    
+    bool isMutex(Task * t)
+    {
+        return false;
+    }
+    
+    bool submitResults(json * results)
+    {
+        return true;
+    }
+};
+
+TEST(TaskManagerTest, merge)
+{
+    TaskManager m = TaskManager();
+    
+    TaskD * d1 = new TaskD(2);
+    TaskD * d2 = new TaskD(5);
+    m.addTask(d1);
+    m.addTask(d2);
+    
+    // D1, Sum, A2, D2, A5... the second Sum was merged into the first one
+    ASSERT_EQ(m.countTasks(), 5);
+    ASSERT_EQ(d1->getDependencyRef(0), d2->getDependencyRef(0));
+    
+    json j = json();
+    m.solve(&j);
+    
+    ASSERT_EQ(d1->result, 7);
+    ASSERT_EQ(d2->result, 7);
+}
@@ -0,0 +1,39 @@
+
+#include "../../include/emp_core.h"
+
+TEST(AddSkyToOctreeTest, emittersAreNotInstanced)
+{
+    TaskManager tm = TaskManager();
+    OconvOptions options = OconvOptions();
+    std::string sky = "gensky -ang 45 40 -c";
+    
+    // Without emitters, the frozen scene is instanced
+    EmpModel dark = EmpModel();
+    dark.addDefaultMaterial();
+    ASSERT_FALSE(dark.hasEmittingMaterials());
+    
+    AddSkyToOctree * instanced = new AddSkyToOctree(&dark, &options, sky);
+    tm.addTask(instanced);
+    ASSERT_TRUE(instanced->instanceScene);
+    OconvTask * frozen = static_cast<OconvTask *>(instanced->getDependencyRef(0));
+    ASSERT_TRUE(frozen->options.getOption<bool>(OCONV_FREEZE));
+    
+    // A light source would be lost inside of an instance
+    EmpModel lit = EmpModel();
+    lit.addDefaultMaterial();
+    json lamp = {{"name", "lamp"}, {"class", "light"}, {"color", {{"r", 10}, {"g", 10}, {"b", 10}}}};
+    lit.addMaterial(&lamp);
+    ASSERT_TRUE(lit.hasEmittingMaterials());
+    
+    AddSkyToOctree * copied = new AddSkyToOctree(&lit, &options, sky);
+    tm.addTask(copied);
+    ASSERT_FALSE(copied->instanceScene);
+    OconvTask * regular = static_cast<OconvTask *>(copied->getDependencyRef(0));
+    ASSERT_FALSE(regular->options.getOption<bool>(OCONV_FREEZE));
+    
+    // ... and so would a glow
+    EmpModel glowing = EmpModel();
+    json glow = {{"name", "glowing"}, {"class", "glow"}, {"color", {{"r", 1}, {"g", 1}, {"b", 1}}}, {"max_radius", 0}};
+    glowing.addMaterial(&glow);
+    ASSERT_TRUE(glowing.hasEmittingMaterials());
+}
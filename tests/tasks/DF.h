@@ -18,9 +18,9 @@ TEST(DaylightFactorTest, singleExteriorSensor)
     // Create rays
     FVECT origin = {0,0,0};
     FVECT dir = {0,0,1};
-    std::vector<RAY> rays = std::vector<RAY>(1);
-    VCOPY(rays.at(0).rorg, origin);
-    VCOPY(rays.at(0).rdir, dir);
+    SensorSet rays = SensorSet(1);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
     
     // Create Task
     CalculateDaylightFactor * task = new CalculateDaylightFactor(&model, &options, &rays);
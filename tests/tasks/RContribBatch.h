@@ -0,0 +1,106 @@
+
+#include "../../include/emp_core.h"
+
+//! Adds a rectangle to a Workplane
+static void addBatchRectangle(Workplane * workplane, double x0, double y0, double x1, double y1)
+{
+    Polygon3D * p = new Polygon3D();
+    Loop * loop = p->getOuterLoopRef();
+    loop->addVertex(new Point3D(x0, y0, 0));
+    loop->addVertex(new Point3D(x1, y0, 0));
+    loop->addVertex(new Point3D(x1, y1, 0));
+    loop->addVertex(new Point3D(x0, y1, 0));
+    p->setNormal(Vector3D(0, 0, 1));
+    workplane->addPolygon(p);
+}
+
+TEST(RContribBatchTest, scatter)
+{
+    TaskManager tm = TaskManager();
+    EmpModel model = EmpModel();
+    RTraceOptions options = RTraceOptions();
+    const int mf = 1;
+    
+    // Two workplanes and a set of sensors
+    Workplane wpA = Workplane("A");
+    addBatchRectangle(&wpA, 0, 0, 2, 1);
+    wpA.setMaxArea(0.5);
+    
+    Workplane wpB = Workplane("B");
+    addBatchRectangle(&wpB, 10, 0, 13, 3);
+    wpB.setMaxArea(1);
+    
+    SensorSet rays = SensorSet(2);
+    rays.setOrigin(0, 20, 0, 0);
+    rays.setOrigin(1, 21, 0, 0);
+    
+    CalculateDDCGlobalMatrix * a = new CalculateDDCGlobalMatrix(&model, &wpA, mf, &options);
+    CalculateDDCGlobalMatrix * b = new CalculateDDCGlobalMatrix(&model, &wpB, mf, &options);
+    CalculateDDCGlobalMatrix * r = new CalculateDDCGlobalMatrix(&model, &rays, mf, &options);
+    tm.addTask(a);
+    tm.addTask(b);
+    tm.addTask(r);
+    
+    // All of them share the batch
+    typedef RContribBatch<CreateDDCGlobalOctree> Batch;
+    Batch * batch = static_cast<Batch *>(a->getDependencyRef(0));
+    ASSERT_EQ(b->getDependencyRef(0), batch);
+    ASSERT_EQ(r->getDependencyRef(0), batch);
+    ASSERT_EQ(batch->countMembers(), 3);
+    
+    // Triangulate (without caching)
+    for (size_t i = 1; i < batch->countDependencies(); i++) {
+        TriangulateWorkplane * triangulate = static_cast<TriangulateWorkplane *>(batch->getDependencyRef(i));
+        triangulate->cacheDir = "";
+        ASSERT_TRUE(triangulate->solve());
+    }
+    
+    // Instead of RCONTRIB, fill each row with the X of its 
+    // sensor (red), the row number (green) and the bin (blue)
+    SensorSet all = SensorSet();
+    std::vector<size_t> firstRow = std::vector<size_t>();
+    batch->gather(&all, &firstRow);
+    
+    const size_t nbins = nReinhartBins(mf);
+    ColorMatrix rows = ColorMatrix(all.size(), nbins);
+    for (size_t i = 0; i < all.size(); i++) {
+        for (size_t bin = 0; bin < nbins; bin++) {
+            rows.r()->setElement(i, bin, all.getOrigin(i)[0]);
+            rows.g()->setElement(i, bin, (float)i);
+            rows.b()->setElement(i, bin, (float)bin);
+        }
+    }
+    batch->scatter(&rows, &firstRow);
+    
+    // Each task got the rows of its own sensors
+    CalculateDDCGlobalMatrix * tasks[3] = {a, b, r};
+    size_t nRows = 0;
+    for (auto task : tasks) {
+        ColorMatrix * result = task->getResult();
+        ASSERT_EQ(result->ncols(), nbins);
+        ASSERT_GT(result->nrows(), 0);
+        nRows += result->nrows();
+    }
+    ASSERT_EQ(nRows, all.size());
+    
+    for (size_t i = 0; i < a->getResult()->nrows(); i++)
+        ASSERT_LT(a->getResult()->r()->getElement(i, nbins - 1), 2);
+    for (size_t i = 0; i < b->getResult()->nrows(); i++) {
+        ASSERT_GT(b->getResult()->r()->getElement(i, 0), 10);
+        ASSERT_LT(b->getResult()->r()->getElement(i, 0), 13);
+    }
+    ASSERT_EQ(r->getResult()->nrows(), 2);
+    ASSERT_EQ(r->getResult()->r()->getElement(0, 0), 20);
+    ASSERT_EQ(r->getResult()->r()->getElement(1, 3), 21);
+    ASSERT_EQ(r->getResult()->b()->getElement(1, 3), 3);
+    
+    // ... in order
+    float previous = -1;
+    for (auto task : tasks) {
+        for (size_t i = 0; i < task->getResult()->nrows(); i++) {
+            const float row = task->getResult()->g()->getElement(i, 0);
+            ASSERT_EQ(row, previous + 1);
+            previous = row;
+        }
+    }
+}
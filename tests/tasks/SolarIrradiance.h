@@ -23,9 +23,9 @@ TEST(SolarIrradiadiation, singleExteriorSensor)
     // Create rays
     FVECT origin = {0,0,0};
     FVECT dir = {0,0,1};
-    std::vector<RAY> rays = std::vector<RAY>(1);
-    VCOPY(rays.at(0).rorg, origin);
-    VCOPY(rays.at(0).rdir, dir);
+    SensorSet rays = SensorSet(1);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
     
     // Create Task
     CalculateSolarIrradiation * task = new CalculateSolarIrradiation(&model, &options, &rays);
@@ -38,3 +38,42 @@ TEST(SolarIrradiadiation, singleExteriorSensor)
     std::cout << "Calc/Real = " << (task->result).getElement(0,0)/1770/1000 << std::endl;
     
 }
+
+TEST(SolarIrradiadiation, singleExteriorSensorFromDC)
+{
+    // Create Task Manager
+    TaskManager tm = TaskManager();
+    
+    // Create empty model
+    EmpModel model = EmpModel();
+    
+    // Needs a weather
+    model.getLocation()->fillWeatherFromEPWFile("../../tests/weather/Santiago.epw");
+    
+    // Create Options
+    RTraceOptions options = RTraceOptions();
+    options.setOption("ab", 2);
+    options.setOption("ad", 50000);
+    options.setOption("aa", 0.1);
+    options.setOption("lw", 0.00001);
+    
+    // Create rays
+    FVECT origin = {0,0,0};
+    FVECT dir = {0,0,1};
+    SensorSet rays = SensorSet(1);
+    rays.setOrigin(0, origin[0], origin[1], origin[2]);
+    rays.setDirection(0, dir[0], dir[1], dir[2]);
+    
+    // Create Tasks... one ray-traced, one through the DC matrix
+    CalculateSolarIrradiation * task = new CalculateSolarIrradiation(&model, &options, &rays);
+    CalculateSolarIrradiation * dcTask = new CalculateSolarIrradiation(&model, &options, &rays, 1);
+    
+    // Add and solve
+    tm.addTask(task);
+    tm.addTask(dcTask);
+    tm.solve();
+    
+    const float traced = (task->result).getElement(0,0);
+    const float fromDC = (dcTask->result).getElement(0,0);
+    ASSERT_NEAR(fromDC, traced, 0.05*traced);
+}
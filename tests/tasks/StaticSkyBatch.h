@@ -0,0 +1,84 @@
+
+#include "../../include/emp_core.h"
+#include "./common.h"
+
+TEST(StaticSkyBatchTest, singleExteriorSensor)
+{
+    // Create Task Manager
+    TaskManager tm = TaskManager();
+    
+    // Create empty model
+    EmpModel model = EmpModel();
+    
+    // Create Options
+    RTraceOptions options = RTraceOptions();
+    options.setOption("ab", 2);
+    options.setOption("ad", 50000);
+    
+    // Create rays
+    SensorSet rays = SensorSet(1);
+    rays.setOrigin(0, 0, 0, 0);
+    rays.setDirection(0, 0, 0, 1);
+    
+    // Two overcast skies, with 100 and 200 W/m2 of horizontal irradiance
+    std::vector<std::string> skies = std::vector<std::string>();
+    skies.push_back("gensky -ang 45 40 -c -B 100");
+    skies.push_back("gensky -ang 45 40 -c -B 200");
+    
+    // Create Task
+    CalculateStaticSkyBatch * task = new CalculateStaticSkyBatch(&model, &rays, skies, 1, &options);
+    
+    // Add and solve
+    tm.addTask(task);
+    tm.solve();
+    
+    Matrix * result = task->getResult();
+    ASSERT_EQ(result->nrows(), 1);
+    ASSERT_EQ(result->ncols(), 2);
+    ASSERT_NEAR(result->getElement(0,0), 17900, 0.03 * 17900); // 3% error.
+    ASSERT_NEAR(result->getElement(0,1), 2 * result->getElement(0,0), 1e-3 * result->getElement(0,1));
+}
+
+TEST(StaticSkyBatchTest, sharedByLuxCompliance)
+{
+    // Create Task Manager
+    TaskManager tm = TaskManager();
+    
+    // Create empty model
+    EmpModel model = EmpModel();
+    
+    // Create Options
+    RTraceOptions options = RTraceOptions();
+    options.setOption("ab", 2);
+    options.setOption("ad", 50000);
+    
+    // Create rays
+    SensorSet rays = SensorSet(1);
+    rays.setOrigin(0, 0, 0, 0);
+    rays.setDirection(0, 0, 0, 1);
+    
+    // Two overcast skies, with 100 and 200 W/m2 of horizontal irradiance
+    std::vector<std::string> skies = std::vector<std::string>();
+    skies.push_back("gensky -ang 45 40 -c -B 100");
+    skies.push_back("gensky -ang 45 40 -c -B 200");
+    
+    // One check per sky... both use the same batch
+    CheckLUXCompliance * dim = new CheckLUXCompliance("dim", &model, &options, &rays, skies, 0, 1, 0, 25000);
+    CheckLUXCompliance * bright = new CheckLUXCompliance("bright", &model, &options, &rays, skies, 1, 1, 0, 25000);
+    
+    tm.addTask(dim);
+    const size_t nTasks = tm.countTasks();
+    tm.addTask(bright);
+    ASSERT_EQ(tm.countTasks(), nTasks + 1);
+    ASSERT_EQ(dim->getDependencyRef(0), bright->getDependencyRef(0));
+    
+    tm.solve();
+    
+    // The first sky gives about 17900 lux, and the second one twice as much
+    Matrix * result = static_cast<CalculateStaticSkyBatch *>(dim->getDependencyRef(0))->getResult();
+    ASSERT_EQ(result->ncols(), 2);
+    ASSERT_NEAR(dim->getDependencyResults()->getElement(0,0), result->getElement(0,0), 1e-6);
+    ASSERT_NEAR(bright->getDependencyResults()->getElement(0,0), result->getElement(0,1), 1e-6);
+    ASSERT_NEAR(dim->compliance, 100, 1e-3);
+    ASSERT_NEAR(bright->compliance, 0, 1e-3);
+}
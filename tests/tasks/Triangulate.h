@@ -0,0 +1,71 @@
+
+#include "../../include/emp_core.h"
+
+TEST(TriangulateWorkplaneTest, cache)
+{
+    // A temporary directory, removed at the end
+    std::string cacheDir = ::testing::TempDir() + "triangulate_cache_test_" + std::to_string(GETPID());
+    
+    Workplane workplane = Workplane("wp");
+    Polygon3D * p = new Polygon3D();
+    Loop * loop = p->getOuterLoopRef();
+    loop->addVertex(new Point3D(0, 0, 0));
+    loop->addVertex(new Point3D(4, 0, 0));
+    loop->addVertex(new Point3D(4, 3, 0));
+    loop->addVertex(new Point3D(0, 3, 0));
+    p->setNormal(Vector3D(0, 0, 1));
+    workplane.addPolygon(p);
+    workplane.setMaxArea(0.5);
+    
+    // Solve and store
+    TriangulateWorkplane first = TriangulateWorkplane(&workplane);
+    first.cacheDir = cacheDir;
+    std::string cacheFile = first.getCacheFileName();
+    ASSERT_NE(cacheFile.find("_a" + std::to_string(EMP_TRIANGULATION_ALGORITHM_VERSION) + ".mesh"), std::string::npos);
+    ASSERT_FALSE(fexists(cacheFile));
+    ASSERT_TRUE(first.solve());
+    ASSERT_TRUE(fexists(cacheFile));
+    ASSERT_GT(first.mesh.nTriangles(), 0);
+    ASSERT_EQ(first.rays.size(), first.mesh.nSensors());
+    
+    // Replace the cached mesh... a second task should load it
+    TriangleMesh fake = TriangleMesh();
+    fake.addTriangle(fake.addVertex(0, 0, 0), fake.addVertex(1, 0, 0), fake.addVertex(0, 1, 0), Vector3D(0, 0, 1));
+    ASSERT_TRUE(fake.write(cacheFile));
+    
+    TriangulateWorkplane second = TriangulateWorkplane(&workplane);
+    second.cacheDir = cacheDir;
+    ASSERT_TRUE(second.solve());
+    ASSERT_EQ(second.mesh.nTriangles(), 1);
+    ASSERT_EQ(second.rays.size(), 1);
+    ASSERT_NEAR(second.rays.getOrigin(0)[0], 1.0/3.0, 1e-6);
+    ASSERT_NEAR(second.rays.getArea(0), 0.5, 1e-6);
+    
+    // Changing the parameters changes the key
+    workplane.setMaxArea(0.25);
+    TriangulateWorkplane third = TriangulateWorkplane(&workplane);
+    third.cacheDir = cacheDir;
+    std::string otherCacheFile = third.getCacheFileName();
+    ASSERT_NE(otherCacheFile, cacheFile);
+    ASSERT_TRUE(third.solve());
+    ASSERT_GT(third.mesh.nTriangles(), first.mesh.nTriangles());
+    
+    // And so does moving a vertex
+    workplane.setMaxArea(0.5);
+    uint64_t hash = workplane.getGeometryHash();
+    *(loop->getVertexRef(2)) = Point3D(4, 3.5, 0);
+    ASSERT_NE(workplane.getGeometryHash(), hash);
+    TriangulateWorkplane fourth = TriangulateWorkplane(&workplane);
+    fourth.cacheDir = cacheDir;
+    ASSERT_NE(fourth.getCacheFileName(), cacheFile);
+    
+    // Without a cache directory, nothing is stored
+    TriangulateWorkplane fifth = TriangulateWorkplane(&workplane);
+    fifth.cacheDir = "";
+    ASSERT_EQ(fifth.getCacheFileName(), "");
+    ASSERT_TRUE(fifth.solve());
+    
+    remove(cacheFile.c_str());
+    remove(otherCacheFile.c_str());
+    remove(cacheDir.c_str());
+}
@@ -3,3 +3,7 @@
 #include "./tasks/DF.h"
 #include "./tasks/CBDM.h"
 #include "./tasks/SolarIrradiance.h"
+#include "./tasks/Triangulate.h"
+#include "./tasks/StaticSkyBatch.h"
+#include "./tasks/RContribBatch.h"
+#include "./tasks/AddSkyToOctree.h"
@@ -0,0 +1,455 @@
+/* trianglemesh_test.h */
+
+#include "../include/emp_core.h"
+#include "../src/common/geometry/trianglemesh.h"
+
+TEST(TriangleMeshTest, addTriangle)
+{
+  TriangleMesh mesh = TriangleMesh();
+  int32_t a = mesh.addVertex(0, 0, 0);
+  int32_t b = mesh.addVertex(2, 0, 0);
+  int32_t c = mesh.addVertex(0, 2, 0);
+  int32_t d = mesh.addVertex(2, 2, 0);
+  size_t t0 = mesh.addTriangle(a, b, c, Vector3D(0, 0, 1));
+  size_t t1 = mesh.addTriangle(b, d, c, Vector3D(0, 0, 1));
+
+  ASSERT_EQ(mesh.nVertices(), 4);
+  ASSERT_EQ(mesh.nTriangles(), 2);
+  ASSERT_EQ(mesh.getNeighbor(t0, 1), -1);
+
+  mesh.setNeighbor(t0, 1, (int32_t)t1);
+  ASSERT_EQ(mesh.getNeighbor(t0, 1), (int32_t)t1);
+
+  ASSERT_NEAR(mesh.getArea(t0), 2, 1e-9);
+  ASSERT_NEAR(mesh.getArea(t1), 2, 1e-9);
+
+  Point3D center = mesh.getCenter(t1);
+  ASSERT_NEAR(center.getX(), 4.0 / 3.0, 1e-9);
+  ASSERT_NEAR(center.getY(), 4.0 / 3.0, 1e-9);
+
+  ASSERT_TRUE(mesh.getVertex(t1, 1).isEqual(Point3D(2, 2, 0)));
+  ASSERT_NEAR(mesh.getNormal(t1).getZ(), 1, 1e-9);
+
+  mesh.clear();
+  ASSERT_EQ(mesh.nVertices(), 0);
+  ASSERT_EQ(mesh.nTriangles(), 0);
+}
+
+TEST(TriangleMeshTest, appendTriangulation)
+{
+  // An L-shaped polygon
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(4, 2, 0));
+  loop->addVertex(new Point3D(2, 2, 0));
+  loop->addVertex(new Point3D(2, 4, 0));
+  loop->addVertex(new Point3D(0, 4, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  Triangulation tri = Triangulation(p);
+  tri.mesh(0.1, 1.5);
+  tri.purge();
+
+  TriangleMesh mesh = TriangleMesh();
+  mesh.append(&tri, p->getNormal());
+
+  const size_t nTriangles = tri.getNumTriangles();
+  ASSERT_EQ(mesh.nTriangles(), nTriangles);
+
+  // Vertices are shared
+  ASSERT_LT(mesh.nVertices(), nTriangles);
+
+  double area = 0;
+  for (size_t i = 0; i < nTriangles; i++) {
+    Triangle * t = tri.getTriangleRef(i);
+    ASSERT_NEAR(mesh.getArea(i), t->getArea(), 1e-9);
+    ASSERT_TRUE(mesh.getCenter(i).isEqual(t->getCenter()));
+    area += mesh.getArea(i);
+
+    for (int j = 0; j < 3; j++) {
+      ASSERT_TRUE(mesh.getVertex(i, j).isEqual(*(t->getVertex(j))));
+
+      // Neighbors are consistent
+      int32_t n = mesh.getNeighbor(i, j);
+      if (t->getNeighbor(j) == nullptr) {
+        ASSERT_EQ(n, -1);
+        continue;
+      }
+      ASSERT_EQ(n, (int32_t)t->getNeighbor(j)->getIndex());
+
+      // ... and share an edge with us
+      int shared = 0;
+      for (int k = 0; k < 3; k++) {
+        for (int l = 0; l < 3; l++) {
+          if (mesh.getVertexIndex(i, k) == mesh.getVertexIndex(n, l))
+            shared++;
+        }
+      }
+      ASSERT_EQ(shared, 2);
+    }
+  }
+  ASSERT_NEAR(area, 12, 1e-6);
+}
+
+//! Checks that the neighbors of a TriangleMesh share an edge, and that the boundary has a certain length
+static void checkGridMesh(const TriangleMesh * mesh, double perimeter)
+{
+  double boundary = 0;
+  for (size_t i = 0; i < mesh->nTriangles(); i++) {
+    for (int j = 0; j < 3; j++) {
+      int32_t a = mesh->getVertexIndex(i, j);
+      int32_t b = mesh->getVertexIndex(i, (j + 1) % 3);
+      int32_t n = mesh->getNeighbor(i, j);
+      if (n < 0) {
+        boundary += (mesh->getVertex(a) - mesh->getVertex(b)).getLength();
+        continue;
+      }
+
+      // The neighbor has the same edge, the other way around
+      bool found = false;
+      for (int k = 0; k < 3; k++) {
+        if (mesh->getVertexIndex(n, k) == b && mesh->getVertexIndex(n, (k + 1) % 3) == a) {
+          ASSERT_EQ(mesh->getNeighbor(n, k), (int32_t)i);
+          found = true;
+        }
+      }
+      ASSERT_TRUE(found);
+    }
+  }
+  ASSERT_NEAR(boundary, perimeter, 1e-6);
+}
+
+TEST(TriangleMeshTest, appendGrid)
+{
+  // A 10x7 rotated rectangle with a 2x3 hole
+  // that does not fall on the grid lines
+  Vector3D u = Vector3D(3, 4, 0) / 5.0;
+  Vector3D v = Vector3D(-4, 3, 0) / 5.0;
+  Point3D o = Point3D(1, 2, 3);
+
+  Polygon3D * p = new Polygon3D();
+  Loop * outer = p->getOuterLoopRef();
+  outer->addVertex(new Point3D(o + u * 0 + v * 0));
+  outer->addVertex(new Point3D(o + u * 10 + v * 0));
+  outer->addVertex(new Point3D(o + u * 10 + v * 7));
+  outer->addVertex(new Point3D(o + u * 0 + v * 7));
+
+  Loop * hole = p->addInnerLoop();
+  hole->addVertex(new Point3D(o + u * 3.5 + v * 1.5));
+  hole->addVertex(new Point3D(o + u * 3.5 + v * 4.5));
+  hole->addVertex(new Point3D(o + u * 5.5 + v * 4.5));
+  hole->addVertex(new Point3D(o + u * 5.5 + v * 1.5));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh mesh = TriangleMesh();
+  ASSERT_FALSE(mesh.appendGrid(p, 0));
+  ASSERT_TRUE(mesh.appendGrid(p, 1));
+
+  // Columns at 0..10 plus 3.5 and 5.5; rows at 0..7 plus 1.5 and 4.5
+  // ... minus the 3 x 4 rectangles in the hole
+  ASSERT_EQ(mesh.nTriangles(), 2 * (12 * 9 - 3 * 4));
+  ASSERT_EQ(mesh.nVertices(), 13 * 10 - 2 * 3);
+
+  // One sensor per rectangle, at its center
+  ASSERT_EQ(mesh.nSensors(), 12 * 9 - 3 * 4);
+  std::vector<double> centers = std::vector<double>();
+  std::vector<double> areas = std::vector<double>();
+  std::vector<float> normals = std::vector<float>();
+  mesh.getSensors(&centers, &areas, &normals);
+  for (size_t i = 0; i < mesh.nTriangles(); i += 2) {
+    const size_t s = mesh.getSensor(i);
+    ASSERT_EQ(mesh.getSensor(i + 1), s);
+    ASSERT_NEAR(areas[s], mesh.getArea(i) + mesh.getArea(i + 1), 1e-9);
+    ASSERT_LE(areas[s], 1 + 1e-9);
+    ASSERT_NEAR(normals[3 * s + 2], 1, 1e-6);
+
+    Point3D c = Point3D(centers[3 * s], centers[3 * s + 1], centers[3 * s + 2]);
+    Point3D middle = (mesh.getVertex(i, 0) + (mesh.getVertex(i, 2) - mesh.getVertex(i, 0)) * 0.5);
+    ASSERT_TRUE(c.isEqual(middle));
+  }
+
+  std::vector< std::vector<int32_t> > outlines = std::vector< std::vector<int32_t> >();
+  mesh.getSensorOutlines(&outlines);
+  ASSERT_EQ(outlines.size(), mesh.nSensors());
+  for (auto & outline : outlines)
+    ASSERT_EQ(outline.size(), 4);
+
+  double area = 0;
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    ASSERT_LE(mesh.getArea(i), 0.5 + 1e-9);
+    ASSERT_NEAR(mesh.getNormal(i).getZ(), 1, 1e-6);
+
+    Point3D c = mesh.getCenter(i);
+    ASSERT_NEAR(c.getZ(), 3, 1e-9);
+    ASSERT_TRUE(p->testPoint(c));
+
+    // Counter clockwise, as seen from the normal
+    Vector3D e1 = mesh.getVertex(i, 1) - mesh.getVertex(i, 0);
+    Vector3D e2 = mesh.getVertex(i, 2) - mesh.getVertex(i, 0);
+    ASSERT_GT((e1 % e2).getZ(), 0);
+
+    area += mesh.getArea(i);
+  }
+  ASSERT_NEAR(area, 10 * 7 - 2 * 3, 1e-6);
+
+  checkGridMesh(&mesh, 2 * (10 + 7) + 2 * (2 + 3));
+
+  delete p;
+}
+
+TEST(TriangleMeshTest, appendGridSnap)
+{
+  // A 4.1 x 3 rectangle with a hole whose edges
+  // are very close to the grid lines
+  Polygon3D * p = new Polygon3D();
+  Loop * outer = p->getOuterLoopRef();
+  outer->addVertex(new Point3D(0, 0, 0));
+  outer->addVertex(new Point3D(4.1, 0, 0));
+  outer->addVertex(new Point3D(4.1, 3, 0));
+  outer->addVertex(new Point3D(0, 3, 0));
+
+  Loop * hole = p->addInnerLoop();
+  hole->addVertex(new Point3D(1.05, 0.95, 0));
+  hole->addVertex(new Point3D(1.05, 2, 0));
+  hole->addVertex(new Point3D(2, 2, 0));
+  hole->addVertex(new Point3D(2, 0.95, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh mesh = TriangleMesh();
+  ASSERT_TRUE(mesh.appendGrid(p, 1));
+
+  // Columns at 0, 1.05, 2, 3, 4.1; rows at 0, 0.95, 2, 3
+  // ... minus the rectangle in the hole
+  ASSERT_EQ(mesh.nSensors(), 4 * 3 - 1);
+  ASSERT_EQ(mesh.nTriangles(), 2 * mesh.nSensors());
+
+  double area = 0;
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    // No slivers
+    ASSERT_GT(mesh.getArea(i), 0.4);
+    area += mesh.getArea(i);
+  }
+  ASSERT_NEAR(area, 4.1 * 3 - 0.95 * 1.05, 1e-9);
+
+  delete p;
+}
+
+TEST(TriangleMeshTest, appendGridNotRectilinear)
+{
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(0, 4, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh mesh = TriangleMesh();
+  ASSERT_FALSE(mesh.appendGrid(p, 1));
+  ASSERT_EQ(mesh.nTriangles(), 0);
+
+  delete p;
+}
+
+TEST(TriangleMeshTest, appendMesh)
+{
+  // An L-shaped polygon, split in two rectangles
+  Polygon3D * a = new Polygon3D();
+  Loop * loop = a->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(4, 2, 0));
+  loop->addVertex(new Point3D(0, 2, 0));
+  a->setNormal(Vector3D(0, 0, 1));
+
+  Polygon3D * b = new Polygon3D();
+  loop = b->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 2, 0));
+  loop->addVertex(new Point3D(2, 2, 0));
+  loop->addVertex(new Point3D(2, 4, 0));
+  loop->addVertex(new Point3D(0, 4, 0));
+  b->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh meshA = TriangleMesh();
+  TriangleMesh meshB = TriangleMesh();
+  ASSERT_TRUE(meshA.appendGrid(a, 0.5));
+  ASSERT_TRUE(meshB.appendGrid(b, 0.5));
+
+  TriangleMesh mesh = TriangleMesh();
+  mesh.append(&meshA);
+  mesh.append(&meshB);
+
+  ASSERT_EQ(mesh.nTriangles(), meshA.nTriangles() + meshB.nTriangles());
+  ASSERT_EQ(mesh.nVertices(), meshA.nVertices() + meshB.nVertices());
+  ASSERT_EQ(mesh.nSensors(), meshA.nSensors() + meshB.nSensors());
+
+  const size_t offset = meshA.nTriangles();
+  for (size_t i = 0; i < meshB.nTriangles(); i++) {
+    ASSERT_TRUE(mesh.getCenter(offset + i).isEqual(meshB.getCenter(i)));
+    ASSERT_EQ(mesh.getSensor(offset + i), meshB.getSensor(i) + (int32_t)meshA.nSensors());
+    for (int j = 0; j < 3; j++) {
+      int32_t n = meshB.getNeighbor(i, j);
+      ASSERT_EQ(mesh.getNeighbor(offset + i, j), n < 0 ? -1 : n + (int32_t)offset);
+    }
+  }
+
+  // Each piece is conforming on its own
+  checkGridMesh(&meshA, 12);
+  checkGridMesh(&meshB, 8);
+
+  delete a;
+  delete b;
+}
+
+TEST(TriangleMeshTest, splitEdge)
+{
+  TriangleMesh mesh = TriangleMesh();
+  int32_t a = mesh.addVertex(0, 0, 0);
+  int32_t b = mesh.addVertex(2, 0, 0);
+  int32_t c = mesh.addVertex(2, 2, 0);
+  int32_t d = mesh.addVertex(0, 2, 0);
+  mesh.addTriangle(a, b, c, Vector3D(0, 0, 1));
+  mesh.addTriangle(a, c, d, Vector3D(0, 0, 1), 0);
+  mesh.setNeighbor(0, 2, 1);
+  mesh.setNeighbor(1, 0, 0);
+  ASSERT_EQ(mesh.nSensors(), 1);
+
+  // Split the diagonal... both triangles are bisected,
+  // and each piece becomes a sensor
+  mesh.splitEdge(0, 2);
+  ASSERT_EQ(mesh.nTriangles(), 4);
+  ASSERT_EQ(mesh.nVertices(), 5);
+  ASSERT_EQ(mesh.nSensors(), 4);
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    for (size_t j = 0; j < i; j++)
+      ASSERT_NE(mesh.getSensor(i), mesh.getSensor(j));
+  }
+  ASSERT_TRUE(mesh.getVertex(4).isEqual(Point3D(1, 1, 0)));
+
+  double area = 0;
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    ASSERT_NEAR(mesh.getArea(i), 1, 1e-9);
+    area += mesh.getArea(i);
+  }
+  ASSERT_NEAR(area, 4, 1e-9);
+  checkGridMesh(&mesh, 8);
+
+  // Split a boundary edge... triangle 0 is now (c, m, b)
+  ASSERT_EQ(mesh.getNeighbor(0, 2), -1);
+  mesh.splitEdge(0, 2);
+  ASSERT_EQ(mesh.nTriangles(), 5);
+  checkGridMesh(&mesh, 8);
+}
+
+TEST(TriangleMeshTest, refine)
+{
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(4, 4, 0));
+  loop->addVertex(new Point3D(0, 4, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh mesh = TriangleMesh();
+  ASSERT_TRUE(mesh.appendGrid(p, 1));
+  const size_t nT = mesh.nTriangles();
+
+  // A sharp edge at X = 1.5
+  std::vector<double> centers = std::vector<double>();
+  std::vector<double> areas = std::vector<double>();
+  std::vector<float> normals = std::vector<float>();
+  std::vector<double> values = std::vector<double>();
+  auto setValues = [&]() {
+    mesh.getSensors(&centers, &areas, &normals);
+    values.resize(mesh.nSensors());
+    for (size_t i = 0; i < values.size(); i++)
+      values[i] = centers[3 * i] < 1.5 ? 1000 : 100;
+  };
+  setValues();
+
+  std::vector<char> changed = std::vector<char>();
+
+  // Nothing changes fast enough
+  ASSERT_EQ(mesh.refine(&values, 10, 0.1, &changed), 0);
+  ASSERT_EQ(mesh.nTriangles(), nT);
+
+  // Refine
+  size_t nChanged = mesh.refine(&values, 0.5, 0.1, &changed);
+  ASSERT_GT(nChanged, 0);
+  ASSERT_EQ(changed.size(), mesh.nSensors());
+  ASSERT_GT(mesh.nTriangles(), nT);
+
+  size_t count = 0;
+  double area = 0;
+  for (size_t i = 0; i < mesh.nTriangles(); i++)
+    area += mesh.getArea(i);
+
+  mesh.getSensors(&centers, &areas, &normals);
+  for (size_t i = 0; i < mesh.nSensors(); i++) {
+    count += changed[i];
+
+    // Only the two columns of cells at the 
+    // jump (at X = 1, between their sensors) are refined
+    if (changed[i]) {
+      const double x = centers[3 * i];
+      ASSERT_GT(x, 0);
+      ASSERT_LT(x, 2);
+    }
+  }
+  ASSERT_EQ(count, nChanged);
+  ASSERT_NEAR(area, 16, 1e-9);
+  checkGridMesh(&mesh, 16);
+
+  // Small triangles are not split
+  setValues();
+  ASSERT_EQ(mesh.refine(&values, 0.5, 0.6, &changed), 0);
+
+  delete p;
+}
+
+TEST(TriangleMeshTest, writeRead)
+{
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(3, 0, 0));
+  loop->addVertex(new Point3D(3, 2, 0));
+  loop->addVertex(new Point3D(0, 2, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  TriangleMesh mesh = TriangleMesh();
+  ASSERT_TRUE(mesh.appendGrid(p, 0.5));
+
+  std::string filename = "trianglemesh_test.mesh";
+  ASSERT_TRUE(mesh.write(filename));
+
+  TriangleMesh other = TriangleMesh();
+  ASSERT_TRUE(other.read(filename));
+  ASSERT_EQ(other.nVertices(), mesh.nVertices());
+  ASSERT_EQ(other.nTriangles(), mesh.nTriangles());
+  ASSERT_EQ(other.nSensors(), mesh.nSensors());
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    ASSERT_TRUE(other.getCenter(i).isEqual(mesh.getCenter(i)));
+    ASSERT_EQ(other.getSensor(i), mesh.getSensor(i));
+    ASSERT_NEAR(other.getNormal(i).getZ(), 1, 1e-9);
+    for (int j = 0; j < 3; j++) {
+      ASSERT_EQ(other.getVertexIndex(i, j), mesh.getVertexIndex(i, j));
+      ASSERT_EQ(other.getNeighbor(i, j), mesh.getNeighbor(i, j));
+    }
+  }
+
+  // Truncated files are rejected
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file << "EMPMESH";
+  }
+  ASSERT_FALSE(other.read(filename));
+  ASSERT_EQ(other.nTriangles(), 0);
+
+  remove(filename.c_str());
+  ASSERT_FALSE(other.read(filename));
+
+  delete p;
+}
@@ -0,0 +1,88 @@
+/* trianglesoup_test.h */
+
+#include "../include/emp_core.h"
+
+//! Adds a triangle (on the XY plane) to a Layer
+static void addTriangle(EmpModel * model, std::string layerName, Material * material, double x0, double y0, double x1, double y1, double x2, double y2)
+{
+    Polygon3D * p = new Polygon3D();
+    Loop * outerLoop = p->getOuterLoopRef();
+    outerLoop->addVertex(new Point3D(x0,y0,0));
+    outerLoop->addVertex(new Point3D(x1,y1,0));
+    outerLoop->addVertex(new Point3D(x2,y2,0));
+    p->setNormal(Vector3D(0,0,1));
+    
+    std::string faceName = "triangle";
+    Face * face = new Face(&faceName);
+    face->setPolygon(p);
+    face->setMaterial(material);
+    model->addObjectToLayer(&layerName, face);
+}
+
+//! Counts the lines of a file that contain a certain string
+static size_t countLines(std::string fileName, std::string text)
+{
+    std::ifstream in(fileName);
+    std::string line;
+    size_t ret = 0;
+    while (std::getline(in, line)) {
+        if (line.find(text) != std::string::npos)
+            ret++;
+    }
+    return ret;
+}
+
+TEST(TriangleSoupTest, findAndWrite)
+{
+    EmpModel model = EmpModel();
+    std::string layerName = "Layer";
+    model.addLayer(&layerName);
+    Material * material = model.addDefaultMaterial();
+    Material * glass = model.addDefaultGlass();
+    
+    // A 3x3 grid of squares, split in two triangles each
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            addTriangle(&model, layerName, material, i, j, i+1, j, i+1, j+1);
+            addTriangle(&model, layerName, material, i, j, i+1, j+1, i, j+1);
+        }
+    }
+    
+    // A few triangles with another material
+    addTriangle(&model, layerName, glass, 0, 0, 1, 0, 1, 1);
+    addTriangle(&model, layerName, glass, 0, 0, 1, 1, 0, 1);
+    
+    RadExporter exporter = RadExporter(&model);
+    const Layer * layer = model.getLayerRef(0);
+    
+    std::vector<TriangleSoup> soups = std::vector<TriangleSoup>();
+    exporter.findTriangleSoups(layer, 10, &soups);
+    ASSERT_EQ(soups.size(), 1);
+    ASSERT_EQ(soups[0].material, material);
+    ASSERT_EQ(soups[0].faces.size(), 18);
+    
+    std::vector<TriangleSoup> all = std::vector<TriangleSoup>();
+    exporter.findTriangleSoups(layer, 1, &all);
+    ASSERT_EQ(all.size(), 2);
+    
+    // Shared vertices are written once
+    std::string objName = "soup.obj";
+    FOPEN(obj, &objName[0], "w");
+    ASSERT_TRUE(exporter.writeOBJ(obj, &soups[0]));
+    fclose(obj);
+    ASSERT_EQ(countLines(objName, "v "), 16);
+    ASSERT_EQ(countLines(objName, "f "), 18);
+    remove(&objName[0]);
+    
+    // The triangles in the soup are replaced by the mesh
+    soups[0].meshName = "soup.rtm";
+    exporter.setTriangleSoups(&soups);
+    std::string radName = "soup.rad";
+    FOPEN(rad, &radName[0], "w");
+    exporter.writeLayersInOneFile(rad, nullptr, nullptr);
+    fclose(rad);
+    ASSERT_EQ(countLines(radName, " mesh "), 1);
+    ASSERT_EQ(countLines(radName, "1 soup.rtm"), 1);
+    ASSERT_EQ(countLines(radName, " polygon "), 2);
+    remove(&radName[0]);
+}
@@ -1,6 +1,8 @@
 /* vector3d_test.h */
 
 #include <cmath>
+#include <chrono>
+#include <map>
 
 #include "../include/emp_core.h"
 //#include "../src/common/geometry/triangulation.h"
@@ -114,3 +116,327 @@ TEST(TriangulateTest, cleanTest)
   }
 
 }
+
+TEST(TriangulateTest, gridMatchesLinearSearch)
+{
+  // A vertical, L-shaped polygon
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 2));
+  loop->addVertex(new Point3D(2, 0, 2));
+  loop->addVertex(new Point3D(2, 0, 4));
+  loop->addVertex(new Point3D(0, 0, 4));
+  p->setNormal(Vector3D(0, -1, 0));
+
+  Triangulation tri = Triangulation(p);
+  tri.mesh(0.1, 1.3);
+
+  std::vector<Triangle *> triangles = std::vector<Triangle *>(tri.getNumTriangles());
+  for (size_t i = 0; i < triangles.size(); i++)
+    triangles[i] = tri.getTriangleRef(i);
+
+  TriangleGrid grid = TriangleGrid();
+  grid.build(&triangles);
+  ASSERT_FALSE(grid.isEmpty());
+
+  for (double x = -0.5; x <= 4.5; x += 0.0731) {
+    for (double z = -0.5; z <= 4.5; z += 0.0731) {
+      Point3D point = Point3D(x, 0, z);
+
+      // Linear search
+      bool expectedFound = false;
+      size_t expectedIndex = 0;
+      int expectedCode = -1;
+      for (size_t i = 0; i < triangles.size(); i++) {
+        if (triangles[i] != nullptr && triangles[i]->testPoint(&point, &expectedCode)) {
+          expectedFound = true;
+          expectedIndex = i;
+          break;
+        }
+      }
+
+      size_t index;
+      int code;
+      bool found = grid.findTriangle(&triangles, &point, &index, &code);
+      ASSERT_EQ(found, expectedFound);
+      if (found) {
+        ASSERT_EQ(index, expectedIndex);
+        ASSERT_EQ(code, expectedCode);
+      }
+    }
+  }
+}
+
+TEST(TriangulateTest, refineLargeFloor)
+{
+  // A 20x20m floor
+  Polygon3D * p = new Polygon3D();
+  Loop * loop = p->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(20, 0, 0));
+  loop->addVertex(new Point3D(20, 20, 0));
+  loop->addVertex(new Point3D(0, 20, 0));
+  p->setNormal(Vector3D(0, 0, 1));
+
+  Triangulation tri = Triangulation(p);
+  tri.mesh(0.25, 1.3);
+  tri.purge();
+
+  // Nothing is lost
+  double area = 0;
+  for (size_t i = 0; i < tri.getNumTriangles(); i++) {
+    ASSERT_LE(tri.getTriangleRef(i)->getArea(), 0.25 + 1e-9);
+    area += tri.getTriangleRef(i)->getArea();
+  }
+  ASSERT_NEAR(area, 400, 1e-6);
+}
+
+//! The refinement used before local Delaunay restoration (for comparison)
+static void legacyRefine(Triangulation * t, double maxArea, double maxAspectRatio)
+{
+  for (size_t i = 0; i < t->getNumTriangles(); i++) {
+    Triangle * tr = t->getTriangleRef(i);
+    if (tr == nullptr)
+      continue;
+
+    double area = tr->getArea();
+    if (area < 9e-3)
+      continue;
+
+    if (tr->getAspectRatio() > maxAspectRatio) {
+      Segment * s = tr->getSegment(0);
+      int longestSegmentIndex = 0;
+      for (int j = 1; j < 3; j++) {
+        if (s->getLength() < tr->getSegment(j)->getLength()) {
+          longestSegmentIndex = j;
+          s = tr->getSegment(j);
+        }
+      }
+      double dX = s->start->getX() + s->end->getX();
+      double dY = s->start->getY() + s->end->getY();
+      double dZ = s->start->getZ() + s->end->getZ();
+      t->addPointToTriangle(i, new Point3D(dX / 2, dY / 2, dZ / 2), longestSegmentIndex + 3);
+      t->restoreDelaunay();
+    }
+    else if (area > maxArea) {
+      Point3D * cCenter = new Point3D(tr->getCircumCenter());
+      if (!t->addPoint(cCenter, false)) {
+        delete cCenter;
+        Point3D * a = tr->getVertex(0);
+        Point3D * b = tr->getVertex(1);
+        Point3D * c = tr->getVertex(2);
+        Point3D * gCenter = new Point3D((a->getX() + b->getX() + c->getX()) / 3, (a->getY() + b->getY() + c->getY()) / 3, (a->getZ() + b->getZ() + c->getZ()) / 3);
+        t->splitTriangle(i, gCenter);
+      }
+      t->restoreDelaunay();
+    }
+  }
+}
+
+//! Quality statistics of a Triangulation
+/*!
+Aspect ratios only consider the triangles that are big enough
+to be refined (see Triangulation::refine())
+*/
+struct MeshQuality {
+  size_t n = 0;
+  double area = 0;
+  double maxArea = 0;
+  double meanAspectRatio = 0;
+  double maxAspectRatio = 0;
+  size_t violations = 0; //!< Refinable triangles that are too big or too skinny
+};
+
+static MeshQuality meshQuality(Triangulation * t, double maxArea)
+{
+  MeshQuality q = MeshQuality();
+  size_t nRefinable = 0;
+  for (size_t i = 0; i < t->getNumTriangles(); i++) {
+    Triangle * tr = t->getTriangleRef(i);
+    if (tr == nullptr)
+      continue;
+    double ar = tr->getAspectRatio();
+    double a = tr->getArea();
+    q.n++;
+    q.area += a;
+    q.maxArea = (a > q.maxArea) ? a : q.maxArea;
+    if (a < 9e-3)
+      continue;
+    nRefinable++;
+    q.meanAspectRatio += ar;
+    q.maxAspectRatio = (ar > q.maxAspectRatio) ? ar : q.maxAspectRatio;
+    if (ar > 1.3 || a > maxArea)
+      q.violations++;
+  }
+  q.meanAspectRatio /= (double)nRefinable;
+  return q;
+}
+
+static void compareRestoreDelaunay(Polygon3D * p, double maxArea)
+{
+  Triangulation legacy = Triangulation(p);
+  auto start = std::chrono::steady_clock::now();
+  legacy.doCDT();
+  legacyRefine(&legacy, maxArea, 1.3);
+  double legacyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Triangulation local = Triangulation(p);
+  start = std::chrono::steady_clock::now();
+  local.mesh(maxArea, 1.3);
+  double localTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  MeshQuality ql = meshQuality(&legacy, maxArea);
+  MeshQuality qn = meshQuality(&local, maxArea);
+
+  std::cout << "Global: " << ql.n << " triangles, mean/max aspect ratio " << ql.meanAspectRatio << "/" << ql.maxAspectRatio << ", " << legacyTime << " s" << std::endl;
+  std::cout << "Local:  " << qn.n << " triangles, mean/max aspect ratio " << qn.meanAspectRatio << "/" << qn.maxAspectRatio << ", " << localTime << " s" << std::endl;
+
+  // Same surface, same size constraints
+  ASSERT_NEAR(qn.area, ql.area, 1e-6*ql.area);
+  ASSERT_LE(qn.maxArea, (maxArea > ql.maxArea) ? maxArea : ql.maxArea);
+
+  // Not worse quality
+  ASSERT_LE(qn.meanAspectRatio, ql.meanAspectRatio * 1.02);
+  ASSERT_LE(qn.maxAspectRatio, ql.maxAspectRatio * 1.02);
+  ASSERT_LE(qn.violations, ql.violations);
+}
+
+TEST(TriangulateTest, localRestoreDelaunay)
+{
+  // The L-shaped polygon
+  Polygon3D * l = new Polygon3D();
+  Loop * loop = l->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 0));
+  loop->addVertex(new Point3D(4, 0, 2));
+  loop->addVertex(new Point3D(2, 0, 2));
+  loop->addVertex(new Point3D(2, 0, 4));
+  loop->addVertex(new Point3D(0, 0, 4));
+  l->setNormal(Vector3D(0, -1, 0));
+  compareRestoreDelaunay(l, 0.1);
+
+  // A floor with a hole
+  Polygon3D * h = new Polygon3D();
+  loop = h->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(10, 0, 0));
+  loop->addVertex(new Point3D(10, 7, 0));
+  loop->addVertex(new Point3D(0, 7, 0));
+  Loop * hole = h->addInnerLoop();
+  hole->addVertex(new Point3D(3, 2, 0));
+  hole->addVertex(new Point3D(3, 4, 0));
+  hole->addVertex(new Point3D(5, 4, 0));
+  hole->addVertex(new Point3D(5, 2, 0));
+  h->setNormal(Vector3D(0, 0, 1));
+  compareRestoreDelaunay(h, 0.04);
+
+  // A large floor
+  Polygon3D * f = new Polygon3D();
+  loop = f->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(20, 0, 0));
+  loop->addVertex(new Point3D(20, 20, 0));
+  loop->addVertex(new Point3D(0, 20, 0));
+  f->setNormal(Vector3D(0, 0, 1));
+  compareRestoreDelaunay(f, 0.04);
+}
+
+//! Checks that meshing a polygon in parallel cells gives a conforming mesh of the same quality
+static void compareCells(Polygon3D * p, double maxArea, size_t nCells, double perimeter)
+{
+  Triangulation serial = Triangulation(p);
+  auto start = std::chrono::steady_clock::now();
+  serial.mesh(maxArea, 1.3);
+  serial.purge();
+  double serialTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Triangulation cells = Triangulation(p);
+  start = std::chrono::steady_clock::now();
+  cells.mesh(maxArea, 1.3, nCells);
+  cells.purge();
+  double cellsTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  MeshQuality qs = meshQuality(&serial, maxArea);
+  MeshQuality qc = meshQuality(&cells, maxArea);
+
+  std::cout << "Serial: " << qs.n << " triangles, mean/max aspect ratio " << qs.meanAspectRatio << "/" << qs.maxAspectRatio << ", " << serialTime << " s" << std::endl;
+  std::cout << "Cells:  " << qc.n << " triangles, mean/max aspect ratio " << qc.meanAspectRatio << "/" << qc.maxAspectRatio << ", " << cellsTime << " s" << std::endl;
+
+  // Same surface, same guarantees
+  ASSERT_NEAR(qc.area, qs.area, 1e-6*qs.area);
+  ASSERT_LE(qc.maxArea, maxArea);
+  ASSERT_EQ(qc.violations, 0);
+  ASSERT_EQ(qs.violations, 0);
+
+  // Conforming: every edge is shared by two triangles, except
+  // those on the boundary of the polygon
+  TriangleMesh mesh = TriangleMesh();
+  mesh.append(&cells, p->getNormal());
+  ASSERT_EQ(mesh.nTriangles(), qc.n);
+
+  std::map<std::pair<int32_t, int32_t>, int> edges = std::map<std::pair<int32_t, int32_t>, int>();
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    for (int j = 0; j < 3; j++) {
+      int32_t a = mesh.getVertexIndex(i, j);
+      int32_t b = mesh.getVertexIndex(i, (j + 1) % 3);
+      edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+    }
+  }
+
+  double boundaryLength = 0;
+  for (auto & e : edges) {
+    ASSERT_LE(e.second, 2);
+    if (e.second == 1)
+      boundaryLength += (mesh.getVertex(e.first.first) - mesh.getVertex(e.first.second)).getLength();
+  }
+  ASSERT_NEAR(boundaryLength, perimeter, 1e-6*perimeter);
+
+  for (size_t i = 0; i < mesh.nTriangles(); i++) {
+    for (int j = 0; j < 3; j++) {
+      int32_t a = mesh.getVertexIndex(i, j);
+      int32_t b = mesh.getVertexIndex(i, (j + 1) % 3);
+      const bool shared = edges[std::make_pair(std::min(a, b), std::max(a, b))] == 2;
+      ASSERT_EQ(mesh.getNeighbor(i, j) >= 0, shared);
+    }
+  }
+}
+
+TEST(TriangulateTest, refineInCells)
+{
+  // A floor with a hole
+  Polygon3D * h = new Polygon3D();
+  Loop * loop = h->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(10, 0, 0));
+  loop->addVertex(new Point3D(10, 7, 0));
+  loop->addVertex(new Point3D(0, 7, 0));
+  Loop * hole = h->addInnerLoop();
+  hole->addVertex(new Point3D(3, 2, 0));
+  hole->addVertex(new Point3D(3, 4, 0));
+  hole->addVertex(new Point3D(5, 4, 0));
+  hole->addVertex(new Point3D(5, 2, 0));
+  h->setNormal(Vector3D(0, 0, 1));
+  compareCells(h, 0.04, 4, 34 + 8);
+
+  // A large, vertical, wall
+  Polygon3D * w = new Polygon3D();
+  loop = w->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(60, 0, 0));
+  loop->addVertex(new Point3D(60, 0, 5));
+  loop->addVertex(new Point3D(0, 0, 5));
+  w->setNormal(Vector3D(0, -1, 0));
+  compareCells(w, 0.1, 7, 130);
+
+  // A large floor
+  Polygon3D * f = new Polygon3D();
+  loop = f->getOuterLoopRef();
+  loop->addVertex(new Point3D(0, 0, 0));
+  loop->addVertex(new Point3D(40, 0, 0));
+  loop->addVertex(new Point3D(40, 40, 0));
+  loop->addVertex(new Point3D(0, 40, 0));
+  f->setNormal(Vector3D(0, 0, 1));
+  compareCells(f, 0.04, 16, 160);
+}